@@ -0,0 +1,431 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ConsensusBench.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#define CATCH_CONFIG_MAIN
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "crypto/bls_include.h"
+#include "libBLS/bls/BLSPrivateKeyShare.h"
+#include "libBLS/bls/BLSPublicKey.h"
+#include "libBLS/bls/BLSSigShare.h"
+#include "libBLS/bls/BLSSigShareSet.h"
+#include "libBLS/bls/BLSSignature.h"
+
+#define BOOST_PENDING_INTEGER_LOG2_HPP
+
+#include <boost/integer/integer_log2.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "chains/Schain.h"
+#include "crypto/BLAKE3Hash.h"
+#include "crypto/CryptoManager.h"
+#include "crypto/MockupSigShare.h"
+#include "crypto/MockupSigShareSet.h"
+#include "crypto/OpenSSLECDSAKey.h"
+#include "crypto/OpenSSLEdDSAKey.h"
+#include "crypto/ThresholdSignature.h"
+#include "datastructures/BlockProposalFragment.h"
+#include "datastructures/BlockProposalFragmentList.h"
+#include "datastructures/CommittedBlock.h"
+#include "datastructures/ReedSolomonCoder.h"
+#include "datastructures/Transaction.h"
+#include "datastructures/TransactionList.h"
+#include "db/BlockDB.h"
+#include "db/MsgDB.h"
+#include "monitoring/LivelinessMonitor.h"
+#include "node/ConsensusEngine.h"
+#include "protocols/binconsensus/BVBroadcastMessage.h"
+#include "utils/Time.h"
+
+#include "thirdparty/catch.hpp"
+
+#include "ConsensusBench.h"
+
+
+static constexpr uint64_t BENCH_TIME_STAMP = 1547640183;
+
+
+static string sized( const string& _name, uint64_t _size, const string& _unit ) {
+    return _name + " [" + to_string( _size ) + " " + _unit + "]";
+}
+
+
+static uint64_t requiredSignersFor( uint64_t _nodeCount ) {
+    return 2 * _nodeCount / 3 + 1;
+}
+
+
+class BenchFixture {
+public:
+    ConsensusEngine engine;
+
+    boost::random::mt19937 gen;
+    boost::random::uniform_int_distribution<> ubyte{ 0, 255 };
+
+    // mockup signatures, no SGX server is needed
+    ptr< CryptoManager > cryptoManager;
+
+    Schain chain;
+
+    ptr< BLAKE3Hash > hash;
+
+    BenchFixture()
+        : cryptoManager( make_shared< CryptoManager >(
+              16, requiredSignersFor( 16 ), false, "", "", "", "", nullptr ) ),
+          chain( schain_id( 1 ), cryptoManager ),
+          hash( BLAKE3Hash::calculateHash( make_shared< vector< uint8_t > >( 32, 1 ) ) ) {}
+
+    ptr< TransactionList > createList( uint64_t _transactionCount ) {
+        auto transactions = make_shared< vector< ptr< Transaction > > >();
+        for ( uint64_t i = 0; i < _transactionCount; i++ ) {
+            transactions->push_back(
+                Transaction::createRandomSample( BENCH_TRANSACTION_SIZE, gen, ubyte ) );
+        }
+        return make_shared< TransactionList >( transactions );
+    }
+
+    ptr< CommittedBlock > createBlock( uint64_t _transactionCount ) {
+        auto proposal = make_shared< BlockProposal >( schain_id( 1 ), node_id( 1 ), block_id( 1 ),
+            schain_index( 1 ), createList( _transactionCount ), u256( 2 ), BENCH_TIME_STAMP, 1, "",
+            cryptoManager );
+        return CommittedBlock::make( proposal->getSchainID(), proposal->getProposerNodeID(),
+            proposal->getBlockID(), proposal->getProposerIndex(), proposal->getTransactionList(),
+            proposal->getStateRoot(), proposal->getTimeStampS(), proposal->getTimeStampMs(),
+            proposal->getSignature(), "EMPTY" );
+    }
+
+    // lists and blocks cache their serialization and merkle root, benchmarks work on new objects
+    // that share the transactions. A new block recalculates its hash from the transactions
+    static ptr< TransactionList > copyList( const ptr< TransactionList >& _list ) {
+        return make_shared< TransactionList >( _list->getItems() );
+    }
+
+    static ptr< CommittedBlock > copyBlock(
+        const ptr< CommittedBlock >& _block, block_id _blockID ) {
+        return CommittedBlock::make( _block->getSchainID(), _block->getProposerNodeID(), _blockID,
+            _block->getProposerIndex(), copyList( _block->getTransactionList() ),
+            _block->getStateRoot(), _block->getTimeStampS(), _block->getTimeStampMs(),
+            _block->getSignature(), _block->getThresholdSig() );
+    }
+};
+
+
+TEST_CASE_METHOD( BenchFixture, "Transaction serialization", "[bench][tx-bench]" ) {
+    for ( auto size : BENCH_TRANSACTION_SIZES ) {
+        auto transaction = Transaction::createRandomSample( size, gen, ubyte );
+
+        auto serialized = make_shared< vector< uint8_t > >();
+        transaction->serializeInto( serialized, true );
+
+        BENCHMARK( sized( "Transaction serialize", size, "bytes" ) ) {
+            auto out = make_shared< vector< uint8_t > >();
+            transaction->serializeInto( out, true );
+        }
+
+        // the partial hash is checked, as for transactions from the network
+        BENCHMARK( sized( "Transaction deserialize", size, "bytes" ) ) {
+            Transaction::deserialize( serialized, 0, serialized->size(), true );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Transaction list serialization", "[bench][tx-list-bench]" ) {
+    for ( auto size : BENCH_BLOCK_SIZES ) {
+        auto list = createList( size );
+        auto serialized = list->serialize( true );
+        auto sizes = list->createTransactionSizesVector( true );
+
+        BENCHMARK( sized( "TransactionList serialize", size, "tx" ) ) {
+            copyList( list )->serialize( true );
+        }
+
+        BENCHMARK( sized( "TransactionList deserialize", size, "tx" ) ) {
+            TransactionList::deserialize( sizes, serialized, 0, true );
+        }
+
+        BENCHMARK( sized( "TransactionList calculateTopMerkleRoot", size, "tx" ) ) {
+            copyList( list )->calculateTopMerkleRoot();
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Block serialization", "[bench][block-bench]" ) {
+    for ( auto size : BENCH_BLOCK_SIZES ) {
+        auto block = createBlock( size );
+
+        auto serializedProposal = block->serialize( SERIALIZE_AS_PROPOSAL );
+        auto serializedBlock = copyBlock( block, block->getBlockID() )->serialize();
+
+        BENCHMARK( sized( "BlockProposal serialize", size, "tx" ) ) {
+            copyBlock( block, block->getBlockID() )->serialize( SERIALIZE_AS_PROPOSAL );
+        }
+
+        // includes the block hash and the ECDSA check of the proposer signature
+        BENCHMARK( sized( "BlockProposal deserialize", size, "tx" ) ) {
+            BlockProposal::deserialize( serializedProposal, cryptoManager );
+        }
+
+        BENCHMARK( sized( "CommittedBlock serialize", size, "tx" ) ) {
+            copyBlock( block, block->getBlockID() )->serialize();
+        }
+
+        BENCHMARK( sized( "CommittedBlock deserialize", size, "tx" ) ) {
+            CommittedBlock::deserialize( serializedBlock, cryptoManager );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Block fragment/defragment", "[bench][fragment-bench]" ) {
+    // sixteen nodes, the other fifteen hold the fragments
+    uint64_t totalFragments = 15;
+    uint64_t dataFragments = ReedSolomonCoder::dataShardsFor( totalFragments );
+
+    for ( auto size : BENCH_BLOCK_SIZES ) {
+        auto block = createBlock( size );
+
+        vector< ptr< BlockProposalFragment > > fragments;
+
+        for ( uint64_t j = 1; j <= totalFragments; j++ ) {
+            fragments.push_back( block->getFragment( totalFragments, j ) );
+        }
+
+        // data and parity fragments for all nodes
+        BENCHMARK( sized( "CommittedBlock fragment", size, "tx" ) ) {
+            auto copy = copyBlock( block, block->getBlockID() );
+            for ( uint64_t j = 1; j <= totalFragments; j++ ) {
+                copy->getFragment( totalFragments, j );
+            }
+        }
+
+        auto defragment = [&]( uint64_t _firstFragment ) {
+            auto list =
+                make_shared< BlockProposalFragmentList >( block->getBlockID(), totalFragments );
+            uint64_t next = 0;
+            for ( uint64_t j = _firstFragment; j < _firstFragment + dataFragments; j++ ) {
+                list->addFragment( fragments.at( j - 1 ), next );
+            }
+            CHECK_STATE( list->isComplete() );
+            CommittedBlock::defragment( list, cryptoManager );
+        };
+
+        BENCHMARK( sized( "CommittedBlock defragment from data fragments", size, "tx" ) ) {
+            defragment( 1 );
+        }
+
+        // the node that holds the first data fragment is down, a parity fragment is decoded
+        BENCHMARK( sized( "CommittedBlock defragment with parity fragment", size, "tx" ) ) {
+            defragment( 2 );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Network message encode/parse", "[bench][message-bench]" ) {
+    auto eddsaKey = OpenSSLEdDSAKey::generateKey();
+    auto ecdsaKey = OpenSSLECDSAKey::generateKey();
+
+    // mockup and real session signatures differ in size
+    vector< tuple< string, string, string, string > > signatures = {
+        { "mockup sig", hash->toHex(), "", "" },
+        { "EdDSA sig", eddsaKey->sign( ( const char* ) hash->data() ),
+            eddsaKey->serializePubKey(), ecdsaKey->sign( ( const char* ) hash->data() ) } };
+
+    for ( auto&& [name, sig, publicKey, pkSig] : signatures ) {
+        auto message = make_shared< BVBroadcastMessage >( node_id( 2 ), block_id( 1 ),
+            schain_index( 1 ), bin_consensus_round( 1 ), bin_consensus_value( 1 ),
+            BENCH_TIME_STAMP * 1000, schain_id( 1 ), msg_id( 1 ), schain_index( 2 ), sig,
+            publicKey, pkSig, &chain );
+
+        auto serialized = message->serializeToString();
+
+        BENCHMARK( sized( "NetworkMessage encode, " + name, serialized.size(), "bytes" ) ) {
+            message->serializeToString();
+        }
+
+        BENCHMARK( sized( "NetworkMessage parse, " + name, serialized.size(), "bytes" ) ) {
+            NetworkMessage::parseMessage( serialized, &chain );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "LevelDB read/write/prefix scan", "[bench][db-bench]" ) {
+    int i = system( "rm -rf /tmp/consensus_bench_*" );
+    i++;  // make compiler happy
+
+    string dirName = "/tmp";
+    string blocksPrefix = "consensus_bench_blocks";
+    string messagesPrefix = "consensus_bench_messages";
+
+    auto blockDB =
+        make_shared< BlockDB >( &chain, dirName, blocksPrefix, node_id( 1 ), BENCH_DB_MAX_SIZE );
+
+    uint64_t blockID = 0;
+
+    for ( auto size : BENCH_BLOCK_SIZES ) {
+        auto block = createBlock( size );
+
+        // every iteration saves a new block
+        BENCHMARK( sized( "BlockDB write", size, "tx" ) ) {
+            blockDB->saveBlock( copyBlock( block, block_id( ++blockID ) ) );
+        }
+
+        auto lastSaved = block_id( blockID );
+
+        BENCHMARK( sized( "BlockDB read", size, "tx" ) ) {
+            blockDB->getSerializedBlockFromLevelDB( lastSaved );
+        }
+    }
+
+    auto msgDB =
+        make_shared< MsgDB >( &chain, dirName, messagesPrefix, node_id( 1 ), BENCH_DB_MAX_SIZE );
+
+    // ids of the same length, so that the prefix of one block does not match another block
+    uint64_t messagesBlockID = 100000;
+
+    for ( auto count : BENCH_MESSAGE_COUNTS ) {
+        messagesBlockID++;
+
+        for ( uint64_t j = 1; j <= count; j++ ) {
+            msgDB->saveMsg( make_shared< BVBroadcastMessage >( node_id( 2 ),
+                block_id( messagesBlockID ), schain_index( 1 ), bin_consensus_round( j ),
+                bin_consensus_value( 1 ), BENCH_TIME_STAMP * 1000, schain_id( 1 ), msg_id( j ),
+                schain_index( 2 ), hash->toHex(), "", "", &chain ) );
+        }
+
+        auto prefix = msgDB->getFormatVersion() + ":" + to_string( messagesBlockID );
+
+        BENCHMARK( sized( "MsgDB prefix scan", count, "messages" ) ) {
+            auto messages = msgDB->readPrefixRange( prefix );
+            CHECK_STATE( messages && messages->size() == count );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Mockup and real signatures", "[bench][crypto-bench]" ) {
+    auto hashBytes = make_shared< array< uint8_t, HASH_LEN > >( hash->getHash() );
+
+    // mockup ECDSA and EdDSA signatures are the hash itself
+
+    auto proposal = make_shared< BlockProposal >( schain_id( 1 ), node_id( 1 ), block_id( 1 ),
+        schain_index( 1 ), createList( 1 ), u256( 2 ), BENCH_TIME_STAMP, 1, "", cryptoManager );
+
+    BENCHMARK( "Mockup ECDSA sign" ) { cryptoManager->signProposal( proposal.get() ); }
+
+    BENCHMARK( "Mockup ECDSA verify" ) {
+        CHECK_STATE( cryptoManager->verifyProposalECDSA(
+            proposal, proposal->getHash()->toHex(), proposal->getSignature() ) );
+    }
+
+    auto message = make_shared< BVBroadcastMessage >( node_id( 2 ), block_id( 1 ),
+        schain_index( 1 ), bin_consensus_round( 1 ), bin_consensus_value( 1 ),
+        BENCH_TIME_STAMP * 1000, schain_id( 1 ), msg_id( 1 ), schain_index( 2 ), "unsigned", "",
+        "", &chain );
+
+    BENCHMARK( "Mockup EdDSA sign" ) { message->sign( cryptoManager ); }
+
+    BENCHMARK( "Mockup EdDSA verify" ) { message->verify( cryptoManager ); }
+
+    auto ecdsaKey = OpenSSLECDSAKey::generateKey();
+    auto ecdsaSig = ecdsaKey->sign( ( const char* ) hash->data() );
+
+    BENCHMARK( "ECDSA sign" ) { ecdsaKey->sign( ( const char* ) hash->data() ); }
+
+    BENCHMARK( "ECDSA verify" ) {
+        CHECK_STATE( ecdsaKey->verifySig( ecdsaSig, ( const char* ) hash->data() ) );
+    }
+
+    auto eddsaKey = OpenSSLEdDSAKey::generateKey();
+    auto eddsaSig = eddsaKey->sign( ( const char* ) hash->data() );
+
+    BENCHMARK( "EdDSA sign" ) { eddsaKey->sign( ( const char* ) hash->data() ); }
+
+    BENCHMARK( "EdDSA verify" ) {
+        CHECK_STATE( eddsaKey->verifySig( eddsaSig, ( const char* ) hash->data() ) );
+    }
+
+    for ( auto nodes : BENCH_NODE_COUNTS ) {
+        auto required = requiredSignersFor( nodes );
+
+        BENCHMARK( sized( "Mockup threshold sign and merge", nodes, "nodes" ) ) {
+            MockupSigShareSet set( block_id( 1 ), nodes, required );
+            for ( uint64_t j = 1; j <= required; j++ ) {
+                set.addSigShare( make_shared< MockupSigShare >( hash->toHex(), schain_id( 1 ),
+                    block_id( 1 ), schain_index( j ), nodes, required ) );
+            }
+            CHECK_STATE( set.mergeSignature()->toString() == hash->toHex() );
+        }
+
+        auto keys = BLSPrivateKeyShare::generateSampleKeys( required, nodes );
+        auto privateKeys = keys.first;
+        auto publicKey = keys.second;
+
+        vector< ptr< BLSSigShare > > shares;
+
+        for ( uint64_t j = 1; j <= required; j++ ) {
+            shares.push_back( privateKeys->at( j - 1 )->signWithHelper( hashBytes, j ) );
+        }
+
+        BENCHMARK( sized( "BLS sign share", nodes, "nodes" ) ) {
+            privateKeys->at( 0 )->signWithHelper( hashBytes, 1 );
+        }
+
+        BENCHMARK( sized( "BLS merge", nodes, "nodes" ) ) {
+            BLSSigShareSet set( required, nodes );
+            for ( auto&& share : shares ) {
+                set.addSigShare( share );
+            }
+            set.merge();
+        }
+
+        BLSSigShareSet set( required, nodes );
+        for ( auto&& share : shares ) {
+            set.addSigShare( share );
+        }
+        auto signature = set.merge();
+
+        BENCHMARK( sized( "BLS verify", nodes, "nodes" ) ) {
+            CHECK_STATE( publicKey->VerifySigWithHelper( hashBytes, signature, required, nodes ) );
+        }
+    }
+}
+
+
+TEST_CASE_METHOD( BenchFixture, "Monitored scope", "[bench][monitor-bench]" ) {
+    auto site = MonitorSite::get( "ConsensusBench", "scope" );
+
+    BENCHMARK( "LivelinessMonitor enter and exit" ) {
+        LivelinessMonitor monitor( &chain, site, 2000 );
+    }
+
+    BENCHMARK( "Watchdog sample of all threads" ) {
+        CHECK_STATE( ThreadScopes::findStuck( &chain, Time::getSteadyTimeUs() ).empty() );
+    }
+}
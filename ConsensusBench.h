@@ -0,0 +1,43 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ConsensusBench.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+// Microbenchmarks of serialization, hashing, DB and signature primitives.
+// Every benchmark runs for several sizes so that a regression shows up at the size it affects.
+
+// transactions in a block
+static constexpr uint64_t BENCH_BLOCK_SIZES[] = { 1, 100, 1000, 10000 };
+
+// bytes in a transaction
+static constexpr uint64_t BENCH_TRANSACTION_SIZES[] = { 32, 200, 1000, 10000 };
+
+static constexpr uint64_t BENCH_TRANSACTION_SIZE = 200;
+
+// nodes in a chain, sig shares of all of them are merged
+static constexpr uint64_t BENCH_NODE_COUNTS[] = { 4, 16 };
+
+// network messages of one block in the message DB
+static constexpr uint64_t BENCH_MESSAGE_COUNTS[] = { 16, 256, 4096 };
+
+static constexpr uint64_t BENCH_DB_MAX_SIZE = 1000000000;
@@ -0,0 +1,217 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Consensusb.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+#include "thirdparty/json.hpp"
+
+#include "chains/Schain.h"
+#include "monitoring/LatencyHistogram.h"
+#include "monitoring/LivelinessMonitor.h"
+#include "monitoring/StageMetrics.h"
+#include "network/InProcessNetwork.h"
+#include "network/Transport.h"
+#include "node/ConsensusEngine.h"
+#include "node/Node.h"
+#include "pendingqueue/TestMessageGeneratorAgent.h"
+#include "utils/Time.h"
+
+#include "Consensusb.h"
+
+
+static void usage() {
+    cerr << "Usage: consensusb nodes_dir [--time-ms N] [--tps N] [--tx-size N] [--latency-us N]"
+            " [--jitter-us N] [--loss-ppm N] [--bandwidth N] [--seed N] [--zmq]"
+            " [--transport zmq|in_process|shared_memory] [--out FILE]"
+         << endl;
+    exit( 1 );
+}
+
+
+static nlohmann::json quantilesToJSON( const LatencyHistogram& _h ) {
+    auto result = nlohmann::json::object();
+    result["count"] = _h.getCount();
+    result["p50Us"] = _h.getQuantile( 0.5 );
+    result["p99Us"] = _h.getQuantile( 0.99 );
+    result["maxUs"] = _h.getMax();
+    return result;
+}
+
+
+int main( int argc, char** argv ) {
+    signal( SIGPIPE, SIG_IGN );
+
+    if ( argc < 2 )
+        usage();
+
+    uint64_t runningTimeMs = DEFAULT_BENCH_TIME_MS;
+    uint64_t transactionsPerSecond = 0;
+    uint64_t transactionSize = DEFAULT_BENCH_TRANSACTION_SIZE;
+    uint64_t seed = 1;
+    auto transport = TransportType::IN_PROCESS;
+    string outFile;
+    InProcessNetwork::LinkProfile link;
+
+    for ( int i = 2; i < argc; i++ ) {
+        string option( argv[i] );
+
+        if ( option == "--zmq" ) {
+            transport = TransportType::ZMQ;
+            continue;
+        }
+
+        if ( i + 1 >= argc )
+            usage();
+
+        string value( argv[++i] );
+
+        if ( option == "--out" ) {
+            outFile = value;
+            continue;
+        }
+
+        if ( option == "--transport" ) {
+            transport = Transport::parseType( value );
+            continue;
+        }
+
+        auto number = static_cast< uint64_t >( stoull( value ) );
+
+        if ( option == "--time-ms" ) {
+            runningTimeMs = number;
+        } else if ( option == "--tps" ) {
+            transactionsPerSecond = number;
+        } else if ( option == "--tx-size" ) {
+            transactionSize = number;
+        } else if ( option == "--latency-us" ) {
+            link.latencyUs = number;
+        } else if ( option == "--jitter-us" ) {
+            link.jitterUs = number;
+        } else if ( option == "--loss-ppm" ) {
+            link.lossPpm = number;
+        } else if ( option == "--bandwidth" ) {
+            link.bandwidthBytesPerSec = number;
+        } else if ( option == "--seed" ) {
+            seed = number;
+        } else {
+            usage();
+        }
+    }
+
+    // start from scratch, as the tests do
+    int i = system( "rm -rf /tmp/*.db.*" );
+    i = system( "rm -rf /tmp/*.db" );
+    i++;  // make compiler happy
+
+    TestMessageGeneratorAgent::setLoad( transactionsPerSecond, transactionSize );
+    InProcessNetwork::setSeed( seed );
+    InProcessNetwork::setDefaultLinkProfile( link );
+
+    if ( link.latencyUs > 0 || link.jitterUs > 0 || link.lossPpm > 0 ||
+         link.bandwidthBytesPerSec > 0 ) {
+        cerr << "consensusb: the link profile applies to consensus messages only, proposals,"
+                " finalization and catchup are not shaped"
+             << endl;
+    }
+
+    fs_path dirPath( boost::filesystem::system_complete( fs_path( argv[1] ) ) );
+
+    auto engine = make_shared< ConsensusEngine >();
+
+    engine->parseTestConfigsAndCreateAllNodes( dirPath );
+
+    // node configs select a transport while they are parsed, the network is created when
+    // nodes start
+    Network::setTransport( transport );
+
+    engine->slowStartBootStrapTest();
+
+    auto nodes = engine->getNodes();
+    CHECK_STATE( !nodes.empty() );
+
+    auto startBlockID = ( uint64_t ) nodes.front()->getSchain()->getLastCommittedBlockID();
+    auto startTransactions = nodes.front()->getSchain()->getTotalTransactions();
+    auto startUs = Time::getSteadyTimeUs();
+
+    usleep( runningTimeMs * 1000 );
+
+    auto elapsedUs = Time::getSteadyTimeUs() - startUs;
+    auto blocks = ( uint64_t ) nodes.front()->getSchain()->getLastCommittedBlockID() - startBlockID;
+    auto transactions = nodes.front()->getSchain()->getTotalTransactions() - startTransactions;
+
+    // commit latency of all nodes
+    LatencyHistogram commitLatency;
+    array< LatencyHistogram, STAGE_COUNT > stages;
+
+    for ( auto&& node : nodes ) {
+        auto metrics = node->getSchain()->getStageMetrics();
+        commitLatency.merge( metrics->getStage( STAGE_BLOCK_COMMIT ) );
+        for ( uint64_t s = 0; s < STAGE_COUNT; s++ ) {
+            stages[s].merge( metrics->getStage( block_stage( s ) ) );
+        }
+    }
+
+    engine->exitGracefullyBlocking();
+
+    auto result = nlohmann::json::object();
+    result["engineVersion"] = ConsensusEngine::getEngineVersion();
+    result["config"] = dirPath.filename().string();
+    result["transport"] = Transport::getTypeName( transport );
+    result["nodes"] = nodes.size();
+    result["timeMs"] = elapsedUs / 1000;
+    result["load"]["tps"] = transactionsPerSecond;
+    result["load"]["txSize"] = transactionSize;
+    result["link"]["latencyUs"] = link.latencyUs;
+    result["link"]["jitterUs"] = link.jitterUs;
+    result["link"]["lossPpm"] = link.lossPpm;
+    result["link"]["bandwidthBytesPerSec"] = link.bandwidthBytesPerSec;
+    result["link"]["seed"] = seed;
+    // the link profile shapes consensus messages only. Proposals, block finalization and
+    // catchup use the request/response channel of the transport, which is not shaped
+    result["link"]["shapedChannels"] = { "consensus" };
+    result["link"]["unshapedChannels"] = { "proposal", "finalize", "catchup" };
+    result["blocks"] = blocks;
+    result["blocksPerSec"] = blocks * 1000000.0 / elapsedUs;
+    result["transactions"] = transactions;
+    result["tps"] = transactions * 1000000.0 / elapsedUs;
+    result["commitLatency"] = quantilesToJSON( commitLatency );
+
+    for ( uint64_t s = 0; s < STAGE_COUNT; s++ ) {
+        result["stages"][StageMetrics::getStageName( block_stage( s ) )] =
+            quantilesToJSON( stages[s] );
+    }
+
+    result["scopes"] = MonitorSite::allToJSON();
+
+    auto output = result.dump();
+
+    if ( !outFile.empty() ) {
+        ofstream f( outFile, ios::trunc );
+        f << output << endl;
+    }
+
+    cout << output << endl;
+
+    return 0;
+}
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2018-2019 SKALE Labs
+    Copyright (C) 2021 SKALE Labs
 
     This file is part of skale-consensus.
 
@@ -16,23 +16,15 @@
     You should have received a copy of the GNU Affero General Public License
     along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
 
-    @file TimeoutThreadPool.h
+    @file Consensusb.h
     @author Stan Kladko
-    @date 2020
+    @date 2021
 */
 
 #pragma once
 
-#include <cstdint>
+// Runs all nodes of a test config in one process for a while and prints
+// blocks/s, TPS and commit latency as one JSON line, so runs can be compared across versions.
 
-#include "threads/WorkerThreadPool.h"
-
-class TimeoutThreadPool : public WorkerThreadPool {
-
-public:
-
-    TimeoutThreadPool(num_threads _numThreads, Agent* _agent);
-
-    void createThread(uint64_t _number) override;
-
-};
+#define DEFAULT_BENCH_TIME_MS 30000
+#define DEFAULT_BENCH_TRANSACTION_SIZE 200
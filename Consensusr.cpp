@@ -0,0 +1,373 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Consensusr.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+#include "thirdparty/json.hpp"
+
+#include "chains/Schain.h"
+#include "crypto/BLAKE3Hash.h"
+#include "crypto/CryptoManager.h"
+#include "crypto/ThresholdSignature.h"
+#include "datastructures/BlockProposal.h"
+#include "datastructures/DAProof.h"
+#include "db/BlockProposalDB.h"
+#include "db/ProposalHashDB.h"
+#include "monitoring/MessageTrace.h"
+#include "monitoring/StageMetrics.h"
+#include "network/ReplayNetwork.h"
+#include "node/ConsensusEngine.h"
+#include "node/Node.h"
+#include "utils/Time.h"
+
+#include "Consensusr.h"
+
+
+static void usage() {
+    cerr << "Usage: consensusr nodes_dir trace_file [--real-time] [--stall-ms N] [--out FILE]"
+         << endl;
+    exit( 1 );
+}
+
+
+void ReplayExtFace::addPendingTransactions(
+    transactions_vector&& _transactions, const u256& _stateRoot ) {
+    lock_guard< mutex > lock( m );
+    pending.emplace( move( _transactions ), _stateRoot );
+}
+
+
+void ReplayExtFace::addExpectedBlock( uint64_t _blockID, const ptr< TraceCreatedBlock >& _block ) {
+    CHECK_ARGUMENT( _block );
+    lock_guard< mutex > lock( m );
+    expectedBlocks[_blockID] = _block;
+}
+
+
+ConsensusExtFace::transactions_vector ReplayExtFace::pendingTransactions(
+    size_t, u256& _stateRoot ) {
+    lock_guard< mutex > lock( m );
+
+    if ( pending.empty() )
+        return {};
+
+    auto result = move( pending.front().first );
+    _stateRoot = pending.front().second;
+    pending.pop();
+
+    return result;
+}
+
+
+void ReplayExtFace::createBlock( const transactions_vector& _approvedTransactions,
+    uint64_t _timeStamp, uint32_t _timeStampMillis, uint64_t _blockID, u256 _gasPrice,
+    u256 _stateRoot, uint64_t _winningNodeIndex ) {
+    transactions_view view;
+
+    for ( auto&& transaction : _approvedTransactions ) {
+        view.push_back( { transaction.data(), transaction.size() } );
+    }
+
+    createBlockFromView( view, _timeStamp, _timeStampMillis, _blockID, _gasPrice, _stateRoot,
+        _winningNodeIndex );
+}
+
+
+void ReplayExtFace::createBlockFromView( const transactions_view& _approvedTransactions,
+    uint64_t _timeStamp, uint32_t _timeStampMillis, uint64_t _blockID, u256, u256,
+    uint64_t _winningNodeIndex ) {
+    createdBlocks++;
+
+    ptr< TraceCreatedBlock > expected;
+
+    {
+        lock_guard< mutex > lock( m );
+        auto it = expectedBlocks.find( _blockID );
+        if ( it == expectedBlocks.end() )
+            return;
+        expected = it->second;
+    }
+
+    if ( expected->proposerIndex != _winningNodeIndex ||
+         expected->transactionCount != _approvedTransactions.size() ||
+         expected->timeStampS != _timeStamp || expected->timeStampMs != _timeStampMillis ) {
+        mismatchedBlocks++;
+        LOG( warn, "Replayed block " + to_string( _blockID ) + " differs from the trace" );
+    }
+}
+
+
+uint64_t ReplayExtFace::getCreatedBlocks() const {
+    return createdBlocks;
+}
+
+
+uint64_t ReplayExtFace::getMismatchedBlocks() const {
+    return mismatchedBlocks;
+}
+
+
+// Own proposals are taken from the trace, so the node proposes what it proposed then.
+// Created blocks are known before the replay, so each one can be checked when it is created.
+static void preloadTrace(
+    const string& _traceFile, const ptr< Node >& _node, ReplayExtFace& _extFace ) {
+    TraceReader reader( _traceFile );
+    TraceRecord record;
+
+    auto cryptoManager = _node->getSchain()->getCryptoManager();
+    auto ownIndex = _node->getSchain()->getSchainIndex();
+
+    while ( reader.next( record ) ) {
+        if ( record.type == TRACE_CREATE_BLOCK ) {
+            _extFace.addExpectedBlock( record.blockID,
+                make_shared< TraceCreatedBlock >( TraceReader::decodeCreateBlock( record.data ) ) );
+            continue;
+        }
+
+        if ( record.type != TRACE_PROPOSAL )
+            continue;
+
+        auto proposal = BlockProposal::deserialize(
+            make_shared< vector< uint8_t > >( record.data.begin(), record.data.end() ),
+            cryptoManager );
+
+        if ( proposal->getProposerIndex() != ownIndex )
+            continue;
+
+        _node->getBlockProposalDB()->addBlockProposal( proposal );
+        _node->getProposalHashDB()->checkAndSaveHash(
+            proposal->getBlockID(), ownIndex, proposal->getHash()->toHex() );
+    }
+}
+
+
+static void replayDAProof( const TraceRecord& _record, Schain& _sChain ) {
+    auto decoded = TraceReader::decodeDAProof( _record.data );
+
+    auto proposal = _sChain.getBlockProposal(
+        block_id( _record.blockID ), schain_index( decoded.proposerIndex ) );
+
+    // the block is already committed
+    if ( !proposal )
+        return;
+
+    auto sig = _sChain.getCryptoManager()->verifyDAProofThresholdSig(
+        BLAKE3Hash::fromHex( decoded.hash ), decoded.signature, block_id( _record.blockID ) );
+
+    _sChain.daProofArrived( make_shared< DAProof >( proposal, sig ) );
+}
+
+
+int main( int argc, char** argv ) {
+    signal( SIGPIPE, SIG_IGN );
+
+    if ( argc < 3 )
+        usage();
+
+    string traceFile( argv[2] );
+    bool realTime = false;
+    uint64_t stallMs = DEFAULT_REPLAY_STALL_MS;
+    string outFile;
+
+    for ( int i = 3; i < argc; i++ ) {
+        string option( argv[i] );
+
+        if ( option == "--real-time" ) {
+            realTime = true;
+            continue;
+        }
+
+        if ( i + 1 >= argc )
+            usage();
+
+        string value( argv[++i] );
+
+        if ( option == "--out" ) {
+            outFile = value;
+        } else if ( option == "--stall-ms" ) {
+            stallMs = static_cast< uint64_t >( stoull( value ) );
+        } else {
+            usage();
+        }
+    }
+
+    TraceReader reader( traceFile );
+    auto header = reader.getHeader();
+
+    CHECK_STATE2( header.startBlockID == 0,
+        "Replay starts from an empty database, capture the trace from the first block" );
+
+    // start from scratch, as the tests do
+    int i = system( "rm -rf /tmp/*.db.*" );
+    i = system( "rm -rf /tmp/*.db" );
+    i++;  // make compiler happy
+
+    ReplayExtFace extFace;
+
+    fs_path dirPath( boost::filesystem::system_complete( fs_path( argv[1] ) ) );
+
+    auto engine = make_shared< ConsensusEngine >( extFace, 0, 0, 0 );
+
+    engine->getNodeIDs().insert( node_id( header.nodeID ) );
+
+    engine->parseTestConfigsAndCreateAllNodes( dirPath );
+
+    Network::setTransport( TransportType::REPLAY );
+
+    auto nodes = engine->getNodes();
+    CHECK_STATE2( nodes.size() == 1, "No config for node " + to_string( header.nodeID ) );
+
+    auto node = nodes.front();
+    auto sChain = node->getSchain();
+
+    CHECK_STATE2( ( uint64_t ) sChain->getSchainIndex() == header.schainIndex &&
+                      ( uint64_t ) sChain->getNodeCount() == header.nodeCount,
+        "The node config does not match the trace" );
+
+    preloadTrace( traceFile, node, extFace );
+
+    node->startServers();
+    node->startClients();
+    sChain->bootstrap( 0, 0, 0 );
+
+    auto network = dynamic_pointer_cast< ReplayNetwork >( node->getNetwork() );
+    CHECK_STATE( network );
+
+    map< string, uint64_t > records;
+    uint64_t lastBlockID = 0;
+    uint64_t stalls = 0;
+    uint64_t errors = 0;
+
+    auto startUs = Time::getSteadyTimeUs();
+
+    // waits until the node needs the records of a block, or until it does not move anymore
+    auto waitForBlock = [&]( uint64_t _blockID ) {
+        auto committed = ( uint64_t ) sChain->getLastCommittedBlockID();
+        auto progressUs = Time::getSteadyTimeUs();
+
+        while ( committed + 1 < _blockID && !node->isExitRequested() ) {
+            usleep( 100 );
+
+            if ( ( uint64_t ) sChain->getLastCommittedBlockID() > committed ) {
+                committed = ( uint64_t ) sChain->getLastCommittedBlockID();
+                progressUs = Time::getSteadyTimeUs();
+            } else if ( Time::getSteadyTimeUs() - progressUs > stallMs * 1000 ) {
+                LOG( warn, "Replay stalled before block " + to_string( committed + 1 ) );
+                stalls++;
+                return;
+            }
+        }
+    };
+
+    TraceRecord record;
+
+    while ( reader.next( record ) && !node->isExitRequested() ) {
+        if ( realTime ) {
+            auto nowUs = Time::getSteadyTimeUs() - startUs;
+            if ( record.timeUs > nowUs )
+                usleep( record.timeUs - nowUs );
+        } else {
+            waitForBlock( record.blockID );
+        }
+
+        lastBlockID = max( lastBlockID, record.blockID );
+
+        try {
+            switch ( record.type ) {
+            case TRACE_NETWORK_MESSAGE:
+                records["networkMessages"]++;
+                network->deliver( move( record.data ) );
+                break;
+            case TRACE_PROPOSAL: {
+                records["proposals"]++;
+                auto proposal = BlockProposal::deserialize(
+                    make_shared< vector< uint8_t > >( record.data.begin(), record.data.end() ),
+                    sChain->getCryptoManager() );
+                if ( proposal->getProposerIndex() != sChain->getSchainIndex() )
+                    sChain->proposedBlockArrived( proposal );
+                break;
+            }
+            case TRACE_DA_PROOF:
+                records["daProofs"]++;
+                replayDAProof( record, *sChain );
+                break;
+            case TRACE_PENDING_TRANSACTIONS: {
+                records["pendingTransactions"]++;
+                u256 stateRoot;
+                auto transactions =
+                    TraceReader::decodePendingTransactions( record.data, stateRoot );
+                extFace.addPendingTransactions( move( transactions ), stateRoot );
+                break;
+            }
+            case TRACE_CREATE_BLOCK:
+                // loaded before the replay
+                records["createBlocks"]++;
+                break;
+            default:
+                BOOST_THROW_EXCEPTION(
+                    FatalError( "Unknown trace record type " + to_string( record.type ) ) );
+            }
+        } catch ( FatalError& ) {
+            throw;
+        } catch ( exception& e ) {
+            errors++;
+            SkaleException::logNested( e );
+        }
+    }
+
+    // let the node finish the last block of the trace
+    waitForBlock( lastBlockID + 1 );
+
+    auto elapsedUs = Time::getSteadyTimeUs() - startUs;
+    auto blocks = ( uint64_t ) sChain->getLastCommittedBlockID();
+
+    auto result = nlohmann::json::object();
+    result["engineVersion"] = ConsensusEngine::getEngineVersion();
+    result["trace"] = traceFile;
+    result["nodeID"] = header.nodeID;
+    result["mode"] = realTime ? "real_time" : "full_speed";
+    result["timeMs"] = elapsedUs / 1000;
+    result["records"] = records;
+    result["errors"] = errors;
+    result["stalls"] = stalls;
+    result["blocks"] = blocks;
+    result["blocksPerSec"] = blocks * 1000000.0 / elapsedUs;
+    result["createdBlocks"] = extFace.getCreatedBlocks();
+    result["mismatchedBlocks"] = extFace.getMismatchedBlocks();
+    result["stages"] = sChain->getStageMetrics()->toJSON()["stages"];
+
+    engine->exitGracefullyBlocking();
+
+    auto output = result.dump();
+
+    if ( !outFile.empty() ) {
+        ofstream f( outFile, ios::trunc );
+        f << output << endl;
+    }
+
+    cout << output << endl;
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Consensusr.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "node/ConsensusInterface.h"
+
+class TraceCreatedBlock;
+
+// Replays a trace captured with traceDir on the node of the trace, from a fresh database, and
+// prints how fast the node got through it as one JSON line. Nothing is sent to other nodes,
+// so the consensus CPU cost can be profiled on production traffic without a network.
+
+#define DEFAULT_REPLAY_STALL_MS 10000
+
+
+// Serves the pending transactions of the trace and checks the created blocks against it
+
+class ReplayExtFace : public ConsensusExtFace {
+
+    mutex m;
+
+    queue< pair< transactions_vector, u256 > > pending;
+
+    map< uint64_t, ptr< TraceCreatedBlock > > expectedBlocks;
+
+    atomic< uint64_t > createdBlocks = 0;
+
+    atomic< uint64_t > mismatchedBlocks = 0;
+
+public:
+
+    void addPendingTransactions( transactions_vector&& _transactions, const u256& _stateRoot );
+
+    void addExpectedBlock( uint64_t _blockID, const ptr< TraceCreatedBlock >& _block );
+
+    transactions_vector pendingTransactions( size_t _limit, u256& _stateRoot ) override;
+
+    void createBlock( const transactions_vector& _approvedTransactions, uint64_t _timeStamp,
+        uint32_t _timeStampMillis, uint64_t _blockID, u256 _gasPrice, u256 _stateRoot,
+        uint64_t _winningNodeIndex ) override;
+
+    void createBlockFromView( const transactions_view& _approvedTransactions, uint64_t _timeStamp,
+        uint32_t _timeStampMillis, uint64_t _blockID, u256 _gasPrice, u256 _stateRoot,
+        uint64_t _winningNodeIndex ) override;
+
+    uint64_t getCreatedBlocks() const;
+
+    uint64_t getMismatchedBlocks() const;
+};
@@ -40,6 +40,7 @@
 #include "iostream"
 #include "time.h"
 #include "crypto/BLAKE3Hash.h"
+#include "blockfinalize/client/BlockFinalizeDownloader.h"
 
 #include "json/JSONFactory.h"
 
@@ -25,6 +25,13 @@
 
 #define DEFAULT_RUNNING_TIME_MS 50000
 #define STUCK_TEST_TIME 5
+#define CATCHUP_TEST_BLOCKS 10000
+#define CATCHUP_TEST_TIMEOUT_S 3600
+#define SUBMIT_TEST_TRANSACTIONS 20000
+#define SUBMIT_TEST_BATCH 100
+#define SUBMIT_TEST_TIMEOUT_S 600
+// simulateNetworkWriteDelayMs of node4 in test/fournodes_slow_peer
+#define SLOW_PEER_DELAY_MS 3000
 
 class Consensust {
 
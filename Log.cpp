@@ -63,29 +63,18 @@ level_enum SkaleLog::logLevelFromString(string &_s) {
 }
 
 shared_ptr<spdlog::logger> SkaleLog::loggerForClass(const char *_s) {
-    string key;
-
-    if (strstr(_s, "Proposal"))
-        key = "Proposal";
-    if (strstr(_s, "Catchup"))
-        key = "Catchup";
-
-    if (strstr(_s, "Pending"))
-        key = "Pending";
-    if (strstr(_s, "Consensus"))
-        key = "Consensus";
-    if (strstr(_s, "Protocol"))
-        key = "Consensus";
-    if (strstr(_s, "Header"))
-        key = "Datastructures";
-    if (strstr(_s, "Network"))
-        key = "Net";
-
-    if (key == "")
-        key = "Main";
-
-    CHECK_STATE(loggers.count(key) > 0);
-    return loggers[key];
+    CHECK_ARGUMENT(_s);
+    auto logger = categoryLoggers[categoryForClass(_s)];
+    CHECK_STATE(logger);
+    return logger;
+}
+
+
+uint64_t SkaleLog::getBlockIDForLog() {
+    CHECK_STATE(logThreadLocal_);
+    auto engine = logThreadLocal_->getEngine();
+    CHECK_STATE(engine);
+    return (uint64_t) engine->getLargestCommittedBlockID();
 }
 
 SkaleLog::SkaleLog(node_id _nodeID, ConsensusEngine* _engine) {
@@ -119,6 +108,14 @@ SkaleLog::SkaleLog(node_id _nodeID, ConsensusEngine* _engine) {
     loggers["Datastructures"] = dataStructuresLogger;
     pendingQueueLogger = _engine->createLogger(prefix + "pending");
     loggers["Pending"] = pendingQueueLogger;
+
+    categoryLoggers[LOG_MAIN] = mainLogger;
+    categoryLoggers[LOG_PROPOSAL] = proposalLogger;
+    categoryLoggers[LOG_CATCHUP] = catchupLogger;
+    categoryLoggers[LOG_PENDING] = pendingQueueLogger;
+    categoryLoggers[LOG_CONSENSUS] = consensusLogger;
+    categoryLoggers[LOG_DATASTRUCTURES] = dataStructuresLogger;
+    categoryLoggers[LOG_NET] = netLogger;
 }
 
 
@@ -52,8 +52,44 @@ class logger;
 
 #define __CLASS_NAME__ className( __PRETTY_FUNCTION__ )
 
-#define LOG( __SEVERITY__, __MESSAGE__ ) \
-    ConsensusEngine::log( __SEVERITY__, __MESSAGE__, className( __PRETTY_FUNCTION__ ) )
+// The logger is picked at compile time from the class name and the level is checked
+// before the message is evaluated, so disabled LOG lines cost one comparison
+
+#define __LOG_CATEGORY__ SkaleLog::categoryForClass( classNameView( __PRETTY_FUNCTION__ ) )
+
+#define LOG( __SEVERITY__, __MESSAGE__ )                                                   \
+    do {                                                                                   \
+        static constexpr log_category __logCategory__ = __LOG_CATEGORY__;                  \
+        if ( auto __logger__ = SkaleLog::enabledLogger( __SEVERITY__, __logCategory__ ) ) \
+            ConsensusEngine::log( __logger__, __SEVERITY__, __MESSAGE__ );                 \
+    } while ( 0 )
+
+// fmt-style LOG, the arguments are formatted by spdlog only if the level is enabled,
+// __FORMAT__ has to be a string literal
+#define LOGF( __SEVERITY__, __FORMAT__, ... )                                              \
+    do {                                                                                   \
+        static constexpr log_category __logCategory__ = __LOG_CATEGORY__;                  \
+        if ( auto __logger__ = SkaleLog::enabledLogger( __SEVERITY__, __logCategory__ ) ) { \
+            if ( logThreadLocal_ ) {                                                       \
+                __logger__->log( __SEVERITY__, "{}:" __FORMAT__, SkaleLog::getBlockIDForLog(), \
+                    ##__VA_ARGS__ );                                                       \
+            } else {                                                                       \
+                __logger__->log( __SEVERITY__, __FORMAT__, ##__VA_ARGS__ );                \
+            }                                                                              \
+        }                                                                                  \
+    } while ( 0 )
+
+
+enum log_category {
+    LOG_MAIN = 0,
+    LOG_PROPOSAL,
+    LOG_CATCHUP,
+    LOG_PENDING,
+    LOG_CONSENSUS,
+    LOG_DATASTRUCTURES,
+    LOG_NET,
+    LOG_CATEGORY_COUNT
+};
 
 
 class SkaleLog {
@@ -68,6 +104,8 @@ class SkaleLog {
     shared_ptr< spdlog::logger > mainLogger, proposalLogger, consensusLogger, catchupLogger,
         netLogger, dataStructuresLogger, pendingQueueLogger;
 
+    array< shared_ptr< spdlog::logger >, LOG_CATEGORY_COUNT > categoryLoggers;
+
 public:
 
     ConsensusEngine *getEngine() const;
@@ -86,6 +124,42 @@ public:
 
     shared_ptr< spdlog::logger > loggerForClass( const char* _className );
 
+    spdlog::logger* loggerForCategory( log_category _category ) const {
+        return categoryLoggers[_category].get();
+    }
+
+    static constexpr log_category categoryForClass( string_view _className ) {
+        // the last match wins
+        auto category = LOG_MAIN;
+
+        if ( _className.find( "Proposal" ) != string_view::npos )
+            category = LOG_PROPOSAL;
+        if ( _className.find( "Catchup" ) != string_view::npos )
+            category = LOG_CATCHUP;
+        if ( _className.find( "Pending" ) != string_view::npos )
+            category = LOG_PENDING;
+        if ( _className.find( "Consensus" ) != string_view::npos )
+            category = LOG_CONSENSUS;
+        if ( _className.find( "Protocol" ) != string_view::npos )
+            category = LOG_CONSENSUS;
+        if ( _className.find( "Header" ) != string_view::npos )
+            category = LOG_DATASTRUCTURES;
+        if ( _className.find( "Network" ) != string_view::npos )
+            category = LOG_NET;
+
+        return category;
+    }
+
+    // returns nullptr if _severity is disabled for the logger of the calling thread
+    static spdlog::logger* enabledLogger( level_enum _severity, log_category _category ) {
+        auto logger = logThreadLocal_ ? logThreadLocal_->loggerForCategory( _category ) :
+                                        ConsensusEngine::getConfigLogger();
+        if ( logger == nullptr || !logger->should_log( _severity ) )
+            return nullptr;
+        return logger;
+    }
+
+    static uint64_t getBlockIDForLog();
 
     static level_enum logLevelFromString(string &_s);
 };
@@ -0,0 +1,147 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file LogTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "spdlog/async.h"
+#include "spdlog/sinks/ostream_sink.h"
+
+#include "node/ConsensusEngine.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t LOG_TEST_CALLS = 1000000;
+
+
+class LogTestAgent {
+public:
+    static uint64_t evaluated;
+
+    static string message( uint64_t _i ) {
+        evaluated++;
+        return "BLOCK_COMMIT: PRPSR:" + to_string( _i % 16 ) + ":BID: " + to_string( _i ) +
+               ":TXS:" + to_string( _i * 3 );
+    }
+
+    // what LOG did before the level check was moved in front of the message
+    static void legacyLog( level_enum _severity, const string& _message, const string& _className ) {
+        auto logger = ConsensusEngine::getConfigLogger();
+        CHECK_STATE( logger );
+        logger->log( _severity, _message );
+        // the logger used to be looked up by the class name
+        CHECK_STATE( !_className.empty() );
+    }
+
+    static uint64_t runLegacy() {
+        auto begin = chrono::steady_clock::now();
+        for ( uint64_t i = 0; i < LOG_TEST_CALLS; i++ ) {
+            legacyLog( trace, message( i ), className( __PRETTY_FUNCTION__ ) );
+        }
+        return chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now() - begin )
+            .count();
+    }
+
+    static uint64_t runGated() {
+        auto begin = chrono::steady_clock::now();
+        for ( uint64_t i = 0; i < LOG_TEST_CALLS; i++ ) {
+            LOG( trace, message( i ) );
+        }
+        return chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now() - begin )
+            .count();
+    }
+
+    static void logEnabled() {
+        LOG( info, message( 7 ) );
+        LOGF( info, "formatted:{}:{}", 42, "block" );
+        LOGF( debug, "disabled:{}", message( 8 ) );
+    }
+};
+
+uint64_t LogTestAgent::evaluated = 0;
+
+
+TEST_CASE( "Loggers are picked at compile time", "[log]" ) {
+    static_assert( classNameView( "void Schain::proposeNextBlock()" ) == "Schain" );
+    static_assert( classNameView( "void f()" ) == "::" );
+    static_assert( SkaleLog::categoryForClass( "Schain" ) == LOG_MAIN );
+    static_assert( SkaleLog::categoryForClass( "BlockProposalServerAgent" ) == LOG_PROPOSAL );
+    static_assert( SkaleLog::categoryForClass( "CatchupClientAgent" ) == LOG_CATCHUP );
+    static_assert( SkaleLog::categoryForClass( "PendingTransactionsAgent" ) == LOG_PENDING );
+    static_assert( SkaleLog::categoryForClass( "BlockConsensusAgent" ) == LOG_CONSENSUS );
+    static_assert( SkaleLog::categoryForClass( "ProtocolInstance" ) == LOG_CONSENSUS );
+    static_assert( SkaleLog::categoryForClass( "BlockProposalHeader" ) == LOG_DATASTRUCTURES );
+    static_assert( SkaleLog::categoryForClass( "ZMQNetwork" ) == LOG_NET );
+
+    REQUIRE( classNameView( __PRETTY_FUNCTION__ ) == className( __PRETTY_FUNCTION__ ) );
+}
+
+
+TEST_CASE( "Disabled log lines are not formatted", "[log]" ) {
+    ostringstream out;
+    auto logger = make_shared< spdlog::logger >(
+        "logtest", make_shared< spdlog::sinks::ostream_sink_st >( out ) );
+    logger->set_pattern( "%v" );
+    logger->set_level( info );
+
+    auto previousLogger = ConsensusEngine::setConfigLogger( logger );
+
+    LogTestAgent::evaluated = 0;
+    LogTestAgent::logEnabled();
+
+    REQUIRE( LogTestAgent::evaluated == 1 );
+    REQUIRE( out.str() == LogTestAgent::message( 7 ) + "\nformatted:42:block\n" );
+
+    auto legacyNs = LogTestAgent::runLegacy();
+    auto gatedNs = LogTestAgent::runGated();
+
+    cerr << "Disabled trace LOG:ns per call:legacy:" << legacyNs / LOG_TEST_CALLS
+         << ":gated:" << ( double ) gatedNs / LOG_TEST_CALLS << endl;
+
+    REQUIRE( gatedNs < legacyNs );
+
+    ConsensusEngine::setConfigLogger( previousLogger );
+}
+
+
+TEST_CASE( "Queued log records are written out when the engine exits", "[log]" ) {
+    ostringstream out;
+
+    {
+        ConsensusEngine engine;
+
+        auto logger = make_shared< spdlog::async_logger >( "logtest-async",
+            make_shared< spdlog::sinks::ostream_sink_mt >( out ), spdlog::thread_pool(),
+            spdlog::async_overflow_policy::block );
+        logger->set_pattern( "%v" );
+
+        for ( uint64_t i = 0; i < LOG_ASYNC_QUEUE_SIZE; i++ ) {
+            logger->info( "{}", i );
+        }
+    }
+
+    auto written = out.str();
+
+    REQUIRE( ( uint64_t ) count( written.begin(), written.end(), '\n' ) == LOG_ASYNC_QUEUE_SIZE );
+}
@@ -32,6 +32,7 @@
 #include "crypto/BLAKE3Hash.h"
 #include "node/ConsensusEngine.h"
 #include "node/Node.h"
+#include "threads/GlobalThreadRegistry.h"
 
 
 
@@ -40,7 +41,8 @@
     extern "C" void MicroProfileOnThreadCreate( const char* );
 #endif
 
-void setThreadName( std::string const& _n,  ConsensusEngine* _engine ) {
+void setThreadName( std::string const& _n,  ConsensusEngine* _engine,
+    std::string const& _role, std::string const& _agent ) {
 
     string prefix;
 
@@ -66,6 +68,9 @@ void setThreadName( std::string const& _n,  ConsensusEngine* _engine ) {
 #if MICROPROFILE_ENABLED
     MicroProfileOnThreadCreate( _n.c_str() );
 #endif
+
+    _engine->getThreadRegistry()->registerThread(
+        _n, _role, _agent, logThreadLocal_ ? ( uint64_t ) logThreadLocal_->getNodeID() : 0 );
 }
 
 std::string getThreadName(){
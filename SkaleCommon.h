@@ -42,6 +42,7 @@
 #include "stdlib.h"
 #include <unistd.h>
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <queue>
 #include <vector>
@@ -149,10 +150,15 @@ static const uint64_t MAX_ACTIVE_CONSENSUSES = 5;
 static const uint64_t MAX_CONSENSUS_HISTORY  = 2 * MAX_ACTIVE_CONSENSUSES;
 
 static const uint64_t SESSION_KEY_CACHE_SIZE  = 2;
-static const uint64_t SESSION_PUBLIC_KEY_CACHE_SIZE  = 16;
+static const uint64_t SESSION_PUBLIC_KEY_CACHE_SIZE  = 256;
+static const uint64_t ECDSA_PUBLIC_KEY_CACHE_SIZE  = 64;
 
 static constexpr uint64_t MAX_CATCHUP_DOWNLOAD_BYTES = 16 * 1024 * 1024;
 
+static constexpr uint64_t CATCHUP_RANGE_BLOCKS = 128;
+
+static constexpr uint64_t CATCHUP_VERIFY_BATCH_BLOCKS = 8;
+
 static constexpr uint64_t MAX_TRANSACTIONS_PER_BLOCK = 8 * 1024;
 
 static constexpr int64_t EMPTY_BLOCK_INTERVAL_MS = 3000;
@@ -163,16 +169,36 @@ static  constexpr uint64_t PROPOSAL_RETRY_INTERVAL_MS = 500;
 
 static constexpr uint64_t CATCHUP_INTERVAL_MS = 5000;
 
+static constexpr uint64_t CATCHUP_MIN_BACKOFF_MS = 100;
+
 static constexpr uint64_t MONITORING_INTERVAL_MS = 1000;
 
+static constexpr uint64_t DEFERRED_MESSAGES_INTERVAL_MS = 1000;
+
+static constexpr uint64_t PENDING_TRANSACTIONS_POLL_INTERVAL_MS = 100;
+
+static constexpr uint64_t PENDING_TRANSACTIONS_INTAKE_CAPACITY = 4 * MAX_TRANSACTIONS_PER_BLOCK;
+
 static constexpr uint64_t WAIT_AFTER_NETWORK_ERROR_MS = 3000;
 
+static constexpr uint64_t SERVER_IO_TIMEOUT_MS = 3000;
+
+static constexpr uint64_t IO_TIMEOUT_MS = 3000;
+
+static constexpr uint64_t CLIENT_REQUEST_TIMEOUT_MS = 30000;
+
 static constexpr uint64_t CONNECTION_REFUSED_LOG_INTERVAL_MS = 10 * 60 * 1000;
 
+// log records are written by a background thread, the queue is bounded and blocks when full
+static constexpr size_t LOG_ASYNC_QUEUE_SIZE = 8192;
+static constexpr size_t LOG_ASYNC_THREADS = 1;
+
 // Non-tunable params
 
 static constexpr uint32_t SOCKET_BACKLOG = 64;
 
+static constexpr uint32_t EPOLL_MAX_EVENTS = 64;
+
 static constexpr size_t HASH_LEN = 32;
 
 static constexpr size_t PARTIAL_HASH_LEN = 8;
@@ -194,6 +220,8 @@ static constexpr uint64_t TEST_MAGIC_NUMBER = 0x2456032650150;
 
 static const uint64_t KNOWN_TRANSACTIONS_HISTORY = 2 * MAX_TRANSACTIONS_PER_BLOCK;
 
+static constexpr uint64_t KNOWN_TRANSACTIONS_SHARDS = 16;
+
 
 enum port_type {
     PROPOSAL = 0, CATCHUP = 1, RETRIEVE = 2, HTTP_JSON = 3, BINARY_CONSENSUS = 4, ZMQ_BROADCAST = 5,
@@ -280,12 +308,29 @@ inline std::string className(const std::string &prettyFunction) {
     return prettyFunction.substr(begin, end);
 }
 
+// same as className, evaluated at compile time when used on __PRETTY_FUNCTION__
+constexpr std::string_view classNameView(std::string_view prettyFunction) {
+    size_t colons = prettyFunction.find("::");
+    if (colons == std::string_view::npos)
+        return "::";
+    size_t begin = prettyFunction.substr(0, colons).rfind(" ") + 1;
+    size_t end = colons - begin;
+
+    return prettyFunction.substr(begin, end);
+}
+
 
 static const num_threads NUM_SCHAIN_THREADS = num_threads(1);
 
 
 static const num_threads NUM_DISPATCH_THREADS = num_threads(1);
 
+// executor workers that are not blocked are capped at the number of cores, this limits the
+// workers that wait for peers, see WorkStealingExecutor::BlockingScope
+static const uint64_t EXECUTOR_MAX_BLOCKED_WORKERS = 1024;
+static const uint64_t EXECUTOR_IDLE_WAIT_MS = 1000;
+static const uint64_t CATCHUP_SERVER_MAX_CONNECTION_TASKS = 16;
+
 static const uint64_t DEFAULT_DB_STORAGE_LIMIT = 5000000000; // 5Gbyte
 
 static const uint64_t  MAX_DELAYED_MESSAGE_SENDS = 256;
@@ -299,7 +344,9 @@ static const uint64_t REBROADCAST_TIMEOUT_MS = 120000;
 
 static const uint64_t ZMQ_RECEIVE_RETRY_MS = 10;
 
-extern void setThreadName(std::string const &_n, ConsensusEngine* _engine);
+// names the calling thread and registers it with the thread registry of the engine
+extern void setThreadName(std::string const &_n, ConsensusEngine* _engine,
+    std::string const &_role, std::string const &_agent);
 
 extern std::string getThreadName();
 
@@ -328,9 +375,18 @@ extern std::string getThreadName();
         auto __msg__ = string("Check failed::") + #_EXPRESSION_ +  " " + string(__FILE__) + ":" + to_string(__LINE__); \
         throw InvalidStateException(__msg__ + ":" + _MSG_, __CLASS_NAME__);}
 
+// Test hooks are INJECT_TEST, simulated network write delays and dropped catchup blocks.
+// They are compiled out of the hot paths when built with -DCONSENSUS_TEST_HOOKS=0
+#ifndef CONSENSUS_TEST_HOOKS
+#define CONSENSUS_TEST_HOOKS 1
+#endif
+
+static constexpr bool TEST_HOOKS_ENABLED = CONSENSUS_TEST_HOOKS;
+
 #define INJECT_TEST(__TEST_NAME__, __TEST_CODE__) \
- { static bool __TEST_NAME__ = (getenv(#__TEST_NAME__) != nullptr); \
- if (__TEST_NAME__) {__TEST_CODE__ ;} };
+ { if constexpr (TEST_HOOKS_ENABLED) { \
+ static bool __TEST_NAME__ = (getenv(#__TEST_NAME__) != nullptr); \
+ if (__TEST_NAME__) {__TEST_CODE__ ;} } };
 
 #define LOCK(_M_) lock_guard<recursive_mutex> _lock_(_M_);
 
@@ -28,6 +28,7 @@ blic License as published
 #include "abstracttcpclient/AbstractClientAgent.h"
 #include "exceptions/ExitRequestedException.h"
 #include "exceptions/SkaleException.h"
+#include "node/ConsensusEngine.h"
 #include "node/Node.h"
 #include <exceptions/ConnectionRefusedException.h>
 
@@ -45,6 +46,12 @@ blic License as published
 
 #include "datastructures/BlockProposal.h"
 #include "datastructures/DAProof.h"
+#include "monitoring/StageMetrics.h"
+#include "threads/GlobalThreadRegistry.h"
+#include "threads/QueueMetrics.h"
+#include "threads/TimerWheel.h"
+#include "threads/WorkStealingExecutor.h"
+#include "utils/Time.h"
 
 
 AbstractClientAgent::AbstractClientAgent( Schain& _sChain, port_type _portType )
@@ -56,15 +63,15 @@ AbstractClientAgent::AbstractClientAgent( Schain& _sChain, port_type _portType )
 
     for ( uint64_t i = 1; i <= _sChain.getNodeCount(); i++ ) {
         ( itemQueue ).emplace( schain_index( i ), make_shared< queue< ptr< SendableItem > > >() );
-        ( queueCond ).emplace( schain_index( i ), make_shared< condition_variable >() );
         ( queueMutex ).emplace( schain_index( i ), make_shared< std::mutex >() );
-    }
-
-    threadCounter = 0;
-}
+        retryItem.emplace( schain_index( i ), nullptr );
+        sending.emplace( schain_index( i ), false );
 
-uint64_t AbstractClientAgent::incrementAndReturnThreadCounter() {
-    return threadCounter++;  // l_sergiy: increment/return-prev of atomic variable
+        auto metrics = make_shared< QueueMetrics >( "itemQueue." + to_string( i ),
+            "BlockProposalClientAgent", ( uint64_t ) _sChain.getNode()->getNodeID() );
+        itemQueueMetrics.emplace( schain_index( i ), metrics );
+        getThreadRegistry()->registerQueue( metrics );
+    }
 }
 
 
@@ -101,6 +108,7 @@ void AbstractClientAgent::sendItem( const ptr< SendableItem >& _item, schain_ind
         if ( sendItemImpl( _item, socket, _dstIndex ).first != CONNECTION_RETRY_LATER ) {
             return;
         } else {
+            WorkStealingExecutor::BlockingScope blocking;
             boost::this_thread::sleep(
                 boost::posix_time::milliseconds( PROPOSAL_RETRY_INTERVAL_MS ) );
         }
@@ -118,100 +126,122 @@ void AbstractClientAgent::enqueueItemImpl( const ptr< SendableItem >& _item ) {
     LOCK( m )
 
     for ( uint64_t i = 1; i <= ( uint64_t ) getSchain()->getNodeCount(); i++ ) {
+        auto dstIndex = schain_index( i );
+
+        // the node does not send to itself
+        if ( dstIndex == getSchain()->getSchainIndex() )
+            continue;
+
+        bool startSending = false;
+
         {
-            lock_guard< std::mutex > lock( *queueMutex[schain_index( i )] );
-            auto q = itemQueue[schain_index( i )];
+            lock_guard< std::mutex > lock( *queueMutex[dstIndex] );
+            auto q = itemQueue[dstIndex];
             CHECK_STATE( q );
-            CHECK_STATE(dynamic_pointer_cast<DAProof>(_item) ||
-                        dynamic_pointer_cast<BlockProposal>(_item));
             q->push( _item );
+            itemQueueMetrics.at( dstIndex )->pushed();
 
             if ( q->size() > MAX_PROPOSAL_QUEUE_SIZE ) {
                 // the destination is not accepting proposals, remove older
                 q->pop();
+                itemQueueMetrics.at( dstIndex )->droppedOldest();
+            }
+
+            if ( !sending[dstIndex] ) {
+                sending[dstIndex] = true;
+                startSending = true;
             }
         }
-        queueCond.at( schain_index( i ) )->notify_all();
+
+        if ( startSending )
+            scheduleSend( dstIndex, 0 );
     }
 }
 
 
-void AbstractClientAgent::workerThreadItemSendLoop( AbstractClientAgent* agent ) {
-    CHECK_STATE( agent );
-
-    setThreadName( "BlockPopClnt", agent->getSchain()->getNode()->getConsensusEngine() );
-
-    agent->waitOnGlobalStartBarrier();
-
-    auto destinationSchainIndex = schain_index( agent->incrementAndReturnThreadCounter() + 1 );
-
-    ptr< SendableItem > proposal = nullptr;
+void AbstractClientAgent::scheduleSend( schain_index _dstIndex, uint64_t _delayMs ) {
+    auto engine = getNode()->getConsensusEngine();
 
     try {
-        while ( !agent->getSchain()->getNode()->isExitRequested() ) {
-            {
-                std::unique_lock< std::mutex > mlock( *agent->queueMutex[destinationSchainIndex] );
-
-                while ( agent->itemQueue[destinationSchainIndex]->empty() ) {
-                    if ( agent->getSchain()->getNode()->isExitRequested() )
-                        return;
-                    agent->getSchain()->getNode()->exitCheck();
-                    agent->queueCond[destinationSchainIndex]->wait( mlock );
-                }
+        if ( _delayMs == 0 ) {
+            engine->getExecutor()->submit(
+                PRIORITY_PROPOSAL, [this, _dstIndex]() { sendQueuedItems( _dstIndex ); } );
+        } else {
+            engine->getTimerWheel()->schedule( _delayMs, PRIORITY_PROPOSAL,
+                [this, _dstIndex]() { sendQueuedItems( _dstIndex ); } );
+        }
+    } catch ( ExitRequestedException& ) {
+        // the executor has been shut down
+    }
+}
 
 
-                CHECK_STATE( agent->itemQueue[destinationSchainIndex] );
+void AbstractClientAgent::sendQueuedItems( schain_index _dstIndex ) {
+    auto node = getNode();
 
-                proposal = agent->itemQueue[destinationSchainIndex]->front();
+    // before the start the items stay queued
+    if ( !node->isStarted() && !node->isExitRequested() ) {
+        scheduleSend( _dstIndex, PROPOSAL_RETRY_INTERVAL_MS );
+        return;
+    }
 
-                CHECK_STATE( proposal );
+    auto metrics = getSchain()->getStageMetrics();
 
-                CHECK_STATE(dynamic_pointer_cast<DAProof>(proposal) ||
-                            dynamic_pointer_cast<BlockProposal>(proposal));
+    try {
+        while ( !node->isExitRequested() ) {
+            ptr< SendableItem > item = nullptr;
 
-                agent->itemQueue[destinationSchainIndex]->pop();
+            {
+                lock_guard< std::mutex > lock( *queueMutex[_dstIndex] );
+
+                if ( retryItem[_dstIndex] ) {
+                    item = retryItem[_dstIndex];
+                    retryItem[_dstIndex] = nullptr;
+                } else if ( itemQueue[_dstIndex]->empty() ) {
+                    sending[_dstIndex] = false;
+                    return;
+                } else {
+                    item = itemQueue[_dstIndex]->front();
+                    itemQueue[_dstIndex]->pop();
+                    itemQueueMetrics.at( _dstIndex )->popped();
+                }
             }
 
+            CHECK_STATE( item );
 
+            auto sendStartUs = Time::getSteadyTimeUs();
 
+            try {
+                sendItem( item, _dstIndex );
+                if ( dynamic_pointer_cast< BlockProposal >( item ) ) {
+                    metrics->recordProposalPush(
+                        _dstIndex, Time::getSteadyTimeUs() - sendStartUs );
+                }
+                continue;
+            } catch ( ExitRequestedException& ) {
+                return;
+            } catch ( ConnectionRefusedException& e ) {
+                logConnectionRefused( e, _dstIndex );
+            } catch ( FatalError& ) {
+                throw;
+            } catch ( exception& e ) {
+                SkaleException::logNested( e );
+            }
 
-            if ( ( uint64_t ) destinationSchainIndex !=
-                 ( uint64_t ) agent->getSchain()->getSchainIndex() ) {
-                bool sent = false;
-
-                while ( !sent ) {
-                    if ( agent->getSchain()->getNode()->isExitRequested() )
-                        return;
-                    try {
-                        agent->sendItem( proposal, destinationSchainIndex );
-                        sent = true;
-                    } catch ( ConnectionRefusedException& e ) {
-                        agent->logConnectionRefused( e, destinationSchainIndex );
-
-                        if ( agent->getNode()->isExitRequested() )
-                            return;
-
-                        usleep( agent->getNode()->getWaitAfterNetworkErrorMs() * 1000 );
-                    } catch ( exception& e ) {
-                        SkaleException::logNested( e );
-
-                        if ( agent->getNode()->isExitRequested() )
-                            return;
+            metrics->retry( _dstIndex );
 
-                        usleep( agent->getNode()->getWaitAfterNetworkErrorMs() * 1000 );
-                    }
-                }
+            {
+                lock_guard< std::mutex > lock( *queueMutex[_dstIndex] );
+                retryItem[_dstIndex] = item;
             }
-        };
-    }
 
-    catch ( FatalError& e ) {
-        SkaleException::logNested( e );
-        agent->getNode()->exitOnFatalError( e.getMessage() );
-    } catch ( ExitRequestedException& e ) {
-        return;
-    } catch ( SkaleException& e ) {
+            // sending stays set, the timer continues with the same item
+            scheduleSend( _dstIndex, node->getWaitAfterNetworkErrorMs() );
+            return;
+        }
+    } catch ( FatalError& e ) {
         SkaleException::logNested( e );
+        node->exitOnFatalError( e.getMessage() );
     }
 }
 
@@ -36,13 +36,16 @@ class DataStructure;
 class BlockProposal;
 class DAProof;
 class ClientSocket;
+class QueueMetrics;
+
+// Items are sent to each destination in order by a task on the executor. The task is
+// submitted when an item is queued for an idle destination and runs until the queue is empty.
+// After a network error it is resubmitted by a timer, so no worker waits for a peer that is down.
 
 class AbstractClientAgent : public Agent {
 protected:
     port_type portType;
 
-    atomic< uint64_t > threadCounter;
-
     explicit AbstractClientAgent( Schain& _sChain, port_type _portType );
 
 protected:
@@ -53,12 +56,22 @@ protected:
 
     std::map< schain_index, ptr< queue< ptr< SendableItem >>>> itemQueue; // thread safe
 
-    uint64_t incrementAndReturnThreadCounter();
+    std::map< schain_index, ptr< QueueMetrics > > itemQueueMetrics;
+
+    // an item that failed to send and is sent again before the queue, guarded by queueMutex
+    std::map< schain_index, ptr< SendableItem > > retryItem;
+
+    // a send task runs or is scheduled for the destination, guarded by queueMutex
+    std::map< schain_index, bool > sending;
 
     void enqueueItemImpl( const ptr< SendableItem >& _item );
 
+    // sends the queued items to _dstIndex, runs on the executor
+    void sendQueuedItems( schain_index _dstIndex );
+
+    void scheduleSend( schain_index _dstIndex, uint64_t _delayMs );
+
 public:
-    static void workerThreadItemSendLoop( AbstractClientAgent* agent );
 
     void enqueueItem( const ptr< BlockProposal >& _item );
 
@@ -27,7 +27,10 @@
 
 #include "chains/Schain.h"
 
+#include "exceptions/ExitRequestedException.h"
 #include "exceptions/OldBlockIDException.h"
+#include "exceptions/ParsingException.h"
+#include "exceptions/PingException.h"
 
 
 #include "blockproposal/pusher/BlockProposalClientAgent.h"
@@ -38,68 +41,88 @@
 #include "network/Network.h"
 #include "network/ServerConnection.h"
 #include "network/Sockets.h"
-#include "network/TCPServerSocket.h"
+#include "network/StreamServerSocket.h"
+#include "datastructures/PartialHashesList.h"
+#include "threads/GlobalThreadRegistry.h"
+#include "threads/QueueMetrics.h"
+#include "utils/Time.h"
 
 
+#include "EpollServerLoop.h"
 #include "AbstractServerAgent.h"
 
-void AbstractServerAgent::pushToQueueAndNotifyWorkers(const ptr<ServerConnection>& _connectionEnvelope ) {
-    CHECK_ARGUMENT( _connectionEnvelope );
-    lock_guard<mutex> lock(incomingTCPConnectionsMutex);
-    incomingTCPConnections.push( _connectionEnvelope );
-    incomingTCPConnectionsCond.notify_all();
-}
+void AbstractServerAgent::pushToQueueAndSubmitTask(const WorkStealingExecutor::task& _step) {
+    CHECK_ARGUMENT(_step);
+    lock_guard<mutex> lock(connectionStepsMutex);
+    connectionSteps.push(_step);
+    connectionStepsMetrics->pushed();
 
-ptr<ServerConnection> AbstractServerAgent::workerThreadWaitandPopConnection() {
+    if (activeConnectionTasks >= maxConnectionTasks)
+        return; // one of the running tasks will pick it up
 
-    unique_lock<mutex> mlock(incomingTCPConnectionsMutex);
+    activeConnectionTasks++;
 
-    while (incomingTCPConnections.empty()) {
-        if( getSchain()->getNode()->isExitRequested() )
-            return nullptr;
-        incomingTCPConnectionsCond.wait_for( mlock, std::chrono::milliseconds( 1000 ) ); // incomingTCPConnectionsCond.wait(mlock);
-        getSchain()->getNode()->exitCheck();
+    try {
+        getNode()->getConsensusEngine()->getExecutor()->submit(
+            connectionTaskPriority, [this]() { processQueuedConnectionSteps(); });
+    } catch (...) {
+        activeConnectionTasks--;
+        throw;
     }
-    if( getSchain()->getNode()->isExitRequested() )
-        return nullptr;
+}
+
+void AbstractServerAgent::processQueuedConnectionSteps() {
 
-    CHECK_STATE(!incomingTCPConnections.empty());
+    while (true) {
 
-    ptr<ServerConnection> connection = incomingTCPConnections.front();
+        WorkStealingExecutor::task step;
 
-    CHECK_STATE( connection );
+        {
+            lock_guard<mutex> lock(connectionStepsMutex);
 
-    incomingTCPConnections.pop();
+            if (connectionSteps.empty()) {
+                activeConnectionTasks--;
+                return;
+            }
 
-    return connection;
+            step = connectionSteps.front();
+            connectionSteps.pop();
+            connectionStepsMetrics->popped();
+        }
 
+        // the loop wraps steps so that they handle their own exceptions
+        step();
+    }
 }
 
 
-void AbstractServerAgent::workerThreadConnectionProcessingLoop(void *_params) {
+void AbstractServerAgent::acceptConnection(const ptr<ServerConnection>& _connection) {
+    readRequest(_connection);
+}
 
-    CHECK_ARGUMENT(_params);
-    AbstractServerAgent *server = (reinterpret_cast < AbstractServerAgent * > ( _params ));
-    CHECK_STATE(server);
 
-    server->waitOnGlobalStartBarrier();
+void AbstractServerAgent::readRequest(const ptr<ServerConnection>& _connection) {
 
-    LOG(trace, "Started server loop");
+    CHECK_ARGUMENT(_connection);
 
-    while (!server->getNode()->isExitRequested()) {
+    serverLoop->readBytesInline(_connection, sizeof(uint64_t), [this, _connection](const ptr<vector<uint8_t>>& _bytes) {
 
-        ptr<ServerConnection> connection = nullptr;
-        try {
+        uint64_t magic = *(uint64_t*) _bytes->data();
 
-            connection = server->workerThreadWaitandPopConnection();
-            if( server->getNode()->isExitRequested() )
-                return; // notice - connection is nullptr in this case
-            CHECK_STATE(connection);
-            server->processNextAvailableConnection(connection);
-        } catch (exception &e) {
-            SkaleException::logNested(e);
+        if (magic == TEST_MAGIC_NUMBER) {
+            return; // ping, the connection is closed
         }
-    }
+
+        if (magic != MAGIC_NUMBER) {
+            BOOST_THROW_EXCEPTION(NetworkProtocolException("Incorrect magic number" + to_string(magic), __CLASS_NAME__));
+        }
+
+        readJsonHeader(_connection, name + ":read request", [this, _connection](nlohmann::json _request) {
+            if (getNode()->isExitRequested())
+                BOOST_THROW_EXCEPTION(ExitRequestedException(__CLASS_NAME__));
+            processRequest(_connection, _request);
+        });
+    });
 }
 
 
@@ -112,83 +135,133 @@ void AbstractServerAgent::send(const ptr<ServerConnection>& _connectionEnvelope,
     CHECK_ARGUMENT(_header->isComplete());
 
     auto buf = _header->toBuffer();
-    getSchain()->getIo()->writeBuf(_connectionEnvelope->getDescriptor(), buf);
-}
 
-AbstractServerAgent::AbstractServerAgent(const string &_name, Schain &_schain,
-                                         const ptr<TCPServerSocket>& _socket)
-        : Agent(_schain, true), name(_name), socket(_socket), networkReadThread(nullptr) {
+    auto bytes = make_shared<vector<uint8_t>>(buf->getBuf()->begin(),
+                                              buf->getBuf()->begin() + buf->getCounter());
 
-    logThreadLocal_ = _schain.getNode()->getLog();
+    sendBytes(_connectionEnvelope, bytes);
 }
 
-AbstractServerAgent::~AbstractServerAgent() {
-    this->networkReadThread->join();
-}
+void AbstractServerAgent::sendBytes(const ptr<ServerConnection>& _connectionEnvelope,
+                                    const ptr<vector<uint8_t>>& _bytes) {
+    CHECK_ARGUMENT(_connectionEnvelope);
+    CHECK_ARGUMENT(_bytes);
 
-void AbstractServerAgent::acceptTCPConnectionsLoop() {
+    uint64_t notBeforeMs = 0;
 
-    setThreadName(name, getSchain()->getNode()->getConsensusEngine());
+    if constexpr (TEST_HOOKS_ENABLED) {
+        auto delayMs = getNode()->getSimulateNetworkWriteDelayMs();
 
-    waitOnGlobalStartBarrier();
+        if (delayMs > 0)
+            notBeforeMs = Time::getSteadyTimeMs() + delayMs;
+    }
 
-    struct sockaddr_in clientAddress;
-    socklen_t sizeOfClientAddress = sizeof(clientAddress);
-    CHECK_STATE(this->socket > 0);
-    auto s = dynamic_pointer_cast<TCPServerSocket>(this->socket)->getDescriptor();
-    CHECK_STATE(s > 0);
-    try {
+    serverLoop->send(_connectionEnvelope, _bytes, notBeforeMs);
+}
 
-        while (!getSchain()->getNode()->isExitRequested()) {
+void AbstractServerAgent::sendBytes(const ptr<ServerConnection>& _connectionEnvelope,
+                                    const ptr<vector<uint8_t>>& _bytes, uint64_t _begin, uint64_t _end) {
+    CHECK_ARGUMENT(_connectionEnvelope);
+    CHECK_ARGUMENT(_bytes);
 
+    uint64_t notBeforeMs = 0;
 
+    if constexpr (TEST_HOOKS_ENABLED) {
+        auto delayMs = getNode()->getSimulateNetworkWriteDelayMs();
 
-            int newConnection = accept(s, (sockaddr *) &clientAddress, &sizeOfClientAddress);
+        if (delayMs > 0)
+            notBeforeMs = Time::getSteadyTimeMs() + delayMs;
+    }
 
-            //static  int one = 1;
-            //CHECK_STATE(setsockopt(newConnection, SOL_TCP, TCP_NODELAY, &one, sizeof(one)) == 0);
+    serverLoop->send(_connectionEnvelope, _bytes, _begin, _end, notBeforeMs);
+}
 
-            if (getSchain()->getNode()->isExitRequested()) {
-                return;
-            }
+void AbstractServerAgent::readBytes(const ptr<ServerConnection>& _connectionEnvelope, uint64_t _len,
+                                    const function<void(const ptr<vector<uint8_t>>&)>& _handler) {
+    serverLoop->readBytes(_connectionEnvelope, _len, _handler);
+}
 
-            if (newConnection < 0) {
-                BOOST_THROW_EXCEPTION(NetworkProtocolException("accept failed:" + string(strerror(errno)), __CLASS_NAME__));
-            }
+void AbstractServerAgent::readJsonHeader(const ptr<ServerConnection>& _connectionEnvelope,
+                                         const string& _errorString,
+                                         const function<void(nlohmann::json)>& _handler) {
+
+    CHECK_ARGUMENT(_connectionEnvelope);
+    CHECK_ARGUMENT(_handler);
 
-            string ip(inet_ntoa(clientAddress.sin_addr));
+    serverLoop->readBytesInline(_connectionEnvelope, sizeof(uint64_t),
+                                [this, _connectionEnvelope, _errorString, _handler](const ptr<vector<uint8_t>>& _bytes) {
 
-            this->pushToQueueAndNotifyWorkers(make_shared<ServerConnection>(newConnection, ip));
+        uint64_t headerLen = *(uint64_t*) _bytes->data();
 
+        if (headerLen < 2 || headerLen > MAX_HEADER_SIZE) {
+            LOG(err, "Total Len:" + to_string(headerLen));
+            BOOST_THROW_EXCEPTION(
+                    ParsingException(_errorString + ":Invalid Header len" + to_string(headerLen), __CLASS_NAME__));
         }
-    } catch (FatalError& e) {
-        getNode()->exitOnFatalError(e.getMessage());
-    }
-}
 
-void AbstractServerAgent::createNetworkReadThread() {
+        readBytes(_connectionEnvelope, headerLen, [_errorString, _handler](const ptr<vector<uint8_t>>& _header) {
 
-    LOG(trace, name + " Starting TCP server network read loop");
-    networkReadThread = make_shared<thread>(std::bind(&AbstractServerAgent::acceptTCPConnectionsLoop, this));
-    LOG(trace, name + " Started TCP server network read loop");
+            nlohmann::json js;
+
+            try {
+                js = nlohmann::json::parse(_header->begin(), _header->end());
+            } catch (...) {
+                BOOST_THROW_EXCEPTION(ParsingException(_errorString + ":Could not parse request" +
+                                                       string(_header->begin(), _header->end()), __CLASS_NAME__));
+            }
 
+            _handler(js);
+        });
+    });
 }
 
+AbstractServerAgent::AbstractServerAgent(const string &_name, Schain &_schain,
+                                         const ptr<StreamServerSocket>& _socket,
+                                         task_priority _connectionTaskPriority,
+                                         uint64_t _maxConnectionTasks)
+        : Agent(_schain, true), name(_name), socket(_socket), networkReadThread(nullptr),
+          connectionTaskPriority(_connectionTaskPriority), maxConnectionTasks(_maxConnectionTasks) {
 
+    CHECK_ARGUMENT(_socket);
+    CHECK_ARGUMENT(_maxConnectionTasks > 0);
 
-void AbstractServerAgent::notifyAllConditionVariables() {
-    Agent::notifyAllConditionVariables();
-    LOG(trace, "Notifying TCP cond" + to_string((uint64_t) (void *) &incomingTCPConnectionsCond));
-    incomingTCPConnectionsCond.notify_all();
+    logThreadLocal_ = _schain.getNode()->getLog();
 
-}
+    connectionStepsMetrics = make_shared<QueueMetrics>(
+            "connectionSteps", _name, (uint64_t) _schain.getNode()->getNodeID());
+    getThreadRegistry()->registerQueue(connectionStepsMetrics);
 
+    serverLoop = make_shared<EpollServerLoop>(
+            _name, _socket->getDescriptor(),
+            [this](const ptr<ServerConnection>& _connection) { acceptConnection(_connection); },
+            [this](const WorkStealingExecutor::task& _step) { pushToQueueAndSubmitTask(_step); });
+}
 
+AbstractServerAgent::~AbstractServerAgent() {
+    this->networkReadThread->join();
+}
 
+void AbstractServerAgent::serverLoopThread() {
 
+    logThreadLocal_ = getSchain()->getNode()->getLog();
 
+    setThreadName(name, getSchain()->getNode()->getConsensusEngine(), "server", name);
 
+    waitOnGlobalStartBarrier();
 
+    try {
+        serverLoop->run([this]() { return getSchain()->getNode()->isExitRequested(); });
+    } catch (ExitRequestedException &) {
+        return;
+    } catch (FatalError& e) {
+        getNode()->exitOnFatalError(e.getMessage());
+    }
+}
 
+void AbstractServerAgent::createNetworkReadThread() {
 
+    LOG(trace, name + " Starting TCP server network read loop");
+    networkReadThread = make_shared<thread>(std::bind(&AbstractServerAgent::serverLoopThread, this));
+    LOG(trace, name + " Started TCP server network read loop");
 
+}
@@ -24,14 +24,16 @@
 #pragma once
 
 #include "Agent.h"
+#include "threads/WorkStealingExecutor.h"
 
 class ServerConnection;
 class Schain;
 class Buffer;
-class TCPServerSocket;
-class ServerSocket;
+class StreamServerSocket;
 class Header;
 class PartialHashesList;
+class EpollServerLoop;
+class QueueMetrics;
 
 
 class AbstractServerAgent : public Agent {
@@ -41,53 +43,75 @@ protected:
 
     const string name;
 
-    ptr<ServerSocket> socket;
+    ptr<StreamServerSocket> socket;
 
     ptr<thread> networkReadThread;
 
-    mutex incomingTCPConnectionsMutex;
+    // does all socket IO of the server on networkReadThread
+    ptr<EpollServerLoop> serverLoop;
 
-    condition_variable incomingTCPConnectionsCond;
+    // protocol steps are processed by executor tasks, at most maxConnectionTasks at a time
+    const task_priority connectionTaskPriority;
 
-    queue<ptr<ServerConnection>> incomingTCPConnections; // thread safe
+    const uint64_t maxConnectionTasks;
 
-    void send(const ptr<ServerConnection>& _connectionEnvelope, const ptr<Header>& _header);
+    mutex connectionStepsMutex;
 
+    queue<WorkStealingExecutor::task> connectionSteps; // thread safe
 
-public:
+    ptr<QueueMetrics> connectionStepsMetrics;
 
-    AbstractServerAgent(const string &_name, Schain &_schain, const ptr<TCPServerSocket>& _socket);
+    uint64_t activeConnectionTasks = 0; // guarded by connectionStepsMutex
 
-    ~AbstractServerAgent() override;
+    void send(const ptr<ServerConnection>& _connectionEnvelope, const ptr<Header>& _header);
 
+    void sendBytes(const ptr<ServerConnection>& _connectionEnvelope, const ptr<vector<uint8_t>>& _bytes);
 
-    void pushToQueueAndNotifyWorkers(const ptr<ServerConnection>& _connectionEnvelope );
+    // sends bytes [_begin, _end) of a buffer that is not modified afterwards, without copying them
+    void sendBytes(const ptr<ServerConnection>& _connectionEnvelope, const ptr<vector<uint8_t>>& _bytes,
+                   uint64_t _begin, uint64_t _end);
 
-    ptr<ServerConnection> workerThreadWaitandPopConnection();
+    // the handlers run on the executor once the bytes have arrived
 
-    static void workerThreadConnectionProcessingLoop(void* _params);
+    void readBytes(const ptr<ServerConnection>& _connectionEnvelope, uint64_t _len,
+                   const function<void(const ptr<vector<uint8_t>>&)>& _handler);
 
+    void readJsonHeader(const ptr<ServerConnection>& _connectionEnvelope, const string& _errorString,
+                        const function<void(nlohmann::json)>& _handler);
 
-    void notifyAllConditionVariables() override;
+    void readPartialHashes(const ptr<ServerConnection>& _connectionEnvelope, transaction_count _txCount,
+                           const function<void(const ptr<PartialHashesList>&)>& _handler);
 
-// to be implemented by subclasses
+    // reads the magic number and the request header, and passes the request to processRequest.
+    // Called again after a response to keep the connection open for the next request
+    void readRequest(const ptr<ServerConnection>& _connection);
 
 
-    virtual void processNextAvailableConnection(const ptr<ServerConnection>& _connection) = 0;
+public:
 
+    AbstractServerAgent(const string &_name, Schain &_schain,
+                        const ptr<StreamServerSocket>& _socket,
+                        task_priority _connectionTaskPriority, uint64_t _maxConnectionTasks);
 
-    virtual ptr<PartialHashesList> readPartialHashes(const ptr<ServerConnection>& _connectionEnvelope, transaction_count _txCount);
+    ~AbstractServerAgent() override;
 
 
+    void pushToQueueAndSubmitTask(const WorkStealingExecutor::task& _step);
 
-    void acceptTCPConnectionsLoop();
+    void processQueuedConnectionSteps();
 
+    // runs on the loop thread, reads the magic number and the request header
+    void acceptConnection(const ptr<ServerConnection>& _connection);
 
-    void createNetworkReadThread();
-};
+// to be implemented by subclasses
 
 
+    virtual void processRequest(const ptr<ServerConnection>& _connection, nlohmann::json _request) = 0;
 
 
+    void serverLoopThread();
 
 
+    void createNetworkReadThread();
+};
+
@@ -0,0 +1,398 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file EpollServerLoop.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+#include "utils/Time.h"
+
+#include "EpollServerLoop.h"
+
+
+EpollServerLoop::EpollServerLoop( const string& _name, int _listenDescriptor,
+    const AcceptHandler& _acceptHandler, const Dispatcher& _dispatcher )
+    : name( _name ),
+      listenDescriptor( _listenDescriptor ),
+      acceptHandler( _acceptHandler ),
+      dispatcher( _dispatcher ) {
+    CHECK_ARGUMENT( _listenDescriptor > 0 );
+    CHECK_ARGUMENT( _acceptHandler );
+    CHECK_ARGUMENT( _dispatcher );
+
+    auto flags = fcntl( listenDescriptor, F_GETFL, 0 );
+    CHECK_STATE( flags >= 0 );
+    CHECK_STATE( fcntl( listenDescriptor, F_SETFL, flags | O_NONBLOCK ) == 0 );
+
+    epollDescriptor = epoll_create1( EPOLL_CLOEXEC );
+
+    if ( epollDescriptor < 0 ) {
+        BOOST_THROW_EXCEPTION( FatalError( "Could not create epoll:" + string( strerror( errno ) ),
+            __CLASS_NAME__ ) );
+    }
+
+    wakeDescriptor = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    if ( wakeDescriptor < 0 ) {
+        BOOST_THROW_EXCEPTION( FatalError(
+            "Could not create eventfd:" + string( strerror( errno ) ), __CLASS_NAME__ ) );
+    }
+
+    for ( auto descriptor : { listenDescriptor, wakeDescriptor } ) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = descriptor;
+        CHECK_STATE( epoll_ctl( epollDescriptor, EPOLL_CTL_ADD, descriptor, &event ) == 0 );
+    }
+}
+
+
+EpollServerLoop::~EpollServerLoop() {
+    for ( auto&& item : connections ) {
+        item.second->close();
+    }
+
+    connections.clear();
+
+    if ( wakeDescriptor >= 0 )
+        close( wakeDescriptor );
+
+    if ( epollDescriptor >= 0 )
+        close( epollDescriptor );
+}
+
+
+void EpollServerLoop::run( const function< bool() >& _exitRequested ) {
+    CHECK_ARGUMENT( _exitRequested );
+
+    array< epoll_event, EPOLL_MAX_EVENTS > events;
+
+    while ( !shutdownRequested && !_exitRequested() ) {
+        auto count = epoll_wait( epollDescriptor, events.data(), events.size(), getTimeoutMs() );
+
+        if ( count < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            BOOST_THROW_EXCEPTION(
+                FatalError( "epoll_wait failed:" + string( strerror( errno ) ), __CLASS_NAME__ ) );
+        }
+
+        for ( int i = 0; i < count; i++ ) {
+            auto descriptor = events[i].data.fd;
+
+            if ( descriptor == listenDescriptor ) {
+                acceptConnections();
+            } else if ( descriptor == wakeDescriptor ) {
+                uint64_t value;
+                while ( read( wakeDescriptor, &value, sizeof( value ) ) > 0 ) {
+                }
+            } else {
+                auto it = connections.find( descriptor );
+                if ( it != connections.end() )
+                    update( it->second, events[i].events );
+            }
+        }
+
+        vector< ptr< ServerConnection > > woken;
+
+        {
+            lock_guard< mutex > lock( wakeLock );
+            woken.swap( wokenConnections );
+        }
+
+        for ( auto&& connection : woken ) {
+            auto it = connections.find( ( int ) connection->getDescriptor() );
+            // the connection may have been closed in the meantime
+            if ( it != connections.end() && it->second == connection )
+                update( connection, 0 );
+        }
+
+        // deadlines and delayed writes
+        auto now = Time::getSteadyTimeMs();
+
+        vector< ptr< ServerConnection > > due;
+
+        for ( auto&& item : connections ) {
+            auto wakeTime = item.second->getWakeTimeMs();
+            if ( wakeTime != 0 && wakeTime <= now )
+                due.push_back( item.second );
+        }
+
+        for ( auto&& connection : due ) {
+            update( connection, 0 );
+        }
+    }
+}
+
+
+void EpollServerLoop::shutdown() {
+    shutdownRequested = true;
+    uint64_t value = 1;
+    CHECK_STATE( write( wakeDescriptor, &value, sizeof( value ) ) == sizeof( value ) );
+}
+
+
+int EpollServerLoop::getTimeoutMs() {
+    uint64_t earliest = 0;
+
+    for ( auto&& item : connections ) {
+        auto wakeTime = item.second->getWakeTimeMs();
+        if ( wakeTime != 0 && ( earliest == 0 || wakeTime < earliest ) )
+            earliest = wakeTime;
+    }
+
+    if ( earliest == 0 )
+        return -1;
+
+    auto now = Time::getSteadyTimeMs();
+
+    if ( earliest <= now )
+        return 0;
+
+    return ( int ) min< uint64_t >( earliest - now, INT32_MAX );
+}
+
+
+void EpollServerLoop::acceptConnections() {
+    while ( true ) {
+        struct sockaddr_storage clientAddress;
+        socklen_t sizeOfClientAddress = sizeof( clientAddress );
+
+        int descriptor = accept4( listenDescriptor, ( sockaddr* ) &clientAddress,
+            &sizeOfClientAddress, SOCK_NONBLOCK | SOCK_CLOEXEC );
+
+        if ( descriptor < 0 ) {
+            if ( errno == EINTR || errno == ECONNABORTED )
+                continue;
+            if ( errno != EAGAIN && errno != EWOULDBLOCK )
+                LOG( err, name + ":accept failed:" + string( strerror( errno ) ) );
+            return;
+        }
+
+        // unix domain sockets of the shared memory transport have no address
+        string ip = "local";
+
+        if ( clientAddress.ss_family == AF_INET ) {
+            int one = 1;
+            setsockopt( descriptor, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+            ip = inet_ntoa( ( ( sockaddr_in* ) &clientAddress )->sin_addr );
+        }
+
+        auto connection = make_shared< ServerConnection >( descriptor, ip );
+
+        epoll_event event = {};
+        event.events = 0;
+        event.data.fd = descriptor;
+
+        if ( epoll_ctl( epollDescriptor, EPOLL_CTL_ADD, descriptor, &event ) != 0 ) {
+            LOG( err, name + ":could not add connection to epoll:" + string( strerror( errno ) ) );
+            connection->close();
+            continue;
+        }
+
+        connections[descriptor] = connection;
+        acceptedConnections++;
+
+        try {
+            acceptHandler( connection );
+        } catch ( exception& e ) {
+            SkaleException::logNested( e );
+            closeConnection( connection );
+            continue;
+        }
+
+        // the request may already be in the socket
+        update( connection, 0 );
+    }
+}
+
+
+void EpollServerLoop::update( const ptr< ServerConnection >& _connection, uint32_t _events ) {
+    try {
+        if ( _events & ( EPOLLERR | EPOLLHUP ) ) {
+            closeConnection( _connection );
+            return;
+        }
+
+        while ( true ) {
+            ptr< vector< uint8_t > > bytes;
+            ServerConnection::ReadCallback callback;
+
+            auto status = _connection->readAvailable( bytes, callback );
+
+            if ( status == IO_CLOSED ) {
+                closeConnection( _connection );
+                return;
+            }
+
+            if ( status == IO_PENDING )
+                break;
+
+            // the callback may ask for more bytes that are already in the socket
+            callback( bytes );
+        }
+
+        if ( _connection->flushWrites() == IO_CLOSED ) {
+            closeConnection( _connection );
+            return;
+        }
+
+        if ( _connection->isFinished() ) {
+            closeConnection( _connection );
+            return;
+        }
+
+        if ( _connection->isExpired( Time::getSteadyTimeMs() ) ) {
+            LOG( debug, name + ":connection timed out:" + _connection->getIP() );
+            closeConnection( _connection );
+            return;
+        }
+
+        epoll_event event = {};
+        event.events = _connection->getWantedEvents();
+        event.data.fd = ( int ) _connection->getDescriptor();
+
+        CHECK_STATE(
+            epoll_ctl( epollDescriptor, EPOLL_CTL_MOD, event.data.fd, &event ) == 0 );
+
+    } catch ( ExitRequestedException& ) {
+        closeConnection( _connection );
+    } catch ( exception& e ) {
+        SkaleException::logNested( e );
+        closeConnection( _connection );
+    }
+}
+
+
+void EpollServerLoop::closeConnection( const ptr< ServerConnection >& _connection ) {
+    auto descriptor = ( int ) _connection->getDescriptor();
+
+    if ( descriptor != 0 ) {
+        epoll_ctl( epollDescriptor, EPOLL_CTL_DEL, descriptor, nullptr );
+        connections.erase( descriptor );
+    }
+
+    _connection->close();
+}
+
+
+void EpollServerLoop::dispatch(
+    const ptr< ServerConnection >& _connection, const WorkStealingExecutor::task& _step ) {
+    _connection->stepDispatched();
+
+    try {
+        dispatcher( [this, _connection, _step]() { runStep( _connection, _step ); } );
+    } catch ( ... ) {
+        _connection->stepCompleted();
+        _connection->markFailed();
+        throw;
+    }
+}
+
+
+void EpollServerLoop::runStep(
+    const ptr< ServerConnection >& _connection, const WorkStealingExecutor::task& _step ) {
+    try {
+        _step();
+    } catch ( ExitRequestedException& ) {
+        _connection->markFailed();
+    } catch ( exception& e ) {
+        SkaleException::logNested( e );
+        _connection->markFailed();
+    }
+
+    // only this step is completed, the next one may already be dispatched by it
+    _connection->stepCompleted();
+    wakeup( _connection );
+}
+
+
+void EpollServerLoop::readBytes( const ptr< ServerConnection >& _connection, uint64_t _len,
+    const ReadHandler& _handler ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _handler );
+
+    _connection->expectBytes( _len, [this, _connection, _handler]( const ptr< vector< uint8_t > >& _bytes ) {
+        dispatch( _connection, [_handler, _bytes]() { _handler( _bytes ); } );
+    } );
+
+    wakeup( _connection );
+}
+
+
+void EpollServerLoop::readBytesInline( const ptr< ServerConnection >& _connection, uint64_t _len,
+    const ReadHandler& _handler ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _handler );
+
+    _connection->expectBytes( _len, _handler );
+
+    wakeup( _connection );
+}
+
+
+void EpollServerLoop::send( const ptr< ServerConnection >& _connection,
+    const ptr< vector< uint8_t > >& _bytes, uint64_t _notBeforeMs ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _bytes );
+
+    _connection->queueWrite( _bytes, _notBeforeMs );
+
+    wakeup( _connection );
+}
+
+
+void EpollServerLoop::send( const ptr< ServerConnection >& _connection,
+    const ptr< vector< uint8_t > >& _bytes, uint64_t _begin, uint64_t _end, uint64_t _notBeforeMs ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _bytes );
+
+    _connection->queueWrite( _bytes, _begin, _end, _notBeforeMs );
+
+    wakeup( _connection );
+}
+
+
+void EpollServerLoop::wakeup( const ptr< ServerConnection >& _connection ) {
+    CHECK_ARGUMENT( _connection );
+
+    {
+        lock_guard< mutex > lock( wakeLock );
+        wokenConnections.push_back( _connection );
+    }
+
+    uint64_t value = 1;
+    // fails only if the counter overflows, the loop is awake then anyway
+    auto result = write( wakeDescriptor, &value, sizeof( value ) );
+    ( void ) result;
+}
+
+
+uint64_t EpollServerLoop::getAcceptedConnectionCount() const {
+    return acceptedConnections;
+}
@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file EpollServerLoop.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_EPOLLSERVERLOOP_H
+#define SKALED_EPOLLSERVERLOOP_H
+
+#include "network/ServerConnection.h"
+#include "threads/WorkStealingExecutor.h"
+
+
+// Accepts connections and does all socket IO of a TCP server on a single thread.
+//
+// A protocol is a chain of steps. Each step asks for the exact number of bytes it needs next.
+// The loop reads them incrementally and runs the step when they are complete, either inline
+// on the loop thread (cheap parsing only) or on the executor. Writes are queued and flushed
+// when the socket is writable. A step that is not completed by the peer before its deadline
+// closes the connection, so a slow peer never holds an executor worker.
+
+class EpollServerLoop {
+
+public:
+
+    using AcceptHandler = function< void( const ptr< ServerConnection >& ) >;
+
+    using Dispatcher = function< void( const WorkStealingExecutor::task& ) >;
+
+    using ReadHandler = function< void( const ptr< vector< uint8_t > >& ) >;
+
+private:
+
+    const string name;
+
+    const int listenDescriptor;
+
+    AcceptHandler acceptHandler;
+
+    Dispatcher dispatcher;
+
+    int epollDescriptor = -1;
+
+    int wakeDescriptor = -1;
+
+    map< int, ptr< ServerConnection > > connections;  // loop thread only
+
+    mutex wakeLock;
+
+    vector< ptr< ServerConnection > > wokenConnections;  // guarded by wakeLock
+
+    atomic< bool > shutdownRequested = false;
+
+    atomic< uint64_t > acceptedConnections = 0;
+
+    void acceptConnections();
+
+    void update( const ptr< ServerConnection >& _connection, uint32_t _events );
+
+    void closeConnection( const ptr< ServerConnection >& _connection );
+
+    void dispatch( const ptr< ServerConnection >& _connection, const WorkStealingExecutor::task& _step );
+
+    void runStep( const ptr< ServerConnection >& _connection, const WorkStealingExecutor::task& _step );
+
+    int getTimeoutMs();
+
+public:
+
+    // _acceptHandler runs on the loop thread and starts the protocol of a new connection,
+    // _dispatcher runs protocol steps, usually on the executor
+    EpollServerLoop( const string& _name, int _listenDescriptor, const AcceptHandler& _acceptHandler,
+        const Dispatcher& _dispatcher );
+
+    ~EpollServerLoop();
+
+    // blocks until _exitRequested returns true after a wakeup or shutdown() is called
+    void run( const function< bool() >& _exitRequested );
+
+    void shutdown();
+
+    // _handler runs through the dispatcher
+    void readBytes( const ptr< ServerConnection >& _connection, uint64_t _len,
+        const ReadHandler& _handler );
+
+    // _handler runs on the loop thread and must not block
+    void readBytesInline( const ptr< ServerConnection >& _connection, uint64_t _len,
+        const ReadHandler& _handler );
+
+    void send( const ptr< ServerConnection >& _connection, const ptr< vector< uint8_t > >& _bytes,
+        uint64_t _notBeforeMs = 0 );
+
+    // sends bytes [_begin, _end) of _bytes without copying them
+    void send( const ptr< ServerConnection >& _connection, const ptr< vector< uint8_t > >& _bytes,
+        uint64_t _begin, uint64_t _end, uint64_t _notBeforeMs );
+
+    // makes the loop look at the connection again
+    void wakeup( const ptr< ServerConnection >& _connection );
+
+    uint64_t getAcceptedConnectionCount() const;
+};
+
+
+#endif  // SKALED_EPOLLSERVERLOOP_H
@@ -0,0 +1,260 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file EpollServerTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "utils/Time.h"
+
+#include "EpollServerLoop.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t EPOLL_TEST_SLOW_PEERS = 16;
+static constexpr uint64_t EPOLL_TEST_WORKERS = 2;
+static constexpr uint64_t EPOLL_TEST_LARGE_PAYLOAD = 4 * 1024 * 1024;
+static constexpr uint64_t EPOLL_TEST_STEP_DELAY_MS = 100;
+
+
+// echo server: a length prefixed request is sent back to the client.
+// In keep alive mode the connection then waits for the next request, which is read by a step
+// dispatched from the previous step while it still runs
+class EchoServer {
+public:
+    bool keepAlive = false;
+    int listenDescriptor = 0;
+    uint16_t port = 0;
+    ptr< WorkStealingExecutor > executor;
+    ptr< EpollServerLoop > loop;
+    ptr< thread > loopThread;
+
+    explicit EchoServer( bool _keepAlive = false ) : keepAlive( _keepAlive ) {
+        listenDescriptor = socket( AF_INET, SOCK_STREAM, 0 );
+        CHECK_STATE( listenDescriptor > 0 );
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        address.sin_port = 0;
+
+        CHECK_STATE( ::bind( listenDescriptor, ( sockaddr* ) &address, sizeof( address ) ) == 0 );
+        CHECK_STATE( listen( listenDescriptor, SOCKET_BACKLOG ) == 0 );
+
+        socklen_t len = sizeof( address );
+        CHECK_STATE( getsockname( listenDescriptor, ( sockaddr* ) &address, &len ) == 0 );
+        port = ntohs( address.sin_port );
+
+        executor = make_shared< WorkStealingExecutor >( EPOLL_TEST_WORKERS );
+
+        loop = make_shared< EpollServerLoop >(
+            "EchoServer", listenDescriptor,
+            [this]( const ptr< ServerConnection >& _connection ) { acceptConnection( _connection ); },
+            [this]( const WorkStealingExecutor::task& _step ) {
+                executor->submit( PRIORITY_CATCHUP, _step );
+            } );
+
+        loopThread = make_shared< thread >( [this]() { loop->run( []() { return false; } ); } );
+    }
+
+    void acceptConnection( const ptr< ServerConnection >& _connection ) {
+        loop->readBytesInline( _connection, sizeof( uint64_t ),
+            [this, _connection]( const ptr< vector< uint8_t > >& _bytes ) {
+                readBody( _connection, _bytes );
+            } );
+    }
+
+    void readBody( const ptr< ServerConnection >& _connection,
+        const ptr< vector< uint8_t > >& _prefix ) {
+        auto len = *( uint64_t* ) _prefix->data();
+        CHECK_STATE( len > 0 && len <= EPOLL_TEST_LARGE_PAYLOAD );
+        loop->readBytes( _connection, len,
+            [this, _connection]( const ptr< vector< uint8_t > >& _body ) {
+                loop->send( _connection, _body );
+
+                if ( !keepAlive )
+                    return;
+
+                loop->readBytes( _connection, sizeof( uint64_t ),
+                    [this, _connection]( const ptr< vector< uint8_t > >& _bytes ) {
+                        // outlives the step that dispatched it
+                        usleep( 2 * EPOLL_TEST_STEP_DELAY_MS * 1000 );
+                        readBody( _connection, _bytes );
+                    } );
+
+                // the next request is already in the socket, so its step starts meanwhile
+                usleep( EPOLL_TEST_STEP_DELAY_MS * 1000 );
+            } );
+    }
+
+    ~EchoServer() {
+        loop->shutdown();
+        loopThread->join();
+        executor->shutdown();
+        loop = nullptr;
+        close( listenDescriptor );
+    }
+};
+
+
+static int connectToServer( uint16_t _port ) {
+    int descriptor = socket( AF_INET, SOCK_STREAM, 0 );
+    CHECK_STATE( descriptor > 0 );
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = htons( _port );
+
+    CHECK_STATE( connect( descriptor, ( sockaddr* ) &address, sizeof( address ) ) == 0 );
+
+    return descriptor;
+}
+
+
+static void writeAll( int _descriptor, const uint8_t* _data, uint64_t _len ) {
+    uint64_t written = 0;
+    while ( written < _len ) {
+        auto result = write( _descriptor, _data + written, _len - written );
+        CHECK_STATE( result > 0 );
+        written += result;
+    }
+}
+
+
+// returns the number of bytes read before the peer closed the socket
+static uint64_t readAll( int _descriptor, uint8_t* _data, uint64_t _len ) {
+    uint64_t bytesRead = 0;
+    while ( bytesRead < _len ) {
+        auto result = read( _descriptor, _data + bytesRead, _len - bytesRead );
+        if ( result <= 0 )
+            break;
+        bytesRead += result;
+    }
+    return bytesRead;
+}
+
+
+static vector< uint8_t > echo( uint16_t _port, const vector< uint8_t >& _payload ) {
+    auto descriptor = connectToServer( _port );
+
+    uint64_t len = _payload.size();
+    writeAll( descriptor, ( const uint8_t* ) &len, sizeof( len ) );
+    writeAll( descriptor, _payload.data(), _payload.size() );
+
+    vector< uint8_t > response( _payload.size() );
+    response.resize( readAll( descriptor, response.data(), response.size() ) );
+
+    close( descriptor );
+
+    return response;
+}
+
+
+TEST_CASE( "Slow peers do not hold server workers", "[epoll-server]" ) {
+    EchoServer server;
+
+    // each slow peer sends half of the length prefix and stalls
+    vector< int > slowPeers;
+
+    for ( uint64_t i = 0; i < EPOLL_TEST_SLOW_PEERS; i++ ) {
+        auto descriptor = connectToServer( server.port );
+        uint32_t half = 0;
+        writeAll( descriptor, ( const uint8_t* ) &half, sizeof( half ) );
+        slowPeers.push_back( descriptor );
+    }
+
+    vector< uint8_t > payload( 1024 );
+    for ( uint64_t i = 0; i < payload.size(); i++ ) {
+        payload[i] = ( uint8_t ) i;
+    }
+
+    auto begin = Time::getSteadyTimeMs();
+
+    REQUIRE( echo( server.port, payload ) == payload );
+
+    // the request is served while all slow peers are still connected
+    REQUIRE( Time::getSteadyTimeMs() - begin < SERVER_IO_TIMEOUT_MS );
+    REQUIRE( server.executor->getWorkerCount() <= EPOLL_TEST_WORKERS );
+
+    // stalled peers are disconnected once their deadline passes
+    uint8_t byte;
+    for ( auto descriptor : slowPeers ) {
+        REQUIRE( read( descriptor, &byte, 1 ) == 0 );
+        close( descriptor );
+    }
+
+    REQUIRE( Time::getSteadyTimeMs() - begin >= SERVER_IO_TIMEOUT_MS );
+    REQUIRE( server.loop->getAcceptedConnectionCount() == EPOLL_TEST_SLOW_PEERS + 1 );
+}
+
+
+TEST_CASE( "Large responses are written incrementally", "[epoll-server]" ) {
+    EchoServer server;
+
+    vector< uint8_t > payload( EPOLL_TEST_LARGE_PAYLOAD );
+    for ( uint64_t i = 0; i < payload.size(); i++ ) {
+        payload[i] = ( uint8_t )( i * 7 );
+    }
+
+    vector< ptr< thread > > clients;
+    atomic< uint64_t > matched = 0;
+
+    for ( int i = 0; i < 4; i++ ) {
+        clients.push_back( make_shared< thread >( [&server, &payload, &matched]() {
+            if ( echo( server.port, payload ) == payload )
+                matched++;
+        } ) );
+    }
+
+    for ( auto&& client : clients ) {
+        client->join();
+    }
+
+    REQUIRE( matched == 4 );
+}
+
+
+TEST_CASE( "Pipelined requests are served on one connection", "[epoll-server]" ) {
+    EchoServer server( true );
+
+    vector< uint8_t > first( 1024, 1 );
+    vector< uint8_t > second( 2048, 2 );
+
+    auto descriptor = connectToServer( server.port );
+
+    // both requests are sent before the first response is read
+    for ( auto&& payload : { first, second } ) {
+        uint64_t len = payload.size();
+        writeAll( descriptor, ( const uint8_t* ) &len, sizeof( len ) );
+        writeAll( descriptor, payload.data(), payload.size() );
+    }
+
+    vector< uint8_t > response( first.size() + second.size() );
+    response.resize( readAll( descriptor, response.data(), response.size() ) );
+
+    close( descriptor );
+
+    REQUIRE( response.size() == first.size() + second.size() );
+    REQUIRE( equal( first.begin(), first.end(), response.begin() ) );
+    REQUIRE( equal( second.begin(), second.end(), response.begin() + first.size() ) );
+}
@@ -66,9 +66,10 @@
 #include "headers/BlockProposalRequestHeader.h"
 #include "monitoring/LivelinessMonitor.h"
 #include "pendingqueue/PendingTransactionsAgent.h"
+#include "threads/WorkStealingExecutor.h"
+#include "utils/Time.h"
 
 #include "BlockFinalizeDownloader.h"
-#include "BlockFinalizeDownloaderThreadPool.h"
 
 
 BlockFinalizeDownloader::BlockFinalizeDownloader(Schain *_sChain, block_id _blockId, schain_index _proposerIndex)
@@ -97,33 +98,48 @@ BlockFinalizeDownloader::BlockFinalizeDownloader(Schain *_sChain, block_id _bloc
 nlohmann::json BlockFinalizeDownloader::readBlockFinalizeResponseHeader(const ptr<ClientSocket>& _socket) {
     MONITOR(__CLASS_NAME__, __FUNCTION__)
     CHECK_ARGUMENT(_socket)
-    return getSchain()->getIo()->readJsonHeader(_socket->getDescriptor(), "Read BlockFinalize response");
+    return getSchain()->getIo()->readJsonHeader(_socket->getDescriptor(), "Read BlockFinalize response",
+                                                MAX_HEADER_SIZE, _socket->getDeadlineMs());
 }
 
 
-uint64_t BlockFinalizeDownloader::downloadFragment(schain_index _dstIndex, fragment_index _fragmentIndex) {
+uint64_t BlockFinalizeDownloader::downloadFragment(schain_index _dstIndex, fragment_index _fragmentIndex,
+                                                   ptr<ClientSocket>& _socket) {
+
+    ptr<ClientSocket> socket = nullptr;
 
     try {
 
         auto header = make_shared<BlockFinalizeRequestHeader>(*sChain, blockId, proposerIndex,
-                this->getNode()->getNodeID(), _fragmentIndex);
+                this->getNode()->getNodeID(), _fragmentIndex, true);
         CHECK_STATE(_dstIndex != (uint64_t) getSchain()->getSchainIndex())
-        auto socket = make_shared<ClientSocket>(*sChain, _dstIndex, CATCHUP);
-        auto io = getSchain()->getIo();
 
+        if (_socket == nullptr) {
+            _socket = make_shared<ClientSocket>(*sChain, _dstIndex, CATCHUP);
+        } else {
+            _socket->startRequest();
+        }
 
-        try {
-            io->writeMagic(socket);
-        } catch (ExitRequestedException &) { throw; } catch (...) {
-            throw_with_nested(
-                    NetworkProtocolException("BlockFinalizec: Server disconnect sending magic", __CLASS_NAME__));
+        // a failed request leaves the connection in an unknown state
+        socket = _socket;
+        _socket = nullptr;
+
+        if (!startRequest(socket)) {
+            // the other nodes sent enough fragments meanwhile
+            _socket = socket;
+            return 0;
         }
 
+        auto io = getSchain()->getIo();
+
+
         try {
-            io->writeHeader(socket, header);
+            io->writeMagicAndHeader(socket, header);
         } catch (ExitRequestedException &) { throw; } catch (...) {
             auto errString = "BlockFinalizec step 1: can not write BlockFinalize request";
-            LOG(err, errString);
+            // a request to a slow node is shut down once the list is complete
+            if (!isComplete())
+                LOG(err, errString);
             throw_with_nested(NetworkProtocolException(errString, __CLASS_NAME__));
         }
         LOG(debug, "BlockFinalizec step 1: wrote BlockFinalize request");
@@ -134,7 +150,9 @@ uint64_t BlockFinalizeDownloader::downloadFragment(schain_index _dstIndex, fragm
             response = readBlockFinalizeResponseHeader(socket);
         } catch (ExitRequestedException &) { throw; } catch (...) {
             auto errString = "BlockFinalizec step 2: can not read BlockFinalize response";
-            LOG(err, errString);
+            // a request to a slow node is shut down once the list is complete
+            if (!isComplete())
+                LOG(err, errString);
             throw_with_nested(NetworkProtocolException(errString, __CLASS_NAME__));
         }
 
@@ -145,6 +163,7 @@ uint64_t BlockFinalizeDownloader::downloadFragment(schain_index _dstIndex, fragm
 
         if (status == CONNECTION_DISCONNECT) {
             LOG(debug, "BlockFinalizec got response::no fragment");
+            finishRequest(socket);
             return 0;
         }
 
@@ -162,20 +181,33 @@ uint64_t BlockFinalizeDownloader::downloadFragment(schain_index _dstIndex, fragm
             CHECK_ARGUMENT(blockFragment)
         } catch (ExitRequestedException &) { throw; } catch (...) {
             auto errString = "BlockFinalizec step 3: can not read fragment";
-            LOG(err, errString);
+            // a request to a slow node is shut down once the list is complete
+            if (!isComplete())
+                LOG(err, errString);
             throw_with_nested(NetworkProtocolException(errString, __CLASS_NAME__));
         }
 
 
+        _socket = socket;
+
         uint64_t next = 0;
 
         fragmentList.addFragment(blockFragment, next);
 
+        finishRequest(socket);
+
+        if (fragmentList.isComplete())
+            setComplete();
+
         LOG(debug, "BlockFinalizec success");
 
         return next;
 
-    } catch (ExitRequestedException &e) { throw; } catch (...) {
+    } catch (ExitRequestedException &e) {
+        finishRequest(socket);
+        throw;
+    } catch (...) {
+        finishRequest(socket);
         throw_with_nested(InvalidStateException(__FUNCTION__, __CLASS_NAME__));
     }
 
@@ -225,7 +257,7 @@ BlockFinalizeDownloader::readBlockFragment(const ptr<ClientSocket>& _socket, nlo
 
     try {
         getSchain()->getIo()->readBytes(_socket->getDescriptor(), serializedFragment,
-                                        msg_len(fragmentSize));
+                                        msg_len(fragmentSize), _socket->getDeadlineMs());
     } catch (ExitRequestedException &) {
         throw;
     } catch (...) {
@@ -248,7 +280,63 @@ BlockFinalizeDownloader::readBlockFragment(const ptr<ClientSocket>& _socket, nlo
 }
 
 
-void BlockFinalizeDownloader::workerThreadFragmentDownloadLoop(BlockFinalizeDownloader * _agent, schain_index _dstIndex) {
+bool BlockFinalizeDownloader::startRequest(const ptr<ClientSocket>& _socket) {
+    CHECK_ARGUMENT(_socket);
+
+    lock_guard<mutex> lock(messageMutex);
+
+    if (complete)
+        return false;
+
+    inFlightSockets.insert(_socket);
+
+    return true;
+}
+
+void BlockFinalizeDownloader::finishRequest(const ptr<ClientSocket>& _socket) {
+    if (!_socket)
+        return;
+
+    lock_guard<mutex> lock(messageMutex);
+    inFlightSockets.erase(_socket);
+}
+
+void BlockFinalizeDownloader::setComplete() {
+    {
+        lock_guard<mutex> lock(messageMutex);
+
+        if (complete)
+            return;
+
+        complete = true;
+
+        // the peer may still be sending, the next request on the socket would read the rest
+        for (auto&& socket : inFlightSockets) {
+            socket->shutdownSocket();
+        }
+    }
+
+    messageCond.notify_all();
+}
+
+void BlockFinalizeDownloader::taskFinished() {
+    {
+        lock_guard<mutex> lock(messageMutex);
+        CHECK_STATE(runningTasks > 0);
+        runningTasks--;
+    }
+
+    messageCond.notify_all();
+}
+
+bool BlockFinalizeDownloader::isComplete() {
+    lock_guard<mutex> lock(messageMutex);
+    return complete;
+}
+
+
+void BlockFinalizeDownloader::fragmentDownloadTask(
+    const ptr<BlockFinalizeDownloader>& _agent, schain_index _dstIndex) {
 
 
     CHECK_STATE( _agent );
@@ -263,10 +351,6 @@ void BlockFinalizeDownloader::workerThreadFragmentDownloadLoop(BlockFinalizeDown
     auto sChainIndex = sChain->getSchainIndex();
     bool testFinalizationDownloadOnly = node->getTestConfig()->isFinalizationDownloadOnly();
 
-    setThreadName("BlckFinLoop", node->getConsensusEngine());
-
-
-
     node->waitOnGlobalClientStartBarrier();
 
 
@@ -278,6 +362,9 @@ void BlockFinalizeDownloader::workerThreadFragmentDownloadLoop(BlockFinalizeDown
 
     uint64_t nextFragment;
 
+    // the fragments from this node are downloaded over one connection
+    ptr<ClientSocket> socket = nullptr;
+
     if (_dstIndex > (uint64_t) sChainIndex) {
         nextFragment = ( uint64_t ) _dstIndex - 1;
     } else {
@@ -288,6 +375,11 @@ void BlockFinalizeDownloader::workerThreadFragmentDownloadLoop(BlockFinalizeDown
 
         while (!node->isExitRequested()) {
 
+            // the remaining fragments have been downloaded from other nodes
+            if (_agent->fragmentList.isComplete()) {
+                return;
+            }
+
             if (!testFinalizationDownloadOnly) {
                 // take into account that the block can
                 //  be in parallel committed through catchup
@@ -309,20 +401,25 @@ void BlockFinalizeDownloader::workerThreadFragmentDownloadLoop(BlockFinalizeDown
             }
 
             try {
-                nextFragment = _agent->downloadFragment(_dstIndex, nextFragment);
+                nextFragment = _agent->downloadFragment(_dstIndex, nextFragment, socket);
                 if (nextFragment == 0) {
                     // all fragments have been downloaded
                     return;
                 }
+                continue;
             } catch (ExitRequestedException &) {
                 return;
             } catch (ConnectionRefusedException &e) {
                 _agent->logConnectionRefused(e, _dstIndex);
-                usleep( static_cast< __useconds_t >( node->getWaitAfterNetworkErrorMs() * 1000 ) );
             } catch (exception &e) {
+                // the request was shut down since the other nodes completed the list
+                if (_agent->isComplete())
+                    return;
                 SkaleException::logNested(e);
-                usleep( static_cast< __useconds_t >( node->getWaitAfterNetworkErrorMs() * 1000 ) );
             };
+
+            WorkStealingExecutor::BlockingScope blocking;
+            usleep( static_cast< __useconds_t >( node->getWaitAfterNetworkErrorMs() * 1000 ) );
         };
     } catch (FatalError& e) {
         node->exitOnFatalError(e.getMessage());
@@ -333,12 +430,45 @@ ptr<BlockProposal> BlockFinalizeDownloader::downloadProposal() {
 
     MONITOR(__CLASS_NAME__, __FUNCTION__);
 
+    auto startTimeMs = Time::getSteadyTimeMs();
+
+    // the tasks that still wait for slow nodes outlive this call
+    auto self = shared_from_this();
+
     {
-        threadPool = make_shared<BlockFinalizeDownloaderThreadPool>((uint64_t) getSchain()->getNodeCount(), this);
-        threadPool->startService();
-        threadPool->joinAll();
+        lock_guard<mutex> lock(messageMutex);
+        runningTasks = (uint64_t) getSchain()->getNodeCount() - 1;
     }
 
+    auto executor = getNode()->getConsensusEngine()->getExecutor();
+
+    for (uint64_t i = 1; i <= (uint64_t) getSchain()->getNodeCount(); i++) {
+        // the node does not download from itself
+        if (i == getSchain()->getSchainIndex())
+            continue;
+        auto dstIndex = schain_index(i);
+        executor->submit(PRIORITY_PROPOSAL, [self, dstIndex]() {
+            try {
+                fragmentDownloadTask(self, dstIndex);
+            } catch (...) {
+                self->taskFinished();
+                throw;
+            }
+            self->taskFinished();
+        });
+    }
+
+    {
+        // another executor worker may run while this one waits for the nodes
+        WorkStealingExecutor::BlockingScope blocking;
+
+        unique_lock<mutex> lock(messageMutex);
+        messageCond.wait(lock, [this]() { return complete || runningTasks == 0; });
+    }
+
+    totalDownloads++;
+    totalDownloadTimeMs += Time::getSteadyTimeMs() - startTimeMs;
+
     try {
 
         if (fragmentList.isComplete()) {
@@ -364,4 +494,16 @@ schain_index BlockFinalizeDownloader::getProposerIndex() {
     return proposerIndex;
 }
 
+uint64_t BlockFinalizeDownloader::getTotalDownloads() {
+    return totalDownloads;
+}
+
+uint64_t BlockFinalizeDownloader::getTotalDownloadTimeMs() {
+    return totalDownloadTimeMs;
+}
+
+atomic<uint64_t> BlockFinalizeDownloader::totalDownloads(0);
+
+atomic<uint64_t> BlockFinalizeDownloader::totalDownloadTimeMs(0);
+
 
@@ -55,12 +55,16 @@ class BlockFinalizeResponseHeader;
 class BlockProposalFragment;
 class BlockProposalFragmentList;
 class BlockProposal;
-class BlockFinalizeDownloaderThreadPool;
 class BlockProposalSet;
 
 #include "datastructures/BlockProposalFragmentList.h"
 
-class BlockFinalizeDownloader : public Agent {
+// Downloads the fragments of a proposal from all other nodes in parallel. downloadProposal()
+// returns as soon as the fragment list is complete, requests still in flight to slow nodes are
+// shut down. The download tasks keep the downloader alive until they return.
+
+class BlockFinalizeDownloader : public Agent,
+                                public enable_shared_from_this< BlockFinalizeDownloader > {
 
     block_id blockId = 0;
 
@@ -68,19 +72,44 @@ class BlockFinalizeDownloader : public Agent {
 
     BlockProposalFragmentList fragmentList;
 
-public:
+    // messageMutex guards the following and messageCond signals downloadProposal()
+
+    uint64_t runningTasks = 0;
+
+    bool complete = false;
+
+    // sockets of the requests in flight
+    set< ptr< ClientSocket > > inFlightSockets;
+
+    // returns false if the list is already complete, the request is not sent then
+    bool startRequest( const ptr< ClientSocket >& _socket );
+
+    void finishRequest( const ptr< ClientSocket >& _socket );
+
+    // shuts down the requests in flight and wakes up downloadProposal()
+    void setComplete();
 
-    ptr<BlockFinalizeDownloaderThreadPool> threadPool = nullptr;
+    void taskFinished();
+
+    static atomic<uint64_t> totalDownloads;
+
+    static atomic<uint64_t> totalDownloadTimeMs;
+
+public:
 
     BlockFinalizeDownloader(Schain *_sChain, block_id _blockId, schain_index _proposerIndex);
 
 
     ~BlockFinalizeDownloader() override;
 
-    uint64_t downloadFragment(schain_index _dstIndex, fragment_index _fragmentIndex);
+    // _socket is kept open for the next fragment from the same node, it is created if null
+    // and reset after an error
+    uint64_t downloadFragment(schain_index _dstIndex, fragment_index _fragmentIndex,
+                              ptr<ClientSocket>& _socket);
 
 
-    static void workerThreadFragmentDownloadLoop(BlockFinalizeDownloader* _agent, schain_index _dstIndex );
+    static void fragmentDownloadTask(
+        const ptr< BlockFinalizeDownloader >& _agent, schain_index _dstIndex );
 
     nlohmann::json readBlockFinalizeResponseHeader( const ptr< ClientSocket >& _socket );
 
@@ -91,8 +120,11 @@ public:
 
     static uint64_t readFragmentSize(nlohmann::json _responseHeader);
 
+    // the downloader has to be owned by a shared_ptr
     ptr<BlockProposal> downloadProposal();
 
+    bool isComplete();
+
     uint64_t readBlockSize(nlohmann::json _responseHeader);
 
     string readBlockHash(nlohmann::json _responseHeader);
@@ -100,5 +132,10 @@ public:
     block_id getBlockId();
 
     schain_index getProposerIndex();
+
+    static uint64_t getTotalDownloads();
+
+    // the time spent in downloadProposal() by all downloaders
+    static uint64_t getTotalDownloadTimeMs();
 };
 
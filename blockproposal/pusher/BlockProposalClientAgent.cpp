@@ -55,7 +55,6 @@
 #include "pendingqueue/PendingTransactionsAgent.h"
 
 #include "BlockProposalClientAgent.h"
-#include "BlockProposalPusherThreadPool.h"
 #include "abstracttcpclient/AbstractClientAgent.h"
 #include "exceptions/ExitRequestedException.h"
 #include "exceptions/PingException.h"
@@ -64,10 +63,6 @@ BlockProposalClientAgent::BlockProposalClientAgent( Schain& _sChain )
     : AbstractClientAgent( _sChain, PROPOSAL ) {
     try {
         LOG( debug, "Constructing blockProposalPushAgent" );
-
-        this->blockProposalThreadPool = make_shared< BlockProposalPusherThreadPool >(
-            num_threads( ( uint64_t ) _sChain.getNodeCount() ), this );
-        blockProposalThreadPool->startService();
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
@@ -80,7 +75,8 @@ ptr< MissingTransactionsRequestHeader >
 BlockProposalClientAgent::readMissingTransactionsRequestHeader(
     const ptr< ClientSocket >& _socket ) {
     auto js =
-        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read missing trans request" );
+        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read missing trans request",
+        MAX_HEADER_SIZE, _socket->getDeadlineMs() );
     auto mtrh = make_shared< MissingTransactionsRequestHeader >();
 
     auto status = ( ConnectionStatus ) Header::getUint64( js, "status" );
@@ -99,7 +95,8 @@ ptr< FinalProposalResponseHeader >
 BlockProposalClientAgent::readAndProcessFinalProposalResponseHeader(
     const ptr< ClientSocket >& _socket ) {
     auto js =
-        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read final response header" );
+        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read final response header",
+        MAX_HEADER_SIZE, _socket->getDeadlineMs() );
 
     auto status = ( ConnectionStatus ) Header::getUint64( js, "status" );
     auto subStatus = ( ConnectionSubStatus ) Header::getUint64( js, "substatus" );
@@ -174,7 +171,8 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalClientAgent::sendBloc
     LOG( trace, "Proposal step 1: wrote proposal header" );
 
     auto response =
-        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read proposal resp" );
+        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read proposal resp",
+            MAX_HEADER_SIZE, _socket->getDeadlineMs() );
 
 
     LOG( trace, "Proposal step 2: read proposal response" );
@@ -203,8 +201,8 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalClientAgent::sendBloc
 
     if ( partialHashesList->getTransactionCount() > 0 ) {
         try {
-            getSchain()->getIo()->writeBytesVector(
-                _socket->getDescriptor(), partialHashesList->getPartialHashes() );
+            getSchain()->getIo()->writeBytesVector( _socket->getDescriptor(),
+                partialHashesList->getPartialHashes(), _socket->getDeadlineMs() );
         } catch ( ExitRequestedException& ) {
             throw;
         } catch ( ... ) {
@@ -268,33 +266,20 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalClientAgent::sendBloc
 
         auto mtrh = make_shared< MissingTransactionsResponseHeader >( missingTransactionsSizes );
 
-        try {
-            getSchain()->getIo()->writeHeader( _socket, mtrh );
-        } catch ( ExitRequestedException& ) {
-            throw;
-        } catch ( ... ) {
-            auto errString =
-                "Proposal: unexpected server disconnect writing missing txs response header";
-            throw_with_nested( NetworkProtocolException( errString, __CLASS_NAME__ ) );
-        }
-
-
-        LOG( trace, "Proposal step 5: sent missing transactions header" );
-
-
         auto missingTransactionsList = make_shared< TransactionList >( missingTransactions );
 
         try {
-            getSchain()->getIo()->writeBytesVector(
-                _socket->getDescriptor(), missingTransactionsList->serialize( false ) );
+            getSchain()->getIo()->writeHeaderAndBytes(
+                _socket, mtrh, missingTransactionsList->serialize( false ) );
         } catch ( ExitRequestedException& ) {
             throw;
         } catch ( ... ) {
-            auto errString = "Proposal: unexpected server disconnect  writing missing hashes";
+            auto errString =
+                "Proposal: unexpected server disconnect writing missing transactions";
             throw_with_nested( NetworkProtocolException( errString, __CLASS_NAME__ ) );
         }
 
-        LOG( trace, "Proposal step 6: sent missing transactions" );
+        LOG( trace, "Proposal step 5: sent missing transactions header and transactions" );
     }
 
     auto finalHeader = readAndProcessFinalProposalResponseHeader( _socket );
@@ -365,7 +350,8 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalClientAgent::sendDAPr
     LOG( trace, "DA proof step 1: wrote request header" );
 
     auto response =
-        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read proposal resp" );
+        sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read proposal resp",
+            MAX_HEADER_SIZE, _socket->getDeadlineMs() );
 
 
     LOG( trace, "DAProof step 2: read response" );
@@ -404,7 +390,8 @@ BlockProposalClientAgent::readMissingHashes( const ptr< ClientSocket >& _socket,
 
 
     try {
-        getSchain()->getIo()->readBytes( _socket->getDescriptor(), buffer, msg_len( bytesToRead ) );
+        getSchain()->getIo()->readBytes(
+            _socket->getDescriptor(), buffer, msg_len( bytesToRead ), _socket->getDeadlineMs() );
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
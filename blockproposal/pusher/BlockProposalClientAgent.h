@@ -31,18 +31,12 @@
 
 class ClientSocket;
 class Schain;
-class BlockProposalPusherThreadPool;
 class BlockProposal;
 class DAProof;
 class MissingTransactionsRequestHeader;
 class FinalProposalResponseHeader;
 
 class BlockProposalClientAgent : public AbstractClientAgent {
-    ptr< BlockProposalPusherThreadPool > blockProposalThreadPool = nullptr;
-
-    friend class BlockProposalPusherThreadPool;
-
-
     ptr< MissingTransactionsRequestHeader > readMissingTransactionsRequestHeader(
         const ptr< ClientSocket >& _socket );
 
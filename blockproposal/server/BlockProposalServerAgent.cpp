@@ -79,18 +79,19 @@
 
 
 #include "BlockProposalServerAgent.h"
-#include "BlockProposalWorkerThreadPool.h"
 #include "crypto/ConsensusBLSSigShare.h"
 #include "headers/BlockFinalizeResponseHeader.h"
 #include "monitoring/LivelinessMonitor.h"
 
+#include "microprofile.h"
 
-ptr< unordered_map< ptr< partial_sha_hash >, ptr< Transaction >, PendingTransactionsAgent::Hasher,
-    PendingTransactionsAgent::Equal > >
-BlockProposalServerAgent::readMissingTransactions(
+
+void BlockProposalServerAgent::readMissingTransactions(
     const ptr< ServerConnection >& _connectionEnvelope,
-    nlohmann::json missingTransactionsResponseHeader ) {
+    nlohmann::json missingTransactionsResponseHeader,
+    const function< void( const ptr< transaction_map >& ) >& _handler ) {
     CHECK_ARGUMENT( _connectionEnvelope );
+    CHECK_ARGUMENT( _handler );
     CHECK_STATE( missingTransactionsResponseHeader > 0 );
 
     auto transactionSizes = make_shared< vector< uint64_t > >();
@@ -110,35 +111,30 @@ BlockProposalServerAgent::readMissingTransactions(
         totalSize += ( size_t ) size;
     }
 
-    auto serializedTransactions = make_shared< vector< uint8_t > >( totalSize );
-
-
-    try {
-        getSchain()->getIo()->readBytes(
-            _connectionEnvelope, serializedTransactions, msg_len( totalSize ) );
-    } catch ( ExitRequestedException& ) {
-        throw;
-    } catch ( ... ) {
+    if ( totalSize > MAX_BUFFER_SIZE ) {
         BOOST_THROW_EXCEPTION(
-            NetworkProtocolException( "Could not read serialized exceptions", __CLASS_NAME__ ) );
+            NetworkProtocolException( "Missing transactions too large", __CLASS_NAME__ ) );
     }
 
-    auto list = TransactionList::deserialize( transactionSizes, serializedTransactions, 0, false );
+    readBytes( _connectionEnvelope, totalSize,
+        [transactionSizes, _handler]( const ptr< vector< uint8_t > >& _serializedTransactions ) {
+            auto list = TransactionList::deserialize(
+                transactionSizes, _serializedTransactions, 0, false );
 
-    CHECK_STATE( list );
+            CHECK_STATE( list );
 
-    auto trs = list->getItems();
+            auto trs = list->getItems();
 
-    CHECK_STATE( trs );
+            CHECK_STATE( trs );
 
-    auto missed = make_shared< unordered_map< ptr< partial_sha_hash >, ptr< Transaction >,
-        PendingTransactionsAgent::Hasher, PendingTransactionsAgent::Equal > >();
+            auto missed = make_shared< transaction_map >();
 
-    for ( auto&& t : *trs ) {
-        ( *missed )[t->getPartialHash()] = t;
-    }
+            for ( auto&& t : *trs ) {
+                ( *missed )[t->getPartialHash()] = t;
+            }
 
-    return missed;
+            _handler( missed );
+        } );
 }
 
 pair< ptr< map< uint64_t, ptr< Transaction > > >, ptr< map< uint64_t, ptr< partial_sha_hash > > > >
@@ -153,15 +149,20 @@ BlockProposalServerAgent::getPresentAndMissingTransactions(
     auto presentTransactions = make_shared< map< uint64_t, ptr< Transaction > > >();
     auto missingHashes = make_shared< map< uint64_t, ptr< partial_sha_hash > > >();
 
+    vector< ptr< Transaction > > knownTransactions;
+
+    _sChain.getPendingTransactionsAgent()->getKnownTransactionsByPartialHashes(
+        _phList, knownTransactions );
+
+    CHECK_STATE( knownTransactions.size() == ( uint64_t ) transactionsCount );
+
     for ( uint64_t i = 0; i < transactionsCount; i++ ) {
-        auto hash = _phList->getPartialHash( i );
-        CHECK_STATE( hash );
-        auto transaction =
-            _sChain.getPendingTransactionsAgent()->getKnownTransactionByPartialHash( hash );
-        if ( transaction == nullptr ) {
+        if ( knownTransactions[i] == nullptr ) {
+            auto hash = _phList->getPartialHash( i );
+            CHECK_STATE( hash );
             ( *missingHashes )[i] = hash;
         } else {
-            ( *presentTransactions )[i] = transaction;
+            ( *presentTransactions )[i] = knownTransactions[i];
         }
     }
 
@@ -170,56 +171,28 @@ BlockProposalServerAgent::getPresentAndMissingTransactions(
 
 
 BlockProposalServerAgent::BlockProposalServerAgent(
-    Schain& _schain, const ptr< TCPServerSocket >& _s )
-    : AbstractServerAgent( "BlockPropSrv", _schain, _s ) {
-    blockProposalWorkerThreadPool =
-        make_shared< BlockProposalWorkerThreadPool >( num_threads( 1 ), this );
-    blockProposalWorkerThreadPool->startService();
+    Schain& _schain, const ptr< StreamServerSocket >& _s )
+    : AbstractServerAgent( "BlockPropSrv", _schain, _s, PRIORITY_PROPOSAL, 1 ) {
     createNetworkReadThread();
 }
 
 BlockProposalServerAgent::~BlockProposalServerAgent() {}
 
 
-void BlockProposalServerAgent::processNextAvailableConnection(
-    const ptr< ServerConnection >& _connection ) {
+void BlockProposalServerAgent::processRequest(
+    const ptr< ServerConnection >& _connection, nlohmann::json _request ) {
     MONITOR( __CLASS_NAME__, __FUNCTION__ );
 
     CHECK_ARGUMENT( _connection );
 
-    try {
-        sChain->getIo()->readMagic( _connection->getDescriptor() );
-    } catch ( ExitRequestedException& ) {
-        throw;
-    } catch ( PingException& ) {
-        return;
-    } catch ( ... ) {
-        throw_with_nested(
-            NetworkProtocolException( "Could not read magic number", __CLASS_NAME__ ) );
-    }
-
-
-    nlohmann::json clientRequest = nullptr;
-
-    try {
-        clientRequest = getSchain()->getIo()->readJsonHeader(
-            _connection->getDescriptor(), "Read proposal req" );
-    } catch ( ExitRequestedException& ) {
-        throw;
-    } catch ( ... ) {
-        throw_with_nested(
-            CouldNotSendMessageException( "Could not read proposal request", __CLASS_NAME__ ) );
-    }
-
-
-    auto type = Header::getString( clientRequest, "type" );
+    auto type = Header::getString( _request, "type" );
 
     CHECK_STATE( !type.empty() );
 
     if ( strcmp( type.data(), Header::BLOCK_PROPOSAL_REQ ) == 0 ) {
-        processProposalRequest( _connection, clientRequest );
+        processProposalRequest( _connection, _request );
     } else if ( strcmp( type.data(), Header::DA_PROOF_REQ ) == 0 ) {
-        processDAProofRequest( _connection, clientRequest );
+        processDAProofRequest( _connection, _request );
     } else {
         BOOST_THROW_EXCEPTION(
             NetworkProtocolException( "Uknown request type:" + type, __CLASS_NAME__ ) );
@@ -229,6 +202,7 @@ void BlockProposalServerAgent::processNextAvailableConnection(
 
 void BlockProposalServerAgent::processDAProofRequest(
     const ptr< ServerConnection >& _connection, nlohmann::json _daProofRequest ) {
+    MICROPROFILE_SCOPEI( "BlockProposalServerAgent", "processDAProofRequest", MP_CYAN );
     CHECK_ARGUMENT( _connection );
 
     ptr< SubmitDAProofRequestHeader > requestHeader = nullptr;
@@ -260,8 +234,9 @@ void BlockProposalServerAgent::processDAProofRequest(
     LOG( trace, "Got DA proof" );
 }
 
-pair< ConnectionStatus, ConnectionSubStatus > BlockProposalServerAgent::processProposalRequest(
+void BlockProposalServerAgent::processProposalRequest(
     const ptr< ServerConnection >& _connection, nlohmann::json _proposalRequest ) {
+    MICROPROFILE_SCOPEI( "BlockProposalServerAgent", "processProposalRequest", MP_CYAN );
     CHECK_ARGUMENT( _connection );
 
     ptr< BlockProposalRequestHeader > requestHeader = nullptr;
@@ -283,7 +258,7 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalServerAgent::processP
     try {
         send( _connection, responseHeader );
         if ( responseHeader->getStatusSubStatus().first != CONNECTION_PROCEED ) {
-            return responseHeader->getStatusSubStatus();
+            return;
         }
     } catch ( ExitRequestedException& ) {
         throw;
@@ -292,19 +267,22 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalServerAgent::processP
             NetworkProtocolException( "Couldnt send proposal response header", __CLASS_NAME__ ) );
     }
 
-    ptr< PartialHashesList > partialHashesList = nullptr;
+    // the rest of the protocol continues when the client has sent the partial hashes
+    readPartialHashes( _connection, requestHeader->getTxCount(),
+        [this, _connection, requestHeader]( const ptr< PartialHashesList >& _partialHashesList ) {
+            processPartialHashes( _connection, requestHeader, _partialHashesList );
+        } );
+}
+
 
-    try {
-        partialHashesList = readPartialHashes( _connection, requestHeader->getTxCount() );
-        CHECK_STATE( partialHashesList );
-    } catch ( ExitRequestedException& ) {
-        throw;
-    } catch ( ... ) {
-        throw_with_nested(
-            NetworkProtocolException( "Could not read partial hashes", __CLASS_NAME__ ) );
-    }
+void BlockProposalServerAgent::processPartialHashes( const ptr< ServerConnection >& _connection,
+    const ptr< BlockProposalRequestHeader >& _requestHeader,
+    const ptr< PartialHashesList >& _partialHashesList ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _requestHeader );
+    CHECK_ARGUMENT( _partialHashesList );
 
-    auto result = getPresentAndMissingTransactions( *sChain, responseHeader, partialHashesList );
+    auto result = getPresentAndMissingTransactions( *sChain, nullptr, _partialHashesList );
 
     auto presentTransactions = result.first;
     auto missingTransactionHashes = result.second;
@@ -324,66 +302,90 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalServerAgent::processP
             "Could not send missing hashes request requestHeader", __CLASS_NAME__ ) );
     }
 
-
-    ptr< unordered_map< ptr< partial_sha_hash >, ptr< Transaction >,
-        PendingTransactionsAgent::Hasher, PendingTransactionsAgent::Equal > >
-        missingTransactions = nullptr;
-
     if ( missingTransactionHashes->size() == 0 ) {
         LOG( debug, "Server: No missing partial hashes" );
-    } else {
-        LOG( debug, "Server: missing partial hashes" );
-        try {
-            getSchain()->getIo()->writePartialHashes(
-                _connection->getDescriptor(), missingTransactionHashes );
-        } catch ( ExitRequestedException& ) {
-            throw;
-        } catch ( ... ) {
-            BOOST_THROW_EXCEPTION( CouldNotSendMessageException(
-                "Could not send missing hashes  requestHeader", __CLASS_NAME__ ) );
-        }
+        storeProposal(
+            _connection, _requestHeader, _partialHashesList, presentTransactions, nullptr );
+        return;
+    }
 
+    LOG( debug, "Server: missing partial hashes" );
 
-        auto missingMessagesResponseHeader =
-            this->readMissingTransactionsResponseHeader( _connection );
+    auto buffer = make_shared< vector< uint8_t > >(
+        missingTransactionHashes->size() * PARTIAL_HASH_LEN );
 
-        missingTransactions = readMissingTransactions( _connection, missingMessagesResponseHeader );
+    uint64_t counter = 0;
+    for ( auto&& item : *missingTransactionHashes ) {
+        memcpy( buffer->data() + counter * PARTIAL_HASH_LEN, item.second->data(),
+            PARTIAL_HASH_LEN );
+        counter++;
+    }
 
-        if ( missingTransactions == nullptr ) {
-            BOOST_THROW_EXCEPTION( CouldNotReadPartialDataHashesException(
-                "Null missing transactions", __CLASS_NAME__ ) );
-        }
+    try {
+        sendBytes( _connection, buffer );
+    } catch ( ExitRequestedException& ) {
+        throw;
+    } catch ( ... ) {
+        BOOST_THROW_EXCEPTION( CouldNotSendMessageException(
+            "Could not send missing hashes  requestHeader", __CLASS_NAME__ ) );
+    }
+
+    readJsonHeader( _connection, "Read missing trans response",
+        [this, _connection, _requestHeader, _partialHashesList, presentTransactions](
+            nlohmann::json _missingMessagesResponseHeader ) {
+            readMissingTransactions( _connection, _missingMessagesResponseHeader,
+                [this, _connection, _requestHeader, _partialHashesList, presentTransactions](
+                    const ptr< transaction_map >& _missingTransactions ) {
+                    if ( _missingTransactions == nullptr ) {
+                        BOOST_THROW_EXCEPTION( CouldNotReadPartialDataHashesException(
+                            "Null missing transactions", __CLASS_NAME__ ) );
+                    }
+
+                    for ( auto&& item : *_missingTransactions ) {
+                        CHECK_STATE( item.second );
+                        sChain->getPendingTransactionsAgent()->pushKnownTransaction( item.second );
+                    }
+
+                    storeProposal( _connection, _requestHeader, _partialHashesList,
+                        presentTransactions, _missingTransactions );
+                } );
+        } );
+}
 
 
-        for ( auto&& item : *missingTransactions ) {
-            CHECK_STATE( item.second );
-            sChain->getPendingTransactionsAgent()->pushKnownTransaction( item.second );
-        }
-    }
+void BlockProposalServerAgent::storeProposal( const ptr< ServerConnection >& _connection,
+    const ptr< BlockProposalRequestHeader >& _requestHeader,
+    const ptr< PartialHashesList >& _partialHashesList,
+    const ptr< map< uint64_t, ptr< Transaction > > >& _presentTransactions,
+    const ptr< transaction_map >& _missingTransactions ) {
+    CHECK_ARGUMENT( _connection );
+    CHECK_ARGUMENT( _requestHeader );
+    CHECK_ARGUMENT( _partialHashesList );
+    CHECK_ARGUMENT( _presentTransactions );
 
     LOG( debug, "Storing block proposal" );
 
     auto transactions = make_shared< vector< ptr< Transaction > > >();
 
-    auto transactionCount = partialHashesList->getTransactionCount();
+    auto transactionCount = _partialHashesList->getTransactionCount();
 
     for ( uint64_t i = 0; i < transactionCount; i++ ) {
-        auto partialHash = partialHashesList->getPartialHash( i );
+        auto partialHash = _partialHashesList->getPartialHash( i );
         CHECK_STATE( partialHash );
 
         ptr< Transaction > transaction;
 
-        if ( presentTransactions->count( i ) > 0 ) {
-            transaction = presentTransactions->at( i );
-        } else {
-            transaction = ( *missingTransactions )[partialHash];
+        if ( _presentTransactions->count( i ) > 0 ) {
+            transaction = _presentTransactions->at( i );
+        } else if ( _missingTransactions ) {
+            transaction = ( *_missingTransactions )[partialHash];
         };
 
         if ( transaction == nullptr ) {
-            checkForOldBlock( requestHeader->getBlockId() );
-            CHECK_STATE( missingTransactions );
+            checkForOldBlock( _requestHeader->getBlockId() );
+            CHECK_STATE( _missingTransactions );
 
-            if ( missingTransactions->count( partialHash ) > 0 ) {
+            if ( _missingTransactions->count( partialHash ) > 0 ) {
                 LOG( err, "Found in missing" );
             }
 
@@ -396,20 +398,20 @@ pair< ConnectionStatus, ConnectionSubStatus > BlockProposalServerAgent::processP
     }
 
     CHECK_STATE( transactionCount == 0 || transactions->at( ( uint64_t ) transactionCount - 1 ) );
-    CHECK_STATE( requestHeader->getTimeStamp() > 0 );
+    CHECK_STATE( _requestHeader->getTimeStamp() > 0 );
 
     auto transactionList = make_shared< TransactionList >( transactions );
 
-    auto proposal = make_shared< ReceivedBlockProposal >( *sChain, requestHeader->getBlockId(),
-        requestHeader->getProposerIndex(), transactionList, requestHeader->getStateRoot(),
-        requestHeader->getTimeStamp(), requestHeader->getTimeStampMs(), requestHeader->getHash(),
-        requestHeader->getSignature() );
+    auto proposal = make_shared< ReceivedBlockProposal >( *sChain, _requestHeader->getBlockId(),
+        _requestHeader->getProposerIndex(), transactionList, _requestHeader->getStateRoot(),
+        _requestHeader->getTimeStamp(), _requestHeader->getTimeStampMs(), _requestHeader->getHash(),
+        _requestHeader->getSignature() );
 
     ptr< Header > finalResponseHeader = nullptr;
 
     try {
         if ( !getSchain()->getCryptoManager()->verifyProposalECDSA(
-                 proposal, requestHeader->getHash(), requestHeader->getSignature() ) ) {
+                 proposal, _requestHeader->getHash(), _requestHeader->getSignature() ) ) {
             finalResponseHeader = make_shared< FinalProposalResponseHeader >(
                 CONNECTION_ERROR, CONNECTION_SIGNATURE_DID_NOT_VERIFY );
             goto err;
@@ -435,8 +437,6 @@ err:
     CHECK_STATE( finalResponseHeader );
 
     send( _connection, finalResponseHeader );
-
-    return finalResponseHeader->getStatusSubStatus();
 }
 
 
@@ -710,38 +710,23 @@ ptr< Header > BlockProposalServerAgent::createFinalResponseHeader(
 }
 
 
-nlohmann::json BlockProposalServerAgent::readMissingTransactionsResponseHeader(
-    const ptr< ServerConnection >& _connectionEnvelope ) {
-    auto js = sChain->getIo()->readJsonHeader(
-        _connectionEnvelope->getDescriptor(), "Read missing trans response" );
-
-    return js;
-}
-
-ptr< PartialHashesList > AbstractServerAgent::readPartialHashes(
-    const ptr< ServerConnection >& _connectionEnvelope, transaction_count _txCount ) {
+void AbstractServerAgent::readPartialHashes( const ptr< ServerConnection >& _connectionEnvelope,
+    transaction_count _txCount, const function< void( const ptr< PartialHashesList >& ) >& _handler ) {
     CHECK_ARGUMENT( _connectionEnvelope );
+    CHECK_ARGUMENT( _handler );
 
     if ( _txCount > ( uint64_t ) getNode()->getMaxTransactionsPerBlock() ) {
         BOOST_THROW_EXCEPTION(
             NetworkProtocolException( "Too many transactions", __CLASS_NAME__ ) );
     }
 
-    auto partialHashesList = make_shared< PartialHashesList >( _txCount );
-
-    if ( ( uint64_t ) _txCount != 0 ) {
-        try {
-            getSchain()->getIo()->readBytes( _connectionEnvelope,
-                partialHashesList->getPartialHashes(),
-                msg_len(
-                    ( uint64_t ) partialHashesList->getTransactionCount() * PARTIAL_HASH_LEN ) );
-        } catch ( ExitRequestedException& ) {
-            throw;
-        } catch ( ... ) {
-            throw_with_nested( CouldNotReadPartialDataHashesException(
-                "Could not read partial hashes", __CLASS_NAME__ ) );
-        }
+    if ( ( uint64_t ) _txCount == 0 ) {
+        _handler( make_shared< PartialHashesList >( _txCount ) );
+        return;
     }
 
-    return partialHashesList;
+    readBytes( _connectionEnvelope, ( uint64_t ) _txCount * PARTIAL_HASH_LEN,
+        [_txCount, _handler]( const ptr< vector< uint8_t > >& _partialHashes ) {
+            _handler( make_shared< PartialHashesList >( _txCount, _partialHashes ) );
+        } );
 }
@@ -27,7 +27,6 @@
 #include "abstracttcpserver/ConnectionStatus.h"
 #include "pendingqueue/PendingTransactionsAgent.h"
 
-class BlockProposalWorkerThreadPool;
 class BlockFinalizeResponseHeader;
 class BlockProposalRequestHeader;
 class SubmitDAProofRequestHeader;
@@ -54,25 +53,42 @@ public:
 
 
 class BlockProposalServerAgent : public AbstractServerAgent {
-    ptr< BlockProposalWorkerThreadPool > blockProposalWorkerThreadPool;
 
+public:
+
+    using transaction_map = unordered_map< ptr< partial_sha_hash >, ptr< Transaction >,
+        PendingTransactionsAgent::Hasher, PendingTransactionsAgent::Equal >;
+
+private:
 
-    pair< ConnectionStatus, ConnectionSubStatus > processProposalRequest(
+    // the proposal protocol is processed in steps, each step runs when the client
+    // has sent the data it needs
+
+    void processProposalRequest(
         const ptr< ServerConnection >& _connection, nlohmann::json _proposalRequest );
 
+    void processPartialHashes( const ptr< ServerConnection >& _connection,
+        const ptr< BlockProposalRequestHeader >& _requestHeader,
+        const ptr< PartialHashesList >& _partialHashesList );
+
+    void storeProposal( const ptr< ServerConnection >& _connection,
+        const ptr< BlockProposalRequestHeader >& _requestHeader,
+        const ptr< PartialHashesList >& _partialHashesList,
+        const ptr< map< uint64_t, ptr< Transaction > > >& _presentTransactions,
+        const ptr< transaction_map >& _missingTransactions );
+
     void processDAProofRequest(
         const ptr< ServerConnection >& _connection, nlohmann::json _daProofRequest );
 
 
 public:
-    BlockProposalServerAgent( Schain& _schain, const ptr< TCPServerSocket >& _s );
+    BlockProposalServerAgent( Schain& _schain, const ptr< StreamServerSocket >& _s );
 
     ~BlockProposalServerAgent() override;
 
-    ptr< unordered_map< ptr< partial_sha_hash >, ptr< Transaction >,
-        PendingTransactionsAgent::Hasher, PendingTransactionsAgent::Equal > >
-    readMissingTransactions( const ptr< ServerConnection >& _connectionEnvelope,
-        nlohmann::json missingTransactionsResponseHeader );
+    void readMissingTransactions( const ptr< ServerConnection >& _connectionEnvelope,
+        nlohmann::json missingTransactionsResponseHeader,
+        const function< void( const ptr< transaction_map >& ) >& _handler );
 
 
     pair< ptr< map< uint64_t, ptr< Transaction > > >,
@@ -81,8 +97,6 @@ public:
         Schain& _sChain, const ptr< Header >, const ptr< PartialHashesList >& _phList );
 
 
-    BlockProposalWorkerThreadPool* getBlockProposalWorkerThreadPool() const;
-
     void checkForOldBlock( const block_id& _blockID );
 
     ptr< Header > createProposalResponseHeader(
@@ -94,11 +108,8 @@ public:
         const ptr< SubmitDAProofRequestHeader >& _header );
 
 
-    nlohmann::json readMissingTransactionsResponseHeader(
-        const ptr< ServerConnection >& _connectionEnvelope );
-
-
-    void processNextAvailableConnection( const ptr< ServerConnection >& _connection ) override;
+    void processRequest(
+        const ptr< ServerConnection >& _connection, nlohmann::json _request ) override;
 
     void signBlock( const ptr< BlockFinalizeResponseHeader >& _responseHeader,
         const ptr< CommittedBlock >& _block ) const;
@@ -42,8 +42,12 @@
 #include "network/Network.h"
 #include "pendingqueue/PendingTransactionsAgent.h"
 #include "sys/random.h"
+#include "node/ConsensusEngine.h"
+#include "threads/TimerWheel.h"
+#include "threads/WorkStealingExecutor.h"
+#include "datastructures/CommittedBlock.h"
 #include "CatchupClientAgent.h"
-#include "CatchupClientThreadPool.h"
+#include "CatchupRangeScheduler.h"
 
 
 CatchupClientAgent::CatchupClientAgent( Schain& _sChain ) : Agent( _sChain, false ) {
@@ -51,9 +55,22 @@ CatchupClientAgent::CatchupClientAgent( Schain& _sChain ) : Agent( _sChain, fals
         logThreadLocal_ = _sChain.getNode()->getLog();
         this->sChain = &_sChain;
 
-        if ( _sChain.getNodeCount() > 1 ) {
-            this->catchupClientThreadPool = make_shared< CatchupClientThreadPool >( 1, this );
-            catchupClientThreadPool->startService();
+        auto nodeCount = ( uint64_t ) _sChain.getNodeCount();
+
+        if ( nodeCount > 1 ) {
+            // start with a random index and then to round-robin
+            uint64_t startIndex;
+
+            do {
+                uint64_t random;
+                getrandom( &random, sizeof( random ), 0 );
+                startIndex = random % nodeCount + 1;
+            } while ( startIndex == ( uint64_t ) _sChain.getSchainIndex() );
+
+            syncDestination = schain_index( startIndex );
+            syncDelayMs = nextBackoffMs( 0, _sChain.getNode()->getCatchupIntervalMs() );
+
+            scheduleSync( syncDelayMs );
         }
     } catch ( ExitRequestedException& ) {
         throw;
@@ -67,32 +84,138 @@ nlohmann::json CatchupClientAgent::readCatchupResponseHeader(const ptr< ClientSo
     CHECK_ARGUMENT( _socket );
     auto result =
         sChain->getIo()->readJsonHeader( _socket->getDescriptor(), "Read catchup response",
-            MAX_CATCHUP_DOWNLOAD_BYTES);
+            MAX_CATCHUP_DOWNLOAD_BYTES, _socket->getDeadlineMs() );
     return result;
 }
 
 
-void CatchupClientAgent::sync( schain_index _dstIndex ) {
+bool CatchupClientAgent::sync( schain_index _dstIndex ) {
     LOG( debug, "Catchupc step 0: requesting blocks after " +
                     to_string( getSchain()->getLastCommittedBlockID() ) );
 
     auto header = make_shared< CatchupRequestHeader >( *sChain, _dstIndex );
-    CHECK_STATE(_dstIndex != (uint64_t ) getSchain()->getSchainIndex());
-    auto socket = make_shared< ClientSocket >( *sChain, _dstIndex, CATCHUP );
-    auto io = getSchain()->getIo();
-    CHECK_STATE( io );
+
+    block_id peerCommittedBlockID = 0;
+
+    auto committedBlockID = getSchain()->getLastCommittedBlockID();
+
+    bool blocksArrived = false;
 
     try {
-        io->writeMagic( socket );
+        // each batch is committed while the next batches are still being verified. The node
+        // proposes only once it has caught up, not for each block it is still behind on
+        blocksArrived = downloadBlocks( _dstIndex, header, peerCommittedBlockID,
+            [this]( const ptr< CommittedBlockList >& _batch, bool ) {
+                getSchain()->blockCommitsArrivedThroughCatchup( _batch, false );
+            } );
+
+        // the response was limited by maxCatchupDownloadBytes, download the rest from all nodes
+        if ( blocksArrived && peerCommittedBlockID > getSchain()->getLastCommittedBlockID() ) {
+            parallelSync( peerCommittedBlockID );
+        }
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
-        throw_with_nested( NetworkProtocolException(
-            "Catchupc: Server disconnect sending magic", __CLASS_NAME__ ) );
+        // the blocks committed before the failure still need the next proposal
+        if ( getSchain()->getLastCommittedBlockID() > committedBlockID )
+            getSchain()->catchupFinished();
+        throw;
     }
 
+    if ( getSchain()->getLastCommittedBlockID() > committedBlockID )
+        getSchain()->catchupFinished();
+
+    if ( !blocksArrived )
+        return false;
+
+    LOG( debug, "Catchupc success" );
+
+    return true;
+}
+
+
+void CatchupClientAgent::wakeup( block_id _blockID ) {
+    // every deferred message calls this, only a message past the last target wakes the agent
+    auto previous = wakeupBlockID.load();
+
+    do {
+        if ( ( uint64_t ) _blockID <= previous )
+            return;
+    } while ( !wakeupBlockID.compare_exchange_weak( previous, ( uint64_t ) _blockID ) );
+
+    if ( wakeupRequested.exchange( true ) )
+        return;
+
+    lock_guard< mutex > lock( syncLock );
+
+    // a running step sees the request when it schedules the next one
+    if ( syncTimerId == 0 )
+        return;
+
+    auto timerWheel = getNode()->getConsensusEngine()->getTimerWheel();
+
+    // the timer may have just fired, then the step sees the request
+    if ( timerWheel->cancel( syncTimerId ) ) {
+        syncTimerId = 0;
+        // no step runs now, the woken step starts backing off again
+        wakeupRequested = false;
+        syncDelayMs = 0;
+        try {
+            getNode()->getConsensusEngine()->getExecutor()->submit(
+                PRIORITY_CATCHUP, [this]() { syncStep(); } );
+        } catch ( ExitRequestedException& ) {
+        }
+    }
+}
+
+
+void CatchupClientAgent::scheduleSync( uint64_t _delayMs ) {
+    lock_guard< mutex > lock( syncLock );
+
+    // other nodes are ahead, start backing off again after this request
+    if ( wakeupRequested.exchange( false ) ) {
+        _delayMs = 0;
+        syncDelayMs = 0;
+    }
+
+    try {
+        if ( _delayMs == 0 ) {
+            syncTimerId = 0;
+            getNode()->getConsensusEngine()->getExecutor()->submit(
+                PRIORITY_CATCHUP, [this]() { syncStep(); } );
+        } else {
+            syncTimerId = getNode()->getConsensusEngine()->getTimerWheel()->schedule(
+                _delayMs, PRIORITY_CATCHUP, [this]() {
+                    {
+                        lock_guard< mutex > lock( syncLock );
+                        syncTimerId = 0;
+                    }
+                    syncStep();
+                } );
+        }
+    } catch ( ExitRequestedException& ) {
+        // the executor has been shut down
+    }
+}
+
+
+uint64_t CatchupClientAgent::nextBackoffMs( uint64_t _delayMs, uint64_t _maxDelayMs ) {
+    return min( max( _delayMs * 2, CATCHUP_MIN_BACKOFF_MS ), _maxDelayMs );
+}
+
+
+bool CatchupClientAgent::downloadBlocks( schain_index _dstIndex,
+    const ptr< CatchupRequestHeader >& _header, block_id& _peerCommittedBlockID,
+    const batch_handler& _handler ) {
+    CHECK_ARGUMENT( _header );
+    CHECK_ARGUMENT( _handler );
+    CHECK_STATE(_dstIndex != (uint64_t ) getSchain()->getSchainIndex());
+    auto socket = make_shared< ClientSocket >( *sChain, _dstIndex, CATCHUP );
+    auto io = getSchain()->getIo();
+    CHECK_STATE( io );
+
     try {
-        io->writeHeader( socket, header );
+        io->writeMagicAndHeader( socket, _header );
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
@@ -117,11 +240,16 @@ void CatchupClientAgent::sync( schain_index _dstIndex ) {
 
     LOG( debug, "Catchupc step 2: read catchup response header" );
 
+    // older nodes do not report their last block
+    if ( response.find( "committedBlockID" ) != response.end() ) {
+        _peerCommittedBlockID = Header::getUint64( response, "committedBlockID" );
+    }
+
     auto status = ( ConnectionStatus ) Header::getUint64( response, "status" );
 
     if ( status == CONNECTION_DISCONNECT ) {
         LOG( debug, "Catchupc got response::no missing blocks" );
-        return;
+        return false;
     }
 
 
@@ -131,12 +259,11 @@ void CatchupClientAgent::sync( schain_index _dstIndex ) {
     }
 
 
-    ptr< CommittedBlockList > blocks;
+    uint64_t blockCount = 0;
 
 
     try {
-        blocks = readMissingBlocks( socket, response );
-        CHECK_STATE( blocks );
+        blockCount = readMissingBlocks( socket, response, _handler );
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
@@ -145,12 +272,145 @@ void CatchupClientAgent::sync( schain_index _dstIndex ) {
         throw_with_nested( NetworkProtocolException( errString, __CLASS_NAME__ ) );
     }
 
-    LOG( debug, "Catchupc step 3: got missing blocks:" + to_string( blocks->getBlocks()->size() ) );
+    LOG( debug, "Catchupc step 3: got missing blocks:" + to_string( blockCount ) );
 
-    getSchain()->blockCommitsArrivedThroughCatchup( blocks );
-    LOG( debug, "Catchupc success" );
+    return true;
 }
 
+
+void CatchupClientAgent::parallelSync( block_id _lastBlockID ) {
+    auto firstBlockID = ( uint64_t ) getSchain()->getLastCommittedBlockID() + 1;
+
+    if ( firstBlockID > ( uint64_t ) _lastBlockID )
+        return;
+
+    LOG( info, "Catchupc parallel download of blocks " + to_string( firstBlockID ) + " to " +
+                   to_string( ( uint64_t ) _lastBlockID ) );
+
+    auto scheduler = make_shared< CatchupRangeScheduler >(
+        firstBlockID, ( uint64_t ) _lastBlockID, CATCHUP_RANGE_BLOCKS );
+
+    vector< WorkStealingExecutor::task > tasks;
+
+    for ( uint64_t i = 1; i <= ( uint64_t ) getSchain()->getNodeCount(); i++ ) {
+        if ( i == getSchain()->getSchainIndex() )
+            continue;
+        auto dstIndex = schain_index( i );
+        tasks.push_back( [this, scheduler, dstIndex]() { downloadRanges( scheduler, dstIndex ); } );
+    }
+
+    getNode()->getConsensusEngine()->getExecutor()->submitAndWait( PRIORITY_CATCHUP, tasks );
+
+    if ( !scheduler->isComplete() ) {
+        LOG( info, "Catchupc parallel download stopped at block " +
+                       to_string( scheduler->getNextReadyBlockID() ) );
+    }
+}
+
+
+void CatchupClientAgent::downloadRanges(
+    const ptr< CatchupRangeScheduler >& _scheduler, schain_index _dstIndex ) {
+    CHECK_ARGUMENT( _scheduler );
+
+    uint64_t firstBlockID = 0;
+    uint64_t lastBlockID = 0;
+
+    // a node that fails a range is not asked again, its range goes to the other nodes
+    while ( _scheduler->claimRange( firstBlockID, lastBlockID ) ) {
+        ptr< CommittedBlockList > blocks = nullptr;
+
+        try {
+            getNode()->exitCheck();
+
+            auto header = make_shared< CatchupRequestHeader >(
+                *sChain, _dstIndex, block_id( firstBlockID - 1 ), block_id( lastBlockID ) );
+
+            block_id peerCommittedBlockID = 0;
+
+            auto received = make_shared< vector< ptr< CommittedBlock > > >();
+
+            // the range is committed as a whole once the ranges before it have arrived
+            auto blocksArrived = downloadBlocks( _dstIndex, header, peerCommittedBlockID,
+                [received]( const ptr< CommittedBlockList >& _batch, bool ) {
+                    auto batchBlocks = _batch->getBlocks();
+                    received->insert( received->end(), batchBlocks->begin(), batchBlocks->end() );
+                } );
+
+            if ( blocksArrived ) {
+                blocks = make_shared< CommittedBlockList >( received );
+                checkRange( blocks, firstBlockID, lastBlockID );
+            }
+        } catch ( ExitRequestedException& ) {
+            _scheduler->rangeFailed( firstBlockID, lastBlockID );
+            throw;
+        } catch ( ConnectionRefusedException& e ) {
+            _scheduler->rangeFailed( firstBlockID, lastBlockID );
+            logConnectionRefused( e, _dstIndex );
+            return;
+        } catch ( exception& e ) {
+            _scheduler->rangeFailed( firstBlockID, lastBlockID );
+            SkaleException::logNested( e );
+            return;
+        }
+
+        if ( !blocks ) {
+            // the node does not have these blocks yet
+            _scheduler->rangeFailed( firstBlockID, lastBlockID );
+            return;
+        }
+
+        auto receivedBlockID = ( uint64_t ) blocks->getBlocks()->back()->getBlockID();
+
+        _scheduler->rangeArrived( firstBlockID, lastBlockID, receivedBlockID, blocks );
+
+        commitReadyBlocks( _scheduler );
+    }
+}
+
+
+void CatchupClientAgent::checkRange(
+    const ptr< CommittedBlockList >& _blocks, uint64_t _firstBlockID, uint64_t _lastBlockID ) {
+    CHECK_ARGUMENT( _blocks );
+
+    auto blocks = _blocks->getBlocks();
+
+    CHECK_STATE( blocks );
+
+    if ( blocks->empty() ) {
+        BOOST_THROW_EXCEPTION(
+            NetworkProtocolException( "Empty catchup range", __CLASS_NAME__ ) );
+    }
+
+    auto expectedBlockID = _firstBlockID;
+
+    for ( auto&& block : *blocks ) {
+        CHECK_STATE( block );
+        if ( ( uint64_t ) block->getBlockID() != expectedBlockID ||
+             expectedBlockID > _lastBlockID ) {
+            BOOST_THROW_EXCEPTION( NetworkProtocolException(
+                "Unexpected block in catchup range:" +
+                    to_string( ( uint64_t ) block->getBlockID() ),
+                __CLASS_NAME__ ) );
+        }
+        expectedBlockID++;
+    }
+}
+
+
+void CatchupClientAgent::commitReadyBlocks( const ptr< CatchupRangeScheduler >& _scheduler ) {
+    CHECK_ARGUMENT( _scheduler );
+
+    // held until the ranges are committed, so that they are committed in the order of popReady()
+    LOCK( commitMutex )
+
+    auto ready = _scheduler->popReady();
+
+    for ( auto&& blocks : *ready ) {
+        getSchain()->blockCommitsArrivedThroughCatchup( blocks, false );
+    }
+}
+
+
 size_t CatchupClientAgent::parseBlockSizes(
     nlohmann::json _responseHeader, const ptr<vector<uint64_t>>& _blockSizes ) {
     nlohmann::json jsonSizes = _responseHeader["sizes"];
@@ -189,8 +449,8 @@ size_t CatchupClientAgent::parseBlockSizes(
 };
 
 
-ptr< CommittedBlockList > CatchupClientAgent::readMissingBlocks(
-    ptr< ClientSocket >& _socket, nlohmann::json responseHeader ) {
+uint64_t CatchupClientAgent::readMissingBlocks( ptr< ClientSocket >& _socket,
+    nlohmann::json responseHeader, const batch_handler& _handler ) {
     CHECK_ARGUMENT( responseHeader > 0 );
     CHECK_ARGUMENT( _socket );
 
@@ -201,8 +461,8 @@ ptr< CommittedBlockList > CatchupClientAgent::readMissingBlocks(
     auto serializedBlocks = make_shared<vector<uint8_t>>( totalSize );
 
     try {
-        getSchain()->getIo()->readBytes(
-            _socket->getDescriptor(), serializedBlocks, msg_len( totalSize ) );
+        getSchain()->getIo()->readBytes( _socket->getDescriptor(), serializedBlocks,
+            msg_len( totalSize ), _socket->getDeadlineMs() );
     } catch ( ExitRequestedException& ) {
         throw;
     } catch ( ... ) {
@@ -215,70 +475,66 @@ ptr< CommittedBlockList > CatchupClientAgent::readMissingBlocks(
     }
 
 
-    ptr< CommittedBlockList > blockList = nullptr;
-
     try {
-        blockList = CommittedBlockList::deserialize(
-            getSchain()->getCryptoManager(), blockSizes, serializedBlocks, 0 );
-        CHECK_STATE( blockList );
+        CommittedBlockList::deserializeInBatches( getSchain()->getCryptoManager(),
+            getNode()->getConsensusEngine()->getExecutor(), blockSizes, serializedBlocks, 0,
+            CATCHUP_VERIFY_BATCH_BLOCKS, _handler );
     } catch ( ExitRequestedException& ) { throw; } catch ( ... ) {
         throw_with_nested(
             NetworkProtocolException( "Could not parse block list", __CLASS_NAME__ ) );
     }
 
-    return blockList;
+    return blockSizes->size();
 }
 
 
 
-void CatchupClientAgent::workerThreadItemSendLoop( CatchupClientAgent* _agent ) {
-    setThreadName( "CatchupClient", _agent->getNode()->getConsensusEngine() );
-
-    CHECK_ARGUMENT( _agent );
-
-    _agent->waitOnGlobalStartBarrier();
-
-
-    // start with a random index and then to round-robin
+void CatchupClientAgent::syncStep() {
+    auto node = getNode();
 
+    if ( node->isExitRequested() )
+        return;
 
-    auto nodeCount = ( uint64_t ) _agent->getSchain()->getNodeCount();
-    auto selfIndex = _agent->getSchain()->getSchainIndex();
-
-    uint64_t  startIndex;
-
+    // catchupIntervalMs is the longest wait between requests
+    auto maxDelayMs = node->getCatchupIntervalMs();
 
-    do {
-        uint64_t random;
-        getrandom( &random, sizeof( random ), 0 );
-        startIndex = random % nodeCount + 1;
-    } while (startIndex == (uint64_t ) selfIndex);
+    if ( !node->isStarted() ) {
+        scheduleSync( max( maxDelayMs, CATCHUP_MIN_BACKOFF_MS ) );
+        return;
+    }
 
-    auto destinationSchainIndex = schain_index(startIndex);
+    bool blocksArrived = false;
 
     try {
-        while ( !_agent->getSchain()->getNode()->isExitRequested() ) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(
-                                        _agent->getNode()->getCatchupIntervalMs()
-                                        ));
-
-            try {
-                _agent->sync( destinationSchainIndex );
-            } catch ( ExitRequestedException& ) {
-                return;
-            } catch ( ConnectionRefusedException& e ) {
-                _agent->logConnectionRefused( e, destinationSchainIndex );
-            } catch ( exception& e ) {
-                SkaleException::logNested( e );
-            }
+        blocksArrived = sync( syncDestination );
 
-            destinationSchainIndex = nextSyncNodeIndex( _agent, destinationSchainIndex );
-        };
+        if ( !blocksArrived ) {
+            syncDelayMs = nextBackoffMs( syncDelayMs, maxDelayMs );
+        }
+    } catch ( ExitRequestedException& ) {
+        return;
+    } catch ( ConnectionRefusedException& e ) {
+        logConnectionRefused( e, syncDestination );
+        syncDelayMs = max( syncDelayMs, nextBackoffMs( 0, maxDelayMs ) );
     } catch ( FatalError& e ) {
-        _agent->getNode()->exitOnFatalError( e.getMessage() );
+        node->exitOnFatalError( e.getMessage() );
+        return;
+    } catch ( exception& e ) {
+        SkaleException::logNested( e );
+        syncDelayMs = max( syncDelayMs, nextBackoffMs( 0, maxDelayMs ) );
     }
+
+    if ( blocksArrived ) {
+        // this node is still behind, ask the same node again right away
+        syncDelayMs = 0;
+    } else {
+        syncDestination = nextSyncNodeIndex( this, syncDestination );
+    }
+
+    scheduleSync( syncDelayMs );
 }
 
+
 schain_index CatchupClientAgent::nextSyncNodeIndex(
     const CatchupClientAgent* _agent, schain_index _destinationSchainIndex ) {
 
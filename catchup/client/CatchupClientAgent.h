@@ -27,28 +27,72 @@
 class CommittedBlockList;
 class ClientSocket;
 class Schain;
-class CatchupClientThreadPool;
 class CatchupResponseHeader;
+class CatchupRequestHeader;
+class CatchupRangeScheduler;
+
+// Syncs with one node at a time in a step that runs on the executor. The next step is
+// scheduled on the timer wheel with a backoff while this node is not behind, a wakeup moves it
+// to now.
 
 class CatchupClientAgent : public Agent {
 
-    ptr< CatchupClientThreadPool > catchupClientThreadPool = nullptr;
+    recursive_mutex commitMutex;
+
+    mutex syncLock;
+    uint64_t syncTimerId = 0;  // guarded by syncLock, 0 while a step runs
+    atomic< bool > wakeupRequested = false;
+    // the highest block id that woke the agent, later messages of the same or earlier
+    // blocks do not wake it again
+    atomic< uint64_t > wakeupBlockID = 0;
+
+    // used by sync steps only, which never overlap
+    schain_index syncDestination = 0;
+    uint64_t syncDelayMs = 0;
+
+    using batch_handler =
+        function< void( const ptr< CommittedBlockList >& _batch, bool _isLastBatch ) >;
+
+    // returns false if the node has no blocks to send, verified blocks are passed to _handler
+    // in batches, in block order
+    bool downloadBlocks( schain_index _dstIndex, const ptr< CatchupRequestHeader >& _header,
+        block_id& _peerCommittedBlockID, const batch_handler& _handler );
+
+    // downloads blocks up to _lastBlockID from all nodes in parallel
+    void parallelSync( block_id _lastBlockID );
+
+    void downloadRanges( const ptr< CatchupRangeScheduler >& _scheduler, schain_index _dstIndex );
+
+    void checkRange(
+        const ptr< CommittedBlockList >& _blocks, uint64_t _firstBlockID, uint64_t _lastBlockID );
+
+    void commitReadyBlocks( const ptr< CatchupRangeScheduler >& _scheduler );
 
 public:
 
     explicit CatchupClientAgent( Schain& _sChain );
 
 
-    void sync( schain_index _dstIndex );
+    // returns false if the node has no blocks that this node is missing
+    bool sync( schain_index _dstIndex );
+
+    // called when a consensus message of block _blockID shows that other nodes are ahead of
+    // this node
+    void wakeup( block_id _blockID );
+
+    static uint64_t nextBackoffMs( uint64_t _delayMs, uint64_t _maxDelayMs );
 
+    void scheduleSync( uint64_t _delayMs );
 
-    static void workerThreadItemSendLoop( CatchupClientAgent* _agent );
+    // syncs with the next node and schedules the next step
+    void syncStep();
 
     nlohmann::json readCatchupResponseHeader(const ptr< ClientSocket >& _socket );
 
 
-    ptr< CommittedBlockList > readMissingBlocks(
-        ptr< ClientSocket >& _socket, nlohmann::json responseHeader );
+    // returns the number of blocks
+    uint64_t readMissingBlocks( ptr< ClientSocket >& _socket, nlohmann::json responseHeader,
+        const batch_handler& _handler );
 
 
     size_t parseBlockSizes( nlohmann::json _responseHeader, const ptr<vector<uint64_t>>& _blockSizes );
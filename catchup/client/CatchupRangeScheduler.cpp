@@ -0,0 +1,114 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file CatchupRangeScheduler.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include "CatchupRangeScheduler.h"
+
+
+CatchupRangeScheduler::CatchupRangeScheduler(
+    uint64_t _firstBlockID, uint64_t _lastBlockID, uint64_t _rangeSize )
+    : lastBlockID( _lastBlockID ), nextReadyBlockID( _firstBlockID ) {
+    CHECK_ARGUMENT( _firstBlockID > 0 );
+    CHECK_ARGUMENT( _firstBlockID <= _lastBlockID );
+    CHECK_ARGUMENT( _rangeSize > 0 );
+
+    for ( uint64_t i = _firstBlockID; i <= _lastBlockID; i += _rangeSize ) {
+        pendingRanges.emplace_back( i, min( i + _rangeSize - 1, _lastBlockID ) );
+    }
+}
+
+
+bool CatchupRangeScheduler::claimRange( uint64_t& _firstBlockID, uint64_t& _lastBlockID ) {
+    LOCK( m )
+
+    if ( pendingRanges.empty() )
+        return false;
+
+    _firstBlockID = pendingRanges.front().first;
+    _lastBlockID = pendingRanges.front().second;
+    pendingRanges.pop_front();
+    claimedRanges++;
+
+    return true;
+}
+
+
+void CatchupRangeScheduler::rangeFailed( uint64_t _firstBlockID, uint64_t _lastBlockID ) {
+    CHECK_ARGUMENT( _firstBlockID <= _lastBlockID );
+
+    LOCK( m )
+
+    CHECK_STATE( claimedRanges > 0 );
+    claimedRanges--;
+
+    // the earliest blocks hold up the commit of everything after them
+    pendingRanges.emplace_front( _firstBlockID, _lastBlockID );
+}
+
+
+void CatchupRangeScheduler::rangeArrived( uint64_t _firstBlockID, uint64_t _lastBlockID,
+    uint64_t _receivedBlockID, const ptr< CommittedBlockList >& _blocks ) {
+    CHECK_ARGUMENT( _firstBlockID <= _receivedBlockID );
+    CHECK_ARGUMENT( _receivedBlockID <= _lastBlockID );
+
+    LOCK( m )
+
+    CHECK_STATE( claimedRanges > 0 );
+    claimedRanges--;
+
+    readyRanges[_firstBlockID] = { _receivedBlockID, _blocks };
+
+    if ( _receivedBlockID < _lastBlockID ) {
+        pendingRanges.emplace_front( _receivedBlockID + 1, _lastBlockID );
+    }
+}
+
+
+ptr< vector< ptr< CommittedBlockList > > > CatchupRangeScheduler::popReady() {
+    auto result = make_shared< vector< ptr< CommittedBlockList > > >();
+
+    LOCK( m )
+
+    while ( !readyRanges.empty() && readyRanges.begin()->first == nextReadyBlockID ) {
+        result->push_back( readyRanges.begin()->second.second );
+        nextReadyBlockID = readyRanges.begin()->second.first + 1;
+        readyRanges.erase( readyRanges.begin() );
+    }
+
+    return result;
+}
+
+
+bool CatchupRangeScheduler::isComplete() {
+    LOCK( m )
+    return nextReadyBlockID > lastBlockID;
+}
+
+
+uint64_t CatchupRangeScheduler::getNextReadyBlockID() {
+    LOCK( m )
+    return nextReadyBlockID;
+}
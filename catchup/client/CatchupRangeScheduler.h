@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file CatchupRangeScheduler.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_CATCHUPRANGESCHEDULER_H
+#define SKALED_CATCHUPRANGESCHEDULER_H
+
+#include <deque>
+
+class CommittedBlockList;
+
+// Splits the missing blocks [firstBlockID, lastBlockID] into ranges that are downloaded
+// from different peers in parallel.
+//
+// A peer may return only the beginning of a range (the response is limited by
+// maxCatchupDownloadBytes), the rest of the range is then queued again. Downloaded
+// ranges are handed out by popReady() strictly in block order, so that they can be
+// passed to Schain::blockCommitsArrivedThroughCatchup as soon as the gap before them is filled.
+
+class CatchupRangeScheduler {
+
+    recursive_mutex m;
+
+    const uint64_t lastBlockID;
+
+    deque< pair< uint64_t, uint64_t > > pendingRanges;  // guarded by m
+
+    // downloaded ranges by their first block id
+    map< uint64_t, pair< uint64_t, ptr< CommittedBlockList > > > readyRanges;  // guarded by m
+
+    uint64_t nextReadyBlockID;  // guarded by m
+
+    uint64_t claimedRanges = 0;  // guarded by m
+
+public:
+
+    CatchupRangeScheduler( uint64_t _firstBlockID, uint64_t _lastBlockID, uint64_t _rangeSize );
+
+    // returns false if there are no ranges left to download
+    bool claimRange( uint64_t& _firstBlockID, uint64_t& _lastBlockID );
+
+    // the peer could not serve the range, it is given to another peer
+    void rangeFailed( uint64_t _firstBlockID, uint64_t _lastBlockID );
+
+    // blocks [_firstBlockID, _receivedBlockID] of the claimed range arrived
+    void rangeArrived( uint64_t _firstBlockID, uint64_t _lastBlockID, uint64_t _receivedBlockID,
+        const ptr< CommittedBlockList >& _blocks );
+
+    // returns downloaded block lists that continue the blocks returned before, in order
+    ptr< vector< ptr< CommittedBlockList > > > popReady();
+
+    // true if all blocks have been returned by popReady()
+    bool isComplete();
+
+    uint64_t getNextReadyBlockID();
+};
+
+
+#endif  // SKALED_CATCHUPRANGESCHEDULER_H
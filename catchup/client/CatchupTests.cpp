@@ -0,0 +1,144 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file CatchupTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "Agent.h"
+#include "threads/WorkStealingExecutor.h"
+
+#include "CatchupClientAgent.h"
+#include "CatchupRangeScheduler.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t CATCHUP_TEST_BLOCK_COUNT = 10000;
+static constexpr uint64_t CATCHUP_TEST_PEERS = 15;
+static constexpr uint64_t CATCHUP_TEST_RANGE_MS = 2;
+
+
+TEST_CASE( "Catchup ranges are split and returned in order", "[catchup-ranges]" ) {
+    CatchupRangeScheduler scheduler( 11, 30, 8 );
+
+    uint64_t first, last;
+
+    REQUIRE( scheduler.claimRange( first, last ) );
+    REQUIRE( ( first == 11 && last == 18 ) );
+
+    uint64_t first2, last2;
+    REQUIRE( scheduler.claimRange( first2, last2 ) );
+    REQUIRE( ( first2 == 19 && last2 == 26 ) );
+
+    // the second range arrives first and is held back
+    scheduler.rangeArrived( first2, last2, last2, nullptr );
+    REQUIRE( scheduler.popReady()->empty() );
+
+    // a size limited response returns part of the range, the rest is queued again
+    scheduler.rangeArrived( first, last, 14, nullptr );
+    REQUIRE( scheduler.popReady()->size() == 1 );
+    REQUIRE( scheduler.getNextReadyBlockID() == 15 );
+
+    REQUIRE( scheduler.claimRange( first, last ) );
+    REQUIRE( ( first == 15 && last == 18 ) );
+
+    scheduler.rangeFailed( first, last );
+
+    REQUIRE( scheduler.claimRange( first, last ) );
+    REQUIRE( ( first == 15 && last == 18 ) );
+    scheduler.rangeArrived( first, last, last, nullptr );
+
+    REQUIRE( scheduler.popReady()->size() == 2 );
+    REQUIRE( scheduler.getNextReadyBlockID() == 27 );
+    REQUIRE( !scheduler.isComplete() );
+
+    REQUIRE( scheduler.claimRange( first, last ) );
+    REQUIRE( ( first == 27 && last == 30 ) );
+    REQUIRE( !scheduler.claimRange( first2, last2 ) );
+
+    scheduler.rangeArrived( first, last, last, nullptr );
+    REQUIRE( scheduler.popReady()->size() == 1 );
+    REQUIRE( scheduler.isComplete() );
+}
+
+
+TEST_CASE( "Catchup ranges are downloaded from all peers", "[catchup-ranges]" ) {
+    WorkStealingExecutor executor( CATCHUP_TEST_PEERS );
+
+    CatchupRangeScheduler scheduler( 1, CATCHUP_TEST_BLOCK_COUNT, CATCHUP_RANGE_BLOCKS );
+
+    mutex commitLock;
+    uint64_t committedRanges = 0;
+
+    vector< WorkStealingExecutor::task > tasks;
+
+    for ( uint64_t i = 0; i < CATCHUP_TEST_PEERS; i++ ) {
+        tasks.push_back( [&, i]() {
+            uint64_t first, last;
+            while ( scheduler.claimRange( first, last ) ) {
+                // every third peer is unresponsive
+                if ( i % 3 == 2 ) {
+                    scheduler.rangeFailed( first, last );
+                    return;
+                }
+                usleep( CATCHUP_TEST_RANGE_MS * 1000 );
+                scheduler.rangeArrived( first, last, last, nullptr );
+
+                lock_guard< mutex > lock( commitLock );
+                auto ready = scheduler.popReady();
+                committedRanges += ready->size();
+            }
+        } );
+    }
+
+    auto begin = chrono::steady_clock::now();
+
+    executor.submitAndWait( PRIORITY_CATCHUP, tasks );
+
+    auto elapsed = chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - begin ).count();
+
+    auto rangeCount = ( CATCHUP_TEST_BLOCK_COUNT + CATCHUP_RANGE_BLOCKS - 1 ) / CATCHUP_RANGE_BLOCKS;
+
+    cerr << "Parallel catchup of " << CATCHUP_TEST_BLOCK_COUNT << " blocks:ranges:" << rangeCount
+         << ":ms:" << elapsed << ":one peer ms:" << rangeCount * CATCHUP_TEST_RANGE_MS << endl;
+
+    REQUIRE( scheduler.isComplete() );
+    REQUIRE( committedRanges == rangeCount );
+}
+
+
+TEST_CASE( "Catchup backs off only up to the catchup interval", "[catchup-ranges]" ) {
+    vector< uint64_t > delays;
+
+    uint64_t delayMs = 0;
+
+    for ( int i = 0; i < 8; i++ ) {
+        delayMs = CatchupClientAgent::nextBackoffMs( delayMs, CATCHUP_INTERVAL_MS );
+        delays.push_back( delayMs );
+    }
+
+    REQUIRE( delays == vector< uint64_t >{ 100, 200, 400, 800, 1600, 3200, 5000, 5000 } );
+
+    // a catchup interval shorter than the minimal backoff is respected
+    REQUIRE( CatchupClientAgent::nextBackoffMs( 0, 10 ) == 10 );
+}
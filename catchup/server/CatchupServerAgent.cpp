@@ -63,12 +63,18 @@
 #include "datastructures/BlockProposalFragment.h"
 #include "datastructures/CommittedBlock.h"
 
+#include "microprofile.h"
 
-CatchupServerAgent::CatchupServerAgent(Schain &_schain, const ptr<TCPServerSocket>& _s) : AbstractServerAgent(
-        "CatchupServer", _schain, _s) {
+
+// a fragment is sent as < fragment bytes >, the bytes are a slice of the cached proposal
+static const ptr<vector<uint8_t>> FRAGMENT_START = make_shared<vector<uint8_t>>(1, '<');
+static const ptr<vector<uint8_t>> FRAGMENT_END = make_shared<vector<uint8_t>>(1, '>');
+
+
+CatchupServerAgent::CatchupServerAgent(Schain &_schain, const ptr<StreamServerSocket>& _s)
+    : AbstractServerAgent(
+        "CatchupServer", _schain, _s, PRIORITY_CATCHUP, CATCHUP_SERVER_MAX_CONNECTION_TASKS) {
     CHECK_ARGUMENT(_s);
-    catchupWorkerThreadPool = make_shared<CatchupWorkerThreadPool>(num_threads(16), this);
-    catchupWorkerThreadPool->startService();
     createNetworkReadThread();
 }
 
@@ -77,52 +83,43 @@ CatchupServerAgent::~CatchupServerAgent() {
 }
 
 
-void CatchupServerAgent::processNextAvailableConnection(const ptr<ServerConnection>& _connection) {
+void CatchupServerAgent::processRequest(const ptr<ServerConnection>& _connection,
+                                        nlohmann::json jsonRequest) {
+    MICROPROFILE_SCOPEI( "CatchupServerAgent", "processRequest", MP_STEELBLUE );
 
 
     MONITOR(__CLASS_NAME__, __FUNCTION__);
 
     CHECK_ARGUMENT(_connection);
 
-    try {
-        sChain->getIo()->readMagic(_connection->getDescriptor());
-    }
-    catch (PingException &) { return; }
-    catch (ExitRequestedException &) { throw; }
-    catch (...) {
-        throw_with_nested(NetworkProtocolException("Incorrect magic number", __CLASS_NAME__));
-    }
-
-
-    nlohmann::json jsonRequest = nullptr;
-
-    try {
-        jsonRequest = sChain->getIo()->readJsonHeader(_connection->getDescriptor(), "Read catchup request");
-    }
-    catch (ExitRequestedException &) { throw; }
-    catch (...) {
-        throw_with_nested(NetworkProtocolException("Could not read request", __CLASS_NAME__));
-    }
-
 
     ptr<Header> responseHeader = nullptr;
 
     auto type = Header::getString(jsonRequest, "type");
 
+    bool isFinalize = false;
 
     if (type.compare(Header::BLOCK_CATCHUP_REQ) == 0) {
         responseHeader = make_shared<CatchupResponseHeader>();
     } else if (type.compare(Header::BLOCK_FINALIZE_REQ) == 0) {
         responseHeader = make_shared<BlockFinalizeResponseHeader>();
+        isFinalize = true;
     } else {
         BOOST_THROW_EXCEPTION(
                 InvalidMessageFormatException("Unknown request type:" + type, __CLASS_NAME__));
     }
 
+    // a finalize downloader asks the same node for several fragments over one connection
+    bool keepAlive = isFinalize && jsonRequest.find("keepAlive") != jsonRequest.end() &&
+                     Header::getUint64(jsonRequest, "keepAlive") > 0;
+
     ptr<vector<uint8_t>> serializedBinary = nullptr;
+    uint64_t binaryBegin = 0;
+    uint64_t binaryEnd = 0;
 
     try {
-        serializedBinary = this->createResponseHeaderAndBinary(_connection, jsonRequest, responseHeader);
+        serializedBinary = this->createResponseHeaderAndBinary(_connection, jsonRequest, responseHeader,
+                                                               binaryBegin, binaryEnd);
     }
     catch (ExitRequestedException &) { throw; }
     catch (...) {
@@ -153,11 +150,21 @@ void CatchupServerAgent::processNextAvailableConnection(const ptr<ServerConnecti
 
     if (serializedBinary == nullptr) {
         LOG(debug, "Server step 3: response completed: no blocks sent");
+        if (keepAlive)
+            readRequest(_connection);
         return;
     }
 
     try {
-        getSchain()->getIo()->writeBytesVector(_connection->getDescriptor(), serializedBinary);
+        if (isFinalize) {
+            sendBytes(_connection, FRAGMENT_START);
+            // the last data fragments of a small block are empty
+            if (binaryEnd > binaryBegin)
+                sendBytes(_connection, serializedBinary, binaryBegin, binaryEnd);
+            sendBytes(_connection, FRAGMENT_END);
+        } else {
+            sendBytes(_connection, serializedBinary, binaryBegin, binaryEnd);
+        }
     } catch (ExitRequestedException &) {
         throw;
     }
@@ -167,7 +174,8 @@ void CatchupServerAgent::processNextAvailableConnection(const ptr<ServerConnecti
 
     LOG(debug, "Server step 3: response completed: blocks sent");
 
-    return;
+    if (keepAlive)
+        readRequest(_connection);
 
 
 }
@@ -175,7 +183,9 @@ void CatchupServerAgent::processNextAvailableConnection(const ptr<ServerConnecti
 
 ptr<vector<uint8_t>> CatchupServerAgent::createResponseHeaderAndBinary(const ptr<ServerConnection>& ,
                                                                        nlohmann::json _jsonRequest,
-                                                                       const ptr<Header> &_responseHeader) {
+                                                                       const ptr<Header> &_responseHeader,
+                                                                       uint64_t &_binaryBegin,
+                                                                       uint64_t &_binaryEnd) {
 
     CHECK_ARGUMENT(_responseHeader);
 
@@ -212,11 +222,17 @@ ptr<vector<uint8_t>> CatchupServerAgent::createResponseHeaderAndBinary(const ptr
                                                           dynamic_pointer_cast<CatchupResponseHeader>(_responseHeader),
                                                           blockID);
 
+            if (serializedBinary != nullptr) {
+                _binaryBegin = 0;
+                _binaryEnd = serializedBinary->size();
+            }
+
         } else if (type.compare(Header::BLOCK_FINALIZE_REQ) == 0) {
 
             serializedBinary = createBlockFinalizeResponse(_jsonRequest,
                                                            dynamic_pointer_cast<BlockFinalizeResponseHeader>(
-                                                                   _responseHeader), blockID);
+                                                                   _responseHeader), blockID,
+                                                           _binaryBegin, _binaryEnd);
 
         }
 
@@ -231,7 +247,7 @@ ptr<vector<uint8_t>> CatchupServerAgent::createResponseHeaderAndBinary(const ptr
 }
 
 
-ptr<vector<uint8_t>> CatchupServerAgent::createBlockCatchupResponse(nlohmann::json /*_jsonRequest */,
+ptr<vector<uint8_t>> CatchupServerAgent::createBlockCatchupResponse(nlohmann::json _jsonRequest,
                                                                     const ptr<CatchupResponseHeader>& _responseHeader,
                                                                     block_id _blockID) {
 
@@ -241,6 +257,8 @@ ptr<vector<uint8_t>> CatchupServerAgent::createBlockCatchupResponse(nlohmann::js
 
     try {
 
+        _responseHeader->setCommittedBlockID(sChain->getLastCommittedBlockID());
+
         if (sChain->getLastCommittedBlockID() <= block_id(_blockID)) {
             LOG(debug, "Catchups: sChain->getCommittedBlockID() <= block_id(blockID)");
             _responseHeader->setStatusSubStatus(CONNECTION_DISCONNECT, CONNECTION_NO_NEW_BLOCKS);
@@ -253,6 +271,13 @@ ptr<vector<uint8_t>> CatchupServerAgent::createBlockCatchupResponse(nlohmann::js
 
         auto committedBlockID = sChain->getLastCommittedBlockID();
 
+        // a client that downloads from several nodes in parallel asks each node for a range
+        if (_jsonRequest.find("lastBlockID") != _jsonRequest.end()) {
+            block_id lastBlockID = Header::getUint64(_jsonRequest, "lastBlockID");
+            if (lastBlockID < committedBlockID)
+                committedBlockID = lastBlockID;
+        }
+
         if (_blockID >= committedBlockID) {
             LOG(debug, "Catchups: blockID >= committedBlockID");
             _responseHeader->setStatusSubStatus(CONNECTION_DISCONNECT, CONNECTION_OK);
@@ -306,7 +331,9 @@ ptr<vector<uint8_t>> CatchupServerAgent::createBlockCatchupResponse(nlohmann::js
 
 ptr<vector<uint8_t>> CatchupServerAgent::createBlockFinalizeResponse(nlohmann::json _jsonRequest,
                                                                      const ptr<BlockFinalizeResponseHeader>& _responseHeader,
-                                                                     block_id _blockID) {
+                                                                     block_id _blockID,
+                                                                     uint64_t &_fragmentBegin,
+                                                                     uint64_t &_fragmentEnd) {
 
     CHECK_ARGUMENT(_responseHeader);
 
@@ -360,22 +387,20 @@ ptr<vector<uint8_t>> CatchupServerAgent::createBlockFinalizeResponse(nlohmann::j
             return nullptr;
         }
 
-        auto fragment = proposal->getFragment(
+        // the proposal and its parity are computed once, fragments are slices of them
+        auto fragmentBuffer = proposal->getFragmentBounds(
                 (uint64_t) getSchain()->getNodeCount() - 1,
-                fragmentIndex);
+                fragmentIndex, _fragmentBegin, _fragmentEnd);
 
-        CHECK_STATE(fragment != nullptr);
+        CHECK_STATE(fragmentBuffer);
 
         _responseHeader->setStatusSubStatus(CONNECTION_PROCEED, CONNECTION_OK);
 
-        auto serializedFragment = fragment->serialize();
-
-        CHECK_STATE(serializedFragment);
-
-        _responseHeader->setFragmentParams(serializedFragment->size(),
+        // the fragment is enclosed in < >
+        _responseHeader->setFragmentParams(_fragmentEnd - _fragmentBegin + 2,
                                            proposal->serialize()->size(), proposal->getHash()->toHex());
 
-        return serializedFragment;
+        return fragmentBuffer;
     } catch (ExitRequestedException &e) { throw; } catch (...) {
         throw_with_nested(InvalidStateException(__FUNCTION__, __CLASS_NAME__));
     }
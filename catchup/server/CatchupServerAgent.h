@@ -34,7 +34,6 @@
 #include "network/ServerConnection.h"
 
 #include "Agent.h"
-#include "CatchupWorkerThreadPool.h"
 
 class CommittedBlock;
 class CommittedBlockList;
@@ -43,26 +42,29 @@ class BlockFinalizeResponseHeader;
 
 class CatchupServerAgent : public AbstractServerAgent {
 
-    ptr< CatchupWorkerThreadPool > catchupWorkerThreadPool;
-
     ptr< vector< uint8_t > > createBlockCatchupResponse( nlohmann::json _jsonRequest,
         const ptr< CatchupResponseHeader >& _responseHeader, block_id _blockID );
 
 
+    // returns the cached buffer that holds the fragment,
+    // the fragment is [_fragmentBegin, _fragmentEnd) of it
     ptr< vector< uint8_t > > createBlockFinalizeResponse( nlohmann::json _jsonRequest,
-        const ptr< BlockFinalizeResponseHeader >& _responseHeader, block_id _blockID );
+        const ptr< BlockFinalizeResponseHeader >& _responseHeader, block_id _blockID,
+        uint64_t& _fragmentBegin, uint64_t& _fragmentEnd );
 
 
 public:
 
-    CatchupServerAgent( Schain& _schain, const ptr< TCPServerSocket >& _s );
+    CatchupServerAgent( Schain& _schain, const ptr< StreamServerSocket >& _s );
 
     ~CatchupServerAgent() override;
 
+    // the bytes to send are [_binaryBegin, _binaryEnd) of the returned buffer
     ptr< vector< uint8_t > > createResponseHeaderAndBinary(
         const ptr< ServerConnection >& _connectionEnvelope, nlohmann::json _jsonRequest,
-        const ptr< Header >& _responseHeader );
+        const ptr< Header >& _responseHeader, uint64_t& _binaryBegin, uint64_t& _binaryEnd );
 
-    void processNextAvailableConnection( const ptr< ServerConnection >& _connection ) override;
+    void processRequest(
+        const ptr< ServerConnection >& _connection, nlohmann::json _jsonRequest ) override;
 
 };
@@ -40,6 +40,7 @@
 #include "node/ConsensusEngine.h"
 #include "node/Node.h"
 #include "pendingqueue/PendingTransactionsAgent.h"
+#include "threads/TimerWheel.h"
 #include "utils/Time.h"
 
 #include "blockfinalize/client/BlockFinalizeDownloader.h"
@@ -66,6 +67,7 @@
 #include "db/ProposalVectorDB.h"
 #include "exceptions/EngineInitException.h"
 #include "exceptions/ExitRequestedException.h"
+#include "threads/WorkStealingExecutor.h"
 #include "exceptions/FatalError.h"
 #include "exceptions/ParsingException.h"
 #include "messages/ConsensusProposalMessage.h"
@@ -74,6 +76,10 @@
 #include "messages/MessageEnvelope.h"
 #include "messages/NetworkMessageEnvelope.h"
 #include "monitoring/MonitoringAgent.h"
+#include "monitoring/MessageTrace.h"
+#include "monitoring/StageMetrics.h"
+#include "threads/GlobalThreadRegistry.h"
+#include "threads/QueueMetrics.h"
 #include "network/ClientSocket.h"
 #include "network/IO.h"
 #include "network/Sockets.h"
@@ -99,6 +105,8 @@
 #include "monitoring/TimeoutAgent.h"
 #include "pendingqueue/TestMessageGeneratorAgent.h"
 
+#include "microprofile.h"
+
 void Schain::postMessage( const ptr< MessageEnvelope >& _me ) {
     CHECK_ARGUMENT( _me );
 
@@ -110,6 +118,7 @@ void Schain::postMessage( const ptr< MessageEnvelope >& _me ) {
     {
         lock_guard< mutex > lock( messageMutex );
         messageQueue.push( _me );
+        messageQueueMetrics->pushed();
         messageCond.notify_all();
     }
 }
@@ -118,7 +127,10 @@ void Schain::postMessage( const ptr< MessageEnvelope >& _me ) {
 void Schain::messageThreadProcessingLoop( Schain* _sChain ) {
     CHECK_ARGUMENT( _sChain );
 
-    setThreadName( "msgThreadProcLoop", _sChain->getNode()->getConsensusEngine() );
+    logThreadLocal_ = _sChain->getNode()->getLog();
+
+    setThreadName( "msgThreadProcLoop", _sChain->getNode()->getConsensusEngine(),
+        "message-processing", "Schain" );
 
     _sChain->waitOnGlobalStartBarrier();
 
@@ -165,6 +177,7 @@ void Schain::messageThreadProcessingLoop( Schain* _sChain ) {
                 }  // catch
 
                 newQueue.pop();
+                _sChain->messageQueueMetrics->popped();
             }
         }
 
@@ -228,6 +241,13 @@ Schain::Schain( weak_ptr< Node > _node, schain_index _schainIndex, const schain_
 
         CHECK_STATE( getNodeCount() > 0 );
 
+        stageMetrics = make_shared< StageMetrics >(
+            ( uint64_t ) getNode()->getNodeID(), ( uint64_t ) getNodeCount() );
+
+        messageQueueMetrics = make_shared< QueueMetrics >(
+            "messageQueue", "Schain", ( uint64_t ) getNode()->getNodeID() );
+        getThreadRegistry()->registerQueue( messageQueueMetrics );
+
         constructChildAgents();
 
         string none = SchainTest::NONE;
@@ -264,7 +284,8 @@ void Schain::constructChildAgents() {
 }
 
 
-void Schain::blockCommitsArrivedThroughCatchup( const ptr< CommittedBlockList >& _blockList ) {
+void Schain::blockCommitsArrivedThroughCatchup(
+    const ptr< CommittedBlockList >& _blockList, bool _proposeNextBlock ) {
     CHECK_ARGUMENT( _blockList );
 
     auto blocks = _blockList->getBlocks();
@@ -295,11 +316,21 @@ void Schain::blockCommitsArrivedThroughCatchup( const ptr< CommittedBlockList >&
     if ( committedIDOld < getLastCommittedBlockID() ) {
         LOG( info, "BLOCK_CATCHUP: " + to_string( getLastCommittedBlockID() - committedIDOld ) +
                        " BLOCKS" );
-        proposeNextBlock();
+        if ( _proposeNextBlock )
+            proposeNextBlock();
     }
 }
 
 
+void Schain::catchupFinished() {
+    checkForExit();
+
+    LOCK( m )
+
+    proposeNextBlock();
+}
+
+
 void Schain::blockCommitArrived( block_id _committedBlockID, schain_index _proposerIndex,
     const ptr< ThresholdSignature >& _thresholdSig ) {
     MONITOR2( __CLASS_NAME__, __FUNCTION__, getMaxExternalBlockProcessingTime() )
@@ -331,6 +362,14 @@ void Schain::blockCommitArrived( block_id _committedBlockID, schain_index _propo
         CHECK_STATE(*getLastCommittedBlockTimeStamp() < *newCommittedBlock->getTimeStamp());
         processCommittedBlock( newCommittedBlock );
 
+        // blocks that come through catchup are not counted
+        auto proposedAtMs = newCommittedBlock->getTimeStampS() * 1000 +
+                            newCommittedBlock->getTimeStampMs();
+        auto nowMs = Time::getCurrentTimeMs();
+        if ( nowMs > proposedAtMs ) {
+            stageMetrics->recordStage( STAGE_BLOCK_COMMIT, ( nowMs - proposedAtMs ) * 1000 );
+        }
+
         proposeNextBlock();
 
     } catch ( ExitRequestedException& e ) {
@@ -380,6 +419,9 @@ void Schain::proposeNextBlock() {
 
         db->checkAndSaveHash( _proposedBlockID, getSchainIndex(), myProposal->getHash()->toHex() );
 
+        daProofWaitStartUs = Time::getSteadyTimeUs();
+        daProofWaitBlockID = ( uint64_t ) _proposedBlockID;
+
         blockProposalClient->enqueueItem( myProposal );
 
         auto [mySig, ecdsaSig, pubKey, pubKeySig] =
@@ -394,6 +436,10 @@ void Schain::proposeNextBlock() {
 
         getSchain()->daProofSigShareArrived( mySig, myProposal );
 
+        // build the transaction list of the next proposal while this block is in consensus
+        getNode()->getConsensusEngine()->getExecutor()->submit( PRIORITY_PROPOSAL,
+            [this]() { pendingTransactionsAgent->prepareNextProposal(); } );
+
     } catch ( ExitRequestedException& e ) {
         throw;
     } catch ( ... ) {
@@ -418,34 +464,43 @@ void Schain::processCommittedBlock( const ptr< CommittedBlock >& _block ) {
 
         auto stamp = make_shared< TimeStamp >( _block->getTimeStampS(), _block->getTimeStampMs() );
 
-        LOG( info,
-            "BLOCK_COMMIT: PRPSR:" + to_string( _block->getProposerIndex() ) +
-                ":BID: " + to_string( _block->getBlockID() ) +
-                ":ROOT:" + _block->getStateRoot().convert_to< string >() + ":HASH:" + h +
-                ":BLOCK_TXS:" + to_string( _block->getTransactionCount() ) +
-                ":DMSG:" + to_string( getMessagesCount() ) +
-                ":MPRPS:" + to_string( MyBlockProposal::getTotalObjects() ) +
-                ":RPRPS:" + to_string( ReceivedBlockProposal::getTotalObjects() ) +
-                ":TXS:" + to_string( Transaction::getTotalObjects() ) +
-                ":TXLS:" + to_string( TransactionList::getTotalObjects() ) +
-                ":KNWN:" + to_string( pendingTransactionsAgent->getKnownTransactionsSize() ) +
-                ":MGS:" + to_string( Message::getTotalObjects() ) +
-                ":INSTS:" + to_string( ProtocolInstance::getTotalObjects() ) +
-                ":BPS:" + to_string( BlockProposalSet::getTotalObjects() ) +
-                ":HDRS:" + to_string( Header::getTotalObjects() ) +
-                ":SOCK:" + to_string( ClientSocket::getTotalSockets() ) +
-                ":CONS:" + to_string( ServerConnection::getTotalObjects() ) + ":DSDS:" +
-                to_string( getSchain()->getNode()->getNetwork()->computeTotalDelayedSends() ) +
-                ":STAMP:" + stamp->toString() );
+        LOGF( info,
+            "BLOCK_COMMIT: PRPSR:{}:BID: {}:ROOT:{}:HASH:{}:BLOCK_TXS:{}:DMSG:{}:MPRPS:{}:RPRPS:{}"
+            ":TXS:{}:TXLS:{}:KNWN:{}:MGS:{}:INSTS:{}:BPS:{}:HDRS:{}:SOCK:{}:CONS:{}:DSDS:{}"
+            ":STAMP:{}",
+            ( uint64_t ) _block->getProposerIndex(), ( uint64_t ) _block->getBlockID(),
+            _block->getStateRoot().convert_to< string >(), h,
+            ( uint64_t ) _block->getTransactionCount(), ( uint64_t ) getMessagesCount(),
+            MyBlockProposal::getTotalObjects(), ReceivedBlockProposal::getTotalObjects(),
+            Transaction::getTotalObjects(), TransactionList::getTotalObjects(),
+            pendingTransactionsAgent->getKnownTransactionsSize(), Message::getTotalObjects(),
+            ProtocolInstance::getTotalObjects(), BlockProposalSet::getTotalObjects(),
+            Header::getTotalObjects(), ClientSocket::getTotalSockets(),
+            ServerConnection::getTotalObjects(),
+            getSchain()->getNode()->getNetwork()->computeTotalDelayedSends(), stamp->toString() );
 
         CHECK_STATE(_block->getBlockID() = getLastCommittedBlockID() + 1);
 
         pushBlockToExtFace( _block );
 
+        pendingTransactionsAgent->blockCommitted( _block );
+
         saveBlock( _block );
 
         updateLastCommittedBlockInfo( ( uint64_t ) _block->getBlockID(), stamp );
 
+#if CONSENSUS_MICROPROFILE
+        // a profiler frame is a block. The nodes running in one process share the profiler,
+        // so the first node that commits the block ends the frame
+        static atomic< uint64_t > lastFrameBlockID = 0;
+        auto frameBlockID = lastFrameBlockID.load();
+        if ( frameBlockID < ( uint64_t ) _block->getBlockID() &&
+             lastFrameBlockID.compare_exchange_strong(
+                 frameBlockID, ( uint64_t ) _block->getBlockID() ) ) {
+            MicroProfileFlip( nullptr );
+        }
+#endif
+
     } catch ( ExitRequestedException& e ) {
         throw;
     } catch ( ... ) {
@@ -460,6 +515,7 @@ void Schain::saveBlock( const ptr< CommittedBlock >& _block ) {
 
     try {
         checkForExit();
+        MEASURE_STAGE( STAGE_DB_SAVE )
         getNode()->getBlockDB()->saveBlock( _block );
     } catch ( ExitRequestedException& ) {
         throw;
@@ -477,7 +533,8 @@ void Schain::pushBlockToExtFace( const ptr< CommittedBlock >& _block ) {
     checkForExit();
 
     try {
-        auto tv = _block->getTransactionList()->createTransactionVector();
+        // _block keeps the transactions alive until createBlockFromView returns
+        auto tv = _block->getTransactionList()->createTransactionView();
 
         // auto next_price = // VERIFY PRICING
 
@@ -486,9 +543,13 @@ void Schain::pushBlockToExtFace( const ptr< CommittedBlock >& _block ) {
 
         auto currentPrice = this->pricingAgent->readPrice( _block->getBlockID() - 1 );
 
+        if ( auto traceWriter = getNode()->getTraceWriter() ) {
+            traceWriter->recordCreateBlock( _block );
+        }
 
         if ( extFace ) {
-            extFace->createBlock( *tv, _block->getTimeStampS(), _block->getTimeStampMs(),
+            MEASURE_STAGE( STAGE_EXT_FACE_CREATE_BLOCK )
+            extFace->createBlockFromView( *tv, _block->getTimeStampS(), _block->getTimeStampMs(),
                 ( __uint64_t ) _block->getBlockID(), currentPrice, _block->getStateRoot(),
                 ( uint64_t ) _block->getProposerIndex() );
             // exit immediately if exit has been requested
@@ -570,6 +631,10 @@ void Schain::daProofArrived( const ptr< DAProof >& _daProof ) {
 
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
+    if ( auto traceWriter = getNode()->getTraceWriter() ) {
+        traceWriter->recordDAProof( _daProof );
+    }
+
     try {
         if ( _daProof->getBlockId() <= getLastCommittedBlockID() )
             return;
@@ -603,6 +668,10 @@ void Schain::tryStartingConsensus( const ptr< BooleanProposalVector >& pv, const
 void Schain::proposedBlockArrived( const ptr< BlockProposal >& _proposal ) {
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
+    if ( auto traceWriter = getNode()->getTraceWriter() ) {
+        traceWriter->recordProposal( _proposal );
+    }
+
     if ( _proposal->getBlockID() <= getLastCommittedBlockID() )
         return;
 
@@ -695,7 +764,7 @@ void Schain::bootstrap( block_id _lastCommittedBlockID, uint64_t _lastCommittedB
 
         LOG( info, "Jump starting the system with block:" + to_string( _lastCommittedBlockID ) );
         if ( getLastCommittedBlockID() == 0 )
-            this->pricingAgent->calculatePrice( ConsensusExtFace::transactions_vector(), 0, 0, 0 );
+            this->pricingAgent->calculatePrice( ConsensusExtFace::transactions_view(), 0, 0, 0 );
 
         proposeNextBlock();
 
@@ -744,7 +813,7 @@ void Schain::healthCheck() {
             BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
         }
 
-        usleep( 1000000 );
+        getNode()->getConsensusEngine()->getTimerWheel()->sleepFor( 1000 );
 
         if ( getNode()->isExitRequested() ) {
             BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
@@ -788,6 +857,12 @@ void Schain::daProofSigShareArrived(
         auto proof =
             getNode()->getDaSigShareDB()->addAndMergeSigShareAndVerifySig( _sigShare, _proposal );
         if ( proof != nullptr ) {
+            uint64_t expected = ( uint64_t ) _proposal->getBlockID();
+            if ( _proposal->getProposerIndex() == getSchainIndex() &&
+                 daProofWaitBlockID.compare_exchange_strong( expected, 0 ) ) {
+                stageMetrics->recordStage(
+                    STAGE_DA_PROOF, Time::getSteadyTimeUs() - daProofWaitStartUs );
+            }
             getSchain()->daProofArrived( proof );
             blockProposalClient->enqueueItem( proof );
         }
@@ -866,13 +941,11 @@ void Schain::finalizeDecidedAndSignedBlock( block_id _blockId, schain_index _pro
             // Note that due to the BLS signature proof, 2t hosts out of 3t + 1 total are guaranteed
             // to posess the proposal
 
-            auto agent = make_unique< BlockFinalizeDownloader >( this, _blockId, _proposerIndex );
+            auto agent = make_shared< BlockFinalizeDownloader >( this, _blockId, _proposerIndex );
 
             {
-                const string msg = "Finalization download:" + to_string( _blockId ) + ":" +
-                                   to_string( _proposerIndex );
-
-                MONITOR( __CLASS_NAME__, msg.c_str() );
+                MONITOR( __CLASS_NAME__, "finalizationDownload" );
+                MEASURE_STAGE( STAGE_FINALIZE_DOWNLOAD )
                 // This will complete successfully also if block arrives through catchup
                 proposal = agent->downloadProposal();
             }
@@ -895,6 +968,11 @@ void Schain::finalizeDecidedAndSignedBlock( block_id _blockId, schain_index _pro
 // empty constructor is used for tests
 Schain::Schain() : Agent() {}
 
+Schain::Schain( const schain_id& _schainID, const ptr< CryptoManager >& _cryptoManager )
+    : Agent(), schainID( _schainID ), cryptoManager( _cryptoManager ) {
+    CHECK_ARGUMENT( _cryptoManager );
+}
+
 bool Schain::fixCorruptStateIfNeeded( block_id _lastCommittedBlockID ) {
     block_id nextBlock = _lastCommittedBlockID + 1;
     if ( getNode()->getBlockDB()->unfinishedBlockExists( nextBlock ) ) {
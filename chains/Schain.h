@@ -40,10 +40,8 @@ class PartialHashesList;
 class DAProof;
 
 class BlockProposalClientAgent;
-class BlockProposalPusherThreadPool;
 
 class BlockFinalizeDownloader;
-class BlockFinalizeDownloaderThreadPool;
 
 class SchainMessageThreadPool;
 
@@ -54,6 +52,8 @@ class CatchupClientAgent;
 class CatchupServerAgent;
 class MonitoringAgent;
 class TimeoutAgent;
+class StageMetrics;
+class QueueMetrics;
 
 class BlockProposalServerAgent;
 
@@ -79,6 +79,9 @@ class Schain : public Agent {
 
     queue< ptr< MessageEnvelope > > messageQueue;
 
+    // includes the batch the message thread took from messageQueue and did not process yet
+    ptr< QueueMetrics > messageQueueMetrics;
+
     bool bootStrapped = false;
     bool startingFromCorruptState = false;
 
@@ -100,6 +103,12 @@ class Schain : public Agent {
 
     ptr< TimeoutAgent > timeoutAgent;
 
+    ptr< StageMetrics > stageMetrics;
+
+    // own proposal that waits for its DA proof, used to measure DA proof collection
+    atomic< uint64_t > daProofWaitBlockID = 0;
+    atomic< uint64_t > daProofWaitStartUs = 0;
+
     ptr< PendingTransactionsAgent > pendingTransactionsAgent;
 
     ptr< BlockProposalClientAgent > blockProposalClient;
@@ -165,8 +174,6 @@ public:
 
     void createBlockConsensusInstance();
 
-    void joinMonitorAndTimeoutThreads();
-
     ptr< BlockProposal > getBlockProposal( block_id _blockID, schain_index _schainIndex );
 
     void constructServers( const ptr< Sockets >& _sockets );
@@ -182,6 +189,9 @@ public:
 
     Schain();  // empty constructor is used for tests
 
+    // used by tests and benchmarks that parse messages without a node
+    Schain( const schain_id& _schainID, const ptr< CryptoManager >& _cryptoManager );
+
     void startThreads();
 
     static void messageThreadProcessingLoop( Schain* _sChain );
@@ -202,7 +212,12 @@ public:
         const ptr< ThresholdSignature >& _thresholdSig );
 
 
-    void blockCommitsArrivedThroughCatchup( const ptr< CommittedBlockList >& _blockList );
+    // a caller that commits a download in several lists proposes only after the last one
+    void blockCommitsArrivedThroughCatchup(
+        const ptr< CommittedBlockList >& _blockList, bool _proposeNextBlock = true );
+
+    // called once a catchup that committed its lists without proposing is over
+    void catchupFinished();
 
     void daProofSigShareArrived(
         const ptr< ThresholdSigShare >& _sigShare, const ptr< BlockProposal >& _proposal );
@@ -215,6 +230,10 @@ public:
 
     ptr< MonitoringAgent > getMonitoringAgent() const;
 
+    ptr< StageMetrics > getStageMetrics() const;
+
+    ptr< CatchupClientAgent > getCatchupClientAgent() const;
+
     schain_index getSchainIndex() const;
 
     ptr< Node > getNode() const;
@@ -31,6 +31,7 @@
 #include "catchup/server/CatchupServerAgent.h"
 #include "headers/BlockProposalRequestHeader.h"
 #include "monitoring/MonitoringAgent.h"
+#include "monitoring/StageMetrics.h"
 #include "monitoring/TimeoutAgent.h"
 #include "utils/Time.h"
 
@@ -77,6 +78,16 @@ ptr<MonitoringAgent> Schain::getMonitoringAgent() const {
     return monitoringAgent;
 }
 
+ptr<StageMetrics> Schain::getStageMetrics() const {
+    CHECK_STATE(stageMetrics)
+    return stageMetrics;
+}
+
+ptr<CatchupClientAgent> Schain::getCatchupClientAgent() const {
+    CHECK_STATE(catchupClientAgent)
+    return catchupClientAgent;
+}
+
 uint64_t Schain::getStartTimeMs() const {
     return startTimeMs;
 }
@@ -245,13 +256,6 @@ uint64_t Schain::getMaxExternalBlockProcessingTime() const {
     return maxExternalBlockProcessingTime;;
 }
 
-void Schain::joinMonitorAndTimeoutThreads() {
-    CHECK_STATE(monitoringAgent);
-    CHECK_STATE(timeoutAgent);
-    monitoringAgent->join();
-    timeoutAgent->join();
-}
-
  ptr<CryptoManager> Schain::getCryptoManager() const {
     CHECK_STATE(cryptoManager);
     return cryptoManager;
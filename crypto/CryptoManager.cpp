@@ -77,6 +77,8 @@
 
 #include "CryptoManager.h"
 
+#include "microprofile.h"
+
 void CryptoManager::initSGXClient() {
     if ( isSGXEnabled ) {
         if ( isHTTPSEnabled ) {
@@ -106,7 +108,10 @@ string CryptoManager::getSgxBlsKeyName() {
 CryptoManager::CryptoManager( uint64_t _totalSigners, uint64_t _requiredSigners, bool _isSGXEnabled,
     string _sgxURL, string _sgxSslKeyFileFullPath, string _sgxSslCertFileFullPath,
     string _sgxEcdsaKeyName, ptr< vector< string > > _sgxEcdsaPublicKeys )
-    : sessionKeys( SESSION_KEY_CACHE_SIZE ), sessionPublicKeys( SESSION_PUBLIC_KEY_CACHE_SIZE ) {
+    : sessionKeys( SESSION_KEY_CACHE_SIZE ),
+      sessionPublicKeys( SESSION_PUBLIC_KEY_CACHE_SIZE ),
+      sessionPublicKeyObjects( SESSION_PUBLIC_KEY_CACHE_SIZE ),
+      ecdsaPublicKeyObjects( ECDSA_PUBLIC_KEY_CACHE_SIZE ) {
     CHECK_ARGUMENT( _totalSigners >= _requiredSigners );
     totalSigners = _totalSigners;
     requiredSigners = _requiredSigners;
@@ -166,6 +171,8 @@ uint64_t CryptoManager::parseSGXPort( const string& _url ) {
 CryptoManager::CryptoManager( Schain& _sChain )
     : sessionKeys( SESSION_KEY_CACHE_SIZE ),
       sessionPublicKeys( SESSION_PUBLIC_KEY_CACHE_SIZE ),
+      sessionPublicKeyObjects( SESSION_PUBLIC_KEY_CACHE_SIZE ),
+      ecdsaPublicKeyObjects( ECDSA_PUBLIC_KEY_CACHE_SIZE ),
       sChain( &_sChain ) {
     totalSigners = getSchain()->getTotalSigners();
     requiredSigners = getSchain()->getRequiredSigners();
@@ -352,12 +359,19 @@ string CryptoManager::sgxSignECDSA( const ptr< BLAKE3Hash >& _hash, string& _key
 
 bool CryptoManager::verifyECDSA(
     const ptr< BLAKE3Hash >& _hash, const string& _sig, const string& _publicKey ) {
-    auto key = OpenSSLECDSAKey::importSGXPubKey( _publicKey );
+    MICROPROFILE_SCOPEI( "CryptoManager", "verifyECDSA", MP_GOLD );
+    auto key = ecdsaPublicKeyObjects.getIfExists( _publicKey );
+
+    if ( !key ) {
+        key = OpenSSLECDSAKey::importSGXPubKey( _publicKey );
+        ecdsaPublicKeyObjects.put( _publicKey, key );
+    }
 
     return key->verifySGXSig( _sig, ( const char* ) _hash->data() );
 }
 
 string CryptoManager::sign( const ptr< BLAKE3Hash >& _hash ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "sign", MP_GOLD );
     CHECK_ARGUMENT( _hash );
 
     if ( isSGXEnabled ) {
@@ -372,6 +386,7 @@ string CryptoManager::sign( const ptr< BLAKE3Hash >& _hash ) {
 
 tuple< string, string, string > CryptoManager::sessionSign(
     const ptr< BLAKE3Hash >& _hash, block_id _blockId ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "sessionSign", MP_GOLD );
     CHECK_ARGUMENT( _hash );
     if ( isSGXEnabled ) {
         string signature = "";
@@ -391,11 +406,18 @@ tuple< string, string, string > CryptoManager::sessionSign(
 
 bool CryptoManager::sessionVerifyEdDSASig(
     const ptr< BLAKE3Hash >& _hash, const string& _sig, const string& _publicKey ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "sessionVerifyEdDSASig", MP_GOLD );
     CHECK_ARGUMENT( _hash )
     CHECK_ARGUMENT( _sig != "" )
 
     if ( isSGXEnabled ) {
-        auto pkey = OpenSSLEdDSAKey::importPubKey( _publicKey );
+        auto pkey = sessionPublicKeyObjects.getIfExists( _publicKey );
+
+        if ( !pkey ) {
+            pkey = OpenSSLEdDSAKey::importPubKey( _publicKey );
+            sessionPublicKeyObjects.put( _publicKey, pkey );
+        }
+
         return pkey->verifySig( _sig, ( const char* ) _hash->data() );
     } else {
         // mockup - used for testing
@@ -412,6 +434,7 @@ bool CryptoManager::sessionVerifyEdDSASig(
 
 
 bool CryptoManager::verifyECDSASig( const ptr< BLAKE3Hash >& _hash, const string& _sig, node_id _nodeId ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "verifyECDSASig", MP_GOLD );
     CHECK_ARGUMENT( _hash )
     CHECK_ARGUMENT( _sig != "" )
 
@@ -480,6 +503,25 @@ ptr< ThresholdSigShare > CryptoManager::signBlockSigShare(
 }
 
 
+ptr< BLAKE3Hash > CryptoManager::calculateBlockSigHash(
+    schain_index _proposerIndex, block_id _blockId, schain_id _schainId ) {
+    MsgType msgType = MSG_BLOCK_SIGN_BROADCAST;
+
+    HASH_INIT( hashObj )
+
+    HASH_UPDATE( hashObj, _proposerIndex )
+    HASH_UPDATE( hashObj, _blockId )
+    HASH_UPDATE( hashObj, _schainId )
+    HASH_UPDATE( hashObj, msgType )
+
+    auto hash = make_shared< BLAKE3Hash >();
+
+    HASH_FINAL( hashObj, hash->data() );
+
+    return hash;
+}
+
+
 ptr< ThresholdSigShare > CryptoManager::signDAProofSigShare(
     const ptr< BLAKE3Hash >& _hash, block_id _blockId, bool _forceMockup ) {
     CHECK_ARGUMENT( _hash );
@@ -505,6 +547,7 @@ ptr< ThresholdSigShare > CryptoManager::signDAProofSigShare(
 
 void CryptoManager::verifyDAProofSigShare( ptr< ThresholdSigShare > _sigShare,
     schain_index _schainIndex, ptr< BLAKE3Hash > _hash, node_id _nodeId, bool _forceMockup ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "verifyDAProofSigShare", MP_GOLD );
     CHECK_ARGUMENT( _hash );
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
@@ -528,6 +571,7 @@ void CryptoManager::verifyDAProofSigShare( ptr< ThresholdSigShare > _sigShare,
 
 ptr< ThresholdSigShare > CryptoManager::signSigShare(
     const ptr< BLAKE3Hash >& _hash, block_id _blockId, bool _forceMockup ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "signSigShare", MP_GOLD );
     CHECK_ARGUMENT( _hash );
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
@@ -613,6 +657,7 @@ ptr< ThresholdSigShare > CryptoManager::createDAProofSigShare(
 
 
 void CryptoManager::signProposal( BlockProposal* _proposal ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "signProposal", MP_GOLD );
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
     CHECK_ARGUMENT( _proposal );
@@ -643,6 +688,7 @@ bool CryptoManager::verifyNetworkMsg( NetworkMessage& _msg ) {
 bool CryptoManager::sessionVerifySigAndKey(
     ptr< BLAKE3Hash >& _hash, const string& _sig, const string& _publicKey, const string& pkSig,
     block_id _blockID, node_id _nodeId) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "sessionVerifySigAndKey", MP_GOLD );
     MONITOR( __CLASS_NAME__, __FUNCTION__ );
 
 
@@ -650,24 +696,17 @@ bool CryptoManager::sessionVerifySigAndKey(
     CHECK_STATE(_hash );
 
 
-    {
-        LOCK( publicSessionKeysLock )
-
-        if (auto result = sessionPublicKeys.getIfExists( pkSig );
-             result.has_value()) {
-            auto publicKey2 =
-                any_cast<string>(result);
-            if ( publicKey2 != _publicKey )
+    if ( auto publicKey2 = sessionPublicKeys.getIfExists( pkSig ); publicKey2 ) {
+        if ( *publicKey2 != _publicKey )
+            return false;
+    } else {
+        if ( isSGXEnabled ) {
+            auto pkeyHash = calculatePublicKeyHash( _publicKey, _blockID );
+            if ( !verifyECDSASig( pkeyHash, pkSig, _nodeId ) ) {
+                LOG( warn, "PubKey ECDSA sig did not verify" );
                 return false;
-        } else {
-            if ( isSGXEnabled ) {
-                auto pkeyHash = calculatePublicKeyHash( _publicKey, _blockID );
-                if ( !verifyECDSASig( pkeyHash, pkSig, _nodeId ) ) {
-                    LOG( warn, "PubKey ECDSA sig did not verify" );
-                    return false;
-                }
-                sessionPublicKeys.put( pkSig, _publicKey );
             }
+            sessionPublicKeys.put( pkSig, make_shared< string >( _publicKey ) );
         }
     }
 
@@ -682,6 +721,7 @@ bool CryptoManager::sessionVerifySigAndKey(
 
 bool CryptoManager::verifyProposalECDSA(
     const ptr< BlockProposal >& _proposal, const string& _hashStr, const string& _signature ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "verifyProposalECDSA", MP_GOLD );
     CHECK_ARGUMENT( _proposal );
     CHECK_ARGUMENT( _hashStr != "" )
     CHECK_ARGUMENT( _signature != "" )
@@ -710,6 +750,7 @@ bool CryptoManager::verifyProposalECDSA(
 
 ptr< ThresholdSignature > CryptoManager::verifyDAProofThresholdSig(
     const ptr< BLAKE3Hash >& _hash, const string& _signature, block_id _blockId ) {
+    MICROPROFILE_SCOPEI( "CryptoManager", "verifyDAProofThresholdSig", MP_GOLD );
     MONITOR( __CLASS_NAME__, __FUNCTION__ )
 
     CHECK_ARGUMENT( _hash );
@@ -34,6 +34,8 @@
 #include "thirdparty/lru_ordered_cache.hpp"
 #include "thirdparty/lrucache.hpp"
 
+#include "PublicKeyCache.h"
+
 class Schain;
 class BLAKE3Hash;
 class ConsensusBLSSigShare;
@@ -71,9 +73,10 @@ class OpenSSLEdDSAKey;
 class CryptoManager {
     cache::lru_cache< uint64_t, tuple< ptr< OpenSSLEdDSAKey >, string, string > >
         sessionKeys;                                               // tsafe
-    cache::lru_ordered_cache< string, string > sessionPublicKeys;  // tsafe
+    PublicKeyCache< string > sessionPublicKeys;                   // tsafe
+    PublicKeyCache< OpenSSLEdDSAKey > sessionPublicKeyObjects;    // tsafe
+    PublicKeyCache< OpenSSLECDSAKey > ecdsaPublicKeyObjects;      // tsafe
     recursive_mutex sessionKeysLock;
-    recursive_mutex publicSessionKeysLock;
 
     map< uint64_t, ptr< jsonrpc::HttpClient > > httpClients;  // tsafe
     map< uint64_t, ptr< StubClient > > sgxClients;            // tsafe
@@ -181,6 +184,10 @@ public:
 
     ptr< ThresholdSigShare > signBlockSigShare( const ptr< BLAKE3Hash >& _hash, block_id _blockId );
 
+    // hash that is signed by the block threshold signature, see BlockSignBroadcastMessage
+    static ptr< BLAKE3Hash > calculateBlockSigHash(
+        schain_index _proposerIndex, block_id _blockId, schain_id _schainId );
+
     tuple< string, string, string > signNetworkMsg( NetworkMessage& _msg );
 
     bool verifyNetworkMsg( NetworkMessage& _msg );
@@ -0,0 +1,154 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file CryptoTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "openssl/bn.h"
+#include "openssl/ec.h"
+#include "openssl/ecdsa.h"
+#include "openssl/evp.h"
+#include "openssl/obj_mac.h"
+
+#include <gmp.h>
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "node/ConsensusEngine.h"
+
+#include "BLAKE3Hash.h"
+#include "CryptoManager.h"
+#include "OpenSSLECDSAKey.h"
+#include "OpenSSLEdDSAKey.h"
+
+#include "thirdparty/catch.hpp"
+
+static constexpr uint64_t VERIFY_BENCHMARK_ITERATIONS = 10000;
+
+ptr< BLAKE3Hash > createTestHash( uint64_t _i ) {
+    auto msg = make_shared< vector< uint8_t > >();
+    auto p = ( uint8_t* ) &_i;
+    msg->insert( msg->end(), p, p + sizeof( _i ) );
+    return BLAKE3Hash::calculateHash( msg );
+}
+
+ptr< CryptoManager > createTestSGXCryptoManager() {
+    // no calls to the SGX server are made by the verification paths
+    return make_shared< CryptoManager >( 4, 3, true, string( "http://localhost:1029" ), "", "",
+        string( "NEK:test" ), make_shared< vector< string > >() );
+}
+
+template < typename F >
+double verifiesPerSecond( F&& _verify ) {
+    auto begin = chrono::steady_clock::now();
+    for ( uint64_t i = 0; i < VERIFY_BENCHMARK_ITERATIONS; i++ ) {
+        REQUIRE( _verify() );
+    }
+    auto elapsed =
+        chrono::duration< double >( chrono::steady_clock::now() - begin ).count();
+    return VERIFY_BENCHMARK_ITERATIONS / elapsed;
+}
+
+// generate secp256k1 key and signature in the same format as SGX server returns
+tuple< string, string > createSGXFormatKeyAndSig( const ptr< BLAKE3Hash >& _hash ) {
+    auto key = EC_KEY_new_by_curve_name( NID_secp256k1 );
+    CHECK_STATE( key );
+    CHECK_STATE( EC_KEY_generate_key( key ) == 1 );
+
+    auto x = BN_new();
+    auto y = BN_new();
+    CHECK_STATE( EC_POINT_get_affine_coordinates_GFp( EC_KEY_get0_group( key ),
+                     EC_KEY_get0_public_key( key ), x, y, nullptr ) == 1 );
+
+    auto toPaddedHex = []( const BIGNUM* _bn ) {
+        auto hex = BN_bn2hex( _bn );
+        string result( hex );
+        OPENSSL_free( hex );
+        return string( 64 - result.size(), '0' ) + result;
+    };
+
+    auto publicKey = toPaddedHex( x ) + toPaddedHex( y );
+
+    auto sig = ECDSA_do_sign( _hash->data(), HASH_LEN, key );
+    CHECK_STATE( sig );
+    const BIGNUM* r = nullptr;
+    const BIGNUM* s = nullptr;
+    ECDSA_SIG_get0( sig, &r, &s );
+
+    auto signature = "0:" + toPaddedHex( r ) + ":" + toPaddedHex( s );
+
+    ECDSA_SIG_free( sig );
+    BN_free( x );
+    BN_free( y );
+    EC_KEY_free( key );
+
+    return { publicKey, signature };
+}
+
+
+TEST_CASE( "EdDSA session signature verification speed", "[eddsa-verify-bench]" ) {
+    ConsensusEngine engine;
+
+    auto cryptoManager = createTestSGXCryptoManager();
+
+    auto hash = createTestHash( 1 );
+    auto key = OpenSSLEdDSAKey::generateKey();
+    auto publicKey = key->serializePubKey();
+    auto sig = key->sign( ( const char* ) hash->data() );
+
+    auto before = verifiesPerSecond( [&]() {
+        return OpenSSLEdDSAKey::importPubKey( publicKey )->verifySig(
+            sig, ( const char* ) hash->data() );
+    } );
+
+    auto after = verifiesPerSecond(
+        [&]() { return cryptoManager->sessionVerifyEdDSASig( hash, sig, publicKey ); } );
+
+    cerr << "EdDSA verify/s: parse each time:" << ( uint64_t ) before
+         << ":cached key:" << ( uint64_t ) after << endl;
+
+    auto wrongHash = createTestHash( 2 );
+    REQUIRE( !cryptoManager->sessionVerifyEdDSASig( wrongHash, sig, publicKey ) );
+}
+
+
+TEST_CASE( "ECDSA signature verification speed", "[ecdsa-verify-bench]" ) {
+    ConsensusEngine engine;
+
+    auto cryptoManager = createTestSGXCryptoManager();
+
+    auto hash = createTestHash( 1 );
+    string publicKey, sig;
+    tie( publicKey, sig ) = createSGXFormatKeyAndSig( hash );
+
+    auto before = verifiesPerSecond( [&]() {
+        return OpenSSLECDSAKey::importSGXPubKey( publicKey )->verifySGXSig(
+            sig, ( const char* ) hash->data() );
+    } );
+
+    auto after =
+        verifiesPerSecond( [&]() { return cryptoManager->verifyECDSA( hash, sig, publicKey ); } );
+
+    cerr << "ECDSA verify/s: parse each time:" << ( uint64_t ) before
+         << ":cached key:" << ( uint64_t ) after << endl;
+
+    auto wrongHash = createTestHash( 2 );
+    REQUIRE( !cryptoManager->verifyECDSA( wrongHash, sig, publicKey ) );
+}
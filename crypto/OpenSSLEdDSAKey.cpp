@@ -206,45 +206,35 @@ string OpenSSLEdDSAKey::serializePubKey() const {
 bool OpenSSLEdDSAKey::verifySig( const string& _encodedSignature, const char* _hash ) const {
     CHECK_STATE( _hash );
 
-    bool result = false;
-
-    EVP_MD_CTX *  verifyCtx = nullptr;
-
-    try {
-
-        verifyCtx = EVP_MD_CTX_new();
-
-        vector< unsigned char > decodedSig( _encodedSignature.size(), 0 );
-
-        int decodedLen = 0;
-
-        CHECK_STATE( ( decodedLen = EVP_DecodeBlock( decodedSig.data(),
-                           ( const unsigned char* ) _encodedSignature.c_str(),
-                           _encodedSignature.size() ) ) > 0 )
-
-        CHECK_STATE( decodedLen >= 64 )
+    // verification context is reused by each thread, so that the verification path does
+    // not allocate
+    static thread_local unique_ptr< EVP_MD_CTX, decltype( &EVP_MD_CTX_free ) > verifyCtx(
+        EVP_MD_CTX_new(), &EVP_MD_CTX_free );
 
+    CHECK_STATE( verifyCtx );
 
+    // base64 encoded 64 byte signature is 88 chars long
+    if ( _encodedSignature.size() > MAX_ENCODED_SIG_LEN ) {
+        return false;
+    }
 
-        CHECK_STATE( verifyCtx );
+    array< unsigned char, MAX_ENCODED_SIG_LEN > decodedSig;
 
-        CHECK_STATE( EVP_DigestVerifyInit( verifyCtx, NULL, NULL, NULL, edKey ) > 0 )
+    auto decodedLen = EVP_DecodeBlock( decodedSig.data(),
+        ( const unsigned char* ) _encodedSignature.c_str(), _encodedSignature.size() );
 
-        CHECK_STATE( EVP_DigestVerify( verifyCtx, decodedSig.data(), 64,
-                         ( const unsigned char* ) _hash, 32 ) == 1 );
-        result = true;
-    } catch (...) {
-        if (!verifyCtx) { // out of memory
-            throw;
-        }
+    if ( decodedLen < 64 ) {
+        return false;
     }
 
-    if (verifyCtx) {
-        EVP_MD_CTX_free(verifyCtx);
-    }
+    CHECK_STATE( EVP_MD_CTX_reset( verifyCtx.get() ) == 1 );
 
-    return result;
+    if ( EVP_DigestVerifyInit( verifyCtx.get(), NULL, NULL, NULL, edKey ) <= 0 ) {
+        return false;
+    }
 
+    return EVP_DigestVerify(
+               verifyCtx.get(), decodedSig.data(), 64, ( const unsigned char* ) _hash, 32 ) == 1;
 }
 
 
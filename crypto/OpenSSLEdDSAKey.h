@@ -28,6 +28,8 @@
 
 class OpenSSLEdDSAKey {
 
+    static constexpr size_t MAX_ENCODED_SIG_LEN = 128;
+
     bool isPrivate = false;
 
     EVP_PKEY*  edKey = nullptr;
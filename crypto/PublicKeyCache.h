@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file PublicKeyCache.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_PUBLICKEYCACHE_H
+#define SKALED_PUBLICKEYCACHE_H
+
+#include <deque>
+
+// Read-mostly cache of parsed public key objects keyed by their encoded string.
+// Lookups take a shared lock and do not allocate, entries are evicted in FIFO order.
+
+template < typename K >
+class PublicKeyCache {
+    unordered_map< string, ptr< K > > items;  // tsafe
+    deque< string > insertionOrder;          // tsafe
+    shared_mutex itemsLock;
+
+    uint64_t maxSize;
+
+public:
+    explicit PublicKeyCache( uint64_t _maxSize ) : maxSize( _maxSize ) {
+        items.reserve( _maxSize );
+    }
+
+    ptr< K > getIfExists( const string& _encodedKey ) {
+        shared_lock< shared_mutex > lock( itemsLock );
+        auto it = items.find( _encodedKey );
+        if ( it == items.end() )
+            return nullptr;
+        return it->second;
+    }
+
+    void put( const string& _encodedKey, const ptr< K >& _key ) {
+        unique_lock< shared_mutex > lock( itemsLock );
+
+        if ( !items.emplace( _encodedKey, _key ).second )
+            return;
+
+        insertionOrder.push_back( _encodedKey );
+
+        while ( insertionOrder.size() > maxSize ) {
+            items.erase( insertionOrder.front() );
+            insertionOrder.pop_front();
+        }
+    }
+
+    uint64_t size() {
+        shared_lock< shared_mutex > lock( itemsLock );
+        return items.size();
+    }
+};
+
+#endif  // SKALED_PUBLICKEYCACHE_H
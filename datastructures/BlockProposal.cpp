@@ -43,6 +43,7 @@
 #include "pendingqueue/PendingTransactionsAgent.h"
 #include "datastructures/BlockProposalFragment.h"
 #include "datastructures/BlockProposalFragmentList.h"
+#include "datastructures/ReedSolomonCoder.h"
 #include "headers/BlockProposalRequestHeader.h"
 
 
@@ -296,7 +297,8 @@ ptr<BlockProposal> BlockProposal::deserialize(const ptr<vector<uint8_t> > &_seri
                 "Could not parse block header: \n" + headerStr, __CLASS_NAME__));
     }
 
-    auto list = deserializeTransactions(blockHeader, headerStr, _serializedProposal);
+    auto list = deserializeTransactions(
+            blockHeader, headerStr, _serializedProposal, 0, _serializedProposal->size());
 
     CHECK_STATE(list);
 
@@ -334,9 +336,11 @@ BlockProposal::defragment(const ptr<BlockProposalFragmentList> &_fragmentList,
     }
 }
 
-ptr<BlockProposalFragment> BlockProposal::getFragment(uint64_t _totalFragments, fragment_index _index) {
+ptr<vector<uint8_t>> BlockProposal::getFragmentBounds(uint64_t _totalFragments, fragment_index _index,
+                                                      uint64_t &_begin, uint64_t &_end) {
 
     CHECK_ARGUMENT(_totalFragments > 0);
+    CHECK_ARGUMENT(_index > 0);
     CHECK_ARGUMENT(_index <= _totalFragments);
     LOCK(m)
 
@@ -346,39 +350,54 @@ ptr<BlockProposalFragment> BlockProposal::getFragment(uint64_t _totalFragments,
 
     auto blockSize = serializedBlock->size();
 
-    uint64_t fragmentStandardSize;
+    ReedSolomonCoder coder(ReedSolomonCoder::dataShardsFor(_totalFragments), _totalFragments);
 
-    if (blockSize % _totalFragments == 0) {
-        fragmentStandardSize = serializedBlock->size() / _totalFragments;
-    } else {
-        fragmentStandardSize = serializedBlock->size() / _totalFragments + 1;
+    uint64_t shard = (uint64_t) _index - 1;
+
+    if (shard < coder.getDataShards()) {
+        coder.getDataShardBounds(blockSize, shard, _begin, _end);
+        return serializedBlock;
+    }
+
+    if (parityFragments == nullptr || parityTotalFragments != _totalFragments) {
+        parityFragments = coder.encodeParity(serializedBlock->data(), blockSize);
+        parityTotalFragments = _totalFragments;
     }
 
-    auto startIndex = fragmentStandardSize * ((uint64_t) _index - 1);
+    _begin = (shard - coder.getDataShards()) * coder.getShardSize(blockSize);
+    _end = _begin + coder.getShardSize(blockSize);
+
+    CHECK_STATE(_end <= parityFragments->size());
+
+    return parityFragments;
+}
+
+ptr<BlockProposalFragment> BlockProposal::getFragment(uint64_t _totalFragments, fragment_index _index) {
+
+    uint64_t begin, end;
+
+    auto serializedBlock = getFragmentBounds(_totalFragments, _index, begin, end);
 
     auto fragmentData = make_shared<vector<uint8_t>>();
 
-    fragmentData->reserve(fragmentStandardSize + 2);
+    fragmentData->reserve(end - begin + 2);
 
     fragmentData->push_back('<');
 
-    if (_index == _totalFragments) {
-        fragmentData->insert(fragmentData->begin() + 1, serializedBlock->begin() + startIndex,
-                             serializedBlock->end());
-    } else {
-        fragmentData->insert(fragmentData->begin() + 1, serializedBlock->begin() + startIndex,
-                             serializedBlock->begin() + startIndex + fragmentStandardSize);
-    }
+    fragmentData->insert(fragmentData->end(), serializedBlock->begin() + begin,
+                         serializedBlock->begin() + end);
 
     fragmentData->push_back('>');
 
     return make_shared<BlockProposalFragment>(getBlockID(), _totalFragments, _index, fragmentData,
-                                              serializedBlock->size(), getHash()->toHex());
+                                              serialize(SERIALIZE_AS_PROPOSAL)->size(),
+                                              getHash()->toHex());
 }
 
 ptr<TransactionList> BlockProposal::deserializeTransactions(const ptr<BlockProposalHeader> &_header,
                                                             const string &_headerString,
-                                                            const ptr<vector<uint8_t> > &_serializedBlock) {
+                                                            const ptr<vector<uint8_t> > &_serializedBlock,
+                                                            uint64_t _begin, uint64_t _end) {
 
     CHECK_ARGUMENT(_header);
     CHECK_ARGUMENT(_headerString != "");
@@ -389,13 +408,14 @@ ptr<TransactionList> BlockProposal::deserializeTransactions(const ptr<BlockPropo
     ptr<TransactionList> list;
     try {
         list = TransactionList::deserialize(
-                _header->getTransactionSizes(), _serializedBlock, headerSize + sizeof(headerSize), true);
+                _header->getTransactionSizes(), _serializedBlock,
+                _begin + headerSize + sizeof(headerSize), _end, true);
         CHECK_STATE(list);
 
     } catch (...) {
         throw_with_nested(
                 ParsingException("Could not parse transactions after header. Header: \n" + _headerString +
-                                 " Transactions size:" + to_string(_serializedBlock->size()),
+                                 " Transactions size:" + to_string(_end - _begin),
                                  __CLASS_NAME__)
         );
     }
@@ -409,9 +429,19 @@ string BlockProposal::extractHeader(const ptr<vector<uint8_t> > &_serializedBloc
 
     CHECK_ARGUMENT(_serializedBlock);
 
+    return extractHeader(_serializedBlock, 0, _serializedBlock->size());
+}
+
+string BlockProposal::extractHeader(const ptr<vector<uint8_t> > &_serializedBlock, uint64_t _begin,
+                                    uint64_t _end) {
+
+    CHECK_ARGUMENT(_serializedBlock);
+    CHECK_ARGUMENT(_begin <= _end);
+    CHECK_ARGUMENT(_end <= _serializedBlock->size());
+
     uint64_t headerSize = 0;
 
-    auto size = _serializedBlock->size();
+    auto size = _end - _begin;
 
     CHECK_ARGUMENT2(
             size >= sizeof(headerSize) + 2, "Serialized block too small:" + to_string(size));
@@ -419,21 +449,21 @@ string BlockProposal::extractHeader(const ptr<vector<uint8_t> > &_serializedBloc
     using boost::iostreams::array_source;
     using boost::iostreams::stream;
 
-    array_source src((char *) _serializedBlock->data(), _serializedBlock->size());
+    array_source src((char *) _serializedBlock->data() + _begin, size);
 
     stream<array_source> in(src);
 
     in.read((char *) &headerSize, sizeof(headerSize)); /* Flawfinder: ignore */
 
-    CHECK_STATE2(headerSize >= 2 && headerSize + sizeof(headerSize) <= _serializedBlock->size(),
+    CHECK_STATE2(headerSize >= 2 && headerSize + sizeof(headerSize) < size,
                  "Invalid header size" + to_string(headerSize));
 
 
     CHECK_STATE(headerSize <= MAX_BUFFER_SIZE);
 
-    CHECK_STATE(_serializedBlock->at(headerSize + sizeof(headerSize)) == '<');
-    CHECK_STATE(_serializedBlock->at(sizeof(headerSize)) == '{');
-    CHECK_STATE(_serializedBlock->back() == '>');
+    CHECK_STATE(_serializedBlock->at(_begin + headerSize + sizeof(headerSize)) == '<');
+    CHECK_STATE(_serializedBlock->at(_begin + sizeof(headerSize)) == '{');
+    CHECK_STATE(_serializedBlock->at(_end - 1) == '>');
 
     string header(headerSize, ' ');
 
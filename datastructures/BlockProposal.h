@@ -49,9 +49,10 @@ class BlockProposalFragmentList;
 class BlockProposal : public SendableItem {
     ptr< BlockProposalRequestHeader > header = nullptr; // tsafe
 
+protected:
+
     ptr< vector< uint8_t > > serializedProposal = nullptr;  // tsafe
 
-protected:
     schain_id schainID = 0;
     node_id proposerNodeID = 0;
     block_id blockID = 0;
@@ -65,18 +66,27 @@ protected:
 
     ptr< BLAKE3Hash > hash = nullptr; // tsafe
 
+    // erasure coded parity fragments, computed when a parity fragment is requested first
+    ptr< vector< uint8_t > > parityFragments = nullptr;  // guarded by m
+
+    uint64_t parityTotalFragments = 0;  // guarded by m
+
     string signature;
 
     void calculateHash();
 
     virtual ptr< BasicHeader > createHeader(uint64_t _flags = 0);
 
+    // the block is in [_begin, _end) of _serializedBlock
     static ptr< TransactionList > deserializeTransactions(
         const ptr< BlockProposalHeader >& _header, const string& _headerString,
-        const ptr< vector< uint8_t > >& _serializedBlock );
+        const ptr< vector< uint8_t > >& _serializedBlock, uint64_t _begin, uint64_t _end );
 
     static string extractHeader( const ptr< vector< uint8_t > >& _serializedBlock );
 
+    static string extractHeader(
+        const ptr< vector< uint8_t > >& _serializedBlock, uint64_t _begin, uint64_t _end );
+
     static ptr< BlockProposalHeader > parseBlockHeader( const string& _header );
 
 public:
@@ -119,6 +129,14 @@ public:
 
     ptr< BlockProposalFragment > getFragment( uint64_t _totalFragments, fragment_index _index );
 
+    // fragments are Reed-Solomon shards, any ReedSolomonCoder::dataShardsFor(_totalFragments)
+    // of them reconstruct the proposal.
+    // Returns the buffer that holds the fragment, which is cached and never modified, and the
+    // bounds of the fragment in it, so that the fragment is sent without a copy. Data fragments
+    // are slices of the serialized proposal, parity fragments are slices of the parity buffer
+    ptr< vector< uint8_t > > getFragmentBounds(
+        uint64_t _totalFragments, fragment_index _index, uint64_t& _begin, uint64_t& _end );
+
     [[nodiscard]]  u256 getStateRoot() const;
 
     [[nodiscard]]  ptr< BlockProposalRequestHeader > createRequestHeader();
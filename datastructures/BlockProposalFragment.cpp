@@ -38,7 +38,8 @@ BlockProposalFragment::BlockProposalFragment(const block_id & _blockId, const ui
     CHECK_ARGUMENT( _blockId > 0);
     CHECK_ARGUMENT( _data->size() > 0);
 
-    if ( _data->size() < 3) {
+    // data fragments at the end of a small block are empty
+    if ( _data->size() < 2) {
         BOOST_THROW_EXCEPTION(ParsingException("Data fragment too short:" +
          to_string( _data->size()), __CLASS_NAME__));
     }
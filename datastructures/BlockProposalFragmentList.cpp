@@ -38,7 +38,9 @@
 
 BlockProposalFragmentList::BlockProposalFragmentList(
     const block_id& _blockId, const uint64_t _totalFragments )
-    : blockID( _blockId ), totalFragments( _totalFragments ) {
+    : blockID( _blockId ),
+      totalFragments( _totalFragments ),
+      coder( ReedSolomonCoder::dataShardsFor( _totalFragments ), _totalFragments ) {
     CHECK_ARGUMENT( totalFragments > 0 );
 
     for ( uint64_t i = 1; i <= totalFragments; i++ ) {
@@ -89,6 +91,10 @@ bool BlockProposalFragmentList::addFragment(
 
     checkSanity();
 
+    // a fragment of a wrong size would corrupt the decoding
+    CHECK_ARGUMENT( _fragment->serialize()->size() ==
+                    coder.getShardLength( blockSize, ( uint64_t ) _fragment->getIndex() - 1 ) + 2 );
+
     nextIndex = 0;
 
     if ( fragments.find( _fragment->getIndex() ) != fragments.end() ) {
@@ -128,13 +134,8 @@ bool BlockProposalFragmentList::isComplete() {
 
     checkSanity();
 
-    if ( fragments.size() == totalFragments ) {
-        for ( uint64_t i = 1; i <= totalFragments; i++ ) {
-            CHECK_STATE( fragments.find( i ) != fragments.end() )
-        }
-
-        CHECK_STATE( missingFragments.size() == 0 );
-
+    if ( fragments.size() >= coder.getDataShards() ) {
+        CHECK_STATE( missingFragments.size() == totalFragments - fragments.size() );
         return true;
     }
 
@@ -142,7 +143,7 @@ bool BlockProposalFragmentList::isComplete() {
 }
 
 const ptr< vector< uint8_t > > BlockProposalFragmentList::serialize() {
-    auto result = make_shared< vector< uint8_t > >();
+    ptr< vector< uint8_t > > result = nullptr;
 
     CHECK_STATE( isComplete() );
     CHECK_STATE( !isSerialized )
@@ -151,28 +152,23 @@ const ptr< vector< uint8_t > > BlockProposalFragmentList::serialize() {
 
     isSerialized = true;
 
-    uint64_t totalLen = 0;
-
     try {
+        map< uint64_t, ReedSolomonCoder::shard_view > shards;
+
+        // fragments are enclosed in < >
         for ( auto&& item : fragments ) {
             CHECK_STATE( item.second );
-            totalLen += item.second->size() - 2;
+            shards[( uint64_t ) item.first - 1] = { item.second->data() + 1, item.second->size() - 2 };
         }
 
-        result->reserve( totalLen );
-
-        for ( auto&& item : fragments ) {
-            auto fragment = item.second;
-            CHECK_STATE( fragment );
-            result->insert( result->end(), fragment->begin() + 1, fragment->end() - 1 );
-        }
+        result = coder.decode( shards, blockSize );
 
     } catch ( ... ) {
         throw_with_nested( SerializeException( "Could not serialize fragments", __CLASS_NAME__ ) );
     }
 
 
-    CHECK_STATE( result->size() == totalLen );
+    CHECK_STATE( result->size() == ( uint64_t ) blockSize );
 
     CHECK_STATE( result->at( sizeof( uint64_t ) ) == '{' );
     CHECK_STATE( result->back() == '>' );
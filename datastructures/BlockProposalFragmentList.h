@@ -35,8 +35,12 @@ class BlockProposalFragment;
 #include <boost/random/uniform_int_distribution.hpp>
 
 #include "DataStructure.h"
+#include "ReedSolomonCoder.h"
 
 
+// Fragments are Reed-Solomon shards of the proposal, the list is complete as soon as
+// any coder.getDataShards() of the totalFragments fragments are received.
+
 class BlockProposalFragmentList : public DataStructure {
 
     map<fragment_index, ptr<vector<uint8_t>>> fragments; // tsafe
@@ -53,6 +57,8 @@ class BlockProposalFragmentList : public DataStructure {
 
     const uint64_t  totalFragments  = 0;
 
+    const ReedSolomonCoder coder;
+
     void checkSanity();
 
     static boost::random::mt19937 gen;
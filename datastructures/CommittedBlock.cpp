@@ -72,6 +72,15 @@ void CommittedBlock::serializedSanityCheck(const ptr<vector<uint8_t>>& _serializ
     CHECK_ARGUMENT( _serializedBlock->back() == '>' );
 };
 
+void CommittedBlock::serializedSanityCheck(
+    const ptr<vector<uint8_t>>& _serializedBlocks, uint64_t _begin, uint64_t _end ) {
+    CHECK_ARGUMENT( _serializedBlocks );
+    CHECK_ARGUMENT( _begin + sizeof( uint64_t ) < _end );
+    CHECK_ARGUMENT( _end <= _serializedBlocks->size() );
+    CHECK_ARGUMENT( _serializedBlocks->at( _begin + sizeof( uint64_t ) ) == '{' );
+    CHECK_ARGUMENT( _serializedBlocks->at( _end - 1 ) == '>' );
+};
+
 
 ptr< CommittedBlock > CommittedBlock::createRandomSample(const ptr< CryptoManager >& _manager,
     uint64_t _size, boost::random::mt19937& _gen, boost::random::uniform_int_distribution<>& _ubyte,
@@ -108,12 +117,20 @@ string CommittedBlock::getThresholdSig() const {
 
 
 
-ptr< CommittedBlock > CommittedBlock::deserialize(
-    const ptr<vector<uint8_t>>& _serializedBlock, const ptr< CryptoManager >& _manager ) {
+ptr< CommittedBlock > CommittedBlock::deserialize( const ptr<vector<uint8_t>>& _serializedBlock,
+    const ptr< CryptoManager >& _manager ) {
     CHECK_ARGUMENT( _serializedBlock );
+
+    return deserialize( _serializedBlock, 0, _serializedBlock->size(), _manager );
+}
+
+
+ptr< CommittedBlock > CommittedBlock::deserialize( const ptr<vector<uint8_t>>& _serializedBlocks,
+    uint64_t _begin, uint64_t _end, const ptr< CryptoManager >& _manager ) {
+    CHECK_ARGUMENT( _serializedBlocks );
     CHECK_ARGUMENT( _manager );
 
-    string headerStr = extractHeader( _serializedBlock );
+    string headerStr = extractHeader( _serializedBlocks, _begin, _end );
 
     CHECK_STATE(!headerStr.empty() );
 
@@ -134,7 +151,7 @@ ptr< CommittedBlock > CommittedBlock::deserialize(
     ptr< TransactionList > list = nullptr;
 
     try {
-        list = deserializeTransactions( blockHeader, headerStr, _serializedBlock );
+        list = deserializeTransactions( blockHeader, headerStr, _serializedBlocks, _begin, _end );
     } catch ( ... ) {
         throw_with_nested(
             InvalidStateException( "Could not deserialize transactions", __CLASS_NAME__ ) );
@@ -69,8 +69,13 @@ public:
         const string& _signature, const string& _thresholdSig );
 
 
-    static ptr< CommittedBlock > deserialize(
-        const ptr<vector<uint8_t>>& _serializedBlock, const ptr< CryptoManager >& _manager );
+    static ptr< CommittedBlock > deserialize( const ptr<vector<uint8_t>>& _serializedBlock,
+        const ptr< CryptoManager >& _manager );
+
+    // deserializes the block in [_begin, _end) of a buffer that holds other blocks too,
+    // without copying it out
+    static ptr< CommittedBlock > deserialize( const ptr<vector<uint8_t>>& _serializedBlocks,
+        uint64_t _begin, uint64_t _end, const ptr< CryptoManager >& _manager );
 
 
     static ptr< CommittedBlock > createRandomSample( const ptr< CryptoManager >& _manager,
@@ -78,4 +83,7 @@ public:
         boost::random::uniform_int_distribution<>& _ubyte, block_id _blockID = block_id( 1 ) );
 
     static void serializedSanityCheck( const ptr<vector<uint8_t>>& _serializedBlock );
+
+    static void serializedSanityCheck(
+        const ptr<vector<uint8_t>>& _serializedBlocks, uint64_t _begin, uint64_t _end );
 };
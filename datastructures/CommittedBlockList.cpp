@@ -27,6 +27,7 @@
 #include "crypto/CryptoManager.h"
 #include "crypto/BLAKE3Hash.h"
 #include "exceptions/InvalidStateException.h"
+#include "threads/WorkStealingExecutor.h"
 
 #include "CommittedBlock.h"
 #include "CommittedBlockList.h"
@@ -50,44 +51,105 @@ CommittedBlockList::CommittedBlockList(const ptr< CryptoManager >& _cryptoManage
     CHECK_ARGUMENT( _serializedBlocks->at( _offset ) == '[' );
     CHECK_ARGUMENT( _serializedBlocks->at( _serializedBlocks->size() - 1 ) == ']' );
 
-    uint64_t counter = 0;
-    size_t index = 0;
-    size_t endIndex = 0;
-
     try {
-        index = _offset + 1;
+        blocks = deserializeBlocks(
+            _cryptoManager, _blockSizes, _serializedBlocks, 0, _blockSizes->size(), _offset + 1 );
+    } catch ( ... ) {
+        throw_with_nested( InvalidStateException(
+            "Could not create block list. \n"
+                "LIST_SIZE:" + to_string(_blockSizes->size()) +
+                ":SERIALIZED_BLOCK_SIZE:" + to_string(_serializedBlocks->size()) +
+                ":OFFSET:" + to_string(_offset), __CLASS_NAME__ ) );
+    }
+};
 
-        blocks = make_shared< vector< ptr< CommittedBlock > > >();
 
-        for ( auto&& size : *_blockSizes ) {
-            endIndex = index + size;
+ptr< vector< ptr< CommittedBlock > > > CommittedBlockList::deserializeBlocks(
+    const ptr< CryptoManager >& _cryptoManager, const ptr< vector< uint64_t > >& _blockSizes,
+    const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t _firstBlock, uint64_t _blockCount,
+    size_t _index ) {
+    CHECK_ARGUMENT( _firstBlock + _blockCount <= _blockSizes->size() );
 
-            CHECK_STATE( endIndex <= _serializedBlocks->size() );
+    auto result = make_shared< vector< ptr< CommittedBlock > > >();
+    result->reserve( _blockCount );
 
-            auto blockData = make_shared<vector<uint8_t>>(
-                _serializedBlocks->begin() + index, _serializedBlocks->begin() + endIndex );
+    uint64_t counter = _firstBlock;
+    size_t index = _index;
+    size_t endIndex = 0;
 
-            CommittedBlock::serializedSanityCheck( blockData );
+    try {
+        for ( ; counter < _firstBlock + _blockCount; counter++ ) {
+            endIndex = index + _blockSizes->at( counter );
 
-            auto block = CommittedBlock::deserialize( blockData, _cryptoManager );
+            CHECK_STATE( endIndex <= _serializedBlocks->size() );
 
-            blocks->push_back(block);
+            // parsed in place, the transactions copy out only their own bytes
+            CommittedBlock::serializedSanityCheck( _serializedBlocks, index, endIndex );
 
-            index = endIndex;
+            auto block =
+                CommittedBlock::deserialize( _serializedBlocks, index, endIndex, _cryptoManager );
 
-            counter++;
+            result->push_back(block);
+
+            index = endIndex;
         }
     } catch ( ... ) {
         throw_with_nested( InvalidStateException(
-            "Could not create block list. \n"
-                "LIST_SIZE:" + to_string(_blockSizes->size()) +
-                ":SERIALIZED_BLOCK_SIZE:" + to_string(_serializedBlocks->size()) +
-                ":OFFSET:" + to_string(_offset) +
-                ":COUNTER:" + to_string(counter) +
+            "Could not deserialize block:COUNTER:" + to_string(counter) +
                 ":INDEX:" + to_string(index) +
                 ":END_INDEX:" + to_string(endIndex), __CLASS_NAME__ ) );
     }
-};
+
+    return result;
+}
+
+
+void CommittedBlockList::deserializeInBatches( const ptr< CryptoManager >& _cryptoManager,
+    const ptr< WorkStealingExecutor >& _executor, const ptr< vector< uint64_t > >& _blockSizes,
+    const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t _offset, uint64_t _batchSize,
+    const batch_handler& _handler ) {
+    CHECK_ARGUMENT( _cryptoManager );
+    CHECK_ARGUMENT( _executor );
+    CHECK_ARGUMENT( _blockSizes );
+    CHECK_ARGUMENT( _blockSizes->size() > 0 );
+    CHECK_ARGUMENT( _serializedBlocks );
+    CHECK_ARGUMENT( _batchSize > 0 );
+    CHECK_ARGUMENT( _handler );
+
+    CHECK_ARGUMENT( _serializedBlocks->at( _offset ) == '[' );
+    CHECK_ARGUMENT( _serializedBlocks->at( _serializedBlocks->size() - 1 ) == ']' );
+
+    auto batchCount = ( _blockSizes->size() + _batchSize - 1 ) / _batchSize;
+
+    auto batches = make_shared< vector< ptr< CommittedBlockList > > >( batchCount );
+
+    vector< WorkStealingExecutor::task > tasks;
+
+    size_t index = _offset + 1;
+
+    for ( uint64_t i = 0; i < batchCount; i++ ) {
+        auto firstBlock = i * _batchSize;
+        auto blockCount = min( _batchSize, _blockSizes->size() - firstBlock );
+
+        // signatures of a batch are verified by the task that parses it, so the batches of a
+        // response are verified in parallel
+        tasks.push_back( [_cryptoManager, _blockSizes, _serializedBlocks, batches, i, firstBlock,
+                             blockCount, index]() {
+            batches->at( i ) = make_shared< CommittedBlockList >( deserializeBlocks(
+                _cryptoManager, _blockSizes, _serializedBlocks, firstBlock, blockCount, index ) );
+        } );
+
+        for ( uint64_t j = firstBlock; j < firstBlock + blockCount; j++ ) {
+            index += _blockSizes->at( j );
+        }
+    }
+
+    CHECK_ARGUMENT( index < _serializedBlocks->size() );
+
+    _executor->submitOrdered( PRIORITY_CATCHUP, tasks, [&]( uint64_t _batch ) {
+        _handler( batches->at( _batch ), _batch + 1 == batchCount );
+    } );
+}
 
 
 ptr< vector< ptr< CommittedBlock > > > CommittedBlockList::getBlocks() {
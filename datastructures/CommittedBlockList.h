@@ -35,6 +35,7 @@
 
 
 class CommittedBlock;
+class WorkStealingExecutor;
 
 class CommittedBlockList : public DataStructure {
 
@@ -44,8 +45,17 @@ class CommittedBlockList : public DataStructure {
         const ptr< vector< uint64_t > >& _blockSizes,
         const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t offset = 0 );
 
+    // parses blocks [_firstBlock, _firstBlock + _blockCount) starting at byte _index
+    static ptr< vector< ptr< CommittedBlock > > > deserializeBlocks(
+        const ptr< CryptoManager >& _cryptoManager, const ptr< vector< uint64_t > >& _blockSizes,
+        const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t _firstBlock,
+        uint64_t _blockCount, size_t _index );
+
 public:
 
+    using batch_handler =
+        function< void( const ptr< CommittedBlockList >& _batch, bool _isLastBatch ) >;
+
     explicit CommittedBlockList( const ptr< vector< ptr< CommittedBlock > > >& _blocks );
 
 
@@ -59,6 +69,14 @@ public:
         const ptr< vector< uint64_t > >& _blockSizes,
         const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t _offset );
 
+    // parses and verifies batches of _batchSize blocks on the executor workers. _handler is
+    // called on the calling thread for each batch in block order, so that the caller processes
+    // a batch while the next ones are still being verified
+    static void deserializeInBatches( const ptr< CryptoManager >& _cryptoManager,
+        const ptr< WorkStealingExecutor >& _executor, const ptr< vector< uint64_t > >& _blockSizes,
+        const ptr< vector< uint8_t > >& _serializedBlocks, uint64_t _offset, uint64_t _batchSize,
+        const batch_handler& _handler );
+
 
     static ptr< CommittedBlockList > createRandomSample( const ptr< CryptoManager >& _cryptoManager,
         uint64_t _size, boost::random::mt19937& _gen,
@@ -36,6 +36,9 @@ ptr<BLAKE3Hash>ListOfHashes::calculateTopMerkleRoot() {
 
     LOCK(m)
 
+    if (topMerkleRoot)
+        return topMerkleRoot;
+
     CHECK_STATE(hashCount() > 0);
 
     vector<ptr<BLAKE3Hash>> hashes;
@@ -57,7 +60,9 @@ ptr<BLAKE3Hash>ListOfHashes::calculateTopMerkleRoot() {
         hashes.resize(hashes.size() / 2);
     }
 
-    return hashes.front();
+    topMerkleRoot = hashes.front();
+
+    return topMerkleRoot;
 
 }
 
@@ -30,6 +30,9 @@ class SHAHAsh;
 
 class ListOfHashes : public DataStructure {
 
+    // lists never change after construction, so the root is calculated once
+    ptr<BLAKE3Hash> topMerkleRoot = nullptr; // guarded by m
+
 public:
 
     virtual uint64_t hashCount() = 0;
@@ -0,0 +1,367 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReedSolomonCoder.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define RS_X86_SIMD 1
+#endif
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include "ReedSolomonCoder.h"
+
+
+// x^8 + x^4 + x^3 + x^2 + 1
+static constexpr uint64_t GF_POLYNOMIAL = 0x11d;
+
+
+ReedSolomonCoder::GaloisField::GaloisField()
+    : mul( 256 ), mulLow( 256 ), mulHigh( 256 ) {
+    uint64_t x = 1;
+
+    for ( uint64_t i = 0; i < 255; i++ ) {
+        exp[i] = ( uint8_t ) x;
+        exp[i + 255] = ( uint8_t ) x;
+        log[x] = ( uint8_t ) i;
+        x <<= 1;
+        if ( x & 0x100 )
+            x ^= GF_POLYNOMIAL;
+    }
+
+    exp[510] = exp[0];
+    exp[511] = exp[1];
+    log[0] = 0;
+
+    for ( uint64_t a = 0; a < 256; a++ ) {
+        for ( uint64_t b = 0; b < 256; b++ ) {
+            mul[a][b] = ( a == 0 || b == 0 ) ? 0 : exp[log[a] + log[b]];
+        }
+        for ( uint64_t b = 0; b < 16; b++ ) {
+            mulLow[a][b] = mul[a][b];
+            mulHigh[a][b] = mul[a][b << 4];
+        }
+    }
+}
+
+
+const ReedSolomonCoder::GaloisField ReedSolomonCoder::field;
+
+
+uint8_t ReedSolomonCoder::gfMultiply( uint8_t _a, uint8_t _b ) {
+    return field.mul[_a][_b];
+}
+
+
+uint8_t ReedSolomonCoder::gfInverse( uint8_t _a ) {
+    CHECK_ARGUMENT( _a != 0 );
+    return field.exp[255 - field.log[_a]];
+}
+
+
+#ifdef RS_X86_SIMD
+
+// both kernels look up the products of the low and high nibbles with a byte shuffle
+// and return the number of bytes processed, the tail is left to the scalar loop
+
+__attribute__( ( target( "ssse3" ) ) ) static uint64_t mulAddSSSE3(
+    const uint8_t* _low, const uint8_t* _high, const uint8_t* _src, uint8_t* _dst, uint64_t _len ) {
+    auto low = _mm_loadu_si128( ( const __m128i* ) _low );
+    auto high = _mm_loadu_si128( ( const __m128i* ) _high );
+    auto mask = _mm_set1_epi8( 0x0f );
+
+    uint64_t i = 0;
+
+    for ( ; i + 16 <= _len; i += 16 ) {
+        auto s = _mm_loadu_si128( ( const __m128i* ) ( _src + i ) );
+        auto l = _mm_shuffle_epi8( low, _mm_and_si128( s, mask ) );
+        auto h = _mm_shuffle_epi8( high, _mm_and_si128( _mm_srli_epi64( s, 4 ), mask ) );
+        auto d = _mm_loadu_si128( ( const __m128i* ) ( _dst + i ) );
+        _mm_storeu_si128( ( __m128i* ) ( _dst + i ), _mm_xor_si128( d, _mm_xor_si128( l, h ) ) );
+    }
+
+    return i;
+}
+
+
+__attribute__( ( target( "avx2" ) ) ) static uint64_t mulAddAVX2(
+    const uint8_t* _low, const uint8_t* _high, const uint8_t* _src, uint8_t* _dst, uint64_t _len ) {
+    auto low = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* ) _low ) );
+    auto high = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* ) _high ) );
+    auto mask = _mm256_set1_epi8( 0x0f );
+
+    uint64_t i = 0;
+
+    for ( ; i + 32 <= _len; i += 32 ) {
+        auto s = _mm256_loadu_si256( ( const __m256i* ) ( _src + i ) );
+        auto l = _mm256_shuffle_epi8( low, _mm256_and_si256( s, mask ) );
+        auto h = _mm256_shuffle_epi8( high, _mm256_and_si256( _mm256_srli_epi64( s, 4 ), mask ) );
+        auto d = _mm256_loadu_si256( ( const __m256i* ) ( _dst + i ) );
+        _mm256_storeu_si256(
+            ( __m256i* ) ( _dst + i ), _mm256_xor_si256( d, _mm256_xor_si256( l, h ) ) );
+    }
+
+    return i;
+}
+
+#endif
+
+
+using mul_add_kernel = uint64_t ( * )(
+    const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, uint64_t );
+
+
+static mul_add_kernel selectKernel() {
+#ifdef RS_X86_SIMD
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) )
+        return mulAddAVX2;
+    if ( __builtin_cpu_supports( "ssse3" ) )
+        return mulAddSSSE3;
+#endif
+    return nullptr;
+}
+
+
+static const mul_add_kernel simdKernel = selectKernel();
+
+
+void ReedSolomonCoder::mulAddRegion(
+    uint8_t _c, const uint8_t* _src, uint8_t* _dst, uint64_t _len, bool _useSimd ) {
+    if ( _c == 0 || _len == 0 )
+        return;
+
+    CHECK_ARGUMENT( _src );
+    CHECK_ARGUMENT( _dst );
+
+    uint64_t i = 0;
+
+    if ( _useSimd && simdKernel ) {
+        i = simdKernel( field.mulLow[_c].data(), field.mulHigh[_c].data(), _src, _dst, _len );
+    }
+
+    auto& row = field.mul[_c];
+
+    for ( ; i < _len; i++ ) {
+        _dst[i] ^= row[_src[i]];
+    }
+}
+
+
+ReedSolomonCoder::ReedSolomonCoder( uint64_t _dataShards, uint64_t _totalShards )
+    : dataShards( _dataShards ), totalShards( _totalShards ) {
+    CHECK_ARGUMENT( _dataShards > 0 );
+    CHECK_ARGUMENT( _dataShards <= _totalShards );
+    // the Cauchy matrix needs totalShards distinct field elements
+    CHECK_ARGUMENT( _totalShards <= 256 );
+
+    auto parityShards = totalShards - dataShards;
+
+    parityMatrix.resize( parityShards * dataShards );
+
+    // 1 / (x_i + y_j) with x_i = dataShards + i and y_j = j, any square submatrix of a
+    // Cauchy matrix is invertible
+    for ( uint64_t i = 0; i < parityShards; i++ ) {
+        for ( uint64_t j = 0; j < dataShards; j++ ) {
+            parityMatrix[i * dataShards + j] = gfInverse( ( uint8_t ) ( ( dataShards + i ) ^ j ) );
+        }
+    }
+}
+
+
+uint64_t ReedSolomonCoder::dataShardsFor( uint64_t _totalShards ) {
+    CHECK_ARGUMENT( _totalShards > 0 );
+    return _totalShards - _totalShards / 3;
+}
+
+
+uint64_t ReedSolomonCoder::getDataShards() const {
+    return dataShards;
+}
+
+
+uint64_t ReedSolomonCoder::getTotalShards() const {
+    return totalShards;
+}
+
+
+uint64_t ReedSolomonCoder::getShardSize( uint64_t _dataSize ) const {
+    CHECK_ARGUMENT( _dataSize > 0 );
+    return ( _dataSize + dataShards - 1 ) / dataShards;
+}
+
+
+void ReedSolomonCoder::getDataShardBounds(
+    uint64_t _dataSize, uint64_t _shard, uint64_t& _begin, uint64_t& _end ) const {
+    CHECK_ARGUMENT( _shard < dataShards );
+
+    auto shardSize = getShardSize( _dataSize );
+
+    _begin = min( _shard * shardSize, _dataSize );
+    _end = min( _begin + shardSize, _dataSize );
+}
+
+
+uint64_t ReedSolomonCoder::getShardLength( uint64_t _dataSize, uint64_t _shard ) const {
+    CHECK_ARGUMENT( _shard < totalShards );
+
+    if ( _shard >= dataShards )
+        return getShardSize( _dataSize );
+
+    uint64_t begin, end;
+    getDataShardBounds( _dataSize, _shard, begin, end );
+    return end - begin;
+}
+
+
+ptr< vector< uint8_t > > ReedSolomonCoder::encodeParity(
+    const uint8_t* _data, uint64_t _dataSize ) const {
+    CHECK_ARGUMENT( _data );
+
+    auto shardSize = getShardSize( _dataSize );
+
+    auto result = make_shared< vector< uint8_t > >( ( totalShards - dataShards ) * shardSize, 0 );
+
+    for ( uint64_t i = 0; i < totalShards - dataShards; i++ ) {
+        auto parity = result->data() + i * shardSize;
+        for ( uint64_t j = 0; j < dataShards; j++ ) {
+            uint64_t begin, end;
+            getDataShardBounds( _dataSize, j, begin, end );
+            mulAddRegion( parityMatrix[i * dataShards + j], _data + begin, parity, end - begin );
+        }
+    }
+
+    return result;
+}
+
+
+void ReedSolomonCoder::invert( vector< uint8_t >& _matrix, uint64_t _size ) {
+    CHECK_ARGUMENT( _matrix.size() == _size * _size );
+
+    vector< uint8_t > inverse( _size * _size, 0 );
+
+    for ( uint64_t i = 0; i < _size; i++ ) {
+        inverse[i * _size + i] = 1;
+    }
+
+    for ( uint64_t col = 0; col < _size; col++ ) {
+        auto pivot = col;
+
+        while ( pivot < _size && _matrix[pivot * _size + col] == 0 ) {
+            pivot++;
+        }
+
+        CHECK_STATE2( pivot < _size, "Singular decoding matrix" );
+
+        if ( pivot != col ) {
+            for ( uint64_t k = 0; k < _size; k++ ) {
+                swap( _matrix[pivot * _size + k], _matrix[col * _size + k] );
+                swap( inverse[pivot * _size + k], inverse[col * _size + k] );
+            }
+        }
+
+        auto factor = gfInverse( _matrix[col * _size + col] );
+
+        for ( uint64_t k = 0; k < _size; k++ ) {
+            _matrix[col * _size + k] = gfMultiply( _matrix[col * _size + k], factor );
+            inverse[col * _size + k] = gfMultiply( inverse[col * _size + k], factor );
+        }
+
+        for ( uint64_t row = 0; row < _size; row++ ) {
+            auto c = _matrix[row * _size + col];
+            if ( row == col || c == 0 )
+                continue;
+            for ( uint64_t k = 0; k < _size; k++ ) {
+                _matrix[row * _size + k] ^= gfMultiply( c, _matrix[col * _size + k] );
+                inverse[row * _size + k] ^= gfMultiply( c, inverse[col * _size + k] );
+            }
+        }
+    }
+
+    _matrix.swap( inverse );
+}
+
+
+ptr< vector< uint8_t > > ReedSolomonCoder::decode(
+    const map< uint64_t, shard_view >& _shards, uint64_t _dataSize ) const {
+    CHECK_ARGUMENT( _shards.size() >= dataShards );
+
+    auto shardSize = getShardSize( _dataSize );
+
+    auto result = make_shared< vector< uint8_t > >( dataShards * shardSize, 0 );
+
+    vector< uint64_t > missing;
+
+    for ( uint64_t j = 0; j < dataShards; j++ ) {
+        auto it = _shards.find( j );
+        if ( it == _shards.end() ) {
+            missing.push_back( j );
+            continue;
+        }
+        CHECK_ARGUMENT( it->second.first || it->second.second == 0 );
+        CHECK_ARGUMENT( it->second.second <= shardSize );
+        memcpy( result->data() + j * shardSize, it->second.first, it->second.second );
+    }
+
+    if ( !missing.empty() ) {
+        // present data shards first, then as many parity shards as needed
+        vector< pair< uint64_t, shard_view > > used;
+
+        for ( auto&& item : _shards ) {
+            CHECK_ARGUMENT( item.first < totalShards );
+            CHECK_ARGUMENT( item.second.second <= shardSize );
+            if ( used.size() == dataShards )
+                break;
+            used.push_back( item );
+        }
+
+        CHECK_STATE( used.size() == dataShards );
+
+        vector< uint8_t > matrix( dataShards * dataShards, 0 );
+
+        for ( uint64_t r = 0; r < dataShards; r++ ) {
+            auto shard = used[r].first;
+            if ( shard < dataShards ) {
+                matrix[r * dataShards + shard] = 1;
+            } else {
+                memcpy( matrix.data() + r * dataShards,
+                    parityMatrix.data() + ( shard - dataShards ) * dataShards, dataShards );
+            }
+        }
+
+        invert( matrix, dataShards );
+
+        for ( auto&& j : missing ) {
+            auto dst = result->data() + j * shardSize;
+            for ( uint64_t r = 0; r < dataShards; r++ ) {
+                mulAddRegion( matrix[j * dataShards + r], used[r].second.first, dst,
+                    used[r].second.second );
+            }
+        }
+    }
+
+    result->resize( _dataSize );
+
+    return result;
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReedSolomonCoder.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_REEDSOLOMONCODER_H
+#define SKALED_REEDSOLOMONCODER_H
+
+
+// Systematic Reed-Solomon code over GF(2^8).
+//
+// The data is cut into dataShards shards of getShardSize() bytes, the last shards are implicitly
+// padded with zeros. The data shards are sent as is, parity shards are computed with a Cauchy
+// matrix, so that any dataShards of the totalShards shards reconstruct the data.
+//
+// Shards are numbered from 0, data shards first.
+
+class ReedSolomonCoder {
+
+public:
+
+    // a shard that may be shorter than the shard size, the missing bytes are zeros
+    using shard_view = pair< const uint8_t*, uint64_t >;
+
+private:
+
+    const uint64_t dataShards;
+
+    const uint64_t totalShards;
+
+    // parityMatrix[i * dataShards + j] is the coefficient of data shard j in parity shard i
+    vector< uint8_t > parityMatrix;
+
+    class GaloisField {
+    public:
+        array< uint8_t, 512 > exp;
+        array< uint8_t, 256 > log;
+        // products of every constant with every byte
+        vector< array< uint8_t, 256 > > mul;
+        // products with the low and high nibbles, used by the SIMD kernels
+        vector< array< uint8_t, 16 > > mulLow;
+        vector< array< uint8_t, 16 > > mulHigh;
+
+        GaloisField();
+    };
+
+    static const GaloisField field;
+
+    static uint8_t gfInverse( uint8_t _a );
+
+    // inverts a _size x _size matrix in place
+    static void invert( vector< uint8_t >& _matrix, uint64_t _size );
+
+public:
+
+    ReedSolomonCoder( uint64_t _dataShards, uint64_t _totalShards );
+
+    // the number of data shards when up to a third of the peers that hold the shards is faulty
+    static uint64_t dataShardsFor( uint64_t _totalShards );
+
+    // _dst ^= _c * _src, uses SSSE3 or AVX2 if the CPU supports them and _useSimd is set
+    static void mulAddRegion(
+        uint8_t _c, const uint8_t* _src, uint8_t* _dst, uint64_t _len, bool _useSimd = true );
+
+    static uint8_t gfMultiply( uint8_t _a, uint8_t _b );
+
+    uint64_t getDataShards() const;
+
+    uint64_t getTotalShards() const;
+
+    uint64_t getShardSize( uint64_t _dataSize ) const;
+
+    // bounds of the bytes of a shard in the data, parity shards are returned by encodeParity()
+    void getDataShardBounds(
+        uint64_t _dataSize, uint64_t _shard, uint64_t& _begin, uint64_t& _end ) const;
+
+    // the number of bytes that are sent for a shard
+    uint64_t getShardLength( uint64_t _dataSize, uint64_t _shard ) const;
+
+    // returns the parity shards one after another, each getShardSize() bytes
+    ptr< vector< uint8_t > > encodeParity( const uint8_t* _data, uint64_t _dataSize ) const;
+
+    // reconstructs the data from any dataShards shards
+    ptr< vector< uint8_t > > decode(
+        const map< uint64_t, shard_view >& _shards, uint64_t _dataSize ) const;
+};
+
+
+#endif  // SKALED_REEDSOLOMONCODER_H
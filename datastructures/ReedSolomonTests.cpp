@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReedSolomonTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "ReedSolomonCoder.h"
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "thirdparty/catch.hpp"
+
+
+static ptr< vector< uint8_t > > randomBytes( uint64_t _size, boost::random::mt19937& _gen ) {
+    boost::random::uniform_int_distribution<> ubyte( 0, 255 );
+    auto result = make_shared< vector< uint8_t > >( _size );
+    for ( auto&& b : *result ) {
+        b = ( uint8_t ) ubyte( _gen );
+    }
+    return result;
+}
+
+
+TEST_CASE( "SIMD multiply-add matches the scalar one", "[erasure-coding]" ) {
+    boost::random::mt19937 gen;
+
+    for ( uint64_t len : { 1, 15, 16, 31, 32, 33, 100, 4097 } ) {
+        auto src = randomBytes( len, gen );
+        auto dst = randomBytes( len, gen );
+
+        for ( uint64_t c = 0; c < 256; c++ ) {
+            auto simd = *dst;
+            auto scalar = *dst;
+
+            ReedSolomonCoder::mulAddRegion( ( uint8_t ) c, src->data(), simd.data(), len, true );
+            ReedSolomonCoder::mulAddRegion( ( uint8_t ) c, src->data(), scalar.data(), len, false );
+
+            REQUIRE( simd == scalar );
+        }
+    }
+
+    REQUIRE( ReedSolomonCoder::gfMultiply( 2, 0x80 ) == 0x1d );
+}
+
+
+TEST_CASE( "Data is decoded from any data shards", "[erasure-coding]" ) {
+    boost::random::mt19937 gen;
+
+    for ( uint64_t totalShards : { 1, 2, 3, 15, 33, 255 } ) {
+        ReedSolomonCoder coder( ReedSolomonCoder::dataShardsFor( totalShards ), totalShards );
+
+        auto k = coder.getDataShards();
+
+        for ( uint64_t dataSize : { k, 7 * k + 3, ( uint64_t ) 10000 } ) {
+            auto data = randomBytes( dataSize, gen );
+            auto parity = coder.encodeParity( data->data(), dataSize );
+            auto shardSize = coder.getShardSize( dataSize );
+
+            REQUIRE( parity->size() == ( totalShards - k ) * shardSize );
+
+            for ( int attempt = 0; attempt < 10; attempt++ ) {
+                vector< uint64_t > indices( totalShards );
+                iota( indices.begin(), indices.end(), 0 );
+
+                for ( uint64_t i = totalShards - 1; i > 0; i-- ) {
+                    boost::random::uniform_int_distribution< uint64_t > position( 0, i );
+                    swap( indices[i], indices[position( gen )] );
+                }
+
+                // the other shards are dropped
+                map< uint64_t, ReedSolomonCoder::shard_view > shards;
+
+                for ( uint64_t i = 0; i < k; i++ ) {
+                    auto shard = indices[i];
+                    if ( shard < k ) {
+                        uint64_t begin, end;
+                        coder.getDataShardBounds( dataSize, shard, begin, end );
+                        shards[shard] = { data->data() + begin, end - begin };
+                    } else {
+                        shards[shard] = { parity->data() + ( shard - k ) * shardSize, shardSize };
+                    }
+                    REQUIRE( shards[shard].second == coder.getShardLength( dataSize, shard ) );
+                }
+
+                REQUIRE( *coder.decode( shards, dataSize ) == *data );
+            }
+        }
+    }
+}
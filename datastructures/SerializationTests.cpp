@@ -33,6 +33,7 @@
 
 #include "SkaleCommon.h"
 #include "exceptions/ParsingException.h"
+#include "crypto/BLAKE3Hash.h"
 #include "crypto/CryptoManager.h"
 #include "chains/Schain.h"
 
@@ -45,6 +46,7 @@
 
 #include "BlockProposalFragment.h"
 #include "BlockProposalFragmentList.h"
+#include "ReedSolomonCoder.h"
 
 
 #define BOOST_PENDING_INTEGER_LOG2_HPP
@@ -87,14 +89,17 @@ void test_committed_block_fragment_defragment(bool _fail) {
 
         uint64_t next;
 
-        for (int j = 1; j < i; j++) {
+        // the data fragments are enough to reconstruct the block
+        int dataFragments = ReedSolomonCoder::dataShardsFor(i);
+
+        for (int j = 1; j < dataFragments; j++) {
             next = 0;
             list->addFragment(t->getFragment(i, j), next);
             REQUIRE(next != 0);
         }
 
 
-        list->addFragment(t->getFragment(i, i), next);
+        list->addFragment(t->getFragment(i, dataFragments), next);
         REQUIRE(next == 0);
 
         REQUIRE(list->isComplete());
@@ -304,6 +309,45 @@ TEST_CASE("Serialize/deserialize committed block", "[committed-block-serialize]"
 }
 
 
+TEST_CASE("Blocks are deserialized in place from a block list", "[committed-block-list-serialize]") {
+    boost::random::mt19937 gen;
+
+    Schain chain;
+    auto cryptoManager = make_shared<CryptoManager>(chain);
+
+    boost::random::uniform_int_distribution<> ubyte(0, 255);
+
+    auto blocks = make_shared<vector<ptr<CommittedBlock>>>();
+
+    for (uint64_t i = 1; i <= 5; i++) {
+        blocks->push_back(CommittedBlock::createRandomSample(cryptoManager, i, gen, ubyte, i));
+    }
+
+    auto list = make_shared<CommittedBlockList>(blocks);
+    auto sizes = list->createSizes();
+    auto serialized = list->serialize();
+
+    // skip the opening '['
+    uint64_t begin = 1;
+
+    for (uint64_t i = 0; i < blocks->size(); i++) {
+        auto end = begin + sizes->at(i);
+
+        auto imp = CommittedBlock::deserialize(serialized, begin, end, cryptoManager);
+        REQUIRE(imp != nullptr);
+        REQUIRE(*imp->serialize() == *blocks->at(i)->serialize());
+
+        // a slice that cuts into the next block or the current one is rejected
+        REQUIRE_THROWS(CommittedBlock::deserialize(serialized, begin, end + 1, cryptoManager));
+        REQUIRE_THROWS(CommittedBlock::deserialize(serialized, begin, end - 1, cryptoManager));
+
+        begin = end;
+    }
+
+    REQUIRE(serialized->at(begin) == ']');
+}
+
+
 TEST_CASE("Serialize/deserialize committed block list", "[committed-block-list-serialize]") {
     SECTION("Test successful serialize/deserialize")
 
@@ -329,6 +373,176 @@ TEST_CASE("Test committed block fragment/defragment", "[committed-block-defragme
 }
 
 
+TEST_CASE("Block is defragmented without fragments from some nodes", "[erasure-coding]") {
+    boost::random::mt19937 gen;
+
+    boost::random::uniform_int_distribution<> ubyte(0, 255);
+
+    ConsensusEngine engine;
+
+    Schain chain;
+
+    auto cryptoManager = make_shared<CryptoManager>(chain);
+
+    // sixteen nodes, the other fifteen hold the fragments
+    uint64_t totalFragments = 15;
+
+    auto dataFragments = ReedSolomonCoder::dataShardsFor(totalFragments);
+
+    for (int i = 1; i < 50; i++) {
+        auto t = CommittedBlock::createRandomSample(cryptoManager, i, gen, ubyte, i);
+
+        auto list = make_shared<BlockProposalFragmentList>(i, totalFragments);
+
+        vector<uint64_t> indices;
+
+        for (uint64_t j = 1; j <= totalFragments; j++) {
+            indices.push_back(j);
+        }
+
+        // the nodes that hold the other fragments are down
+        for (uint64_t j = totalFragments - 1; j > 0; j--) {
+            swap(indices[j], indices[ubyte(gen) % (j + 1)]);
+        }
+
+        uint64_t next = 0;
+
+        for (uint64_t j = 0; j < dataFragments; j++) {
+            REQUIRE(!list->isComplete());
+            list->addFragment(t->getFragment(totalFragments, indices[j]), next);
+        }
+
+        REQUIRE(next == 0);
+        REQUIRE(list->isComplete());
+
+        auto imp = CommittedBlock::defragment(list, cryptoManager);
+        REQUIRE(imp != nullptr);
+        REQUIRE(*imp->serialize() == *t->serialize());
+    }
+}
+
+
+TEST_CASE("Pipelined catchup of large blocks", "[catchup-pipeline-bench]") {
+    static constexpr uint64_t BLOCK_COUNT = 64;
+    static constexpr uint64_t TRANSACTIONS_PER_BLOCK = 2000;
+    // stands for pushBlockToExtFace
+    static constexpr uint64_t COMMIT_US = 2000;
+
+    boost::random::mt19937 gen;
+    boost::random::uniform_int_distribution<> ubyte(0, 255);
+
+    ConsensusEngine engine;
+    Schain chain;
+    auto cryptoManager = make_shared<CryptoManager>(chain);
+
+    auto blocks = make_shared<vector<ptr<CommittedBlock>>>();
+
+    for (uint64_t i = 0; i < BLOCK_COUNT; i++) {
+        blocks->push_back(CommittedBlock::createRandomSample(
+            cryptoManager, TRANSACTIONS_PER_BLOCK, gen, ubyte, i + 1));
+    }
+
+    auto list = make_shared<CommittedBlockList>(blocks);
+    auto sizes = list->createSizes();
+    auto serialized = list->serialize();
+
+    auto begin = chrono::steady_clock::now();
+
+    auto serialList = CommittedBlockList::deserialize(cryptoManager, sizes, serialized, 0);
+    for (uint64_t i = 0; i < serialList->getBlocks()->size(); i++) {
+        usleep(COMMIT_US);
+    }
+
+    auto serialMs = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - begin).count();
+
+    uint64_t committed = 0;
+
+    begin = chrono::steady_clock::now();
+
+    CommittedBlockList::deserializeInBatches(cryptoManager, engine.getExecutor(), sizes,
+        serialized, 0, CATCHUP_VERIFY_BATCH_BLOCKS,
+        [&committed](const ptr<CommittedBlockList>& _batch, bool) {
+            for (auto&& block : *_batch->getBlocks()) {
+                REQUIRE((uint64_t) block->getBlockID() == committed + 1);
+                committed++;
+                usleep(COMMIT_US);
+            }
+        });
+
+    auto pipelinedMs = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - begin).count();
+
+    cerr << "Catchup of " << BLOCK_COUNT << " blocks of " << TRANSACTIONS_PER_BLOCK
+         << " transactions:serial blocks/s:" << BLOCK_COUNT * 1000 / max<uint64_t>(serialMs, 1)
+         << ":pipelined blocks/s:" << BLOCK_COUNT * 1000 / max<uint64_t>(pipelinedMs, 1) << endl;
+
+    REQUIRE(committed == BLOCK_COUNT);
+}
+
+
+// counts the bytes passed to createBlock, the views are copied by the default adapter
+class CopyingExtFace : public ConsensusExtFace {
+public:
+    uint64_t totalBytes = 0;
+
+    transactions_vector pendingTransactions(size_t, u256&) override {
+        return transactions_vector();
+    }
+
+    void createBlock(const transactions_vector& _approvedTransactions, uint64_t, uint32_t, uint64_t,
+        u256, u256, uint64_t) override {
+        for (auto&& transaction : _approvedTransactions) {
+            totalBytes += transaction.size();
+        }
+    }
+};
+
+
+class ViewExtFace : public CopyingExtFace {
+public:
+    void createBlockFromView(const transactions_view& _approvedTransactions, uint64_t, uint32_t,
+        uint64_t, u256, u256, uint64_t) override {
+        for (auto&& transaction : _approvedTransactions) {
+            totalBytes += transaction.size;
+        }
+    }
+};
+
+
+TEST_CASE("Committed block is passed to ExtFace without a copy", "[ext-face-bench]") {
+    static constexpr uint64_t TRANSACTIONS_PER_BLOCK = 2000;
+    static constexpr uint64_t ITERATIONS = 100;
+
+    boost::random::mt19937 gen;
+    boost::random::uniform_int_distribution<> ubyte(0, 255);
+
+    auto list = TransactionList::createRandomSample(TRANSACTIONS_PER_BLOCK, gen, ubyte);
+
+    auto bench = [&list](ConsensusExtFace& _extFace) {
+        auto begin = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < ITERATIONS; i++) {
+            auto tv = list->createTransactionView();
+            _extFace.createBlockFromView(*tv, 0, 0, i + 1, 0, 0, 1);
+        }
+        return chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - begin).count();
+    };
+
+    CopyingExtFace copying;
+    ViewExtFace view;
+
+    auto copyUs = bench(copying);
+    auto viewUs = bench(view);
+
+    REQUIRE(copying.totalBytes == view.totalBytes);
+    REQUIRE(copying.totalBytes == ITERATIONS * TRANSACTIONS_PER_BLOCK * TRANSACTIONS_PER_BLOCK);
+
+    cerr << "createBlock of " << TRANSACTIONS_PER_BLOCK << " transactions:copy us:"
+         << copyUs / ITERATIONS << ":view us:" << viewUs / ITERATIONS << endl;
+}
+
+
 class CryptoFixture {
 public:
     CryptoFixture() {
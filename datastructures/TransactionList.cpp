@@ -31,6 +31,8 @@
 #include "Transaction.h"
 #include "TransactionList.h"
 
+#include "microprofile.h"
+
 
 
 TransactionList::TransactionList(const ptr<vector<ptr<Transaction>>>& _transactions) {
@@ -44,20 +46,23 @@ TransactionList::TransactionList(const ptr<vector<ptr<Transaction>>>& _transacti
 
 
 TransactionList::TransactionList(const ptr<vector<uint64_t>>& _transactionSizes,
-    const ptr<vector<uint8_t>>& _serializedTransactions, uint32_t _offset, bool _checkPartialHash ) {
+    const ptr<vector<uint8_t>>& _serializedTransactions, uint64_t _begin, uint64_t _end,
+    bool _checkPartialHash ) {
 
     CHECK_ARGUMENT(_transactionSizes);
     CHECK_ARGUMENT(_serializedTransactions);
+    CHECK_ARGUMENT(_begin < _end);
+    CHECK_ARGUMENT(_end <= _serializedTransactions->size());
 
-    CHECK_ARGUMENT(_serializedTransactions->at(_offset) == '<');
-    CHECK_ARGUMENT(_serializedTransactions->at(_serializedTransactions->size() - 1) == '>');
+    CHECK_ARGUMENT(_serializedTransactions->at(_begin) == '<');
+    CHECK_ARGUMENT(_serializedTransactions->at(_end - 1) == '>');
 
     totalObjects++;
 
     if (_transactionSizes->size() == 0) {
-        if ((_serializedTransactions->size()  - _offset) != 2) {
+        if ((_end - _begin) != 2) {
             BOOST_THROW_EXCEPTION(InvalidArgumentException("Size not equal to 2:" +
-            to_string(_serializedTransactions->size()), __CLASS_NAME__));
+            to_string(_end - _begin), __CLASS_NAME__));
         }
 
         transactions = make_shared<vector<ptr<Transaction>>>();
@@ -69,12 +74,12 @@ TransactionList::TransactionList(const ptr<vector<uint64_t>>& _transactionSizes,
     }
 
     if (_checkPartialHash) {
-        CHECK_ARGUMENT( _serializedTransactions->size() - _offset > PARTIAL_HASH_LEN + 2 );
+        CHECK_ARGUMENT( _end - _begin > PARTIAL_HASH_LEN + 2 );
     } else {
-        CHECK_ARGUMENT( _serializedTransactions->size() - _offset > 2 );
+        CHECK_ARGUMENT( _end - _begin > 2 );
     }
 
-    size_t index = _offset + 1;
+    size_t index = _begin + 1;
 
     transactions = make_shared<vector<ptr<Transaction>>>();
     transactions->reserve(_transactionSizes->size());
@@ -82,6 +87,7 @@ TransactionList::TransactionList(const ptr<vector<uint64_t>>& _transactionSizes,
     for (auto &&size : *_transactionSizes) {
 
         CHECK_ARGUMENT(size > 0);
+        CHECK_ARGUMENT(index + size < _end);
 
         try {
             auto transaction =
@@ -106,6 +112,7 @@ ptr<vector<ptr<Transaction>>> TransactionList::getItems() {
 }
 
 ptr<vector<uint8_t> > TransactionList::serialize( bool _writeTxPartialHash ) {
+    MICROPROFILE_SCOPEI( "TransactionList", "serialize", MP_PURPLE );
 
     LOCK(serializedTransactionsLock);
 
@@ -160,14 +167,44 @@ ptr<ConsensusExtFace::transactions_vector> TransactionList::createTransactionVec
     }
     return tv;
 }
+
+ptr<ConsensusExtFace::transactions_view> TransactionList::createTransactionView() {
+
+    LOCK(m)
+
+    auto tv = make_shared<ConsensusExtFace::transactions_view >();
+
+    CHECK_STATE(transactions);
+
+    tv->reserve( transactions->size() );
+
+    for ( auto&& t : *transactions ) {
+        auto data = t->getData();
+        CHECK_STATE(data);
+        tv->push_back( { data->data(), data->size() } );
+    }
+    return tv;
+}
 ptr< TransactionList > TransactionList::deserialize(const ptr<vector<uint64_t>>& _transactionSizes,
     const ptr<vector<uint8_t>>& _serializedTransactions, uint32_t _offset, bool _writePartialHash ) {
 
     CHECK_ARGUMENT(_transactionSizes);
     CHECK_ARGUMENT(_serializedTransactions);
 
+    return deserialize( _transactionSizes, _serializedTransactions, _offset,
+        _serializedTransactions->size(), _writePartialHash );
+}
+
+ptr< TransactionList > TransactionList::deserialize(const ptr<vector<uint64_t>>& _transactionSizes,
+    const ptr<vector<uint8_t>>& _serializedTransactions, uint64_t _begin, uint64_t _end,
+    bool _writePartialHash ) {
+
+    CHECK_ARGUMENT(_transactionSizes);
+    CHECK_ARGUMENT(_serializedTransactions);
+
     return ptr< TransactionList >(
-        new TransactionList( _transactionSizes, _serializedTransactions, _offset, _writePartialHash ) );
+        new TransactionList( _transactionSizes, _serializedTransactions, _begin, _end,
+            _writePartialHash ) );
 }
 ptr<vector<uint64_t>> TransactionList::createTransactionSizesVector(bool _writePartialHash) {
 
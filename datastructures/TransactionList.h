@@ -48,7 +48,7 @@ class TransactionList : public ListOfHashes {
     recursive_mutex serializedTransactionsLock;
 
     TransactionList( const ptr< vector< uint64_t > >& _transactionSizes,
-        const ptr< vector< uint8_t > >& _serializedTransactions, uint32_t _offset,
+        const ptr< vector< uint8_t > >& _serializedTransactions, uint64_t _begin, uint64_t _end,
         bool _checkPartialHash );
 
 public:
@@ -67,6 +67,9 @@ public:
 
     ptr< ConsensusExtFace::transactions_vector > createTransactionVector();
 
+    // the views point into the transactions of this list and are valid while the list is alive
+    ptr< ConsensusExtFace::transactions_view > createTransactionView();
+
     ptr< vector< uint64_t > > createTransactionSizesVector( bool _writePartialHash );
 
     ptr< BLAKE3Hash > getHash( uint64_t _index ) override;
@@ -79,6 +82,11 @@ public:
         const ptr< vector< uint8_t > >& _serializedTransactions, uint32_t _offset,
         bool _writePartialHash );
 
+    // parses the list in [_begin, _end) of a buffer that holds other data too, without a copy
+    static ptr< TransactionList > deserialize( const ptr< vector< uint64_t > >& _transactionSizes,
+        const ptr< vector< uint8_t > >& _serializedTransactions, uint64_t _begin, uint64_t _end,
+        bool _writePartialHash );
+
     static ptr< TransactionList > createRandomSample( uint64_t _size, boost::random::mt19937& _gen,
         boost::random::uniform_int_distribution<>& _ubyte );
 
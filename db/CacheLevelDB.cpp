@@ -53,6 +53,8 @@
 #include "CacheLevelDB.h"
 #include "leveldb/cache.h"
 
+#include "microprofile.h"
+
 
 
 
@@ -118,6 +120,7 @@ string CacheLevelDB::readString(string &_key) {
 
 
 string CacheLevelDB::readStringUnsafe(string &_key) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "readStringUnsafe", MP_SEAGREEN );
 
     for (int i = LEVELDB_SHARDS - 1; i >= 0; i--) {
         string result;
@@ -132,6 +135,7 @@ string CacheLevelDB::readStringUnsafe(string &_key) {
 }
 
 bool CacheLevelDB::keyExistsUnsafe(const string &_key) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "keyExistsUnsafe", MP_SEAGREEN );
 
     for (int i = LEVELDB_SHARDS - 1; i >= 0; i--) {
         auto result = make_shared<string>();
@@ -155,6 +159,7 @@ bool CacheLevelDB::keyExists(const string &_key) {
 
 void CacheLevelDB::writeString(const string &_key, const string &_value,
                                bool _overWrite) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "writeString", MP_SEAGREEN );
 
     rotateDBsIfNeeded();
 
@@ -176,6 +181,7 @@ void CacheLevelDB::writeString(const string &_key, const string &_value,
 
 void CacheLevelDB::writeByteArray(const char *_key, size_t _keyLen, const char * _value,
                                   size_t _valueLen) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "writeByteArray", MP_SEAGREEN );
 
     CHECK_ARGUMENT(_key)
     CHECK_ARGUMENT(_value)
@@ -250,6 +256,7 @@ ptr<map<string, string>> CacheLevelDB::readPrefixRange(string &_prefix) {
 
 ptr<map<string, string>> CacheLevelDB::readPrefixRangeFromDBUnsafe(string &_prefix, const ptr<leveldb::DB>& _db,
                                                                         bool _lastOnly) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "readPrefixRangeFromDBUnsafe", MP_SEAGREEN );
 
     CHECK_ARGUMENT(_db)
 
@@ -498,6 +505,7 @@ bool CacheLevelDB::isEnough(block_id _blockID) {
 
 
 uint64_t CacheLevelDB::readCount(block_id _blockId) {
+    MICROPROFILE_SCOPEI( "CacheLevelDB", "readCount", MP_SEAGREEN );
 
     auto counterKey = createCounterKey(_blockId);
 
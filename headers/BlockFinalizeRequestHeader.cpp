@@ -48,7 +48,8 @@ using namespace std;
 BlockFinalizeRequestHeader::BlockFinalizeRequestHeader(Schain &_sChain, block_id _blockID,
                                                            schain_index _proposerIndex,
                                                            node_id _nodeID,
-                                                           fragment_index _fragmentIndex) :
+                                                           fragment_index _fragmentIndex,
+                                                           bool _keepAlive) :
         AbstractBlockRequestHeader(_sChain.getNodeCount(), _sChain.getSchainID(), _blockID,
                 Header::BLOCK_FINALIZE_REQ, _proposerIndex) {
 
@@ -58,6 +59,7 @@ BlockFinalizeRequestHeader::BlockFinalizeRequestHeader(Schain &_sChain, block_id
 
     this->fragmentIndex = _fragmentIndex;
     this->nodeID = _nodeID;
+    this->keepAlive = _keepAlive;
 
 
     complete = true;
@@ -70,6 +72,10 @@ void BlockFinalizeRequestHeader::addFields(nlohmann::basic_json<> &jsonRequest)
     jsonRequest["fragmentIndex"] = (uint64_t ) fragmentIndex;
     jsonRequest["nodeID"] = (uint64_t ) nodeID;
 
+    // the server waits for the next request on the same connection
+    if (keepAlive)
+        jsonRequest["keepAlive"] = (uint64_t ) 1;
+
 }
 
 const node_id &BlockFinalizeRequestHeader::getNodeId() const {
@@ -30,13 +30,14 @@ class BlockFinalizeRequestHeader : public AbstractBlockRequestHeader{
 
    fragment_index fragmentIndex;
    node_id        nodeID;
+   bool           keepAlive;
 
 
 public:
 
     BlockFinalizeRequestHeader(Schain &_sChain, block_id _blockID,
             schain_index _proposerIndex, node_id _nodeID,
-                               fragment_index _fragmentIndex);
+                               fragment_index _fragmentIndex, bool _keepAlive = false);
 
 
 
@@ -58,6 +58,16 @@ CatchupRequestHeader::CatchupRequestHeader(Schain &_sChain, schain_index _dstInd
 
 }
 
+CatchupRequestHeader::CatchupRequestHeader(Schain &_sChain, schain_index _dstIndex,
+    block_id _afterBlockID, block_id _lastBlockID) : CatchupRequestHeader(_sChain, _dstIndex) {
+
+    CHECK_ARGUMENT(_afterBlockID < _lastBlockID);
+
+    this->blockID = _afterBlockID;
+    this->lastBlockID = _lastBlockID;
+
+}
+
 void CatchupRequestHeader::addFields(nlohmann::json& _j) {
 
     Header::addFields(_j);
@@ -66,6 +76,9 @@ void CatchupRequestHeader::addFields(nlohmann::json& _j) {
     _j["blockID"] = (uint64_t ) blockID;
     _j["nodeID"] = (uint64_t) nodeID;
 
+    if (lastBlockID > 0)
+        _j["lastBlockID"] = (uint64_t) lastBlockID;
+
 }
 
 const node_id &CatchupRequestHeader::getNodeId() const {
@@ -34,6 +34,7 @@ class CatchupRequestHeader : public Header{
     schain_id schainID;
     block_id blockID;
     node_id nodeID;
+    block_id lastBlockID = 0;  // 0 if the response is limited by size only
 
 public:
 
@@ -41,6 +42,10 @@ public:
 
     CatchupRequestHeader(Schain &_sChain, schain_index _dstIndex);
 
+    // requests blocks (_afterBlockID, _lastBlockID]
+    CatchupRequestHeader(Schain &_sChain, schain_index _dstIndex, block_id _afterBlockID,
+        block_id _lastBlockID);
+
     void addFields(nlohmann::basic_json<> &j) override;
 
     [[nodiscard]] const node_id &getNodeId() const;
@@ -55,12 +55,18 @@ void CatchupResponseHeader::addFields(nlohmann::json &_j) {
 
     _j["count"] = blockCount;
 
+    _j["committedBlockID"] = committedBlockID;
+
     if (blockSizes != nullptr)
         _j["sizes"] = *blockSizes;
 
 
 }
 
+void CatchupResponseHeader::setCommittedBlockID(block_id _committedBlockID) {
+    committedBlockID = (uint64_t) _committedBlockID;
+}
+
 uint64_t CatchupResponseHeader::getBlockCount() const {
     return blockCount;
 }
@@ -40,6 +40,9 @@ private:
 
     uint64_t blockCount = 0;
 
+    // the last block of the responding node, tells the client how far behind it is
+    uint64_t committedBlockID = 0;
+
     ptr<list<uint64_t>> blockSizes = nullptr;
 
 public:
@@ -50,6 +53,8 @@ public:
 
     void setBlockSizes(const ptr<list<uint64_t>>& _blockSizes);
 
+    void setCommittedBlockID(block_id _committedBlockID);
+
     void addFields(nlohmann::basic_json<> &j_) override;
 
 };
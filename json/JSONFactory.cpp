@@ -52,6 +52,7 @@
 
 #include "exceptions/ParsingException.h"
 #include "network/Sockets.h"
+#include "network/Transport.h"
 #include "node/ConsensusEngine.h"
 #include "node/Node.h"
 #include "node/NodeInfo.h"
@@ -134,7 +135,20 @@ ptr< Node > JSONFactory::createNodeFromJsonObject( const nlohmann::json& _j, set
         CHECK_STATE(JSONFactory::splitString(_blsKeyName)->size() == 7);
     }
 
-    Network::setTransport( TransportType::ZMQ );
+    // nodes on one host can use shared memory, TEST_TRANSPORT overrides the config for tests
+    string transport = "zmq";
+
+    if ( _j.find( "transport" ) != _j.end() ) {
+        transport = _j.at( "transport" ).get< string >();
+    }
+
+    if constexpr ( TEST_HOOKS_ENABLED ) {
+        if ( auto env = std::getenv( "TEST_TRANSPORT" ) ) {
+            transport = env;
+        }
+    }
+
+    Network::setTransport( Transport::parseType( transport ) );
 
     if ( _j.find( "logLevelConfig" ) != _j.end() ) {
         string logLevel( _j.at( "logLevelConfig" ).get<string>() );
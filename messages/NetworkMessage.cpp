@@ -57,6 +57,8 @@
 
 #include "NetworkMessage.h"
 
+#include "microprofile.h"
+
 
 NetworkMessage::NetworkMessage(MsgType _messageType, block_id _blockID, schain_index _blockProposerIndex,
                                bin_consensus_round _r,
@@ -397,6 +399,7 @@ void NetworkMessage::sign(const ptr<CryptoManager>& _mgr) {
 }
 
 void NetworkMessage::verify(const ptr<CryptoManager>& _mgr) {
+    MICROPROFILE_SCOPEI( "NetworkMessage", "verify", MP_ORANGE );
     CHECK_ARGUMENT(_mgr)
     CHECK_STATE2(_mgr->verifyNetworkMsg(*this), "ECDSA sig did not verify")
 }
@@ -0,0 +1,145 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file LatencyHistogram.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include <cmath>
+
+#include "LatencyHistogram.h"
+
+
+LatencyHistogram::LatencyHistogram() {
+    for ( auto&& bucket : buckets ) {
+        bucket = 0;
+    }
+}
+
+
+uint64_t LatencyHistogram::bucketOf( uint64_t _value ) {
+    if ( _value < SUB_BUCKETS )
+        return _value;
+
+    uint64_t exponent = 63 - __builtin_clzll( _value );
+    uint64_t subBucket = ( _value >> ( exponent - SUB_BUCKET_BITS ) ) & ( SUB_BUCKETS - 1 );
+
+    return ( exponent - SUB_BUCKET_BITS + 1 ) * SUB_BUCKETS + subBucket;
+}
+
+
+uint64_t LatencyHistogram::bucketLow( uint64_t _bucket ) {
+    CHECK_ARGUMENT( _bucket < BUCKET_COUNT );
+
+    if ( _bucket < SUB_BUCKETS )
+        return _bucket;
+
+    uint64_t exponent = _bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = _bucket % SUB_BUCKETS;
+
+    return ( SUB_BUCKETS + subBucket ) << ( exponent - SUB_BUCKET_BITS );
+}
+
+
+uint64_t LatencyHistogram::bucketHigh( uint64_t _bucket ) {
+    CHECK_ARGUMENT( _bucket < BUCKET_COUNT );
+
+    if ( _bucket < SUB_BUCKETS )
+        return _bucket;
+
+    uint64_t exponent = _bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+
+    return bucketLow( _bucket ) + ( ( 1ULL << ( exponent - SUB_BUCKET_BITS ) ) - 1 );
+}
+
+
+void LatencyHistogram::record( uint64_t _valueUs ) {
+    buckets[bucketOf( _valueUs )].fetch_add( 1, memory_order_relaxed );
+    count.fetch_add( 1, memory_order_relaxed );
+    sum.fetch_add( _valueUs, memory_order_relaxed );
+
+    auto previous = maxValue.load( memory_order_relaxed );
+    while ( previous < _valueUs &&
+            !maxValue.compare_exchange_weak( previous, _valueUs, memory_order_relaxed ) ) {
+    }
+}
+
+
+void LatencyHistogram::merge( const LatencyHistogram& _other ) {
+    for ( uint64_t i = 0; i < BUCKET_COUNT; i++ ) {
+        buckets[i].fetch_add( _other.buckets[i].load( memory_order_relaxed ), memory_order_relaxed );
+    }
+    count.fetch_add( _other.getCount(), memory_order_relaxed );
+    sum.fetch_add( _other.getSum(), memory_order_relaxed );
+
+    auto otherMax = _other.getMax();
+    auto previous = maxValue.load( memory_order_relaxed );
+    while ( previous < otherMax &&
+            !maxValue.compare_exchange_weak( previous, otherMax, memory_order_relaxed ) ) {
+    }
+}
+
+
+uint64_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+
+uint64_t LatencyHistogram::getSum() const {
+    return sum;
+}
+
+
+uint64_t LatencyHistogram::getMax() const {
+    return maxValue;
+}
+
+
+uint64_t LatencyHistogram::getQuantile( double _quantile ) const {
+    CHECK_ARGUMENT( _quantile >= 0 && _quantile <= 1 );
+
+    // the buckets are read one by one while values are recorded, so the total is recounted
+    array< uint64_t, BUCKET_COUNT > snapshot;
+    uint64_t total = 0;
+
+    for ( uint64_t i = 0; i < BUCKET_COUNT; i++ ) {
+        snapshot[i] = buckets[i].load( memory_order_relaxed );
+        total += snapshot[i];
+    }
+
+    if ( total == 0 )
+        return 0;
+
+    auto rank = max< uint64_t >( 1, ( uint64_t ) ceil( _quantile * total ) );
+
+    uint64_t seen = 0;
+
+    for ( uint64_t i = 0; i < BUCKET_COUNT; i++ ) {
+        seen += snapshot[i];
+        if ( seen >= rank ) {
+            return min( bucketHigh( i ), getMax() );
+        }
+    }
+
+    return getMax();
+}
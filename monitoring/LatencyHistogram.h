@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file LatencyHistogram.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_LATENCYHISTOGRAM_H
+#define SKALED_LATENCYHISTOGRAM_H
+
+
+// Log-linear histogram of latencies in microseconds, in the style of HdrHistogram.
+//
+// Every power of two is split into 2^SUB_BUCKET_BITS buckets, so a value is known within
+// 1/2^SUB_BUCKET_BITS of itself over the whole uint64_t range. Recording is lock free.
+
+class LatencyHistogram {
+
+public:
+
+    static constexpr uint64_t SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr uint64_t BUCKET_COUNT = ( 64 - SUB_BUCKET_BITS + 1 ) * SUB_BUCKETS;
+
+private:
+
+    array< atomic< uint64_t >, BUCKET_COUNT > buckets;
+
+    atomic< uint64_t > count = 0;
+
+    atomic< uint64_t > sum = 0;
+
+    atomic< uint64_t > maxValue = 0;
+
+public:
+
+    LatencyHistogram();
+
+    static uint64_t bucketOf( uint64_t _value );
+
+    // the smallest and the largest value that fall into the bucket
+    static uint64_t bucketLow( uint64_t _bucket );
+
+    static uint64_t bucketHigh( uint64_t _bucket );
+
+    void record( uint64_t _valueUs );
+
+    // adds the values recorded in _other
+    void merge( const LatencyHistogram& _other );
+
+    uint64_t getCount() const;
+
+    uint64_t getSum() const;
+
+    uint64_t getMax() const;
+
+    // the largest value of the bucket that holds the _quantile, 0 if nothing was recorded
+    uint64_t getQuantile( double _quantile ) const;
+};
+
+
+#endif  // SKALED_LATENCYHISTOGRAM_H
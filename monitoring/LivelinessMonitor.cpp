@@ -20,58 +20,214 @@
     @author Stan Kladko
     @date 2019
 */
+
 #include "SkaleCommon.h"
 #include "Log.h"
+#include "exceptions/FatalError.h"
 #include "thirdparty/json.hpp"
 
+#include <sys/syscall.h>
+
 #include "utils/Time.h"
-#include "chains/Schain.h"
-#include "node/Node.h"
 #include "LivelinessMonitor.h"
 
 
+mutex MonitorSite::sitesLock;
+map< string, ptr< MonitorSite > > MonitorSite::sites;
+
+mutex ThreadScopes::allLock;
+list< ptr< ThreadScopes > > ThreadScopes::all;
+
+
+MonitorSite::MonitorSite( const string& _class, const string& _function )
+    : cl( _class ), function( _function ) {}
 
 
-LivelinessMonitor::LivelinessMonitor(const ptr<MonitoringAgent>& _agent, const string& _class, const string&  _function,
-                                     uint64_t _maxTime) : cl(_class), function(_function), agent(_agent) {
+MonitorSite* MonitorSite::get( const string& _class, const string& _function ) {
+    auto key = _class + "::" + _function;
 
-    CHECK_ARGUMENT(_agent);
+    lock_guard< mutex > lock( sitesLock );
 
-    startTime = Time::getCurrentTimeMs();
-    expiryTime = startTime + _maxTime;
-    threadId = pthread_self();
-    id = counter++;
+    auto& site = sites[key];
+
+    if ( !site )
+        site = make_shared< MonitorSite >( _class, _function );
+
+    return site.get();
 }
 
-LivelinessMonitor::~LivelinessMonitor() {
-    auto pointer = agent.lock();
-    if (pointer) {
-        pointer->unregisterMonitor(this->getId());
+
+string MonitorSite::getName() const {
+    return cl + "::" + function;
+}
+
+
+void MonitorSite::record( uint64_t _durationUs ) {
+    durations.record( _durationUs );
+}
+
+
+const LatencyHistogram& MonitorSite::getDurations() const {
+    return durations;
+}
+
+
+nlohmann::json MonitorSite::allToJSON() {
+    map< string, ptr< MonitorSite > > sitesCopy;
+
+    {
+        lock_guard< mutex > lock( sitesLock );
+        sitesCopy = sites;
+    }
+
+    auto result = nlohmann::json::object();
+
+    for ( auto&& item : sitesCopy ) {
+        auto& h = item.second->getDurations();
+
+        if ( h.getCount() == 0 )
+            continue;
+
+        auto siteJSON = nlohmann::json::object();
+        siteJSON["count"] = h.getCount();
+        siteJSON["sumUs"] = h.getSum();
+        siteJSON["p50Us"] = h.getQuantile( 0.5 );
+        siteJSON["p99Us"] = h.getQuantile( 0.99 );
+        siteJSON["maxUs"] = h.getMax();
+        result[item.first] = siteJSON;
     }
+
+    return result;
 }
 
-string LivelinessMonitor::toString() {
-    auto pointer = agent.lock();
-    if (pointer) {
-        return
-                "Node:" + to_string(pointer->getSchain()->getNode()->getNodeID()) +
-                ":Thread:" + to_string((uint64_t) threadId) + ":" + cl + string("::") + function;
-    } else {
-        return "";
+
+ThreadScopes::ThreadScopes() : tid( ( uint64_t ) syscall( SYS_gettid ) ) {}
+
+
+namespace {
+
+// marks the stack of a thread as exited, so that the watchdog forgets it
+class ThreadScopesHolder {
+public:
+    ptr< ThreadScopes > scopes;
+
+    ~ThreadScopesHolder() {
+        if ( scopes )
+            scopes->exited = true;
+    }
+};
+
+}  // namespace
+
+
+ThreadScopes& ThreadScopes::current() {
+    static thread_local ThreadScopesHolder holder;
+
+    if ( !holder.scopes ) {
+        holder.scopes = make_shared< ThreadScopes >();
+
+        lock_guard< mutex > lock( allLock );
+        all.remove_if( []( const ptr< ThreadScopes >& _s ) { return _s->exited.load(); } );
+        all.push_back( holder.scopes );
     }
+
+    return *holder.scopes;
 }
 
-uint64_t LivelinessMonitor::getExpiryTime() const {
-    return expiryTime;
+
+bool ThreadScopes::sample(
+    const Schain* _sChain, uint64_t _nowUs, vector< StuckScope >& _stuck ) const {
+    auto before = version.load( memory_order_acquire );
+
+    // the owner is pushing or popping
+    if ( before % 2 == 1 )
+        return false;
+
+    auto sampledDepth = min( depth.load( memory_order_relaxed ), MAX_DEPTH );
+
+    vector< pair< MonitorSite*, uint64_t > > found;
+
+    for ( uint64_t i = 0; i < sampledDepth; i++ ) {
+        auto& scope = scopes[i];
+        auto site = scope.site.load( memory_order_relaxed );
+        auto startUs = scope.startUs.load( memory_order_relaxed );
+
+        if ( site && scope.sChain.load( memory_order_relaxed ) == _sChain && _nowUs > startUs &&
+             _nowUs - startUs > scope.maxTimeUs.load( memory_order_relaxed ) ) {
+            found.emplace_back( site, _nowUs - startUs );
+        }
+    }
+
+    atomic_thread_fence( memory_order_acquire );
+
+    // a stack that changed while it was sampled is not stuck
+    if ( version.load( memory_order_relaxed ) != before )
+        return false;
+
+    for ( auto&& item : found ) {
+        StuckScope stuck;
+        stuck.tid = tid;
+        stuck.site = item.first->getName();
+        stuck.runningUs = item.second;
+        _stuck.push_back( stuck );
+    }
+
+    return true;
 }
 
-uint64_t LivelinessMonitor::getStartTime() const {
-    return startTime;
+
+vector< ThreadScopes::StuckScope > ThreadScopes::findStuck(
+    const Schain* _sChain, uint64_t _nowUs ) {
+    list< ptr< ThreadScopes > > allCopy;
+
+    {
+        lock_guard< mutex > lock( allLock );
+        allCopy = all;
+    }
+
+    vector< StuckScope > stuck;
+
+    for ( auto&& scopes : allCopy ) {
+        if ( !scopes->exited )
+            scopes->sample( _sChain, _nowUs, stuck );
+    }
+
+    return stuck;
 }
 
-atomic<uint64_t> LivelinessMonitor::counter = 0;
 
-uint64_t LivelinessMonitor::getId() const {
-    return id;
+LivelinessMonitor::LivelinessMonitor(
+    const Schain* _sChain, MonitorSite* _site, uint64_t _maxTimeMs )
+    : site( _site ), scopes( ThreadScopes::current() ), startUs( Time::getSteadyTimeUs() ) {
+    CHECK_ARGUMENT( _site );
+
+    // only this thread writes the stack, so plain loads and stores are enough on the writer side
+    auto version = scopes.version.load( memory_order_relaxed );
+    auto depth = scopes.depth.load( memory_order_relaxed );
+
+    scopes.version.store( version + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+
+    if ( depth < ThreadScopes::MAX_DEPTH ) {
+        auto& scope = scopes.scopes[depth];
+        scope.site.store( _site, memory_order_relaxed );
+        scope.sChain.store( _sChain, memory_order_relaxed );
+        scope.startUs.store( startUs, memory_order_relaxed );
+        scope.maxTimeUs.store( _maxTimeMs * 1000, memory_order_relaxed );
+    }
+
+    scopes.depth.store( depth + 1, memory_order_relaxed );
+    scopes.version.store( version + 2, memory_order_release );
 }
 
+
+LivelinessMonitor::~LivelinessMonitor() {
+    site->record( Time::getSteadyTimeUs() - startUs );
+
+    auto version = scopes.version.load( memory_order_relaxed );
+
+    scopes.version.store( version + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+    scopes.depth.store( scopes.depth.load( memory_order_relaxed ) - 1, memory_order_relaxed );
+    scopes.version.store( version + 2, memory_order_release );
+}
@@ -25,42 +25,130 @@
 #define SKALED_LIVELINESSMONITOR_H
 
 
+#include "thirdparty/json.hpp"
+
+#include "LatencyHistogram.h"
 #include "MonitoringAgent.h"
-#define MONITOR2(_C_, _F_, _T_) \
-       auto __L__ = make_shared<LivelinessMonitor>(getSchain()->getMonitoringAgent(), _C_, _F_, _T_); \
-       getSchain()->getMonitoringAgent()->registerMonitor(__L__);
 
-#define MONITOR(_C_, _F_) auto __L__ = \
-   make_shared<LivelinessMonitor>(getSchain()->getMonitoringAgent(), _C_, _F_, 2000);\
-   getSchain()->getMonitoringAgent()->registerMonitor(__L__);
+// the site of a scope is looked up once, the scope itself only touches the stack of its thread
+#define MONITOR2( _C_, _F_, _T_ )                                         \
+    static MonitorSite* __S__ = MonitorSite::get( _C_, _F_ );             \
+    LivelinessMonitor __L__( getSchain(), __S__, _T_ );
 
+#define MONITOR( _C_, _F_ ) MONITOR2( _C_, _F_, 2000 )
 
-class LivelinessMonitor {
 
-    string cl;
-    string function;
-    pthread_t  threadId = 0;
-    uint64_t id = 0;
-    uint64_t startTime = 0;
-    uint64_t expiryTime = 0;
-    static atomic<uint64_t> counter;
-    weak_ptr<MonitoringAgent> agent;
+class Schain;
+
+
+// A place in the code that is monitored. Durations of all its scopes go to one histogram.
+// Sites live until the process exits.
+
+class MonitorSite {
+
+    const string cl;
+
+    const string function;
+
+    LatencyHistogram durations;
+
+    static mutex sitesLock;
+
+    static map< string, ptr< MonitorSite > > sites;  // guarded by sitesLock
+
+public:
+
+    MonitorSite( const string& _class, const string& _function );
+
+    static MonitorSite* get( const string& _class, const string& _function );
+
+    [[nodiscard]] string getName() const;
+
+    void record( uint64_t _durationUs );
+
+    [[nodiscard]] const LatencyHistogram& getDurations() const;
+
+    // duration quantiles of all sites that were entered
+    static nlohmann::json allToJSON();
+};
+
+
+// Scopes that are open on one thread.
+//
+// Only the owner thread pushes and pops. The watchdog reads the stack of any thread without
+// locks, and discards what it read if the version changed meanwhile, since then the thread
+// made progress anyway.
+
+class ThreadScopes {
 
 public:
 
-    [[nodiscard]] uint64_t getId() const;
+    static constexpr uint64_t MAX_DEPTH = 32;
 
-    [[nodiscard]] uint64_t getStartTime() const;
+    class Scope {
+    public:
+        atomic< MonitorSite* > site = nullptr;
+        atomic< const Schain* > sChain = nullptr;
+        atomic< uint64_t > startUs = 0;
+        atomic< uint64_t > maxTimeUs = 0;
+    };
 
-    [[nodiscard]] uint64_t getExpiryTime() const;
+    class StuckScope {
+    public:
+        uint64_t tid = 0;
+        string site;
+        uint64_t runningUs = 0;
+    };
+
+    array< Scope, MAX_DEPTH > scopes;
+
+    // may exceed MAX_DEPTH, deeper scopes are only timed
+    atomic< uint64_t > depth = 0;
+
+    atomic< uint64_t > version = 0;
+
+    atomic< bool > exited = false;
+
+    const uint64_t tid;
+
+    ThreadScopes();
+
+    // the stack of the calling thread, created on first use
+    static ThreadScopes& current();
+
+    // scopes of _sChain on all threads that have been open for longer than their max time
+    static vector< StuckScope > findStuck( const Schain* _sChain, uint64_t _nowUs );
+
+private:
+
+    static mutex allLock;
+
+    static list< ptr< ThreadScopes > > all;  // guarded by allLock
+
+    bool sample( const Schain* _sChain, uint64_t _nowUs, vector< StuckScope >& _stuck ) const;
+};
+
+
+// Marks a monitored scope on the stack of the current thread, and records its duration on exit.
+
+class LivelinessMonitor {
+
+    MonitorSite* const site;
+
+    ThreadScopes& scopes;
+
+    const uint64_t startUs;
+
+public:
 
-    string toString();
+    LivelinessMonitor( const Schain* _sChain, MonitorSite* _site, uint64_t _maxTimeMs );
 
-    virtual ~LivelinessMonitor();
+    ~LivelinessMonitor();
 
-    LivelinessMonitor(const ptr<MonitoringAgent>& _agent, const string& _class, const string& _function, uint64_t _maxTime);
+    LivelinessMonitor( const LivelinessMonitor& ) = delete;
 
+    LivelinessMonitor& operator=( const LivelinessMonitor& ) = delete;
 };
 
 
-#endif //SKALED_LIVELINESSMONITOR_H
+#endif  // SKALED_LIVELINESSMONITOR_H
@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file LivelinessMonitorTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include <sys/syscall.h>
+
+#include "thirdparty/catch.hpp"
+
+#include "utils/Time.h"
+
+#include "LivelinessMonitor.h"
+
+
+// scopes only compare the chain pointer, the tests never dereference it
+static const Schain* testChain( uint64_t _i ) {
+    static array< uint64_t, 2 > chains;
+    return reinterpret_cast< const Schain* >( &chains.at( _i ) );
+}
+
+
+static void nestedScopes( MonitorSite* _site, uint64_t _depth ) {
+    LivelinessMonitor monitor( testChain( 0 ), _site, 2000 );
+
+    if ( _depth > 1 )
+        nestedScopes( _site, _depth - 1 );
+}
+
+
+TEST_CASE( "Monitored scopes record their durations", "[liveliness]" ) {
+    auto site = MonitorSite::get( "LivelinessTest", "durations" );
+
+    REQUIRE( MonitorSite::get( "LivelinessTest", "durations" ) == site );
+    REQUIRE( site->getName() == "LivelinessTest::durations" );
+
+    {
+        LivelinessMonitor monitor( testChain( 0 ), site, 2000 );
+        usleep( 10000 );
+    }
+
+    REQUIRE( site->getDurations().getCount() == 1 );
+    REQUIRE( site->getDurations().getMax() >= 10000 );
+
+    // deeper than the stack, the extra scopes are only timed
+    nestedScopes( site, ThreadScopes::MAX_DEPTH + 8 );
+
+    REQUIRE( site->getDurations().getCount() == ThreadScopes::MAX_DEPTH + 9 );
+    REQUIRE( ThreadScopes::current().depth == 0 );
+
+    auto json = MonitorSite::allToJSON();
+
+    REQUIRE( json["LivelinessTest::durations"]["count"] == ThreadScopes::MAX_DEPTH + 9 );
+    REQUIRE( json.count( "LivelinessTest::unused" ) == 0 );
+}
+
+
+TEST_CASE( "Watchdog finds stuck scopes", "[liveliness]" ) {
+    auto site = MonitorSite::get( "LivelinessTest", "stuck" );
+
+    atomic< uint64_t > tid = 0;
+    atomic< bool > release = false;
+
+    thread worker( [&]() {
+        LivelinessMonitor monitor( testChain( 0 ), site, 10 );
+        tid = ( uint64_t ) syscall( SYS_gettid );
+        while ( !release ) {
+            usleep( 1000 );
+        }
+    } );
+
+    while ( tid == 0 ) {
+        usleep( 1000 );
+    }
+
+    usleep( 30000 );
+
+    auto now = Time::getSteadyTimeUs();
+
+    auto stuck = ThreadScopes::findStuck( testChain( 0 ), now );
+
+    REQUIRE( stuck.size() == 1 );
+    REQUIRE( stuck[0].tid == tid );
+    REQUIRE( stuck[0].site == "LivelinessTest::stuck" );
+    REQUIRE( stuck[0].runningUs >= 30000 );
+
+    // scopes of other chains and scopes within their max time are not reported
+    REQUIRE( ThreadScopes::findStuck( testChain( 1 ), now ).empty() );
+    REQUIRE( ThreadScopes::findStuck( testChain( 0 ), now - stuck[0].runningUs + 5000 ).empty() );
+
+    release = true;
+    worker.join();
+
+    REQUIRE( ThreadScopes::findStuck( testChain( 0 ), Time::getSteadyTimeUs() ).empty() );
+    REQUIRE( site->getDurations().getCount() == 1 );
+}
@@ -0,0 +1,260 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file MessageTrace.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+#include "exceptions/ParsingException.h"
+
+#include "crypto/BLAKE3Hash.h"
+#include "crypto/ThresholdSignature.h"
+#include "datastructures/CommittedBlock.h"
+#include "datastructures/DAProof.h"
+#include "utils/Time.h"
+
+#include "MessageTrace.h"
+
+
+static const string TRACE_MAGIC = "SKCTRACE";
+static constexpr uint32_t TRACE_VERSION = 1;
+
+
+static void appendUint64( string& _out, uint64_t _value ) {
+    _out.append( ( const char* ) &_value, sizeof( _value ) );
+}
+
+
+static void appendString( string& _out, const string& _value ) {
+    appendUint64( _out, _value.size() );
+    _out.append( _value );
+}
+
+
+// reads the payload of a record, throws on a truncated payload
+class TraceDecoder {
+    const string& data;
+    uint64_t position = 0;
+
+public:
+    explicit TraceDecoder( const string& _data ) : data( _data ) {}
+
+    uint64_t readUint64() {
+        uint64_t value;
+        CHECK_STATE2( position + sizeof( value ) <= data.size(), "Truncated trace record" );
+        memcpy( &value, data.data() + position, sizeof( value ) );
+        position += sizeof( value );
+        return value;
+    }
+
+    string readString() {
+        auto size = readUint64();
+        CHECK_STATE2( size <= data.size() - position, "Truncated trace record" );
+        auto value = data.substr( position, size );
+        position += size;
+        return value;
+    }
+};
+
+
+TraceWriter::TraceWriter( const string& _path, const TraceHeader& _header )
+    : file( _path, ios::binary | ios::trunc ), startUs( Time::getSteadyTimeUs() ) {
+    if ( !file.is_open() ) {
+        BOOST_THROW_EXCEPTION( FatalError( "Could not open trace file " + _path ) );
+    }
+
+    string header( TRACE_MAGIC );
+    header.append( ( const char* ) &TRACE_VERSION, sizeof( TRACE_VERSION ) );
+    appendUint64( header, _header.nodeID );
+    appendUint64( header, _header.schainIndex );
+    appendUint64( header, _header.nodeCount );
+    appendUint64( header, _header.startBlockID );
+
+    file.write( header.data(), header.size() );
+
+    LOG( info, "Capturing consensus trace to " + _path );
+}
+
+
+TraceWriter::~TraceWriter() {
+    lock_guard< mutex > lock( m );
+    file.flush();
+}
+
+
+void TraceWriter::write( trace_record_type _type, uint64_t _blockID, const string& _data ) {
+    uint64_t timeUs = Time::getSteadyTimeUs() - startUs;
+    uint32_t size = _data.size();
+
+    lock_guard< mutex > lock( m );
+
+    file.put( ( char ) _type );
+    file.write( ( const char* ) &timeUs, sizeof( timeUs ) );
+    file.write( ( const char* ) &_blockID, sizeof( _blockID ) );
+    file.write( ( const char* ) &size, sizeof( size ) );
+    file.write( _data.data(), _data.size() );
+}
+
+
+void TraceWriter::recordNetworkMessage( uint64_t _blockID, const string& _message ) {
+    write( TRACE_NETWORK_MESSAGE, _blockID, _message );
+}
+
+
+void TraceWriter::recordProposal( const ptr< BlockProposal >& _proposal ) {
+    CHECK_ARGUMENT( _proposal );
+    auto serialized = _proposal->serialize();
+    CHECK_STATE( serialized );
+    write( TRACE_PROPOSAL, ( uint64_t ) _proposal->getBlockID(),
+        string( ( const char* ) serialized->data(), serialized->size() ) );
+}
+
+
+void TraceWriter::recordDAProof( const ptr< DAProof >& _proof ) {
+    CHECK_ARGUMENT( _proof );
+
+    string data;
+    appendUint64( data, ( uint64_t ) _proof->getProposerIndex() );
+    appendString( data, _proof->getHash()->toHex() );
+    appendString( data, _proof->getThresholdSig()->toString() );
+
+    write( TRACE_DA_PROOF, ( uint64_t ) _proof->getBlockId(), data );
+}
+
+
+void TraceWriter::recordPendingTransactions( uint64_t _blockID,
+    const ConsensusExtFace::transactions_vector& _transactions, const u256& _stateRoot ) {
+    string data;
+    appendString( data, _stateRoot.str() );
+    appendUint64( data, _transactions.size() );
+
+    for ( auto&& transaction : _transactions ) {
+        appendString( data, string( transaction.begin(), transaction.end() ) );
+    }
+
+    write( TRACE_PENDING_TRANSACTIONS, _blockID, data );
+}
+
+
+void TraceWriter::recordCreateBlock( const ptr< CommittedBlock >& _block ) {
+    CHECK_ARGUMENT( _block );
+
+    string data;
+    appendUint64( data, ( uint64_t ) _block->getProposerIndex() );
+    appendUint64( data, ( uint64_t ) _block->getTransactionCount() );
+    appendUint64( data, _block->getTimeStampS() );
+    appendUint64( data, _block->getTimeStampMs() );
+
+    write( TRACE_CREATE_BLOCK, ( uint64_t ) _block->getBlockID(), data );
+}
+
+
+TraceReader::TraceReader( const string& _path ) : file( _path, ios::binary ) {
+    if ( !file.is_open() ) {
+        BOOST_THROW_EXCEPTION( FatalError( "Could not open trace file " + _path ) );
+    }
+
+    string magic( TRACE_MAGIC.size(), '\0' );
+    uint32_t version = 0;
+
+    file.read( magic.data(), magic.size() );
+    file.read( ( char* ) &version, sizeof( version ) );
+    file.read( ( char* ) &header.nodeID, sizeof( header.nodeID ) );
+    file.read( ( char* ) &header.schainIndex, sizeof( header.schainIndex ) );
+    file.read( ( char* ) &header.nodeCount, sizeof( header.nodeCount ) );
+    file.read( ( char* ) &header.startBlockID, sizeof( header.startBlockID ) );
+
+    if ( !file || magic != TRACE_MAGIC || version != TRACE_VERSION ) {
+        BOOST_THROW_EXCEPTION(
+            ParsingException( "Not a consensus trace: " + _path, __CLASS_NAME__ ) );
+    }
+}
+
+
+const TraceHeader& TraceReader::getHeader() const {
+    return header;
+}
+
+
+bool TraceReader::next( TraceRecord& _record ) {
+    char type;
+    uint32_t size;
+
+    if ( !file.get( type ) )
+        return false;
+
+    file.read( ( char* ) &_record.timeUs, sizeof( _record.timeUs ) );
+    file.read( ( char* ) &_record.blockID, sizeof( _record.blockID ) );
+    file.read( ( char* ) &size, sizeof( size ) );
+
+    // the capture may have been cut off by a crash
+    if ( !file )
+        return false;
+
+    _record.type = ( trace_record_type ) type;
+    _record.data.resize( size );
+    file.read( _record.data.data(), size );
+
+    return ( bool ) file;
+}
+
+
+TraceDAProof TraceReader::decodeDAProof( const string& _data ) {
+    TraceDecoder decoder( _data );
+    TraceDAProof result;
+    result.proposerIndex = decoder.readUint64();
+    result.hash = decoder.readString();
+    result.signature = decoder.readString();
+    return result;
+}
+
+
+ConsensusExtFace::transactions_vector TraceReader::decodePendingTransactions(
+    const string& _data, u256& _stateRoot ) {
+    TraceDecoder decoder( _data );
+
+    _stateRoot = u256( decoder.readString() );
+
+    auto count = decoder.readUint64();
+    CHECK_STATE2( count <= _data.size(), "Truncated trace record" );
+
+    ConsensusExtFace::transactions_vector result( count );
+
+    for ( auto&& transaction : result ) {
+        auto bytes = decoder.readString();
+        transaction.assign( bytes.begin(), bytes.end() );
+    }
+
+    return result;
+}
+
+
+TraceCreatedBlock TraceReader::decodeCreateBlock( const string& _data ) {
+    TraceDecoder decoder( _data );
+    TraceCreatedBlock result;
+    result.proposerIndex = decoder.readUint64();
+    result.transactionCount = decoder.readUint64();
+    result.timeStampS = decoder.readUint64();
+    result.timeStampMs = decoder.readUint64();
+    return result;
+}
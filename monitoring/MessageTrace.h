@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file MessageTrace.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "node/ConsensusInterface.h"
+
+class BlockProposal;
+class CommittedBlock;
+class DAProof;
+
+
+enum trace_record_type : uint8_t {
+    // consensus message as read from the network
+    TRACE_NETWORK_MESSAGE = 1,
+    // own or received proposal, serialized
+    TRACE_PROPOSAL,
+    TRACE_DA_PROOF,
+    // transactions returned by ConsensusExtFace::pendingTransactions
+    TRACE_PENDING_TRANSACTIONS,
+    // block passed to ConsensusExtFace::createBlock
+    TRACE_CREATE_BLOCK
+};
+
+
+class TraceHeader {
+public:
+    uint64_t nodeID = 0;
+    uint64_t schainIndex = 0;
+    uint64_t nodeCount = 0;
+    // last committed block when the capture started
+    uint64_t startBlockID = 0;
+};
+
+
+class TraceRecord {
+public:
+    trace_record_type type = TRACE_NETWORK_MESSAGE;
+    // since the start of the capture
+    uint64_t timeUs = 0;
+    uint64_t blockID = 0;
+    string data;
+};
+
+
+class TraceDAProof {
+public:
+    uint64_t proposerIndex = 0;
+    string hash;
+    string signature;
+};
+
+
+class TraceCreatedBlock {
+public:
+    uint64_t proposerIndex = 0;
+    uint64_t transactionCount = 0;
+    uint64_t timeStampS = 0;
+    uint64_t timeStampMs = 0;
+};
+
+
+// Captures what a node receives from the outside - network messages, proposals, DA proofs and
+// ExtFace calls - with time stamps, so consensus can be replayed offline on production traffic.
+//
+// Records are binary: type, time, block id, length and payload. The payload of a network
+// message is the message as it came from the network.
+
+class TraceWriter {
+
+    mutex m;
+
+    ofstream file;
+
+    const uint64_t startUs;
+
+    void write( trace_record_type _type, uint64_t _blockID, const string& _data );
+
+public:
+
+    TraceWriter( const string& _path, const TraceHeader& _header );
+
+    ~TraceWriter();
+
+    void recordNetworkMessage( uint64_t _blockID, const string& _message );
+
+    void recordProposal( const ptr< BlockProposal >& _proposal );
+
+    void recordDAProof( const ptr< DAProof >& _proof );
+
+    void recordPendingTransactions( uint64_t _blockID,
+        const ConsensusExtFace::transactions_vector& _transactions, const u256& _stateRoot );
+
+    void recordCreateBlock( const ptr< CommittedBlock >& _block );
+};
+
+
+class TraceReader {
+
+    ifstream file;
+
+    TraceHeader header;
+
+public:
+
+    explicit TraceReader( const string& _path );
+
+    const TraceHeader& getHeader() const;
+
+    // returns false at the end of the trace
+    bool next( TraceRecord& _record );
+
+    static TraceDAProof decodeDAProof( const string& _data );
+
+    static ConsensusExtFace::transactions_vector decodePendingTransactions(
+        const string& _data, u256& _stateRoot );
+
+    static TraceCreatedBlock decodeCreateBlock( const string& _data );
+};
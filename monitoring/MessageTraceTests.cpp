@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file MessageTraceTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "thirdparty/catch.hpp"
+
+#include "MessageTrace.h"
+
+
+TEST_CASE( "Message trace round trip", "[message-trace]" ) {
+    string path = "/tmp/consensus_trace_test.bin";
+
+    TraceHeader header;
+    header.nodeID = 3;
+    header.schainIndex = 2;
+    header.nodeCount = 4;
+
+    ConsensusExtFace::transactions_vector transactions{
+        { 1, 2, 3 }, {}, vector< uint8_t >( 300, 7 ) };
+
+    {
+        TraceWriter writer( path, header );
+        writer.recordNetworkMessage( 5, string( "message\0with zero", 17 ) );
+        writer.recordPendingTransactions( 6, transactions, u256( 12345 ) );
+    }
+
+    TraceReader reader( path );
+
+    REQUIRE( reader.getHeader().nodeID == 3 );
+    REQUIRE( reader.getHeader().schainIndex == 2 );
+    REQUIRE( reader.getHeader().nodeCount == 4 );
+    REQUIRE( reader.getHeader().startBlockID == 0 );
+
+    TraceRecord record;
+
+    REQUIRE( reader.next( record ) );
+    REQUIRE( record.type == TRACE_NETWORK_MESSAGE );
+    REQUIRE( record.blockID == 5 );
+    REQUIRE( record.data == string( "message\0with zero", 17 ) );
+
+    auto firstUs = record.timeUs;
+
+    REQUIRE( reader.next( record ) );
+    REQUIRE( record.type == TRACE_PENDING_TRANSACTIONS );
+    REQUIRE( record.blockID == 6 );
+    REQUIRE( record.timeUs >= firstUs );
+
+    u256 stateRoot;
+    REQUIRE( TraceReader::decodePendingTransactions( record.data, stateRoot ) == transactions );
+    REQUIRE( stateRoot == 12345 );
+
+    REQUIRE_THROWS(
+        TraceReader::decodePendingTransactions( record.data.substr( 0, 20 ), stateRoot ) );
+
+    REQUIRE( !reader.next( record ) );
+
+    remove( path.c_str() );
+}
+
+
+TEST_CASE( "Truncated message trace", "[message-trace]" ) {
+    string path = "/tmp/consensus_trace_truncated_test.bin";
+
+    {
+        TraceWriter writer( path, TraceHeader() );
+        writer.recordNetworkMessage( 1, "first" );
+        writer.recordNetworkMessage( 1, "second" );
+    }
+
+    // cut in the middle of the second record, as a crash would
+    auto size = boost::filesystem::file_size( path );
+    boost::filesystem::resize_file( path, size - 3 );
+
+    TraceReader reader( path );
+    TraceRecord record;
+
+    REQUIRE( reader.next( record ) );
+    REQUIRE( record.data == "first" );
+    REQUIRE( !reader.next( record ) );
+
+    remove( path.c_str() );
+
+    REQUIRE_THROWS( TraceReader( "/tmp/consensus_trace_does_not_exist.bin" ) );
+}
@@ -32,18 +32,19 @@
 #include "node/Node.h"
 #include "chains/Schain.h"
 #include "LivelinessMonitor.h"
+#include "StageMetrics.h"
 #include "MonitoringAgent.h"
-#include "MonitoringThreadPool.h"
-
-#include "utils/Time.h"
+#include "threads/GlobalThreadRegistry.h"
+#include "threads/TimerWheel.h"
 
 MonitoringAgent::MonitoringAgent(Schain &_sChain) : Agent(_sChain, false, true) {
     try {
         logThreadLocal_ = _sChain.getNode()->getLog();
         this->sChain = &_sChain;
 
-        this->monitoringThreadPool = make_shared<MonitoringThreadPool>(1, this);
-        monitoringThreadPool->startService();
+        timerId = _sChain.getNode()->getConsensusEngine()->getTimerWheel()->schedulePeriodic(
+            _sChain.getNode()->getMonitoringIntervalMs(), PRIORITY_MONITORING,
+            [this]() { monitor(); });
 
     } catch (...) {
         throw_with_nested(FatalError(__FUNCTION__, __CLASS_NAME__));
@@ -54,98 +55,70 @@ MonitoringAgent::MonitoringAgent(Schain &_sChain) : Agent(_sChain, false, true)
 
 void MonitoringAgent::monitor() {
 
-    if (ConsensusEngine::isOnTravis())
+    if (getNode()->isExitRequested()) {
+        cancelTimer();
         return;
-
-    while (!getNode()->isInited()) {
-        usleep(100000);
     }
 
+    // requested by SIGUSR1 or by an admin call, so it is written on Travis too
+    if (getThreadRegistry()->takeDumpRequest())
+        writeThreadsAndQueues();
 
-    map<uint64_t, weak_ptr<LivelinessMonitor>> monitorsCopy;
-
-    {
-        LOCK(m)
-
-        lock_guard<recursive_mutex> lock(m);
-
-        monitorsCopy = activeMonitors;
-
-    }
-
-    for (auto &&item: monitorsCopy ) {
-
-        if( sChain->getNode()->isExitRequested() )
-            return;
-
-        ptr<LivelinessMonitor> monitor = item.second.lock();
-
-        if (monitor) {
+    if (ConsensusEngine::isOnTravis())
+        return;
 
-            CHECK_STATE(monitor != nullptr);
+    if (!getNode()->isInited())
+        return;
 
-            auto currentTime = Time::getCurrentTimeMs();
+    writeStageMetrics();
 
-            if (currentTime > monitor->getExpiryTime()) {
-                LOG(warn,
-                    monitor->toString() + " has been stuck for " + to_string(currentTime - monitor->getStartTime()) +
-                    " ms");
-            }
-        }
+    // samples the scope stacks of all threads
+    for (auto &&stuck : ThreadScopes::findStuck(sChain, Time::getSteadyTimeUs())) {
+        LOG(warn, "Node:" + to_string(getNode()->getNodeID()) + ":Thread:" +
+                  to_string(stuck.tid) + ":" + stuck.site + " has been stuck for " +
+                  to_string(stuck.runningUs / 1000) + " ms");
     }
-
-
 }
 
 
 
 
-void MonitoringAgent::monitoringLoop(MonitoringAgent *_agent) {
-
-
-    CHECK_ARGUMENT(_agent);
-
-    setThreadName("MonitoringLoop", _agent->getSchain()->getNode()->getConsensusEngine());
-
-
-    LOG(info, "Monitoring agent started monitoring");
+void MonitoringAgent::writeStageMetrics() {
+    auto engine = getNode()->getConsensusEngine();
+    CHECK_STATE(engine);
+    string fileName = engine->getHealthCheckDir() + "/consensus_metrics";
+    auto id = engine->getEngineID();
+    if (id > 1) {
+        fileName.append("." + to_string(id));
+    }
 
+    // the textfile collector of the node exporter only reads files that end with .prom
     try {
-        while (!_agent->getSchain()->getNode()->isExitRequested()) {
-            usleep(_agent->getSchain()->getNode()->getMonitoringIntervalMs() * 1000);
-
-            try {
-                _agent->monitor();
-
-            } catch (ExitRequestedException &) {
-                return;
-            } catch (exception &e) {
-                SkaleException::logNested(e);
-            }
-
-        };
-    } catch (FatalError& e) {
-        _agent->getSchain()->getNode()->exitOnFatalError(e.getMessage());
+        sChain->getStageMetrics()->writeFiles(fileName + ".prom", fileName + ".json");
+    } catch (exception &e) {
+        SkaleException::logNested(e);
     }
 }
 
-void MonitoringAgent::registerMonitor(const ptr<LivelinessMonitor>& _m) {
-
-    CHECK_ARGUMENT(_m)
-    LOCK(m)
-    activeMonitors[_m->getId()] = _m;
-}
-
-void MonitoringAgent::unregisterMonitor(uint64_t _id) {
 
-    LOCK(m)
-
-    activeMonitors.erase(_id);
+void MonitoringAgent::writeThreadsAndQueues() {
+    auto engine = getNode()->getConsensusEngine();
+    CHECK_STATE(engine);
+    string fileName = engine->getHealthCheckDir() + "/consensus_threads";
+    auto id = engine->getEngineID();
+    if (id > 1) {
+        fileName.append("." + to_string(id));
+    }
 
+    try {
+        getThreadRegistry()->writeJSON(fileName + ".json");
+        LOG(info, "Wrote threads and queues to " + fileName + ".json");
+    } catch (exception &e) {
+        SkaleException::logNested(e);
+    }
 }
 
 
-void MonitoringAgent::join() {
-    CHECK_STATE(monitoringThreadPool);
-    monitoringThreadPool->joinAll();
+void MonitoringAgent::cancelTimer() {
+    getNode()->getConsensusEngine()->getTimerWheel()->cancel(timerId);
 }
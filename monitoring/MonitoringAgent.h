@@ -24,28 +24,21 @@
 #pragma once
 
 class Schain;
-class MonitoringThreadPool;
-class LivelinessMonitor;
 
 class MonitoringAgent : public Agent  {
 
-    map<uint64_t, weak_ptr<LivelinessMonitor>> activeMonitors; // tsafe
+    uint64_t timerId = 0;
 
-    ptr< MonitoringThreadPool > monitoringThreadPool = nullptr;
+    void writeStageMetrics();
+
+    void writeThreadsAndQueues();
 
 public:
 
     explicit MonitoringAgent( Schain& _sChain );
 
-    static void monitoringLoop( MonitoringAgent* agent );
-
     void monitor();
 
-    void join();
-
-
-    void registerMonitor(const ptr<LivelinessMonitor>& _m);
-
-    void unregisterMonitor(uint64_t _id);
+    void cancelTimer();
 
 };
@@ -0,0 +1,234 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file StageMetrics.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+#include "utils/Time.h"
+
+#include "StageMetrics.h"
+
+
+static const double EXPORTED_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+
+StageMetrics::StageMetrics( uint64_t _nodeID, uint64_t _nodeCount )
+    : nodeID( _nodeID ), proposalPush( _nodeCount ), peers( _nodeCount ) {
+    CHECK_ARGUMENT( _nodeCount > 0 );
+}
+
+
+const char* StageMetrics::getStageName( block_stage _stage ) {
+    switch ( _stage ) {
+    case STAGE_PENDING_PULL:
+        return "pending_pull";
+    case STAGE_PROPOSAL_BUILD:
+        return "proposal_build";
+    case STAGE_DA_PROOF:
+        return "da_proof";
+    case STAGE_BIN_CONSENSUS_ROUND:
+        return "bin_consensus_round";
+    case STAGE_BLOCK_SIGN:
+        return "block_sign";
+    case STAGE_FINALIZE_DOWNLOAD:
+        return "finalize_download";
+    case STAGE_EXT_FACE_CREATE_BLOCK:
+        return "ext_face_create_block";
+    case STAGE_DB_SAVE:
+        return "db_save";
+    case STAGE_BLOCK_COMMIT:
+        return "block_commit";
+    default:
+        BOOST_THROW_EXCEPTION(
+            InvalidArgumentException( "Unknown stage " + to_string( _stage ), __CLASS_NAME__ ) );
+    }
+}
+
+
+StageMetrics::PeerCounters& StageMetrics::peer( schain_index _index ) {
+    CHECK_ARGUMENT( _index > 0 && ( uint64_t ) _index <= peers.size() );
+    return peers[( uint64_t ) _index - 1];
+}
+
+
+void StageMetrics::recordStage( block_stage _stage, uint64_t _latencyUs ) {
+    CHECK_ARGUMENT( _stage < STAGE_COUNT );
+    stages[_stage].record( _latencyUs );
+}
+
+
+void StageMetrics::recordProposalPush( schain_index _peer, uint64_t _latencyUs ) {
+    CHECK_ARGUMENT( _peer > 0 && ( uint64_t ) _peer <= proposalPush.size() );
+    proposalPush[( uint64_t ) _peer - 1].record( _latencyUs );
+}
+
+
+void StageMetrics::messageSent( schain_index _peer, uint64_t _bytes ) {
+    auto& counters = peer( _peer );
+    counters.messagesSent++;
+    counters.bytesSent += _bytes;
+}
+
+
+void StageMetrics::messageReceived( schain_index _peer, uint64_t _bytes ) {
+    auto& counters = peer( _peer );
+    counters.messagesReceived++;
+    counters.bytesReceived += _bytes;
+}
+
+
+void StageMetrics::retry( schain_index _peer ) {
+    peer( _peer ).retries++;
+}
+
+
+const LatencyHistogram& StageMetrics::getStage( block_stage _stage ) const {
+    CHECK_ARGUMENT( _stage < STAGE_COUNT );
+    return stages[_stage];
+}
+
+
+static void writeSummary( ostringstream& _out, const string& _labels, const LatencyHistogram& _h ) {
+    for ( auto quantile : EXPORTED_QUANTILES ) {
+        _out << "consensus_stage_latency_us{" << _labels << ",quantile=\"" << quantile << "\"} "
+             << _h.getQuantile( quantile ) << "\n";
+    }
+    _out << "consensus_stage_latency_us_sum{" << _labels << "} " << _h.getSum() << "\n";
+    _out << "consensus_stage_latency_us_count{" << _labels << "} " << _h.getCount() << "\n";
+}
+
+
+string StageMetrics::toPrometheus() {
+    ostringstream out;
+
+    auto node = "node=\"" + to_string( nodeID ) + "\"";
+
+    out << "# HELP consensus_stage_latency_us Latency of a block processing stage.\n";
+    out << "# TYPE consensus_stage_latency_us summary\n";
+
+    for ( uint64_t i = 0; i < STAGE_COUNT; i++ ) {
+        writeSummary( out, node + ",stage=\"" + getStageName( block_stage( i ) ) + "\"",
+            stages[i] );
+    }
+
+    for ( uint64_t i = 0; i < proposalPush.size(); i++ ) {
+        if ( proposalPush[i].getCount() == 0 )
+            continue;
+        writeSummary( out,
+            node + ",stage=\"proposal_push\",peer=\"" + to_string( i + 1 ) + "\"",
+            proposalPush[i] );
+    }
+
+    auto writeCounter = [&]( const string& _name, const string& _help,
+                            const function< uint64_t( const PeerCounters& ) >& _value ) {
+        out << "# HELP " << _name << " " << _help << "\n";
+        out << "# TYPE " << _name << " counter\n";
+        for ( uint64_t i = 0; i < peers.size(); i++ ) {
+            out << _name << "{" << node << ",peer=\"" << i + 1 << "\"} " << _value( peers[i] )
+                << "\n";
+        }
+    };
+
+    writeCounter( "consensus_peer_messages_sent_total", "Messages sent to a peer.",
+        []( const PeerCounters& _c ) { return _c.messagesSent.load(); } );
+    writeCounter( "consensus_peer_bytes_sent_total", "Bytes sent to a peer.",
+        []( const PeerCounters& _c ) { return _c.bytesSent.load(); } );
+    writeCounter( "consensus_peer_messages_received_total", "Messages received from a peer.",
+        []( const PeerCounters& _c ) { return _c.messagesReceived.load(); } );
+    writeCounter( "consensus_peer_bytes_received_total", "Bytes received from a peer.",
+        []( const PeerCounters& _c ) { return _c.bytesReceived.load(); } );
+    writeCounter( "consensus_peer_retries_total", "Sends to a peer that had to be retried.",
+        []( const PeerCounters& _c ) { return _c.retries.load(); } );
+
+    return out.str();
+}
+
+
+static nlohmann::json histogramToJSON( const LatencyHistogram& _h ) {
+    auto result = nlohmann::json::object();
+    result["count"] = _h.getCount();
+    result["sumUs"] = _h.getSum();
+    result["maxUs"] = _h.getMax();
+    result["p50Us"] = _h.getQuantile( 0.5 );
+    result["p90Us"] = _h.getQuantile( 0.9 );
+    result["p99Us"] = _h.getQuantile( 0.99 );
+    result["p999Us"] = _h.getQuantile( 0.999 );
+    return result;
+}
+
+
+nlohmann::json StageMetrics::toJSON() {
+    auto result = nlohmann::json::object();
+
+    result["nodeID"] = nodeID;
+
+    for ( uint64_t i = 0; i < STAGE_COUNT; i++ ) {
+        result["stages"][getStageName( block_stage( i ) )] = histogramToJSON( stages[i] );
+    }
+
+    for ( uint64_t i = 0; i < peers.size(); i++ ) {
+        auto& counters = peers[i];
+        auto peerJSON = nlohmann::json::object();
+        peerJSON["proposalPush"] = histogramToJSON( proposalPush[i] );
+        peerJSON["messagesSent"] = counters.messagesSent.load();
+        peerJSON["bytesSent"] = counters.bytesSent.load();
+        peerJSON["messagesReceived"] = counters.messagesReceived.load();
+        peerJSON["bytesReceived"] = counters.bytesReceived.load();
+        peerJSON["retries"] = counters.retries.load();
+        result["peers"][to_string( i + 1 )] = peerJSON;
+    }
+
+    return result;
+}
+
+
+static void replaceFile( const string& _fileName, const string& _contents ) {
+    auto tmpFileName = _fileName + ".tmp";
+
+    ofstream f;
+    f.open( tmpFileName, ios::trunc );
+    f << _contents;
+    f.close();
+
+    if ( !f || rename( tmpFileName.c_str(), _fileName.c_str() ) != 0 ) {
+        BOOST_THROW_EXCEPTION(
+            InvalidStateException( "Could not write " + _fileName, __CLASS_NAME__ ) );
+    }
+}
+
+
+void StageMetrics::writeFiles( const string& _prometheusFile, const string& _jsonFile ) {
+    replaceFile( _prometheusFile, toPrometheus() );
+    replaceFile( _jsonFile, toJSON().dump() );
+}
+
+
+StageTimer::StageTimer( const ptr< StageMetrics >& _metrics, block_stage _stage )
+    : metrics( _metrics ), stage( _stage ), startUs( Time::getSteadyTimeUs() ) {
+    CHECK_ARGUMENT( _metrics );
+}
+
+
+StageTimer::~StageTimer() {
+    metrics->recordStage( stage, Time::getSteadyTimeUs() - startUs );
+}
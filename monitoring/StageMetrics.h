@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file StageMetrics.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_STAGEMETRICS_H
+#define SKALED_STAGEMETRICS_H
+
+#include "thirdparty/json.hpp"
+
+#include "LatencyHistogram.h"
+
+
+// measures the scope it is declared in
+#define MEASURE_STAGE( _S_ ) StageTimer __stageTimer__( getSchain()->getStageMetrics(), _S_ );
+
+
+enum block_stage {
+    STAGE_PENDING_PULL = 0,
+    STAGE_PROPOSAL_BUILD,
+    STAGE_DA_PROOF,
+    STAGE_BIN_CONSENSUS_ROUND,
+    STAGE_BLOCK_SIGN,
+    STAGE_FINALIZE_DOWNLOAD,
+    STAGE_EXT_FACE_CREATE_BLOCK,
+    STAGE_DB_SAVE,
+    // from the proposal time stamp to the commit on this node
+    STAGE_BLOCK_COMMIT,
+    STAGE_COUNT
+};
+
+
+// Latencies of the stages a block goes through and traffic counters per peer of a node.
+//
+// The monitoring agent writes them periodically as a Prometheus text file, that can be picked
+// up by the node exporter textfile collector, and as a JSON file.
+
+class StageMetrics {
+
+    class PeerCounters {
+    public:
+        atomic< uint64_t > messagesSent = 0;
+        atomic< uint64_t > bytesSent = 0;
+        atomic< uint64_t > messagesReceived = 0;
+        atomic< uint64_t > bytesReceived = 0;
+        atomic< uint64_t > retries = 0;
+    };
+
+    const uint64_t nodeID;
+
+    array< LatencyHistogram, STAGE_COUNT > stages;
+
+    // proposal push latencies and counters by peer schain index - 1
+    vector< LatencyHistogram > proposalPush;
+
+    vector< PeerCounters > peers;
+
+    PeerCounters& peer( schain_index _index );
+
+public:
+
+    StageMetrics( uint64_t _nodeID, uint64_t _nodeCount );
+
+    static const char* getStageName( block_stage _stage );
+
+    void recordStage( block_stage _stage, uint64_t _latencyUs );
+
+    void recordProposalPush( schain_index _peer, uint64_t _latencyUs );
+
+    void messageSent( schain_index _peer, uint64_t _bytes );
+
+    void messageReceived( schain_index _peer, uint64_t _bytes );
+
+    void retry( schain_index _peer );
+
+    const LatencyHistogram& getStage( block_stage _stage ) const;
+
+    string toPrometheus();
+
+    nlohmann::json toJSON();
+
+    // each file is replaced atomically
+    void writeFiles( const string& _prometheusFile, const string& _jsonFile );
+};
+
+
+class StageTimer {
+
+    const ptr< StageMetrics > metrics;
+
+    const block_stage stage;
+
+    const uint64_t startUs;
+
+public:
+
+    StageTimer( const ptr< StageMetrics >& _metrics, block_stage _stage );
+
+    ~StageTimer();
+};
+
+
+#endif  // SKALED_STAGEMETRICS_H
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file StageMetricsTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include <random>
+
+#include "thirdparty/catch.hpp"
+
+#include "LatencyHistogram.h"
+#include "StageMetrics.h"
+
+
+TEST_CASE( "Latency histogram buckets cover all values", "[stage-metrics]" ) {
+    REQUIRE( LatencyHistogram::bucketOf( 0 ) == 0 );
+    REQUIRE( LatencyHistogram::bucketOf( UINT64_MAX ) == LatencyHistogram::BUCKET_COUNT - 1 );
+
+    for ( uint64_t value : vector< uint64_t >{ 0, 1, 15, 16, 17, 31, 32, 1000, 123456789,
+              ( 1ULL << 40 ) + 12345, UINT64_MAX } ) {
+        auto bucket = LatencyHistogram::bucketOf( value );
+        REQUIRE( LatencyHistogram::bucketLow( bucket ) <= value );
+        REQUIRE( LatencyHistogram::bucketHigh( bucket ) >= value );
+        // a value is known within 1/16 of itself
+        REQUIRE( LatencyHistogram::bucketHigh( bucket ) - LatencyHistogram::bucketLow( bucket ) <=
+                 value / LatencyHistogram::SUB_BUCKETS );
+    }
+
+    for ( uint64_t i = 1; i < LatencyHistogram::BUCKET_COUNT; i++ ) {
+        REQUIRE( LatencyHistogram::bucketLow( i ) == LatencyHistogram::bucketHigh( i - 1 ) + 1 );
+    }
+}
+
+
+TEST_CASE( "Latency histogram quantiles", "[stage-metrics]" ) {
+    LatencyHistogram histogram;
+
+    REQUIRE( histogram.getQuantile( 0.99 ) == 0 );
+
+    vector< uint64_t > values;
+    mt19937_64 random( 7 );
+    exponential_distribution< double > latency( 1.0 / 20000 );
+
+    for ( uint64_t i = 0; i < 100000; i++ ) {
+        values.push_back( ( uint64_t ) latency( random ) );
+        histogram.record( values.back() );
+    }
+
+    sort( values.begin(), values.end() );
+
+    REQUIRE( histogram.getCount() == values.size() );
+    REQUIRE( histogram.getMax() == values.back() );
+    REQUIRE( histogram.getQuantile( 1 ) == values.back() );
+
+    for ( auto quantile : { 0.5, 0.9, 0.99, 0.999 } ) {
+        auto exact = values.at( ( uint64_t ) ceil( quantile * values.size() ) - 1 );
+        auto estimate = histogram.getQuantile( quantile );
+        REQUIRE( estimate >= exact );
+        REQUIRE( estimate - exact <= exact / LatencyHistogram::SUB_BUCKETS );
+    }
+}
+
+
+TEST_CASE( "Stage metrics export", "[stage-metrics]" ) {
+    StageMetrics metrics( 5, 4 );
+
+    metrics.recordStage( STAGE_DA_PROOF, 1000 );
+    metrics.recordStage( STAGE_DA_PROOF, 3000 );
+    metrics.recordProposalPush( schain_index( 2 ), 500 );
+    metrics.messageSent( schain_index( 3 ), 100 );
+    metrics.messageSent( schain_index( 3 ), 50 );
+    metrics.messageReceived( schain_index( 4 ), 70 );
+    metrics.retry( schain_index( 1 ) );
+
+    REQUIRE_THROWS( metrics.messageSent( schain_index( 5 ), 1 ) );
+
+    auto text = metrics.toPrometheus();
+
+    REQUIRE( text.find( "# TYPE consensus_stage_latency_us summary\n" ) != string::npos );
+    REQUIRE( text.find( "consensus_stage_latency_us_count{node=\"5\",stage=\"da_proof\"} 2\n" ) !=
+             string::npos );
+    REQUIRE( text.find( "consensus_stage_latency_us_sum{node=\"5\",stage=\"da_proof\"} 4000\n" ) !=
+             string::npos );
+    REQUIRE( text.find( "consensus_stage_latency_us{node=\"5\",stage=\"da_proof\",quantile=\"0.5\"} "
+                        "1023\n" ) != string::npos );
+    REQUIRE( text.find( "stage=\"proposal_push\",peer=\"2\"" ) != string::npos );
+    REQUIRE( text.find( "stage=\"proposal_push\",peer=\"1\"" ) == string::npos );
+    REQUIRE( text.find( "consensus_peer_bytes_sent_total{node=\"5\",peer=\"3\"} 150\n" ) !=
+             string::npos );
+    REQUIRE( text.find( "consensus_peer_retries_total{node=\"5\",peer=\"1\"} 1\n" ) !=
+             string::npos );
+
+    auto json = metrics.toJSON();
+
+    REQUIRE( json["nodeID"] == 5 );
+    REQUIRE( json["stages"]["da_proof"]["count"] == 2 );
+    REQUIRE( json["stages"]["da_proof"]["maxUs"] == 3000 );
+    REQUIRE( json["stages"]["db_save"]["count"] == 0 );
+    REQUIRE( json["peers"]["3"]["messagesSent"] == 2 );
+    REQUIRE( json["peers"]["4"]["bytesReceived"] == 70 );
+    REQUIRE( json["peers"]["2"]["proposalPush"]["p99Us"] == 500 );
+}
+
+
+TEST_CASE( "Latency histograms merge", "[stage-metrics]" ) {
+    LatencyHistogram first;
+    LatencyHistogram second;
+
+    for ( uint64_t i = 1; i <= 100; i++ ) {
+        first.record( i * 10 );
+        second.record( i * 1000 );
+    }
+
+    first.merge( second );
+
+    REQUIRE( first.getCount() == 200 );
+    REQUIRE( first.getMax() == 100000 );
+    REQUIRE( first.getSum() == 50500 + 5050000 );
+    // the largest value of the first histogram is the median
+    REQUIRE( first.getQuantile( 0.5 ) ==
+             LatencyHistogram::bucketHigh( LatencyHistogram::bucketOf( 1000 ) ) );
+    REQUIRE( first.getQuantile( 0.51 ) >= 2000 );
+}
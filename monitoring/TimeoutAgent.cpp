@@ -33,17 +33,15 @@
 #include "chains/Schain.h"
 #include "LivelinessMonitor.h"
 #include "TimeoutAgent.h"
-#include "TimeoutThreadPool.h"
-
-#include "utils/Time.h"
+#include "threads/TimerWheel.h"
 
 TimeoutAgent::TimeoutAgent(Schain &_sChain) : Agent(_sChain, false, true) {
     try {
         logThreadLocal_ = _sChain.getNode()->getLog();
         this->sChain = &_sChain;
-        this->timeoutThreadPool = make_shared<TimeoutThreadPool>(1, this);
-        timeoutThreadPool->startService();
-
+        timerId = _sChain.getNode()->getConsensusEngine()->getTimerWheel()->schedulePeriodic(
+            _sChain.getNode()->getMonitoringIntervalMs(), PRIORITY_CONSENSUS,
+            [this]() { checkTimeouts(); });
     } catch (...) {
         throw_with_nested(FatalError(__FUNCTION__, __CLASS_NAME__));
     }
@@ -51,77 +49,51 @@ TimeoutAgent::TimeoutAgent(Schain &_sChain) : Agent(_sChain, false, true) {
 }
 
 
-void TimeoutAgent::timeoutLoop(TimeoutAgent *_agent) {
-
+void TimeoutAgent::checkTimeouts() {
 
-    CHECK_ARGUMENT(_agent);
-
-    setThreadName("TimeoutLoop", _agent->getSchain()->getNode()->getConsensusEngine());
+    if (getSchain()->getNode()->isExitRequested()) {
+        cancelTimer();
+        return;
+    }
 
-    _agent->getSchain()->getSchain()->waitOnGlobalStartBarrier();
+    // runs on the timer wheel, so it can not wait on the start barrier
+    if (!getSchain()->getNode()->isStarted())
+        return;
 
-    LOG(info, "Timeout agent started monitoring");
+    auto currentBlockId = getSchain()->getLastCommittedBlockID() + 1;
+    auto currentTime = Time::getCurrentTimeMs();
 
-    uint64_t blockProcessingStart = max(_agent->getSchain()->getLastCommitTimeMs(),
-                                                           _agent->getSchain()->getStartTimeMs());
+    auto timeZero = max(getSchain()->getLastCommitTimeMs(),
+                        getSchain()->getStartTimeMs());
 
-    if( blockProcessingStart == 0)
-        blockProcessingStart = Time::getCurrentTimeMs();
+    if (timeZero == 0)
+        timeZero = currentTime;
 
-    uint64_t lastRebroadCastTime = blockProcessingStart;
+    auto blockProcessingStart = timeZero;
 
-    bool proposalReceiptTimedOut = false;
+    lastRebroadCastTime = max(lastRebroadCastTime, timeZero);
 
-    try {
-        while (!_agent->getSchain()->getNode()->isExitRequested()) {
+    if (getSchain()->getNodeCount() > 2) {
 
-            usleep(_agent->getSchain()->getNode()->getMonitoringIntervalMs() * 1000);
+        if ( currentTime - blockProcessingStart <= BLOCK_PROPOSAL_RECEIVE_TIMEOUT_MS )
+            proposalReceiptTimedOut = false;
 
+        if ( !proposalReceiptTimedOut && currentBlockId > 2 && currentTime - blockProcessingStart > BLOCK_PROPOSAL_RECEIVE_TIMEOUT_MS ) {
             try {
-
-                auto currentBlockId = _agent->getSchain()->getLastCommittedBlockID() + 1;
-                auto currentTime = Time::getCurrentTimeMs();
-
-                auto timeZero = max(_agent->getSchain()->getLastCommitTimeMs(),
-                                    _agent->getSchain()->getStartTimeMs());
-
-                blockProcessingStart = timeZero;
-
-                lastRebroadCastTime = max(lastRebroadCastTime, timeZero);
-
-                if (_agent->getSchain()->getNodeCount() > 2) {
-
-                    if ( currentTime - blockProcessingStart <= BLOCK_PROPOSAL_RECEIVE_TIMEOUT_MS )
-                        proposalReceiptTimedOut = false;
-
-                    if ( !proposalReceiptTimedOut && currentBlockId > 2 && currentTime - blockProcessingStart > BLOCK_PROPOSAL_RECEIVE_TIMEOUT_MS ) {
-                        try {
-                            _agent->getSchain()->blockProposalReceiptTimeoutArrived(
-                                currentBlockId );
-                            proposalReceiptTimedOut = true;
-                        } catch ( ... ) {
-                        }
-                    }
-
-                    if ( currentBlockId > 2 && currentTime - lastRebroadCastTime > REBROADCAST_TIMEOUT_MS) {
-                        _agent->getSchain()->rebroadcastAllMessagesForCurrentBlock();
-                        lastRebroadCastTime = currentTime;
-                    }
-                }
-
-            } catch (ExitRequestedException &) {
-                return;
-            } catch (exception &e) {
-                SkaleException::logNested(e);
+                getSchain()->blockProposalReceiptTimeoutArrived(
+                    currentBlockId );
+                proposalReceiptTimedOut = true;
+            } catch ( ... ) {
             }
+        }
 
-        };
-    } catch (FatalError& e) {
-        _agent->getSchain()->getNode()->exitOnFatalError(e.getMessage());
+        if ( currentBlockId > 2 && currentTime - lastRebroadCastTime > REBROADCAST_TIMEOUT_MS) {
+            getSchain()->rebroadcastAllMessagesForCurrentBlock();
+            lastRebroadCastTime = currentTime;
+        }
     }
 }
 
-void TimeoutAgent::join() {
-    CHECK_STATE( timeoutThreadPool );
-    timeoutThreadPool->joinAll();
+void TimeoutAgent::cancelTimer() {
+    getSchain()->getNode()->getConsensusEngine()->getTimerWheel()->cancel(timerId);
 }
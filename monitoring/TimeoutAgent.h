@@ -26,19 +26,22 @@
 
 class Schain;
 
-class TimeoutThreadPool;
 class LivelinessMonitor;
 
 class TimeoutAgent : public Agent  {
 
-    ptr< TimeoutThreadPool > timeoutThreadPool = nullptr;
+    uint64_t timerId = 0;
+
+    uint64_t lastRebroadCastTime = 0;
+
+    bool proposalReceiptTimedOut = false;
 
 public:
 
     explicit TimeoutAgent( Schain& _sChain );
 
-    static void timeoutLoop( TimeoutAgent* agent );
+    void checkTimeouts();
 
-    void join();
+    void cancelTimer();
 
 };
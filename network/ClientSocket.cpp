@@ -25,13 +25,14 @@
 #include "SkaleCommon.h"
 #include "exceptions/FatalError.h"
 
-#include "Sockets.h"
+#include "Transport.h"
 #include "chains/Schain.h"
 #include "thirdparty/json.hpp"
 
 #include "ClientSocket.h"
-#include "exceptions/ConnectionRefusedException.h"
 #include "node/NodeInfo.h"
+#include "threads/WorkStealingExecutor.h"
+#include "utils/Time.h"
 
 using namespace std;
 
@@ -57,30 +58,22 @@ network_port ClientSocket::getConnectionPort() {
     return remotePort;
 }
 
-int ClientSocket::createTCPSocket() {
-    int s;
-
-    if ( ( s = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP ) ) < 0 ) {
-        BOOST_THROW_EXCEPTION(
-            FatalError( "Could not create outgoing socket:" + string( strerror( errno ) ) ) );
-    }
-
-
-    // Init the connection
-    CHECK_STATE(remoteAddr)
-
-    if ( connect( s, ( sockaddr* ) remoteAddr.get(), sizeof( remoteAddr ) ) < 0 ) {
-        close( s );
-        BOOST_THROW_EXCEPTION( ConnectionRefusedException(
-            "Couldnt connect to:" + getConnectionIP() + ":" + to_string( getConnectionPort() ),
-            errno, __CLASS_NAME__ ) );
-    }
+uint64_t ClientSocket::getDeadlineMs() const {
+    return deadlineMs;
+}
 
-    return s;
+void ClientSocket::startRequest() {
+    deadlineMs = Time::getSteadyTimeMs() + CLIENT_REQUEST_TIMEOUT_MS;
 }
 
+void ClientSocket::shutdownSocket() {
+    LOCK( m )
+    if ( descriptor != 0 )
+        shutdown( ( int ) descriptor, SHUT_RDWR );
+}
 
-ClientSocket::ClientSocket( Schain& _sChain, schain_index _destinationIndex, port_type portType ) {
+ClientSocket::ClientSocket( Schain& _sChain, schain_index _destinationIndex, port_type portType )
+    : deadlineMs( Time::getSteadyTimeMs() + CLIENT_REQUEST_TIMEOUT_MS ) {
 
     if ( _sChain.getNode()->getNodeInfoByIndex( _destinationIndex ) == nullptr ) {
         BOOST_THROW_EXCEPTION( FatalError( "Could not find node with destination index " ) );
@@ -96,10 +89,10 @@ ClientSocket::ClientSocket( Schain& _sChain, schain_index _destinationIndex, por
 
     remotePort = ni->getPort() + portType;
 
-    this->remoteAddr = Sockets::createSocketAddress( remoteIP, ( uint16_t ) remotePort );
-    CHECK_STATE(remoteAddr)
-
-    descriptor = createTCPSocket();
+    {
+        WorkStealingExecutor::BlockingScope blocking;
+        descriptor = Transport::get().connect( remoteIP, ( uint16_t ) remotePort );
+    }
 
     CHECK_STATE( descriptor != 0 )
 
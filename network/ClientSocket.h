@@ -43,14 +43,12 @@ class ClientSocket {
 
     network_port remotePort = 0;
 
-    ptr<sockaddr_in> remoteAddr = nullptr;
+    // all IO of a request shares this deadline, see startRequest()
+    atomic< uint64_t > deadlineMs;
 
     void closeSocket();
 
 
-    int createTCPSocket();
-
-
 public:
 
     file_descriptor getDescriptor() ;
@@ -59,6 +57,15 @@ public:
 
     network_port getConnectionPort();
 
+    uint64_t getDeadlineMs() const;
+
+    // gives the next request on a socket that is kept open its own deadline
+    void startRequest();
+
+    // wakes up a request in flight on another thread, the descriptor is closed only when
+    // the socket is destroyed, so that it is not reused meanwhile
+    void shutdownSocket();
+
     static uint64_t getTotalSockets();
 
     virtual ~ClientSocket() {
@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file FaultInjectionNetwork.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "chains/Schain.h"
+#include "messages/NetworkMessage.h"
+#include "messages/NetworkMessageEnvelope.h"
+#include "node/Node.h"
+#include "node/NodeInfo.h"
+
+#include "Buffer.h"
+#include "FaultInjectionNetwork.h"
+
+
+FaultInjectionNetwork::FaultInjectionNetwork( Schain& _sChain, const ptr< Network >& _network,
+    uint64_t _catchupBlocks, uint32_t _packetLoss, uint64_t _writeDelayMs )
+    : Network( _sChain ),
+      network( _network ),
+      catchupBlocks( _catchupBlocks ),
+      packetLoss( _packetLoss ),
+      writeDelayMs( _writeDelayMs ),
+      random( ( uint64_t ) _sChain.getNode()->getNodeID() ) {
+    CHECK_ARGUMENT( _network );
+    CHECK_ARGUMENT( _packetLoss <= 100 );
+}
+
+
+bool FaultInjectionNetwork::sendMessage(
+    const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) {
+    CHECK_ARGUMENT( _remoteNodeInfo );
+    CHECK_ARGUMENT( _msg );
+
+    // dropped messages count as sent, so they do not go to delayed sends
+    if ( _msg->getBlockID() <= catchupBlocks )
+        return true;
+
+    if ( packetLoss > 0 ) {
+        LOCK( randomLock );
+        if ( random() % 100 < packetLoss )
+            return true;
+    }
+
+    if ( writeDelayMs > 0 )
+        usleep( 1000 * writeDelayMs );
+
+    return network->sendMessage( _remoteNodeInfo, _msg );
+}
+
+
+uint64_t FaultInjectionNetwork::readMessageFromNetwork( ptr< Buffer > _buf ) {
+    return network->readMessageFromNetwork( _buf );
+}
+
+
+ptr< NetworkMessageEnvelope > FaultInjectionNetwork::receiveMessage() {
+    auto m = Network::receiveMessage();
+
+    // the read loop reads again
+    if ( m && m->getMessage()->getBlockID() <= catchupBlocks )
+        return nullptr;
+
+    return m;
+}
+
+
+bool FaultInjectionNetwork::isConfigured( Schain& _sChain ) {
+    auto cfg = _sChain.getNode()->getCfg();
+
+    return cfg.find( "catchupBlocks" ) != cfg.end() || cfg.find( "packetLoss" ) != cfg.end() ||
+           _sChain.getNode()->getSimulateNetworkWriteDelayMs() > 0;
+}
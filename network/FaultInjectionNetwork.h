@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file FaultInjectionNetwork.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <random>
+
+#include "Network.h"
+
+class NodeInfo;
+class NetworkMessage;
+class NetworkMessageEnvelope;
+class Schain;
+
+
+// Wraps the network of a node with the fault injection of the node config: messages of the
+// first catchupBlocks blocks are neither sent nor received, so the node has to catch them
+// up, sends are delayed by simulateNetworkWriteDelayMs and packetLoss percent of them are
+// dropped. The wrapped network only moves bytes, the read loop, delayed sends and deferred
+// messages run on this one.
+
+class FaultInjectionNetwork : public Network {
+
+    ptr< Network > network;
+
+    uint64_t catchupBlocks = 0;
+
+    uint32_t packetLoss = 0;  // percent
+
+    uint64_t writeDelayMs = 0;
+
+    recursive_mutex randomLock;
+    mt19937_64 random;
+
+public:
+
+    FaultInjectionNetwork( Schain& _sChain, const ptr< Network >& _network,
+        uint64_t _catchupBlocks, uint32_t _packetLoss, uint64_t _writeDelayMs );
+
+    bool sendMessage(
+        const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) override;
+
+    uint64_t readMessageFromNetwork( ptr< Buffer > _buf ) override;
+
+    ptr< NetworkMessageEnvelope > receiveMessage() override;
+
+    // true if the node config asks for any of the faults
+    static bool isConfigured( Schain& _sChain );
+};
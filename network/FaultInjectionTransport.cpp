@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file FaultInjectionTransport.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "chains/Schain.h"
+#include "node/Node.h"
+
+#include "FaultInjectionNetwork.h"
+#include "StreamServerSocket.h"
+
+#include "FaultInjectionTransport.h"
+
+
+ptr< Network > FaultInjectionTransport::createNetwork( Schain& _sChain ) {
+    auto network = Transport::getSelected().createNetwork( _sChain );
+
+    // a replayed trace already has the faults of the run it was captured from
+    if ( Network::getTransport() == TransportType::REPLAY ||
+         !FaultInjectionNetwork::isConfigured( _sChain ) ) {
+        return network;
+    }
+
+    auto cfg = _sChain.getNode()->getCfg();
+
+    uint64_t catchupBlocks = 0;
+    uint32_t packetLoss = 0;
+
+    if ( cfg.find( "catchupBlocks" ) != cfg.end() ) {
+        catchupBlocks = cfg.at( "catchupBlocks" ).get< uint64_t >();
+    }
+
+    if ( cfg.find( "packetLoss" ) != cfg.end() ) {
+        packetLoss = cfg.at( "packetLoss" ).get< uint64_t >();
+        CHECK_STATE( packetLoss <= 100 );
+    }
+
+    return make_shared< FaultInjectionNetwork >( _sChain, network, catchupBlocks, packetLoss,
+        _sChain.getNode()->getSimulateNetworkWriteDelayMs() );
+}
+
+
+ptr< StreamServerSocket > FaultInjectionTransport::createServerSocket(
+    const string& _bindIP, uint16_t _basePort, port_type _portType ) {
+    return Transport::getSelected().createServerSocket( _bindIP, _basePort, _portType );
+}
+
+
+int FaultInjectionTransport::connect( const string& _ip, uint16_t _port ) {
+    return Transport::getSelected().connect( _ip, _port );
+}
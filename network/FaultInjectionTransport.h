@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file FaultInjectionTransport.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include "Transport.h"
+
+
+// Transport::get() returns this decorator when built with the test hooks. It forwards to the
+// selected transport and wraps the networks of nodes that are configured with faults in a
+// FaultInjectionNetwork, so the other networks carry no test code.
+//
+// The simulated write delays of the request/response channel stay in IO and the server
+// agents: that channel is plain descriptors that IO and the epoll loop write to directly.
+
+class FaultInjectionTransport : public Transport {
+
+public:
+
+    ptr< Network > createNetwork( Schain& _sChain ) override;
+
+    ptr< StreamServerSocket > createServerSocket(
+        const string& _bindIP, uint16_t _basePort, port_type _portType ) override;
+
+    int connect( const string& _ip, uint16_t _port ) override;
+};
@@ -40,128 +40,186 @@
 #include "exceptions/ExitRequestedException.h"
 #include "chains/Schain.h"
 #include "Buffer.h"
-#include "ServerConnection.h"
+#include "threads/WorkStealingExecutor.h"
+#include "utils/Time.h"
 #include "IO.h"
 
-using namespace std;
+#include <poll.h>
 
-void IO::readBytes(const ptr<ServerConnection>& _env, const ptr<vector<uint8_t>>& _buffer, msg_len len) {
-    CHECK_ARGUMENT( _env );
-    CHECK_ARGUMENT(_buffer);
-    return readBytes( _env->getDescriptor(), _buffer, len);
-}
+using namespace std;
 
-void IO::readBuf(file_descriptor descriptor, const ptr<Buffer>& _buf, msg_len len) {
+void IO::readBuf(file_descriptor descriptor, const ptr<Buffer>& _buf, msg_len len, uint64_t _deadlineMs) {
     CHECK_ARGUMENT(_buf);
     CHECK_ARGUMENT(len > 0);
     CHECK_ARGUMENT( _buf->getSize() >= len);
-    return readBytes(descriptor, _buf->getBuf(), len);
+    return readBytes(descriptor, _buf->getBuf(), len, _deadlineMs);
 }
 
 
-void IO::readBytes(file_descriptor _descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len _len) {
-    // fd_set read_set;
-    // struct timeval timeout;
+uint64_t IO::getDeadlineMs(uint64_t _deadlineMs) {
+    if (_deadlineMs != 0)
+        return _deadlineMs;
+    return Time::getSteadyTimeMs() + IO_TIMEOUT_MS;
+}
 
-    CHECK_ARGUMENT(_buffer)
-    CHECK_ARGUMENT(_len > 0)
-    CHECK_ARGUMENT(_buffer->size() >= _len)
 
-    int64_t bytesRead = 0;
+void IO::waitForSocket(file_descriptor _descriptor, short _events, uint64_t _deadlineMs) {
 
-    int64_t result;
+    // another executor worker may run while this one waits for the peer
+    WorkStealingExecutor::BlockingScope blocking;
 
+    while (true) {
+        auto now = Time::getSteadyTimeMs();
 
-    struct timeval tv;
-    tv.tv_sec = 3;
-    tv.tv_usec = 0;
-    setsockopt(int(_descriptor), SOL_SOCKET, SO_RCVTIMEO, (const char *) &tv, sizeof tv);
+        if (now >= _deadlineMs) {
+            BOOST_THROW_EXCEPTION(NetworkProtocolException(
+                    (_events & POLLIN) ? "Peer read timeout" : "Peer write timeout", __CLASS_NAME__));
+        }
 
-    while (msg_len(bytesRead) < _len) {
-        if (sChain->getNode()->isExitRequested())
-            BOOST_THROW_EXCEPTION(ExitRequestedException(__CLASS_NAME__));
+        struct pollfd pfd;
+        pfd.fd = (int) _descriptor;
+        pfd.events = _events;
+        pfd.revents = 0;
 
-        uint64_t counter = 1;
+        auto result = poll(&pfd, 1, (int) min<uint64_t>(_deadlineMs - now, INT32_MAX));
 
-        do {
+        if (result > 0)
+            return; // errors and hangups are reported by the following recv/send
 
-            result = recv(int(_descriptor), _buffer->data() + bytesRead, uint64_t(_len) - bytesRead, 0);
+        if (result < 0 && errno != EINTR) {
+            BOOST_THROW_EXCEPTION(
+                    NetworkProtocolException("Poll returned error:" + string(strerror(errno)), __CLASS_NAME__));
+        }
+    }
+}
 
-            if (sChain->getNode()->isExitRequested())
-                BOOST_THROW_EXCEPTION(ExitRequestedException(__CLASS_NAME__));
-            if (result == 0) {
-                usleep(10); // dont do busy wait
-            };
-            counter++;
 
-            if (counter > 1000) {
-                BOOST_THROW_EXCEPTION(NetworkProtocolException("Peer read timeout", __CLASS_NAME__));
-            }
+void IO::receive(file_descriptor _descriptor, uint8_t* _data, uint64_t _len, uint64_t _deadlineMs) {
+    CHECK_ARGUMENT(_data);
 
+    uint64_t bytesRead = 0;
 
-        } while (result < 0 && errno == EAGAIN);
+    while (bytesRead < _len) {
+        auto result = recv(int(_descriptor), _data + bytesRead, _len - bytesRead, MSG_DONTWAIT);
 
-        if (result < 0) {
-            BOOST_THROW_EXCEPTION(
-                    NetworkProtocolException("Read returned error:" + string(strerror(errno)), __CLASS_NAME__));
+        if (result > 0) {
+            bytesRead += result;
+            continue;
         }
 
         if (result == 0) {
             BOOST_THROW_EXCEPTION(NetworkProtocolException("The peer shut down the socket, bytes to read:" +
-                                                           to_string(uint64_t(_len) - bytesRead), __CLASS_NAME__));
+                                                           to_string(_len - bytesRead), __CLASS_NAME__));
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            waitForSocket(_descriptor, POLLIN, _deadlineMs);
+        } else if (errno != EINTR) {
+            BOOST_THROW_EXCEPTION(
+                    NetworkProtocolException("Read returned error:" + string(strerror(errno)), __CLASS_NAME__));
+        }
+    }
+}
+
+
+void IO::sendVectors(file_descriptor _descriptor, vector<iovec>& _vectors, uint64_t _deadlineMs) {
+
+    uint64_t first = 0;
+
+    while (first < _vectors.size()) {
+
+        struct msghdr message = {};
+        message.msg_iov = _vectors.data() + first;
+        message.msg_iovlen = min<uint64_t>(_vectors.size() - first, IOV_MAX);
+
+        auto result = sendmsg((int) _descriptor, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitForSocket(_descriptor, POLLOUT, _deadlineMs);
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            BOOST_THROW_EXCEPTION(IOException("Could not write bytes", errno, __CLASS_NAME__));
         }
 
-        bytesRead += result;
+        uint64_t written = result;
+
+        while (written > 0) {
+            auto& vec = _vectors[first];
+            if (written < vec.iov_len) {
+                vec.iov_base = (uint8_t*) vec.iov_base + written;
+                vec.iov_len -= written;
+                break;
+            }
+            written -= vec.iov_len;
+            first++;
+        }
 
-        // LOG(trace, "IO bytes read:" + to_string( bytesRead ) );
+        // skip empty vectors
+        while (first < _vectors.size() && _vectors[first].iov_len == 0)
+            first++;
     }
+}
 
-    CHECK_STATE(bytesRead == (int64_t )(uint64_t ) _len);
 
+void IO::simulateWriteDelay() {
+    if constexpr (TEST_HOOKS_ENABLED) {
+        auto delayMs = sChain->getNode()->getSimulateNetworkWriteDelayMs();
+        if (delayMs > 0)
+            usleep(delayMs * 1000);
+    }
 }
 
 
-void IO::writeBytes(file_descriptor descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len len) {
+void IO::checkForExit() {
+    if (sChain->getNode()->isExitRequested())
+        BOOST_THROW_EXCEPTION(ExitRequestedException(__CLASS_NAME__));
+}
 
-    CHECK_ARGUMENT(_buffer);
-    CHECK_ARGUMENT(!_buffer->empty());
-    CHECK_ARGUMENT(len <= _buffer->size())
-    CHECK_ARGUMENT(len > 0);
-    CHECK_ARGUMENT(descriptor != 0);
 
+void IO::readBytes(file_descriptor _descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len _len,
+                   uint64_t _deadlineMs) {
 
-    usleep(sChain->getNode()->getSimulateNetworkWriteDelayMs() * 1000);
+    CHECK_ARGUMENT(_buffer)
+    CHECK_ARGUMENT(_len > 0)
+    CHECK_ARGUMENT(_buffer->size() >= _len)
 
+    checkForExit();
 
-    //    setsockopt( int( descriptor ), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( int ) );
+    receive(_descriptor, _buffer->data(), (uint64_t) _len, getDeadlineMs(_deadlineMs));
 
-    uint64_t bytesWritten = 0;
+    checkForExit();
+}
 
-    while (msg_len(bytesWritten) < len) {
-        int64_t result =
-                write((int) descriptor, _buffer->data() + bytesWritten, (uint64_t) len - bytesWritten);
-        if (sChain->getNode()->isExitRequested())
-            BOOST_THROW_EXCEPTION(ExitRequestedException(__CLASS_NAME__));
 
-        CHECK_STATE(result != 0);
+void IO::writeBytes(file_descriptor descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len len,
+                    uint64_t _deadlineMs) {
 
-        if (result < 1) {
-            BOOST_THROW_EXCEPTION(IOException("Could not write bytes", errno, __CLASS_NAME__));
-        }
+    CHECK_ARGUMENT(_buffer);
+    CHECK_ARGUMENT(!_buffer->empty());
+    CHECK_ARGUMENT(len <= _buffer->size())
+    CHECK_ARGUMENT(len > 0);
+    CHECK_ARGUMENT(descriptor != 0);
 
-        bytesWritten += result;
-    }
+    simulateWriteDelay();
+
+    checkForExit();
 
-    CHECK_STATE(bytesWritten == len);
+    vector<iovec> vectors = {{_buffer->data(), (uint64_t) len}};
 
+    sendVectors(descriptor, vectors, getDeadlineMs(_deadlineMs));
+
+    checkForExit();
 }
 
 
 
-void IO::writeBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf ) {
+void IO::writeBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf, uint64_t _deadlineMs) {
     CHECK_ARGUMENT( _buf);
     CHECK_ARGUMENT( _buf->getBuf());
-    writeBytes( _descriptor, _buf->getBuf(), msg_len( _buf->getCounter()));
+    writeBytes( _descriptor, _buf->getBuf(), msg_len( _buf->getCounter()), _deadlineMs);
 }
 
 void IO::writeMagic(const ptr<ClientSocket>& _socket, bool _isPing) {
@@ -180,13 +238,7 @@ void IO::writeMagic(const ptr<ClientSocket>& _socket, bool _isPing) {
 
     memcpy(buf->data(), &magic, sizeof(magic));
 
-    try {
-        writeBytesVector(_socket->getDescriptor(), buf);
-    } catch (ExitRequestedException &) { throw; }
-
-    catch (...) {
-        throw;
-    }
+    writeBytesVector(_socket->getDescriptor(), buf, _socket->getDeadlineMs());
 }
 
 
@@ -194,11 +246,54 @@ void IO::writeHeader(const ptr<ClientSocket>& _socket, const ptr<Header>& _heade
     CHECK_ARGUMENT(_socket);
     CHECK_ARGUMENT(_header);
     CHECK_ARGUMENT(_header->isComplete());
-    writeBuf(_socket->getDescriptor(), _header->toBuffer());
+    writeBuf(_socket->getDescriptor(), _header->toBuffer(), _socket->getDeadlineMs());
+}
+
+void IO::writeMagicAndHeader(const ptr<ClientSocket>& _socket, const ptr<Header>& _header) {
+    CHECK_ARGUMENT(_socket);
+    CHECK_ARGUMENT(_header);
+    CHECK_ARGUMENT(_header->isComplete());
+
+    uint64_t magic = MAGIC_NUMBER;
+
+    auto buf = _header->toBuffer();
+
+    simulateWriteDelay();
+
+    checkForExit();
+
+    vector<iovec> vectors = {{&magic, sizeof(magic)},
+                             {buf->getBuf()->data(), buf->getCounter()}};
+
+    sendVectors(_socket->getDescriptor(), vectors, _socket->getDeadlineMs());
+
+    checkForExit();
+}
+
+void IO::writeHeaderAndBytes(const ptr<ClientSocket>& _socket, const ptr<Header>& _header,
+                             const ptr<vector<uint8_t>>& _bytes) {
+    CHECK_ARGUMENT(_socket);
+    CHECK_ARGUMENT(_header);
+    CHECK_ARGUMENT(_header->isComplete());
+    CHECK_ARGUMENT(_bytes);
+
+    auto buf = _header->toBuffer();
+
+    simulateWriteDelay();
+
+    checkForExit();
+
+    vector<iovec> vectors = {{buf->getBuf()->data(), buf->getCounter()},
+                             {_bytes->data(), _bytes->size()}};
+
+    sendVectors(_socket->getDescriptor(), vectors, _socket->getDeadlineMs());
+
+    checkForExit();
 }
 
-void IO::writeBytesVector(file_descriptor _socket, const ptr<vector<uint8_t> >& _bytes ) {
-    writeBytes( _socket, _bytes, msg_len( _bytes->size()));
+void IO::writeBytesVector(file_descriptor _socket, const ptr<vector<uint8_t> >& _bytes,
+                          uint64_t _deadlineMs) {
+    writeBytes( _socket, _bytes, msg_len( _bytes->size()), _deadlineMs);
 }
 
 void IO::writePartialHashes(
@@ -223,14 +318,14 @@ IO::IO(Schain *_sChain) : sChain(_sChain) {
 };
 
 
-void IO::readMagic(file_descriptor descriptor) {
+void IO::readMagic(file_descriptor descriptor, uint64_t _deadlineMs) {
 
     uint64_t magic;
 
     auto readBuffer = make_shared<vector<uint8_t>>(sizeof(magic));
 
     try {
-        readBytes(descriptor, readBuffer, sizeof(magic));
+        readBytes(descriptor, readBuffer, sizeof(magic), _deadlineMs);
     } catch (ExitRequestedException &) { throw; }
     catch (...) {
         throw_with_nested(NetworkProtocolException("Could not read magic number", __CLASS_NAME__));
@@ -249,16 +344,19 @@ void IO::readMagic(file_descriptor descriptor) {
 }
 
 nlohmann::json IO::readJsonHeader(file_descriptor descriptor, const char *_errorString,
-    uint64_t _maxHeaderLen) {
+    uint64_t _maxHeaderLen, uint64_t _deadlineMs) {
 
     CHECK_ARGUMENT(_errorString);
 
+    // the length and the header share the deadline
+    _deadlineMs = getDeadlineMs(_deadlineMs);
+
     auto buf2 = make_shared<vector<uint8_t>>(sizeof(uint64_t));
 
     try {
         readBytes(descriptor,
                   buf2,
-                  msg_len(sizeof(uint64_t)));
+                  msg_len(sizeof(uint64_t)), _deadlineMs);
     } catch (ExitRequestedException &) { throw; }
     catch (...) {
         throw_with_nested(NetworkProtocolException(_errorString + string(":Could not read header len"), __CLASS_NAME__));
@@ -276,9 +374,7 @@ nlohmann::json IO::readJsonHeader(file_descriptor descriptor, const char *_error
     ptr<Buffer> buf = make_shared<Buffer>(headerLen);
 
     try {
-        sChain->getIo()->
-                readBuf(descriptor, buf,
-                        msg_len(headerLen));
+        readBuf(descriptor, buf, msg_len(headerLen), _deadlineMs);
     } catch (ExitRequestedException &) { throw; }
     catch (...) {
         throw_with_nested(
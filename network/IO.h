@@ -23,48 +23,69 @@
 
 #pragma once
 
+#include <sys/uio.h>
+
 
 class Buffer;
-class ServerConnection;
 class Header;
 class Buffer;
 class ClientSocket;
 class Schain;
 
+// Blocking socket IO used by the clients. Every call has an absolute deadline on the steady
+// clock, 0 means IO_TIMEOUT_MS from now. The thread sleeps in poll() until the socket is ready.
+
 class IO {
 
     Schain *sChain = nullptr;
 
+    void checkForExit();
+
+    void simulateWriteDelay();
+
 public:
 
     IO(Schain *_sChain);
 
-    void readBytes(const ptr<ServerConnection>& _env, const ptr<vector<uint8_t>>& _buffer, msg_len _len);
+    static uint64_t getDeadlineMs(uint64_t _deadlineMs);
 
-    void readBytes(file_descriptor _descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len _len);
+    // waits until the socket is ready for _events, throws on timeout
+    static void waitForSocket(file_descriptor _descriptor, short _events, uint64_t _deadlineMs);
 
-    void readBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf, msg_len _len);
+    static void receive(file_descriptor _descriptor, uint8_t* _data, uint64_t _len, uint64_t _deadlineMs);
 
-    void writeBytes(file_descriptor descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len len);
+    // gather write, _vectors are consumed
+    static void sendVectors(file_descriptor _descriptor, vector<iovec>& _vectors, uint64_t _deadlineMs);
 
-    void writeBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf);
+    void readBytes(file_descriptor _descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len _len,
+        uint64_t _deadlineMs = 0);
 
-    void writeHeader(const ptr<ClientSocket>& _socket, const ptr<Header>& _header);
+    void readBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf, msg_len _len,
+        uint64_t _deadlineMs = 0);
 
-    void writeMagic(const ptr<ClientSocket>& _socket, bool _isPing = false);
+    void writeBytes(file_descriptor descriptor, const ptr<vector<uint8_t>>& _buffer, msg_len len,
+        uint64_t _deadlineMs = 0);
 
-    void writeBytesVector(file_descriptor _socket, const ptr<vector<uint8_t>>& _bytes );
+    void writeBuf(file_descriptor _descriptor, const ptr<Buffer>& _buf, uint64_t _deadlineMs = 0);
 
-    void writePartialHashes(file_descriptor _socket, const ptr<map<uint64_t, ptr<partial_sha_hash>>>& _hashes );
+    void writeHeader(const ptr<ClientSocket>& _socket, const ptr<Header>& _header);
 
-    void readMagic(file_descriptor descriptor);
+    // magic number and request header in one write
+    void writeMagicAndHeader(const ptr<ClientSocket>& _socket, const ptr<Header>& _header);
 
-    nlohmann::json readJsonHeader(file_descriptor descriptor, const char* _errorString,
-        uint64_t _maxHeaderLen = MAX_HEADER_SIZE);
+    void writeHeaderAndBytes(const ptr<ClientSocket>& _socket, const ptr<Header>& _header,
+        const ptr<vector<uint8_t>>& _bytes);
 
-};
+    void writeMagic(const ptr<ClientSocket>& _socket, bool _isPing = false);
 
+    void writeBytesVector(file_descriptor _socket, const ptr<vector<uint8_t>>& _bytes,
+        uint64_t _deadlineMs = 0);
 
+    void writePartialHashes(file_descriptor _socket, const ptr<map<uint64_t, ptr<partial_sha_hash>>>& _hashes );
 
+    void readMagic(file_descriptor descriptor, uint64_t _deadlineMs = 0);
 
+    nlohmann::json readJsonHeader(file_descriptor descriptor, const char* _errorString,
+        uint64_t _maxHeaderLen = MAX_HEADER_SIZE, uint64_t _deadlineMs = 0);
 
+};
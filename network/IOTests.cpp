@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file IOTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "utils/Time.h"
+
+#include "IO.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t IO_TEST_ROUNDS = 1000;
+static constexpr uint64_t IO_TEST_NAGLE_ROUNDS = 50;  // each round waits for a delayed ack
+static constexpr uint64_t IO_TEST_HEADER_SIZE = 256;
+static constexpr uint64_t IO_TEST_RESPONSE_SIZE = 1024;
+static constexpr uint64_t IO_TEST_MAX_P99_US = 50000;
+static constexpr uint64_t IO_TEST_READ_TIMEOUT_MS = 200;
+
+
+static pair< int, int > loopbackPair( bool _noDelay ) {
+    int listenDescriptor = socket( AF_INET, SOCK_STREAM, 0 );
+    CHECK_STATE( listenDescriptor > 0 );
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    CHECK_STATE( ::bind( listenDescriptor, ( sockaddr* ) &address, sizeof( address ) ) == 0 );
+    CHECK_STATE( listen( listenDescriptor, 1 ) == 0 );
+
+    socklen_t len = sizeof( address );
+    CHECK_STATE( getsockname( listenDescriptor, ( sockaddr* ) &address, &len ) == 0 );
+
+    int client = socket( AF_INET, SOCK_STREAM, 0 );
+    CHECK_STATE( connect( client, ( sockaddr* ) &address, sizeof( address ) ) == 0 );
+
+    int server = accept( listenDescriptor, nullptr, nullptr );
+    CHECK_STATE( server > 0 );
+
+    close( listenDescriptor );
+
+    int flag = _noDelay ? 1 : 0;
+    setsockopt( client, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+    setsockopt( server, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof( flag ) );
+
+    return { client, server };
+}
+
+
+// request: length prefix and header written by the client, response: fixed size body
+static vector< uint64_t > measureRoundTrips( bool _noDelay, bool _gather, uint64_t _rounds ) {
+    auto sockets = loopbackPair( _noDelay );
+
+    thread server( [&sockets, _rounds]() {
+        vector< uint8_t > request( IO_TEST_HEADER_SIZE );
+        vector< uint8_t > response( IO_TEST_RESPONSE_SIZE, 'r' );
+
+        for ( uint64_t i = 0; i < _rounds; i++ ) {
+            uint64_t len;
+            auto deadline = IO::getDeadlineMs( 0 );
+            IO::receive( sockets.second, ( uint8_t* ) &len, sizeof( len ), deadline );
+            CHECK_STATE( len == IO_TEST_HEADER_SIZE );
+            IO::receive( sockets.second, request.data(), len, deadline );
+            vector< iovec > vectors = { { response.data(), response.size() } };
+            IO::sendVectors( sockets.second, vectors, deadline );
+        }
+    } );
+
+    vector< uint8_t > header( IO_TEST_HEADER_SIZE, 'h' );
+    vector< uint8_t > response( IO_TEST_RESPONSE_SIZE );
+    vector< uint64_t > latencies;
+
+    for ( uint64_t i = 0; i < _rounds; i++ ) {
+        uint64_t len = header.size();
+        auto deadline = IO::getDeadlineMs( 0 );
+
+        auto begin = chrono::steady_clock::now();
+
+        if ( _gather ) {
+            vector< iovec > vectors = { { &len, sizeof( len ) }, { header.data(), header.size() } };
+            IO::sendVectors( sockets.first, vectors, deadline );
+        } else {
+            vector< iovec > first = { { &len, sizeof( len ) } };
+            IO::sendVectors( sockets.first, first, deadline );
+            vector< iovec > second = { { header.data(), header.size() } };
+            IO::sendVectors( sockets.first, second, deadline );
+        }
+
+        IO::receive( sockets.first, response.data(), response.size(), deadline );
+
+        latencies.push_back( chrono::duration_cast< chrono::microseconds >(
+            chrono::steady_clock::now() - begin )
+                                 .count() );
+    }
+
+    server.join();
+
+    close( sockets.first );
+    close( sockets.second );
+
+    sort( latencies.begin(), latencies.end() );
+
+    return latencies;
+}
+
+
+TEST_CASE( "Loopback request latency", "[io-latency]" ) {
+    auto separateWrites = measureRoundTrips( false, false, IO_TEST_NAGLE_ROUNDS );
+    auto gatherWrites = measureRoundTrips( true, true, IO_TEST_ROUNDS );
+
+    auto p50 = []( const vector< uint64_t >& _l ) { return _l[_l.size() / 2]; };
+    auto p99 = []( const vector< uint64_t >& _l ) { return _l[_l.size() * 99 / 100]; };
+
+    cerr << "Nagle, separate writes: p50 us:" << p50( separateWrites )
+         << ":p99 us:" << p99( separateWrites ) << endl;
+    cerr << "TCP_NODELAY, gather write: p50 us:" << p50( gatherWrites )
+         << ":p99 us:" << p99( gatherWrites ) << endl;
+
+    REQUIRE( p99( gatherWrites ) < IO_TEST_MAX_P99_US );
+}
+
+
+TEST_CASE( "Read deadline does not busy wait", "[io-latency]" ) {
+    int sockets[2];
+    REQUIRE( socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) == 0 );
+
+    struct rusage before, after;
+    getrusage( RUSAGE_THREAD, &before );
+
+    auto begin = Time::getSteadyTimeMs();
+
+    uint8_t byte;
+
+    REQUIRE_THROWS( IO::receive(
+        sockets[0], &byte, 1, Time::getSteadyTimeMs() + IO_TEST_READ_TIMEOUT_MS ) );
+
+    auto elapsed = Time::getSteadyTimeMs() - begin;
+
+    getrusage( RUSAGE_THREAD, &after );
+
+    auto cpuUs = ( after.ru_utime.tv_sec - before.ru_utime.tv_sec ) * 1000000 +
+                 ( after.ru_utime.tv_usec - before.ru_utime.tv_usec ) +
+                 ( after.ru_stime.tv_sec - before.ru_stime.tv_sec ) * 1000000 +
+                 ( after.ru_stime.tv_usec - before.ru_stime.tv_usec );
+
+    REQUIRE( elapsed >= IO_TEST_READ_TIMEOUT_MS );
+    REQUIRE( elapsed < 2 * IO_TEST_READ_TIMEOUT_MS );
+    // the thread sleeps in poll
+    REQUIRE( cpuUs < IO_TEST_READ_TIMEOUT_MS * 100 );
+
+    // a peer that closes the socket is reported at once
+    close( sockets[1] );
+    REQUIRE_THROWS( IO::receive( sockets[0], &byte, 1, IO::getDeadlineMs( 0 ) ) );
+    REQUIRE( Time::getSteadyTimeMs() - begin < 2 * IO_TEST_READ_TIMEOUT_MS );
+
+    close( sockets[0] );
+}
@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file InProcessNetwork.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "Log.h"
+#include "SkaleCommon.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+#include "exceptions/NetworkProtocolException.h"
+
+#include "chains/Schain.h"
+#include "messages/NetworkMessage.h"
+#include "monitoring/StageMetrics.h"
+#include "node/Node.h"
+#include "node/NodeInfo.h"
+#include "utils/Time.h"
+
+#include "InProcessNetwork.h"
+
+
+// how often a waiting reader checks for exit
+static constexpr uint64_t IN_PROCESS_READ_POLL_US = 100000;
+
+
+mutex InProcessNetwork::registryLock;
+map< uint64_t, InProcessNetwork* > InProcessNetwork::registry;
+
+mutex InProcessNetwork::profilesLock;
+InProcessNetwork::LinkProfile InProcessNetwork::defaultProfile;
+map< pair< uint64_t, uint64_t >, InProcessNetwork::LinkProfile > InProcessNetwork::profiles;
+uint64_t InProcessNetwork::seed = 1;
+
+
+void InProcessNetwork::setDefaultLinkProfile( const LinkProfile& _profile ) {
+    lock_guard< mutex > lock( profilesLock );
+    defaultProfile = _profile;
+}
+
+
+void InProcessNetwork::setLinkProfile(
+    schain_index _src, schain_index _dst, const LinkProfile& _profile ) {
+    CHECK_ARGUMENT( _src > 0 && _dst > 0 );
+    lock_guard< mutex > lock( profilesLock );
+    profiles[{ ( uint64_t ) _src, ( uint64_t ) _dst }] = _profile;
+}
+
+
+void InProcessNetwork::clearLinkProfiles() {
+    lock_guard< mutex > lock( profilesLock );
+    defaultProfile = LinkProfile();
+    profiles.clear();
+}
+
+
+void InProcessNetwork::setSeed( uint64_t _seed ) {
+    lock_guard< mutex > lock( profilesLock );
+    seed = _seed;
+}
+
+
+InProcessNetwork::InProcessNetwork( Schain& _sChain )
+    : Network( _sChain ),
+      nodeID( ( uint64_t ) _sChain.getNode()->getNodeID() ),
+      links( ( uint64_t ) _sChain.getNodeCount() ) {
+    auto src = ( uint64_t ) _sChain.getSchainIndex();
+
+    {
+        lock_guard< mutex > lock( profilesLock );
+
+        for ( uint64_t i = 0; i < links.size(); i++ ) {
+            auto dst = i + 1;
+            auto& link = links[i];
+
+            auto profile = profiles.find( { src, dst } );
+            link.profile = ( profile != profiles.end() ) ? profile->second : defaultProfile;
+
+            seed_seq linkSeed{ seed, src, dst };
+            link.random.seed( linkSeed );
+        }
+    }
+
+    lock_guard< mutex > lock( registryLock );
+    CHECK_STATE2( registry.count( nodeID ) == 0,
+        "In process network already exists for node " + to_string( nodeID ) );
+    registry[nodeID] = this;
+}
+
+
+InProcessNetwork::~InProcessNetwork() {
+    lock_guard< mutex > lock( registryLock );
+    registry.erase( nodeID );
+}
+
+
+void InProcessNetwork::deliver( const ptr< string >& _data, uint64_t _deliverAtUs ) {
+    {
+        lock_guard< mutex > lock( inboxLock );
+        inbox.push( { _deliverAtUs, inboxSequence++, _data } );
+    }
+    inboxCond.notify_one();
+}
+
+
+bool InProcessNetwork::sendMessage(
+    const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) {
+    CHECK_ARGUMENT( _remoteNodeInfo );
+    CHECK_ARGUMENT( _msg );
+
+    auto data = make_shared< string >( _msg->serializeToString() );
+
+    auto dst = ( uint64_t ) _remoteNodeInfo->getSchainIndex();
+    CHECK_STATE( dst > 0 && dst <= links.size() );
+    auto& link = links[dst - 1];
+
+    uint64_t deliverAtUs;
+
+    {
+        lock_guard< mutex > lock( link.m );
+
+        if ( link.profile.lossPpm > 0 && link.random() % 1000000 < link.profile.lossPpm ) {
+            // lost on the way, for the sender the message went out
+            return true;
+        }
+
+        auto now = Time::getSteadyTimeUs();
+        auto leaveAtUs = max( now, link.busyUntilUs );
+
+        if ( link.profile.bandwidthBytesPerSec > 0 ) {
+            leaveAtUs += data->size() * 1000000 / link.profile.bandwidthBytesPerSec;
+        }
+
+        link.busyUntilUs = leaveAtUs;
+
+        deliverAtUs = leaveAtUs + link.profile.latencyUs;
+
+        if ( link.profile.jitterUs > 0 ) {
+            deliverAtUs += link.random() % ( link.profile.jitterUs + 1 );
+        }
+    }
+
+    {
+        lock_guard< mutex > lock( registryLock );
+
+        auto receiver = registry.find( ( uint64_t ) _remoteNodeInfo->getNodeID() );
+
+        // the receiving node did not start yet, the message goes to delayed sends
+        if ( receiver == registry.end() )
+            return false;
+
+        receiver->second->deliver( data, deliverAtUs );
+    }
+
+    sChain->getStageMetrics()->messageSent( _remoteNodeInfo->getSchainIndex(), data->size() );
+
+    return true;
+}
+
+
+uint64_t InProcessNetwork::readMessageFromNetwork( ptr< Buffer > _buf ) {
+    CHECK_ARGUMENT( _buf );
+
+    unique_lock< mutex > lock( inboxLock );
+
+    while ( true ) {
+        if ( getNode()->isExitRequested() ) {
+            BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+        }
+
+        auto waitUs = IN_PROCESS_READ_POLL_US;
+
+        if ( !inbox.empty() ) {
+            auto now = Time::getSteadyTimeUs();
+            auto& head = inbox.top();
+
+            if ( head.deliverAtUs <= now ) {
+                auto data = head.data;
+                inbox.pop();
+
+                if ( data->size() >= MAX_CONSENSUS_MESSAGE_LEN ) {
+                    BOOST_THROW_EXCEPTION( NetworkProtocolException(
+                        "Consensus Message length too large:" + to_string( data->size() ),
+                        __CLASS_NAME__ ) );
+                }
+
+                memcpy( _buf->getBuf()->data(), data->data(), data->size() );
+                return data->size();
+            }
+
+            waitUs = min( waitUs, head.deliverAtUs - now );
+        }
+
+        inboxCond.wait_for( lock, chrono::microseconds( waitUs ) );
+    }
+}
@@ -0,0 +1,119 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file InProcessNetwork.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#pragma once
+
+#include <random>
+
+#include "Buffer.h"
+#include "Network.h"
+
+class NodeInfo;
+class NetworkMessage;
+class Schain;
+
+
+// Consensus messages between nodes that run in one process, passed through memory.
+//
+// Every link from one schain index to another can add latency, jitter, loss and a bandwidth
+// limit. Link randomness comes from a seed, so a run can be repeated with the same link
+// behavior. Proposals, finalization and catchup go over the request/response channel of the
+// transport and are not shaped.
+
+class InProcessNetwork : public Network {
+
+public:
+
+    class LinkProfile {
+    public:
+        uint64_t latencyUs = 0;
+        uint64_t jitterUs = 0;
+        // messages lost per million
+        uint64_t lossPpm = 0;
+        // 0 means unlimited
+        uint64_t bandwidthBytesPerSec = 0;
+    };
+
+private:
+
+    class Delivery {
+    public:
+        uint64_t deliverAtUs;
+        uint64_t sequence;
+        ptr< string > data;
+
+        bool operator>( const Delivery& _other ) const {
+            return deliverAtUs > _other.deliverAtUs ||
+                   ( deliverAtUs == _other.deliverAtUs && sequence > _other.sequence );
+        }
+    };
+
+    class Link {
+    public:
+        mutex m;
+        LinkProfile profile;
+        mt19937_64 random;
+        // time the previous message leaves the sender, used for the bandwidth limit
+        uint64_t busyUntilUs = 0;
+    };
+
+    static mutex registryLock;
+    static map< uint64_t, InProcessNetwork* > registry;  // by node id
+
+    static mutex profilesLock;
+    static LinkProfile defaultProfile;
+    static map< pair< uint64_t, uint64_t >, LinkProfile > profiles;  // by schain indices
+    static uint64_t seed;
+
+    const uint64_t nodeID;
+
+    // links to other nodes by schain index - 1
+    vector< Link > links;
+
+    mutex inboxLock;
+    condition_variable inboxCond;
+    priority_queue< Delivery, vector< Delivery >, greater< Delivery > > inbox;
+    uint64_t inboxSequence = 0;
+
+    void deliver( const ptr< string >& _data, uint64_t _deliverAtUs );
+
+public:
+
+    static void setDefaultLinkProfile( const LinkProfile& _profile );
+
+    static void setLinkProfile(
+        schain_index _src, schain_index _dst, const LinkProfile& _profile );
+
+    static void clearLinkProfiles();
+
+    static void setSeed( uint64_t _seed );
+
+    explicit InProcessNetwork( Schain& _sChain );
+
+    ~InProcessNetwork() override;
+
+    bool sendMessage(
+        const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) override;
+
+    uint64_t readMessageFromNetwork( ptr< Buffer > _buf ) override;
+};
@@ -26,12 +26,15 @@
 #include "SkaleCommon.h"
 #include "blockproposal/pusher/BlockProposalClientAgent.h"
 #include "chains/Schain.h"
+#include "catchup/client/CatchupClientAgent.h"
 #include "crypto/BLAKE3Hash.h"
 #include "crypto/ConsensusBLSSigShare.h"
 #include "datastructures/BlockProposal.h"
 #include "db/BlockProposalDB.h"
 #include "exceptions/FatalError.h"
 #include "messages/NetworkMessage.h"
+#include "monitoring/MessageTrace.h"
+#include "monitoring/StageMetrics.h"
 #include "node/Node.h"
 #include "node/NodeInfo.h"
 #include "protocols/blockconsensus/BlockSignBroadcastMessage.h"
@@ -51,6 +54,9 @@
 #include "network/Sockets.h"
 #include "network/ZMQSockets.h"
 #include "threads/GlobalThreadRegistry.h"
+#include "threads/QueueMetrics.h"
+#include "threads/TimerWheel.h"
+#include "utils/Time.h"
 
 TransportType Network::transport = TransportType::ZMQ;
 
@@ -76,6 +82,7 @@ void Network::addToDeferredMessageQueue( const ptr< NetworkMessageEnvelope >& _m
         };
 
         messageList->push_back( _me );
+        deferredMessageMetrics->pushed();
     }
 }
 
@@ -84,6 +91,8 @@ ptr< vector< ptr< NetworkMessageEnvelope > > > Network::pullMessagesForCurrentBl
 
     auto returnList = make_shared< vector< ptr< NetworkMessageEnvelope > > >();
 
+    auto nowMs = Time::getCurrentTimeMs();
+
     LOCK( deferredMessageMutex );
 
     for ( auto it = deferredMessageQueue.cbegin();
@@ -92,6 +101,8 @@ ptr< vector< ptr< NetworkMessageEnvelope > > > Network::pullMessagesForCurrentBl
         if ( it->first <= currentBlockID ) {
             for ( auto&& msg : *( it->second ) ) {
                 returnList->push_back( msg );
+                auto waitMs = nowMs - min( nowMs, msg->getArrivalTime() );
+                deferredMessageMetrics->poppedAfter( waitMs * 1000 );
             }
 
             it = deferredMessageQueue.erase( it );
@@ -110,8 +121,10 @@ void Network::addToDelayedSends(
     auto dstIndex = ( uint64_t ) _dstNodeInfo->getSchainIndex();
     LOCK( delayedSendsLocks.at( dstIndex - 1 ) );
     delayedSends.at( dstIndex - 1 ).push_back( { _m, _dstNodeInfo } );
+    delayedSendsMetrics.at( dstIndex - 1 )->pushed();
     if ( delayedSends.at( dstIndex - 1 ).size() > MAX_DELAYED_MESSAGE_SENDS ) {
         delayedSends.at( dstIndex - 1 ).pop_front();
+        delayedSendsMetrics.at( dstIndex - 1 )->droppedOldest();
     }
 }
 
@@ -126,11 +139,6 @@ void Network::rebroadcastMessage( const ptr< NetworkMessage >& _msg ) {
 void Network::broadcastMessageImpl( const ptr< NetworkMessage >& _msg, bool _isFirstBroadcast ) {
     CHECK_ARGUMENT( _msg );
 
-    // used for testing
-    if ( _msg->getBlockID() <= this->catchupBlocks ) {
-        return;
-    }
-
     try {
         if ( _isFirstBroadcast ) {
             // sign message before sending
@@ -150,6 +158,8 @@ void Network::broadcastMessageImpl( const ptr< NetworkMessage >& _msg, bool _isF
                 if ( dstIndex != ( getSchain()->getSchainIndex() ) && !sent.count( dstIndex ) ) {
                     if ( sendMessage( it.second, _msg ) ) {
                         sent.insert( dstIndex );
+                    } else {
+                        getSchain()->getStageMetrics()->retry( dstIndex );
                     }
                 }
             }
@@ -175,7 +185,10 @@ void Network::broadcastMessageImpl( const ptr< NetworkMessage >& _msg, bool _isF
 }
 
 void Network::networkReadLoop() {
-    setThreadName( "NtwkRdLoop", getSchain()->getNode()->getConsensusEngine() );
+    logThreadLocal_ = getSchain()->getNode()->getLog();
+
+    setThreadName( "NtwkRdLoop", getSchain()->getNode()->getConsensusEngine(), "network-read",
+        "Network" );
 
 
     waitOnGlobalStartBarrier();
@@ -188,10 +201,6 @@ void Network::networkReadLoop() {
                 if ( !m )
                     continue;  // check exit again
 
-                if ( m->getMessage()->getBlockID() <= catchupBlocks ) {
-                    continue;
-                }
-
                 CHECK_STATE( sChain );
 
                 postDeferOrDrop( m );
@@ -232,6 +241,8 @@ void Network::postDeferOrDrop( const ptr< NetworkMessageEnvelope >& _me ) {
     if ( bid > currentBlockID ) {
         // block id is in the future, defer
         addToDeferredMessageQueue( _me );
+        // other nodes have committed blocks that this node does not have
+        sChain->getCatchupClientAgent()->wakeup( bid );
         return;
     }
 
@@ -279,7 +290,10 @@ void Network::trySendingDelayedSends() {
                     {
                         LOCK( delayedSendsLocks.at( i ) );
                         delayedSends.at( i ).pop_front();
+                        delayedSendsMetrics.at( i )->popped();
                     }
+                } else {
+                    getSchain()->getStageMetrics()->retry( i + 1 );
                 }
                 {
                     // could not send a message to this host, no point trying to
@@ -291,49 +305,56 @@ void Network::trySendingDelayedSends() {
     }
 }
 
-void Network::deferredMessagesLoop() {
-    setThreadName( "DeferMsgLoop", getSchain()->getNode()->getConsensusEngine() );
-
-    waitOnGlobalStartBarrier();
-
-    while ( !getSchain()->getNode()->isExitRequested() ) {
-        try {
-            ptr< vector< ptr< NetworkMessageEnvelope > > > deferredMessages;
+void Network::processDeferredMessages() {
+    if ( getSchain()->getNode()->isExitRequested() ) {
+        getNode()->getConsensusEngine()->getTimerWheel()->cancel( deferredMessagesTimerId );
+        return;
+    }
 
-            // Get messages for the current block id
-            deferredMessages = pullMessagesForCurrentBlockID();
+    try {
+        ptr< vector< ptr< NetworkMessageEnvelope > > > deferredMessages;
 
-            CHECK_STATE( deferredMessages );
+        // Get messages for the current block id
+        deferredMessages = pullMessagesForCurrentBlockID();
 
-            for ( auto message : *deferredMessages ) {
-                if ( getSchain()->getNode()->isExitRequested() )
-                    return;
-                postDeferOrDrop( message );
-            }
+        CHECK_STATE( deferredMessages );
 
-            trySendingDelayedSends();
-        } catch ( ExitRequestedException& ) {
-            // exit
-            LOG( info, "Exit requested, exiting deferred messages loop" );
-            return;
-        } catch ( SkaleException& e ) {
-            // print the error and continue the loop
-            SkaleException::logNested( e );
+        for ( auto message : *deferredMessages ) {
+            if ( getSchain()->getNode()->isExitRequested() )
+                return;
+            postDeferOrDrop( message );
         }
-        usleep( 1000000 );
+
+        trySendingDelayedSends();
+    } catch ( ExitRequestedException& ) {
+        LOG( info, "Exit requested, stopping deferred messages processing" );
+    } catch ( SkaleException& e ) {
+        // print the error, the timer will run again
+        SkaleException::logNested( e );
     }
 }
 
 
 void Network::startThreads() {
     networkReadThread = make_shared< thread >( std::bind( &Network::networkReadLoop, this ) );
-    deferredMessageThread =
-        make_shared< thread >( std::bind( &Network::deferredMessagesLoop, this ) );
 
     auto reg = getSchain()->getNode()->getConsensusEngine()->getThreadRegistry();
 
     reg->add( networkReadThread );
-    reg->add( deferredMessageThread );
+
+    // registered here rather than in the constructor, since the network wrapped by
+    // FaultInjectionNetwork is never started and its queues stay empty
+    for ( auto& metrics : delayedSendsMetrics ) {
+        reg->registerQueue( metrics );
+    }
+    reg->registerQueue( deferredMessageMetrics );
+}
+
+void Network::startDeferredMessagesTimer() {
+    deferredMessagesTimerId =
+        getNode()->getConsensusEngine()->getTimerWheel()->schedulePeriodic(
+            DEFERRED_MESSAGES_INTERVAL_MS, PRIORITY_CONSENSUS,
+            [this]() { processDeferredMessages(); } );
 }
 
 bool Network::validateIpAddress( const string& _ip ) {
@@ -360,6 +381,10 @@ ptr< NetworkMessageEnvelope > Network::receiveMessage() {
 
     CHECK_STATE( mptr );
 
+    if ( auto traceWriter = sChain->getNode()->getTraceWriter() ) {
+        traceWriter->recordNetworkMessage( ( uint64_t ) mptr->getBlockID(), msg );
+    }
+
     mptr->verify( getSchain()->getCryptoManager() );
 
     ptr< NodeInfo > realSender = sChain->getNode()->getNodeInfoByIndex( mptr->getSrcSchainIndex() );
@@ -369,6 +394,8 @@ ptr< NetworkMessageEnvelope > Network::receiveMessage() {
             "NetworkMessage from unknown sender schain index", __CLASS_NAME__ ) );
     }
 
+    getSchain()->getStageMetrics()->messageReceived( mptr->getSrcSchainIndex(), readBytes );
+
     ptr< ProtocolKey > key = mptr->createDestinationProtocolKey();
 
     CHECK_STATE( key );
@@ -390,14 +417,6 @@ TransportType Network::getTransport() {
     return transport;
 }
 
-void Network::setPacketLoss( uint32_t _packetLoss ) {
-    Network::packetLoss = _packetLoss;
-}
-
-void Network::setCatchupBlocks( uint64_t _catchupBlocks ) {
-    Network::catchupBlocks = _catchupBlocks;
-}
-
 uint64_t Network::computeTotalDelayedSends() {
     uint64_t total = 0;
     for ( uint64_t i = 0; i < delayedSends.size(); i++ ) {
@@ -414,17 +433,22 @@ Network::Network( Schain& _sChain )
       delayedSends( ( uint64_t ) _sChain.getNodeCount() ),
       delayedSendsLocks( ( uint64_t ) _sChain.getNodeCount() ) {
 
-    auto cfg = _sChain.getNode()->getCfg();
+    auto nodeID = ( uint64_t ) _sChain.getNode()->getNodeID();
 
-    if ( cfg.find( "catchupBlocks" ) != cfg.end() ) {
-        uint64_t catchupBlock = cfg.at( "catchupBlocks" ).get< uint64_t >();
-        setCatchupBlocks( catchupBlock );
+    for ( uint64_t i = 1; i <= ( uint64_t ) _sChain.getNodeCount(); i++ ) {
+        delayedSendsMetrics.push_back(
+            make_shared< QueueMetrics >( "delayedSends." + to_string( i ), "Network", nodeID ) );
     }
 
-    if ( cfg.find( "packetLoss" ) != cfg.end() ) {
-        uint32_t pl = cfg.at( "packetLoss" ).get< uint64_t >();
-        CHECK_STATE( pl <= 100 );
-        setPacketLoss( pl );
+    // messages of future blocks, pulled by block id rather than in arrival order
+    deferredMessageMetrics =
+        make_shared< QueueMetrics >( "deferredMessageQueue", "Network", nodeID, false );
+
+    // catchupBlocks and packetLoss are applied by FaultInjectionNetwork
+    if ( !TEST_HOOKS_ENABLED ) {
+        auto cfg = _sChain.getNode()->getCfg();
+        if ( cfg.find( "catchupBlocks" ) != cfg.end() || cfg.find( "packetLoss" ) != cfg.end() )
+            LOG( warn, "Built without test hooks, ignoring catchupBlocks and packetLoss" );
     }
 }
 
@@ -31,9 +31,10 @@ class NodeInfo;
 class NetworkMessage;
 class Buffer;
 class Node;
+class QueueMetrics;
 class Schain;
 
-enum TransportType {ZMQ};
+enum TransportType {ZMQ, IN_PROCESS, SHARED_MEMORY, REPLAY};
 
 class Network : public Agent  {
 
@@ -42,16 +43,11 @@ protected:
 
     vector<list<pair<ptr<NetworkMessage>,ptr<NodeInfo>>>> delayedSends; // tsafe
     vector<recursive_mutex> delayedSendsLocks;
-
-    // used in testing
-
-    uint32_t packetLoss = 0;
-
-    uint64_t   catchupBlocks = 0;
+    vector<ptr<QueueMetrics>> delayedSendsMetrics;
 
     ptr<thread> networkReadThread;
 
-    ptr<thread> deferredMessageThread;
+    uint64_t deferredMessagesTimerId = 0;
 
     static TransportType transport;
 
@@ -59,6 +55,7 @@ protected:
 
     map<block_id, ptr<vector<ptr<NetworkMessageEnvelope>>>> deferredMessageQueue; //tsafe
     recursive_mutex deferredMessageMutex;
+    ptr<QueueMetrics> deferredMessageMetrics;
 
     virtual void addToDeferredMessageQueue(const ptr<NetworkMessageEnvelope>& _me);
 
@@ -66,11 +63,16 @@ protected:
 
     virtual bool sendMessage(const ptr<NodeInfo> &remoteNodeInfo, const ptr<NetworkMessage>& _msg) = 0;
 
+    // wraps another network and sends through it
+    friend class FaultInjectionNetwork;
+
 public:
 
     void startThreads();
 
-    void deferredMessagesLoop();
+    void startDeferredMessagesTimer();
+
+    void processDeferredMessages();
 
     void networkReadLoop();
 
@@ -82,7 +84,7 @@ public:
 
     void broadcastMessageImpl(const ptr<NetworkMessage>& _msg , bool _isFirstBroadcast );
 
-    ptr<NetworkMessageEnvelope> receiveMessage();
+    virtual ptr<NetworkMessageEnvelope> receiveMessage();
 
     virtual uint64_t readMessageFromNetwork(ptr<Buffer> buf) = 0;
 
@@ -92,10 +94,6 @@ public:
 
     static TransportType getTransport();
 
-    void setPacketLoss(uint32_t packetLoss);
-
-    void setCatchupBlocks(uint64_t _catchupBlocks);
-
     void postDeferOrDrop(const ptr<NetworkMessageEnvelope> & _me );
 
     ~Network() override;
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReplayNetwork.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "Log.h"
+#include "SkaleCommon.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+#include "exceptions/NetworkProtocolException.h"
+
+#include "chains/Schain.h"
+#include "messages/NetworkMessage.h"
+#include "node/Node.h"
+
+#include "ReplayNetwork.h"
+
+
+// how often a waiting reader checks for exit
+static constexpr uint64_t REPLAY_READ_POLL_MS = 100;
+
+
+ReplayNetwork::ReplayNetwork( Schain& _sChain ) : Network( _sChain ) {}
+
+
+void ReplayNetwork::deliver( string&& _message ) {
+    {
+        lock_guard< mutex > lock( inboxLock );
+        inbox.push( move( _message ) );
+    }
+    inboxCond.notify_one();
+}
+
+
+bool ReplayNetwork::sendMessage(
+    const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) {
+    CHECK_ARGUMENT( _remoteNodeInfo );
+    CHECK_ARGUMENT( _msg );
+    return true;
+}
+
+
+uint64_t ReplayNetwork::readMessageFromNetwork( ptr< Buffer > _buf ) {
+    CHECK_ARGUMENT( _buf );
+
+    unique_lock< mutex > lock( inboxLock );
+
+    while ( inbox.empty() ) {
+        if ( getNode()->isExitRequested() ) {
+            BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+        }
+        inboxCond.wait_for( lock, chrono::milliseconds( REPLAY_READ_POLL_MS ) );
+    }
+
+    auto message = move( inbox.front() );
+    inbox.pop();
+
+    if ( message.size() >= MAX_CONSENSUS_MESSAGE_LEN ) {
+        BOOST_THROW_EXCEPTION( NetworkProtocolException(
+            "Consensus Message length too large:" + to_string( message.size() ),
+            __CLASS_NAME__ ) );
+    }
+
+    memcpy( _buf->getBuf()->data(), message.data(), message.size() );
+
+    return message.size();
+}
@@ -0,0 +1,55 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReplayNetwork.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "Network.h"
+
+class NodeInfo;
+class NetworkMessage;
+class Schain;
+
+
+// Network of a node that replays a captured trace. Messages come from the replay tool,
+// messages the node sends go nowhere.
+
+class ReplayNetwork : public Network {
+
+    mutex inboxLock;
+    condition_variable inboxCond;
+    queue< string > inbox;
+
+public:
+
+    explicit ReplayNetwork( Schain& _sChain );
+
+    // a message as it was read from the network when the trace was captured
+    void deliver( string&& _message );
+
+    bool sendMessage(
+        const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) override;
+
+    uint64_t readMessageFromNetwork( ptr< Buffer > _buf ) override;
+};
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ReplayTransport.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ConnectionRefusedException.h"
+
+#include "ReplayNetwork.h"
+#include "UnixServerSocket.h"
+
+#include "ReplayTransport.h"
+
+
+ptr< Network > ReplayTransport::createNetwork( Schain& _sChain ) {
+    return make_shared< ReplayNetwork >( _sChain );
+}
+
+
+ptr< StreamServerSocket > ReplayTransport::createServerSocket(
+    const string& _bindIP, uint16_t _basePort, port_type _portType ) {
+    // nobody connects, a unix socket does not take the ports of a running node
+    return make_shared< UnixServerSocket >( _bindIP, _basePort, _portType );
+}
+
+
+int ReplayTransport::connect( const string& _ip, uint16_t _port ) {
+    BOOST_THROW_EXCEPTION( ConnectionRefusedException(
+        "Replay has no peers:" + _ip + ":" + to_string( _port ), ECONNREFUSED, __CLASS_NAME__ ) );
+}
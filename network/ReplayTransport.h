@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2019 SKALE Labs
+    Copyright (C) 2021 SKALE Labs
 
     This file is part of skale-consensus.
 
@@ -16,28 +16,28 @@
     You should have received a copy of the GNU Affero General Public License
     along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
 
-    @file BlockFinalizeDownloaderThreadPool.h
+    @file ReplayTransport.h
     @author Stan Kladko
-    @date 2019
+    @date 2021
 */
 
-#pragma once
 
-#include <cstdint>
+#pragma once
 
-#include "threads/WorkerThreadPool.h"
+#include "Transport.h"
 
-class BlockFinalizeDownloaderThreadPool : public WorkerThreadPool {
 
-public:
+// A single node that replays a captured trace: messages come from the trace, there are no
+// peers to connect to.
 
-    BlockFinalizeDownloaderThreadPool(num_threads numThreads, Agent *_params);
+class ReplayTransport : public Transport {
 
-    void createThread(uint64_t threadIndex ) override;
+public:
 
-    void startService() override;
+    ptr< Network > createNetwork( Schain& _sChain ) override;
 
-    ~BlockFinalizeDownloaderThreadPool() override;
+    ptr< StreamServerSocket > createServerSocket(
+        const string& _bindIP, uint16_t _basePort, port_type _portType ) override;
 
+    int connect( const string& _ip, uint16_t _port ) override;
 };
-
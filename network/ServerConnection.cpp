@@ -24,6 +24,10 @@
 #include "SkaleCommon.h"
 #include "Log.h"
 #include "exceptions/FatalError.h"
+#include "utils/Time.h"
+
+#include <sys/epoll.h>
+#include <sys/uio.h>
 
 #include "ServerConnection.h"
 
@@ -57,12 +61,222 @@ ServerConnection::~ServerConnection() {
 void ServerConnection::closeConnection() {
     LOCK(m)
     if (descriptor != 0)
-        close((int)descriptor);
+        ::close((int)descriptor);
     descriptor = 0;
 }
 
+void ServerConnection::close() {
+    LOCK(m)
+    failed = true;
+    readCallback = nullptr;
+    readBuffer = nullptr;
+    writeQueue.clear();
+    closeConnection();
+}
+
 
 
 uint64_t ServerConnection::getTotalObjects() {
     return totalObjects;
-};
+}
+
+
+void ServerConnection::expectBytes(uint64_t _len, const ReadCallback& _callback) {
+    CHECK_ARGUMENT(_len > 0);
+    CHECK_ARGUMENT(_callback);
+
+    LOCK(m)
+
+    CHECK_STATE(!readCallback);
+
+    readBuffer = make_shared<vector<uint8_t>>(_len);
+    readOffset = 0;
+    readCallback = _callback;
+
+    // the peer has to deliver the whole step before the deadline
+    deadlineMs = Time::getSteadyTimeMs() + SERVER_IO_TIMEOUT_MS;
+}
+
+
+void ServerConnection::queueWrite(const ptr<vector<uint8_t>>& _bytes, uint64_t _notBeforeMs) {
+    CHECK_ARGUMENT(_bytes);
+    queueWrite(_bytes, 0, _bytes->size(), _notBeforeMs);
+}
+
+
+void ServerConnection::queueWrite(const ptr<vector<uint8_t>>& _bytes, uint64_t _begin, uint64_t _end,
+                                  uint64_t _notBeforeMs) {
+    CHECK_ARGUMENT(_bytes);
+    CHECK_ARGUMENT(_begin < _end);
+    CHECK_ARGUMENT(_end <= _bytes->size());
+
+    LOCK(m)
+
+    if (failed)
+        return;
+
+    if (writeQueue.empty())
+        deadlineMs = max(Time::getSteadyTimeMs(), _notBeforeMs) + SERVER_IO_TIMEOUT_MS;
+
+    writeQueue.push_back({_bytes, _begin, _end});
+    writeNotBeforeMs = max(writeNotBeforeMs, _notBeforeMs);
+}
+
+
+io_status ServerConnection::readAvailable(ptr<vector<uint8_t>>& _buffer, ReadCallback& _callback) {
+    LOCK(m)
+
+    if (failed)
+        return IO_CLOSED;
+
+    if (!readCallback)
+        return IO_PENDING;
+
+    while (readOffset < readBuffer->size()) {
+        auto result = recv((int) descriptor, readBuffer->data() + readOffset,
+                           readBuffer->size() - readOffset, 0);
+
+        if (result > 0) {
+            readOffset += result;
+            continue;
+        }
+
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return IO_PENDING;
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        // the peer shut down the socket or an error happened
+        return IO_CLOSED;
+    }
+
+    _buffer = readBuffer;
+    _callback = readCallback;
+
+    readBuffer = nullptr;
+    readCallback = nullptr;
+
+    return IO_COMPLETE;
+}
+
+
+io_status ServerConnection::flushWrites() {
+    LOCK(m)
+
+    if (failed)
+        return IO_CLOSED;
+
+    if (writeQueue.empty() || Time::getSteadyTimeMs() < writeNotBeforeMs)
+        return IO_PENDING;
+
+    while (!writeQueue.empty()) {
+        array<iovec, 16> vectors;
+        uint64_t count = 0;
+
+        for (auto&& slice : writeQueue) {
+            if (count == vectors.size())
+                break;
+            auto begin = slice.begin + ((count == 0) ? writeOffset : 0);
+            vectors[count].iov_base = slice.bytes->data() + begin;
+            vectors[count].iov_len = slice.end - begin;
+            count++;
+        }
+
+        auto result = writev((int) descriptor, vectors.data(), count);
+
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return IO_PENDING;
+            if (errno == EINTR)
+                continue;
+            return IO_CLOSED;
+        }
+
+        // the peer is reading, so the deadline moves
+        deadlineMs = Time::getSteadyTimeMs() + SERVER_IO_TIMEOUT_MS;
+
+        uint64_t written = result;
+
+        while (written > 0) {
+            auto remaining = writeQueue.front().end - writeQueue.front().begin - writeOffset;
+            if (written < remaining) {
+                writeOffset += written;
+                break;
+            }
+            written -= remaining;
+            writeQueue.pop_front();
+            writeOffset = 0;
+        }
+    }
+
+    return IO_COMPLETE;
+}
+
+
+uint32_t ServerConnection::getWantedEvents() {
+    LOCK(m)
+
+    uint32_t events = 0;
+
+    if (readCallback)
+        events |= EPOLLIN;
+
+    if (!writeQueue.empty() && Time::getSteadyTimeMs() >= writeNotBeforeMs)
+        events |= EPOLLOUT;
+
+    return events;
+}
+
+
+bool ServerConnection::isFinished() {
+    LOCK(m)
+    return busySteps == 0 && !readCallback && writeQueue.empty();
+}
+
+
+bool ServerConnection::isExpired(uint64_t _nowMs) {
+    LOCK(m)
+    // the deadline does not run while a protocol step is processed locally
+    return busySteps == 0 && deadlineMs != 0 && _nowMs > deadlineMs;
+}
+
+
+uint64_t ServerConnection::getWakeTimeMs() {
+    LOCK(m)
+
+    uint64_t result = 0;
+
+    if (busySteps == 0 && deadlineMs != 0)
+        result = deadlineMs + 1;
+
+    if (!writeQueue.empty() && writeNotBeforeMs != 0 && (result == 0 || writeNotBeforeMs < result))
+        result = writeNotBeforeMs;
+
+    return result;
+}
+
+
+void ServerConnection::stepDispatched() {
+    LOCK(m)
+    busySteps++;
+}
+
+
+void ServerConnection::stepCompleted() {
+    LOCK(m)
+    CHECK_STATE(busySteps > 0);
+    busySteps--;
+}
+
+
+void ServerConnection::markFailed() {
+    LOCK(m)
+    failed = true;
+}
+
+
+bool ServerConnection::isFailed() {
+    LOCK(m)
+    return failed;
+}
@@ -23,8 +23,23 @@
 
 #pragma  once
 
+#include <deque>
+#include <functional>
+
+enum io_status { IO_PENDING = 0, IO_COMPLETE = 1, IO_CLOSED = 2 };
+
+
+// Server side connection. Reads and writes are non-blocking and driven by EpollServerLoop,
+// which owns the connection from accept until close.
+
 class ServerConnection {
 
+public:
+
+    using ReadCallback = function< void( const ptr< vector< uint8_t > >& ) >;
+
+private:
+
     recursive_mutex m;
 
     static atomic<int64_t> totalObjects;
@@ -33,6 +48,32 @@ class ServerConnection {
 
     string ip;
 
+    // incremental read of the bytes the protocol expects next, guarded by m
+    ptr< vector< uint8_t > > readBuffer;
+    uint64_t readOffset = 0;
+    ReadCallback readCallback;
+
+    // a queued write is a slice of a buffer that may be shared, so it is sent without a copy
+    class WriteSlice {
+    public:
+        ptr< vector< uint8_t > > bytes;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // guarded by m
+    deque< WriteSlice > writeQueue;
+    uint64_t writeOffset = 0;  // offset into the front slice
+    uint64_t writeNotBeforeMs = 0;
+
+    // protocol steps dispatched to the executor and not completed yet, guarded by m.
+    // A step may dispatch the next one before it completes itself, so this is a counter
+    uint64_t busySteps = 0;
+
+    bool failed = false;  // guarded by m
+
+    uint64_t deadlineMs = 0;  // guarded by m
+
     void closeConnection();
 
 public:
@@ -47,5 +88,38 @@ public:
 
     static uint64_t getTotalObjects();
 
-};
+    void expectBytes( uint64_t _len, const ReadCallback& _callback );
 
+    void queueWrite( const ptr< vector< uint8_t > >& _bytes, uint64_t _notBeforeMs );
+
+    // queues bytes [_begin, _end) of _bytes, which must not change until they are written
+    void queueWrite( const ptr< vector< uint8_t > >& _bytes, uint64_t _begin, uint64_t _end,
+        uint64_t _notBeforeMs );
+
+    // reads without blocking, on completion returns the buffer and the callback to run
+    io_status readAvailable( ptr< vector< uint8_t > >& _buffer, ReadCallback& _callback );
+
+    io_status flushWrites();
+
+    // epoll events the connection waits for
+    uint32_t getWantedEvents();
+
+    // nothing to read, write or process
+    bool isFinished();
+
+    bool isExpired( uint64_t _nowMs );
+
+    // earliest time the loop has to look at the connection again, 0 if none
+    uint64_t getWakeTimeMs();
+
+    void stepDispatched();
+
+    void stepCompleted();
+
+    void markFailed();
+
+    bool isFailed();
+
+    void close();
+
+};
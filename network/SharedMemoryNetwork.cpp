@@ -0,0 +1,302 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file SharedMemoryNetwork.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "Log.h"
+#include "SkaleCommon.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+#include "exceptions/NetworkProtocolException.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "chains/Schain.h"
+#include "messages/NetworkMessage.h"
+#include "monitoring/StageMetrics.h"
+#include "node/Node.h"
+#include "node/NodeInfo.h"
+
+#include "SharedMemoryNetwork.h"
+
+
+static constexpr uint64_t SEGMENT_MAGIC = 0x534b414c45534d31;
+
+// an idle reader spins for a while, then sleeps between polls
+static constexpr uint64_t SHARED_MEMORY_SPIN_COUNT = 1000;
+static constexpr uint64_t SHARED_MEMORY_SLEEP_US = 50;
+
+
+SharedMemoryNetwork::Segment::Segment( void* _address, uint64_t _size )
+    : address( _address ), size( _size ) {
+    CHECK_ARGUMENT( _address );
+}
+
+
+SharedMemoryNetwork::Segment::~Segment() {
+    munmap( address, size );
+}
+
+
+SharedMemoryNetwork::SegmentHeader* SharedMemoryNetwork::Segment::getHeader() {
+    return ( SegmentHeader* ) address;
+}
+
+
+SharedMemoryNetwork::Ring* SharedMemoryNetwork::Segment::getRing( uint64_t _index ) {
+    CHECK_ARGUMENT( _index < getHeader()->ringCount );
+    return ( Ring* ) ( ( uint8_t* ) address + sizeof( SegmentHeader ) ) + _index;
+}
+
+
+string SharedMemoryNetwork::getSegmentName( uint64_t _schainID, uint64_t _nodeID ) {
+    return "/skale-consensus-" + to_string( _schainID ) + "-" + to_string( _nodeID );
+}
+
+
+uint64_t SharedMemoryNetwork::getSegmentSize( uint64_t _ringCount ) {
+    return sizeof( SegmentHeader ) + _ringCount * sizeof( Ring );
+}
+
+
+SharedMemoryNetwork::SharedMemoryNetwork( Schain& _sChain )
+    : Network( _sChain ),
+      schainID( ( uint64_t ) _sChain.getSchainID() ),
+      nodeID( ( uint64_t ) _sChain.getNode()->getNodeID() ),
+      nodeCount( ( uint64_t ) _sChain.getNodeCount() ),
+      sendLocks( nodeCount ) {
+    auto name = getSegmentName( schainID, nodeID );
+    auto size = getSegmentSize( nodeCount );
+
+    // left over by a node that did not exit cleanly
+    shm_unlink( name.c_str() );
+
+    int fd = shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600 );
+
+    if ( fd < 0 ) {
+        BOOST_THROW_EXCEPTION( FatalError(
+            "Could not create shared memory segment " + name + ":" + string( strerror( errno ) ) ) );
+    }
+
+    if ( ftruncate( fd, ( off_t ) size ) != 0 ) {
+        close( fd );
+        shm_unlink( name.c_str() );
+        BOOST_THROW_EXCEPTION( FatalError( "Could not size shared memory segment " + name ) );
+    }
+
+    auto address = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if ( address == MAP_FAILED ) {
+        shm_unlink( name.c_str() );
+        BOOST_THROW_EXCEPTION( FatalError( "Could not map shared memory segment " + name ) );
+    }
+
+    ownSegment = make_shared< Segment >( address, size );
+
+    // the segment is zero filled by ftruncate
+    auto header = new ( address ) SegmentHeader;
+    header->closed.store( 0 );
+    header->ringCount = nodeCount;
+
+    for ( uint64_t i = 0; i < nodeCount; i++ ) {
+        auto ring = new ( ownSegment->getRing( i ) ) Ring;
+        ring->head.store( 0 );
+        ring->tail.store( 0 );
+    }
+
+    header->magic.store( SEGMENT_MAGIC, memory_order_release );
+}
+
+
+SharedMemoryNetwork::~SharedMemoryNetwork() {
+    ownSegment->getHeader()->closed.store( 1, memory_order_release );
+    shm_unlink( getSegmentName( schainID, nodeID ).c_str() );
+}
+
+
+ptr< SharedMemoryNetwork::Segment > SharedMemoryNetwork::getPeerSegment( uint64_t _nodeID ) {
+    lock_guard< mutex > lock( peersLock );
+
+    auto peer = peers.find( _nodeID );
+
+    if ( peer != peers.end() ) {
+        if ( peer->second->getHeader()->closed.load( memory_order_acquire ) == 0 )
+            return peer->second;
+        // the receiver exited, a restarted one creates a new segment
+        peers.erase( peer );
+    }
+
+    auto name = getSegmentName( schainID, _nodeID );
+    auto size = getSegmentSize( nodeCount );
+
+    int fd = shm_open( name.c_str(), O_RDWR, 0 );
+
+    // the receiving node did not start yet
+    if ( fd < 0 )
+        return nullptr;
+
+    struct stat status;
+
+    if ( fstat( fd, &status ) != 0 || ( uint64_t ) status.st_size != size ) {
+        close( fd );
+        return nullptr;
+    }
+
+    auto address = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if ( address == MAP_FAILED )
+        return nullptr;
+
+    auto segment = make_shared< Segment >( address, size );
+
+    auto header = segment->getHeader();
+
+    if ( header->magic.load( memory_order_acquire ) != SEGMENT_MAGIC ||
+         header->ringCount != nodeCount || header->closed.load( memory_order_acquire ) != 0 )
+        return nullptr;
+
+    peers[_nodeID] = segment;
+
+    return segment;
+}
+
+
+bool SharedMemoryNetwork::writeToRing( Ring* _ring, const string& _data ) {
+    uint32_t length = _data.size();
+    uint64_t recordSize = sizeof( length ) + length;
+
+    auto tail = _ring->tail.load( memory_order_relaxed );
+    auto head = _ring->head.load( memory_order_acquire );
+
+    if ( RING_SIZE - ( tail - head ) < recordSize )
+        return false;
+
+    auto copy = [&]( uint64_t _position, const void* _src, uint64_t _size ) {
+        auto offset = _position % RING_SIZE;
+        auto first = min( _size, RING_SIZE - offset );
+        memcpy( _ring->data + offset, _src, first );
+        memcpy( _ring->data, ( const uint8_t* ) _src + first, _size - first );
+    };
+
+    copy( tail, &length, sizeof( length ) );
+    copy( tail + sizeof( length ), _data.data(), length );
+
+    _ring->tail.store( tail + recordSize, memory_order_release );
+
+    return true;
+}
+
+
+uint64_t SharedMemoryNetwork::readFromRing( Ring* _ring, ptr< Buffer >& _buf ) {
+    auto head = _ring->head.load( memory_order_relaxed );
+    auto tail = _ring->tail.load( memory_order_acquire );
+
+    if ( head == tail )
+        return 0;
+
+    auto copy = [&]( uint64_t _position, void* _dst, uint64_t _size ) {
+        auto offset = _position % RING_SIZE;
+        auto first = min( _size, RING_SIZE - offset );
+        memcpy( _dst, _ring->data + offset, first );
+        memcpy( ( uint8_t* ) _dst + first, _ring->data, _size - first );
+    };
+
+    uint32_t length;
+    copy( head, &length, sizeof( length ) );
+
+    if ( length >= MAX_CONSENSUS_MESSAGE_LEN ) {
+        _ring->head.store( head + sizeof( length ) + length, memory_order_release );
+        BOOST_THROW_EXCEPTION( NetworkProtocolException(
+            "Consensus Message length too large:" + to_string( length ), __CLASS_NAME__ ) );
+    }
+
+    copy( head + sizeof( length ), _buf->getBuf()->data(), length );
+
+    _ring->head.store( head + sizeof( length ) + length, memory_order_release );
+
+    return length;
+}
+
+
+bool SharedMemoryNetwork::sendMessage(
+    const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) {
+    CHECK_ARGUMENT( _remoteNodeInfo );
+    CHECK_ARGUMENT( _msg );
+
+    auto data = _msg->serializeToString();
+
+    CHECK_STATE( data.size() < MAX_CONSENSUS_MESSAGE_LEN );
+
+    auto dst = ( uint64_t ) _remoteNodeInfo->getSchainIndex();
+    CHECK_STATE( dst > 0 && dst <= nodeCount );
+
+    auto segment = getPeerSegment( ( uint64_t ) _remoteNodeInfo->getNodeID() );
+
+    // the receiving node did not start yet, the message goes to delayed sends
+    if ( !segment )
+        return false;
+
+    auto ring = segment->getRing( ( uint64_t ) sChain->getSchainIndex() - 1 );
+
+    {
+        lock_guard< mutex > lock( sendLocks.at( dst - 1 ) );
+
+        // the receiver is behind, the message goes to delayed sends
+        if ( !writeToRing( ring, data ) )
+            return false;
+    }
+
+    sChain->getStageMetrics()->messageSent( _remoteNodeInfo->getSchainIndex(), data.size() );
+
+    return true;
+}
+
+
+uint64_t SharedMemoryNetwork::readMessageFromNetwork( ptr< Buffer > _buf ) {
+    CHECK_ARGUMENT( _buf );
+
+    uint64_t idlePolls = 0;
+
+    while ( true ) {
+        for ( uint64_t i = 0; i < nodeCount; i++ ) {
+            auto index = nextRing;
+            nextRing = ( nextRing + 1 ) % nodeCount;
+
+            auto size = readFromRing( ownSegment->getRing( index ), _buf );
+
+            if ( size > 0 )
+                return size;
+        }
+
+        if ( getNode()->isExitRequested() ) {
+            BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+        }
+
+        if ( ++idlePolls > SHARED_MEMORY_SPIN_COUNT ) {
+            usleep( SHARED_MEMORY_SLEEP_US );
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file SharedMemoryNetwork.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "Network.h"
+
+class NodeInfo;
+class NetworkMessage;
+class Schain;
+
+
+// Consensus messages between nodes on the same host, passed through POSIX shared memory.
+//
+// Every node owns a segment with one single producer single consumer ring per sender
+// schain index. A sender maps the segment of the receiver once and copies the serialized
+// message into its ring, the receiver polls its rings, so a message costs two copies and
+// no system call.
+
+class SharedMemoryNetwork : public Network {
+
+public:
+
+    static constexpr uint64_t RING_SIZE = 256 * 1024;
+
+    class alignas( 64 ) SegmentHeader {
+    public:
+        // set last by the receiver, a sender does not use the segment before
+        atomic< uint64_t > magic;
+        // set by the receiver on exit, senders remap the segment of a restarted node
+        atomic< uint64_t > closed;
+        uint64_t ringCount;
+    };
+
+    // head and tail count bytes since the start and are on separate cache lines,
+    // so the sender and the receiver do not write to the same line
+    class alignas( 64 ) Ring {
+    public:
+        alignas( 64 ) atomic< uint64_t > head;  // written by the receiver
+        alignas( 64 ) atomic< uint64_t > tail;  // written by the sender
+        alignas( 64 ) uint8_t data[RING_SIZE];
+    };
+
+    class Segment {
+        void* address = nullptr;
+        uint64_t size = 0;
+
+    public:
+        Segment( void* _address, uint64_t _size );
+
+        ~Segment();
+
+        SegmentHeader* getHeader();
+
+        Ring* getRing( uint64_t _index );
+    };
+
+private:
+
+    const uint64_t schainID;
+
+    const uint64_t nodeID;
+
+    const uint64_t nodeCount;
+
+    ptr< Segment > ownSegment;
+
+    // segments of receivers by node id
+    mutex peersLock;
+    map< uint64_t, ptr< Segment > > peers;
+
+    // one sender per ring, by schain index - 1 of the receiver
+    vector< mutex > sendLocks;
+
+    // ring checked first by the next read
+    uint64_t nextRing = 0;
+
+    ptr< Segment > getPeerSegment( uint64_t _nodeID );
+
+    bool writeToRing( Ring* _ring, const string& _data );
+
+    uint64_t readFromRing( Ring* _ring, ptr< Buffer >& _buf );
+
+public:
+
+    static string getSegmentName( uint64_t _schainID, uint64_t _nodeID );
+
+    static uint64_t getSegmentSize( uint64_t _ringCount );
+
+    explicit SharedMemoryNetwork( Schain& _sChain );
+
+    ~SharedMemoryNetwork() override;
+
+    bool sendMessage(
+        const ptr< NodeInfo >& _remoteNodeInfo, const ptr< NetworkMessage >& _msg ) override;
+
+    uint64_t readMessageFromNetwork( ptr< Buffer > _buf ) override;
+};
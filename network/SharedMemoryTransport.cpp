@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file SharedMemoryTransport.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ConnectionRefusedException.h"
+#include "exceptions/FatalError.h"
+
+#include "SharedMemoryNetwork.h"
+#include "UnixServerSocket.h"
+
+#include "SharedMemoryTransport.h"
+
+
+ptr< Network > SharedMemoryTransport::createNetwork( Schain& _sChain ) {
+    return make_shared< SharedMemoryNetwork >( _sChain );
+}
+
+
+ptr< StreamServerSocket > SharedMemoryTransport::createServerSocket(
+    const string& _bindIP, uint16_t _basePort, port_type _portType ) {
+    return make_shared< UnixServerSocket >( _bindIP, _basePort, _portType );
+}
+
+
+int SharedMemoryTransport::connect( const string& _ip, uint16_t _port ) {
+    auto path = UnixServerSocket::getPath( _ip, _port );
+    auto address = UnixServerSocket::createAddress( path );
+
+    int s;
+
+    if ( ( s = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 ) {
+        BOOST_THROW_EXCEPTION(
+            FatalError( "Could not create outgoing socket:" + string( strerror( errno ) ) ) );
+    }
+
+    if ( ::connect( s, ( sockaddr* ) &address, sizeof( address ) ) < 0 ) {
+        auto error = errno;
+        close( s );
+        BOOST_THROW_EXCEPTION(
+            ConnectionRefusedException( "Couldnt connect to:" + path, error, __CLASS_NAME__ ) );
+    }
+
+    return s;
+}
@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2018-2019 SKALE Labs
+    Copyright (C) 2021 SKALE Labs
 
     This file is part of skale-consensus.
 
@@ -16,23 +16,28 @@
     You should have received a copy of the GNU Affero General Public License
     along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
 
-    @file MonitoringThreadPool.h
+    @file SharedMemoryTransport.h
     @author Stan Kladko
-    @date 2018
+    @date 2021
 */
 
+
 #pragma once
 
-#include <cstdint>
+#include "Transport.h"
+
 
-#include "threads/WorkerThreadPool.h"
+// Nodes on the same host: consensus messages go through shared memory rings,
+// proposals and catchup through unix domain sockets.
 
-class MonitoringThreadPool : public WorkerThreadPool {
+class SharedMemoryTransport : public Transport {
 
 public:
 
-    MonitoringThreadPool(num_threads _numThreads, Agent* _agent);
+    ptr< Network > createNetwork( Schain& _sChain ) override;
 
-    void createThread(uint64_t _number) override;
+    ptr< StreamServerSocket > createServerSocket(
+        const string& _bindIP, uint16_t _basePort, port_type _portType ) override;
 
+    int connect( const string& _ip, uint16_t _port ) override;
 };
@@ -28,8 +28,9 @@
 #include "thirdparty/json.hpp"
 
 #include "Network.h"
+#include "StreamServerSocket.h"
 #include "Sockets.h"
-#include "TCPServerSocket.h"
+#include "Transport.h"
 #include "ZMQSockets.h"
 
 using namespace std;
@@ -41,8 +42,8 @@ void Sockets::initSockets(const string & _bindIP, uint16_t _basePort ) {
     LOG(debug, "Initing network processing\n");
 
     consensusZMQSockets = make_shared< ZMQSockets >( _bindIP, _basePort, BINARY_CONSENSUS);
-    blockProposalSocket = make_shared<TCPServerSocket>( _bindIP, _basePort, PROPOSAL);
-    catchupSocket = make_shared<TCPServerSocket>( _bindIP, _basePort, CATCHUP);
+    blockProposalSocket = Transport::get().createServerSocket( _bindIP, _basePort, PROPOSAL);
+    catchupSocket = Transport::get().createServerSocket( _bindIP, _basePort, CATCHUP);
 }
 
 
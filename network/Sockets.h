@@ -31,8 +31,7 @@
 #include "node/Node.h"
 
 
-class ServerSocker;
-class TCPServerSocket;
+class StreamServerSocket;
 class ZMQSockets;
 
 class Sockets {
@@ -41,9 +40,9 @@ public:
 
     ptr< ZMQSockets > consensusZMQSockets;
 
-    ptr<TCPServerSocket> blockProposalSocket;
+    ptr<StreamServerSocket> blockProposalSocket;
 
-    ptr<TCPServerSocket> catchupSocket;
+    ptr<StreamServerSocket> catchupSocket;
 
 
     Node &getNode() const;
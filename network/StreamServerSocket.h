@@ -1,5 +1,5 @@
 /*
-    Copyright (C) 2018-2019 SKALE Labs
+    Copyright (C) 2021 SKALE Labs
 
     This file is part of skale-consensus.
 
@@ -16,23 +16,28 @@
     You should have received a copy of the GNU Affero General Public License
     along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
 
-    @file CatchupClientThreadPool.h
+    @file StreamServerSocket.h
     @author Stan Kladko
-    @date 2018
+    @date 2021
 */
 
+
 #pragma once
 
-#include <cstdint>
+#include "ServerSocket.h"
+
 
-#include "threads/WorkerThreadPool.h"
+// Listening stream socket of the request/response channel, accepted by the epoll server loop.
 
-class CatchupClientThreadPool : public WorkerThreadPool {
+class StreamServerSocket : public ServerSocket {
 
 public:
 
-    CatchupClientThreadPool(num_threads numThreads, Agent *_agent);
+    StreamServerSocket( const string& _bindIP, uint16_t _basePort, port_type _portType )
+        : ServerSocket( _bindIP, _basePort, _portType ) {}
 
-    void createThread(uint64_t number) override;
+    virtual int getDescriptor() = 0;
 
+    // connects to the socket to wake up a blocked accept on exit
+    virtual void touch() = 0;
 };
@@ -33,7 +33,7 @@
 #include "TCPServerSocket.h"
 
 TCPServerSocket::TCPServerSocket(const string& _bindIP, uint16_t _basePort, port_type _portType )
-    : ServerSocket( _bindIP, _basePort, _portType ) {
+    : StreamServerSocket( _bindIP, _basePort, _portType ) {
 
     socketaddr = Sockets::createSocketAddress( bindIP, bindPort );
 
@@ -26,10 +26,10 @@
 
 
 
-#include "ServerSocket.h"
+#include "StreamServerSocket.h"
 
 
-class TCPServerSocket : public ServerSocket{
+class TCPServerSocket : public StreamServerSocket{
 
     ptr< sockaddr_in > socketaddr;
 
@@ -39,9 +39,9 @@ public:
 
     TCPServerSocket(const string &_bindIP, uint16_t _basePort, port_type  _portType);
 
-    void touch();
+    void touch() override;
 
-    int getDescriptor();
+    int getDescriptor() override;
 
     ~TCPServerSocket() override;
 
@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TCPTransport.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ConnectionRefusedException.h"
+#include "exceptions/FatalError.h"
+
+#include <netinet/tcp.h>
+
+#include "InProcessNetwork.h"
+#include "Sockets.h"
+#include "TCPServerSocket.h"
+#include "ZMQNetwork.h"
+
+#include "TCPTransport.h"
+
+
+TCPTransport::TCPTransport( TransportType _type ) : type( _type ) {}
+
+
+ptr< Network > TCPTransport::createNetwork( Schain& _sChain ) {
+    if ( type == TransportType::IN_PROCESS )
+        return make_shared< InProcessNetwork >( _sChain );
+    return make_shared< ZMQNetwork >( _sChain );
+}
+
+
+ptr< StreamServerSocket > TCPTransport::createServerSocket(
+    const string& _bindIP, uint16_t _basePort, port_type _portType ) {
+    return make_shared< TCPServerSocket >( _bindIP, _basePort, _portType );
+}
+
+
+int TCPTransport::connect( const string& _ip, uint16_t _port ) {
+    auto remoteAddr = Sockets::createSocketAddress( _ip, _port );
+    CHECK_STATE( remoteAddr )
+
+    int s;
+
+    if ( ( s = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP ) ) < 0 ) {
+        BOOST_THROW_EXCEPTION(
+            FatalError( "Could not create outgoing socket:" + string( strerror( errno ) ) ) );
+    }
+
+    if ( ::connect( s, ( sockaddr* ) remoteAddr.get(), sizeof( sockaddr_in ) ) < 0 ) {
+        auto error = errno;
+        close( s );
+        BOOST_THROW_EXCEPTION( ConnectionRefusedException(
+            "Couldnt connect to:" + _ip + ":" + to_string( _port ), error, __CLASS_NAME__ ) );
+    }
+
+    // requests are small writes followed by a read, Nagle would delay them
+    int one = 1;
+    setsockopt( s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+
+    return s;
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TCPTransport.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "Transport.h"
+
+
+// Nodes on different hosts: ZMQ (or in process) broadcast and TCP request/response.
+
+class TCPTransport : public Transport {
+
+    const TransportType type;
+
+public:
+
+    explicit TCPTransport( TransportType _type );
+
+    ptr< Network > createNetwork( Schain& _sChain ) override;
+
+    ptr< StreamServerSocket > createServerSocket(
+        const string& _bindIP, uint16_t _basePort, port_type _portType ) override;
+
+    int connect( const string& _ip, uint16_t _port ) override;
+};
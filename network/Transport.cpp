@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Transport.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/InvalidArgumentException.h"
+
+#include "FaultInjectionTransport.h"
+#include "ReplayTransport.h"
+#include "SharedMemoryTransport.h"
+#include "TCPTransport.h"
+
+#include "Transport.h"
+
+
+Transport& Transport::get() {
+    if constexpr ( TEST_HOOKS_ENABLED ) {
+        static FaultInjectionTransport faultInjectionTransport;
+        return faultInjectionTransport;
+    }
+
+    return getSelected();
+}
+
+
+Transport& Transport::getSelected() {
+    static TCPTransport zmqTransport( TransportType::ZMQ );
+    static TCPTransport inProcessTransport( TransportType::IN_PROCESS );
+    static SharedMemoryTransport sharedMemoryTransport;
+    static ReplayTransport replayTransport;
+
+    switch ( Network::getTransport() ) {
+    case TransportType::IN_PROCESS:
+        return inProcessTransport;
+    case TransportType::SHARED_MEMORY:
+        return sharedMemoryTransport;
+    case TransportType::REPLAY:
+        return replayTransport;
+    default:
+        return zmqTransport;
+    }
+}
+
+
+TransportType Transport::parseType( const string& _name ) {
+    if ( _name == "zmq" )
+        return TransportType::ZMQ;
+    if ( _name == "in_process" )
+        return TransportType::IN_PROCESS;
+    if ( _name == "shared_memory" )
+        return TransportType::SHARED_MEMORY;
+    if ( _name == "replay" )
+        return TransportType::REPLAY;
+
+    BOOST_THROW_EXCEPTION(
+        InvalidArgumentException( "Unknown transport:" + _name, __CLASS_NAME__ ) );
+}
+
+
+string Transport::getTypeName( TransportType _type ) {
+    switch ( _type ) {
+    case TransportType::IN_PROCESS:
+        return "in_process";
+    case TransportType::SHARED_MEMORY:
+        return "shared_memory";
+    case TransportType::REPLAY:
+        return "replay";
+    default:
+        return "zmq";
+    }
+}
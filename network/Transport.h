@@ -0,0 +1,66 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file Transport.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include "Network.h"
+
+class Schain;
+class StreamServerSocket;
+
+
+// Carries both channels between nodes: the broadcast channel of consensus messages
+// (a Network) and the request/response channel of proposals and catchup (a
+// StreamServerSocket and connect()).
+//
+// The request/response side is descriptor based, so IO and the epoll server loop
+// work the same for every transport.
+
+class Transport {
+
+protected:
+
+    // transport selected by Network::setTransport, without the fault injection decorator
+    static Transport& getSelected();
+
+public:
+
+    virtual ~Transport() = default;
+
+    virtual ptr< Network > createNetwork( Schain& _sChain ) = 0;
+
+    virtual ptr< StreamServerSocket > createServerSocket(
+        const string& _bindIP, uint16_t _basePort, port_type _portType ) = 0;
+
+    // returns a connected stream descriptor, throws ConnectionRefusedException
+    virtual int connect( const string& _ip, uint16_t _port ) = 0;
+
+    // transport selected by Network::setTransport. When built with the test hooks it is
+    // wrapped in a FaultInjectionTransport
+    static Transport& get();
+
+    static TransportType parseType( const string& _name );
+
+    static string getTypeName( TransportType _type );
+};
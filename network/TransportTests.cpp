@@ -0,0 +1,89 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TransportTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ConnectionRefusedException.h"
+
+#include "thirdparty/catch.hpp"
+
+#include "FaultInjectionTransport.h"
+#include "Transport.h"
+#include "UnixServerSocket.h"
+
+
+static constexpr uint16_t TRANSPORT_TEST_BASE_PORT = 23000;
+
+
+TEST_CASE( "Transport names", "[transport]" ) {
+    for ( auto type :
+        { TransportType::ZMQ, TransportType::IN_PROCESS, TransportType::SHARED_MEMORY,
+            TransportType::REPLAY } ) {
+        REQUIRE( Transport::parseType( Transport::getTypeName( type ) ) == type );
+    }
+
+    REQUIRE_THROWS( Transport::parseType( "carrier_pigeon" ) );
+}
+
+
+TEST_CASE( "Fault injection wraps the transport only with the test hooks", "[transport]" ) {
+    auto decorated = dynamic_cast< FaultInjectionTransport* >( &Transport::get() ) != nullptr;
+    REQUIRE( decorated == TEST_HOOKS_ENABLED );
+}
+
+
+TEST_CASE( "Shared memory transport connects over unix sockets", "[transport]" ) {
+    auto previous = Network::getTransport();
+    Network::setTransport( TransportType::SHARED_MEMORY );
+
+    auto& transport = Transport::get();
+
+    auto serverSocket =
+        transport.createServerSocket( "127.0.0.1", TRANSPORT_TEST_BASE_PORT, port_type::PROPOSAL );
+
+    auto path = UnixServerSocket::getPath( "127.0.0.1", TRANSPORT_TEST_BASE_PORT + PROPOSAL );
+    REQUIRE( access( path.c_str(), F_OK ) == 0 );
+
+    int client = transport.connect( "127.0.0.1", TRANSPORT_TEST_BASE_PORT + PROPOSAL );
+    int server = accept( serverSocket->getDescriptor(), nullptr, nullptr );
+    REQUIRE( server > 0 );
+
+    string request( "proposal" );
+    REQUIRE( write( client, request.data(), request.size() ) == ( ssize_t ) request.size() );
+
+    char received[16] = {};
+    REQUIRE( read( server, received, sizeof( received ) ) == ( ssize_t ) request.size() );
+    REQUIRE( string( received ) == request );
+
+    close( client );
+    close( server );
+
+    serverSocket->closeAndCleanupAll();
+    REQUIRE( access( path.c_str(), F_OK ) != 0 );
+
+    REQUIRE_THROWS_AS( transport.connect( "127.0.0.1", TRANSPORT_TEST_BASE_PORT + PROPOSAL ),
+        ConnectionRefusedException );
+
+    Network::setTransport( previous );
+}
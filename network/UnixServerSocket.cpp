@@ -0,0 +1,107 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file UnixServerSocket.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include "UnixServerSocket.h"
+
+
+string UnixServerSocket::getPath( const string& _ip, uint16_t _port ) {
+    return "/tmp/skale-consensus-" + _ip + "-" + to_string( _port ) + ".sock";
+}
+
+
+sockaddr_un UnixServerSocket::createAddress( const string& _path ) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    CHECK_ARGUMENT( _path.size() < sizeof( address.sun_path ) );
+    strncpy( address.sun_path, _path.c_str(), sizeof( address.sun_path ) - 1 );
+    return address;
+}
+
+
+UnixServerSocket::UnixServerSocket(
+    const string& _bindIP, uint16_t _basePort, port_type _portType )
+    : StreamServerSocket( _bindIP, _basePort, _portType ),
+      path( getPath( bindIP, ( uint16_t ) bindPort ) ),
+      descriptor( 0 ) {
+    LOG( debug, "Creating unix listen socket " + path );
+
+    auto address = createAddress( path );
+
+    int s;
+
+    if ( ( s = socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 ) {
+        BOOST_THROW_EXCEPTION( FatalError( "Could not create read socket" ) );
+    }
+
+    // left over by a node that did not exit cleanly
+    unlink( path.c_str() );
+
+    if ( ::bind( s, ( sockaddr* ) &address, sizeof( address ) ) < 0 ) {
+        close( s );
+        BOOST_THROW_EXCEPTION(
+            FatalError( "Could not bind the unix socket: error " + to_string( errno ) ) );
+    }
+
+    listen( s, SOCKET_BACKLOG );
+
+    descriptor = s;
+
+    CHECK_STATE( descriptor > 0 );
+}
+
+
+UnixServerSocket::~UnixServerSocket() {
+    closeAndCleanupAll();
+}
+
+
+void UnixServerSocket::touch() {
+    int s = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+    if ( s < 0 )
+        return;
+
+    auto address = createAddress( path );
+    ::connect( s, ( sockaddr* ) &address, sizeof( address ) );
+    close( s );
+}
+
+
+int UnixServerSocket::getDescriptor() {
+    CHECK_STATE( descriptor );
+    return descriptor;
+}
+
+
+void UnixServerSocket::closeAndCleanupAll() {
+    auto previous = descriptor.exchange( 0 );
+    if ( previous != 0 ) {
+        close( previous );
+        unlink( path.c_str() );
+    }
+}
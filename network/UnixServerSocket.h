@@ -0,0 +1,56 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file UnixServerSocket.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#pragma once
+
+#include <sys/un.h>
+
+#include "StreamServerSocket.h"
+
+
+// Listening AF_UNIX stream socket for nodes on the same host. The path is derived from
+// the bind IP and port, so clients find it the same way they find a TCP server.
+
+class UnixServerSocket : public StreamServerSocket {
+
+    string path;
+
+    atomic< int > descriptor;
+
+public:
+
+    static string getPath( const string& _ip, uint16_t _port );
+
+    static sockaddr_un createAddress( const string& _path );
+
+    UnixServerSocket( const string& _bindIP, uint16_t _basePort, port_type _portType );
+
+    void touch() override;
+
+    int getDescriptor() override;
+
+    ~UnixServerSocket() override;
+
+    void closeAndCleanupAll() override;
+};
@@ -37,6 +37,7 @@
 #include "exceptions/NetworkProtocolException.h"
 #include "messages/NetworkMessage.h"
 #include "messages/NetworkMessageEnvelope.h"
+#include "monitoring/StageMetrics.h"
 #include "node/NodeInfo.h"
 #include "pendingqueue/PendingTransactionsAgent.h"
 
@@ -61,7 +62,12 @@ bool ZMQNetwork::sendMessage(
         _remoteNodeInfo );
 
 
-    return interruptableSend( s, buf.data(), buf.size() );
+    if ( !interruptableSend( s, buf.data(), buf.size() ) )
+        return false;
+
+    sChain->getStageMetrics()->messageSent( _remoteNodeInfo->getSchainIndex(), buf.size() );
+
+    return true;
 }
 
 
@@ -109,11 +115,6 @@ uint64_t ZMQNetwork::interruptableRecv( void* _socket, void* _buf, size_t _len )
 
 
 bool ZMQNetwork::interruptableSend( void* _socket, void* _buf, size_t _len ) {
-    auto simulatedDelay = sChain->getNode()->getSimulateNetworkWriteDelayMs();
-
-    if ( simulatedDelay > 0 )
-        usleep( 1000 * sChain->getNode()->getSimulateNetworkWriteDelayMs() );
-
     int rc;
 
 
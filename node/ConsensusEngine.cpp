@@ -32,6 +32,8 @@
 #include "exceptions/FatalError.h"
 #include "thirdparty/json.hpp"
 #include "threads/GlobalThreadRegistry.h"
+#include "threads/TimerWheel.h"
+#include "threads/WorkStealingExecutor.h"
 
 #include "zmq.h"
 
@@ -75,11 +77,14 @@
 #include <libff/common/profiling.hpp>
 
 
+#include "spdlog/async.h"
 #include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
 
 #include "chains/Schain.h"
+#include "pendingqueue/PendingTransactionsAgent.h"
+#include "pendingqueue/TransactionIntakeQueue.h"
 #include "exceptions/EngineInitException.h"
 #include "json/JSONFactory.h"
 #include "libBLS/bls/BLSPrivateKeyShare.h"
@@ -101,6 +106,8 @@
 
 #include "ENGINE_VERSION"
 
+#include "microprofile.h"
+
 using namespace boost::filesystem;
 
 
@@ -110,6 +117,12 @@ recursive_mutex ConsensusEngine::logMutex;
 
 atomic< uint64_t > ConsensusEngine::engineCounter;
 
+uint64_t ConsensusEngine::loggingEngines = 0;
+
+bool ConsensusEngine::ownsLogThreadPool = false;
+
+terminate_handler ConsensusEngine::previousTerminateHandler = nullptr;
+
 
 void ConsensusEngine::logInit() {
     engineID = ++engineCounter;
@@ -118,6 +131,18 @@ void ConsensusEngine::logInit() {
 
     spdlog::flush_every( std::chrono::seconds( 1 ) );
 
+    // the host may have created the pool already, replacing it would break its async loggers
+    if ( !spdlog::thread_pool() ) {
+        spdlog::init_thread_pool( LOG_ASYNC_QUEUE_SIZE, LOG_ASYNC_THREADS );
+        ownsLogThreadPool = true;
+    }
+
+    loggingEngines++;
+
+    if ( !previousTerminateHandler ) {
+        previousTerminateHandler = set_terminate( &ConsensusEngine::terminateHandler );
+    }
+
     logThreadLocal_ = nullptr;
 
 
@@ -181,15 +206,23 @@ const string ConsensusEngine::getLogDir() {
 }
 
 shared_ptr< spdlog::logger > ConsensusEngine::createLogger( const string& loggerName ) {
+    LOCK( logMutex )
+
     shared_ptr< spdlog::logger > logger = spdlog::get( loggerName );
 
     if ( !logger ) {
         if (!logFileNamePrefix.empty()) {
-            logger = make_shared< spdlog::logger >( loggerName, logRotatingFileSync );
-            logger->flush_on( debug );
+            logger = make_shared< spdlog::async_logger >( loggerName, logRotatingFileSync,
+                spdlog::thread_pool(), spdlog::async_overflow_policy::block );
         } else {
-            logger = spdlog::stdout_color_mt( loggerName, spdlog::color_mode::never );
+            logger = make_shared< spdlog::async_logger >( loggerName,
+                make_shared< spdlog::sinks::stdout_color_sink_mt >( spdlog::color_mode::never ),
+                spdlog::thread_pool(), spdlog::async_overflow_policy::block );
         }
+        // registered so that flushLogs() and spdlog::shutdown() reach it
+        spdlog::register_logger( logger );
+        // warnings and errors are written out without waiting for the periodic flush
+        logger->flush_on( warn );
         logger->set_pattern( "%+", spdlog::pattern_time_type::utc );
     }
 
@@ -199,6 +232,39 @@ shared_ptr< spdlog::logger > ConsensusEngine::createLogger( const string& logger
 }
 
 
+void ConsensusEngine::flushLogs() {
+    spdlog::apply_all( []( const ptr< spdlog::logger >& _logger ) { _logger->flush(); } );
+}
+
+
+void ConsensusEngine::terminateHandler() {
+    // destroying the pool drains its queue, the process is going down anyway
+    spdlog::shutdown();
+
+    if ( previousTerminateHandler ) {
+        previousTerminateHandler();
+    }
+
+    abort();
+}
+
+
+void ConsensusEngine::logShutdown() {
+    LOCK( logMutex )
+
+    CHECK_STATE( loggingEngines > 0 );
+
+    if ( --loggingEngines > 0 || !ownsLogThreadPool ) {
+        flushLogs();
+        return;
+    }
+
+    // drains the queue and joins the logging thread, the next engine creates a new pool
+    spdlog::shutdown();
+    ownsLogThreadPool = false;
+}
+
+
 void ConsensusEngine::setConfigLogLevel( string& _s ) {
     auto configLogLevel = SkaleLog::logLevelFromString( _s );
     CHECK_STATE( configLogger != nullptr );
@@ -211,20 +277,27 @@ void ConsensusEngine::logConfig(
     configLogger->log( _severity, _className + ": " + _message );
 }
 
-void ConsensusEngine::log(
-    level_enum _severity, const string& _message, const string& _className ) {
+void ConsensusEngine::log( spdlog::logger* _logger, level_enum _severity, const string& _message ) {
+    CHECK_ARGUMENT( _logger );
+
     if ( logThreadLocal_ == nullptr ) {
-        CHECK_STATE( configLogger != nullptr );
-        configLogger->log( _severity, _message );
+        _logger->log( _severity, _message );
     } else {
-        auto engine = logThreadLocal_->getEngine();
-        CHECK_STATE( engine );
+        _logger->log( _severity, "{}:{}", SkaleLog::getBlockIDForLog(), _message );
+    }
+}
 
-        string fullMessage =
-            to_string( ( uint64_t ) engine->getLargestCommittedBlockID() ) + ":" + _message;
 
-        logThreadLocal_->loggerForClass( _className.c_str() )->log( _severity, fullMessage );
-    }
+spdlog::logger* ConsensusEngine::getConfigLogger() {
+    return configLogger.get();
+}
+
+
+ptr< spdlog::logger > ConsensusEngine::setConfigLogger( const ptr< spdlog::logger >& _logger ) {
+    LOCK( logMutex )
+    auto previous = configLogger;
+    configLogger = _logger;
+    return previous;
 }
 
 
@@ -451,7 +524,8 @@ void ConsensusEngine::parseTestConfigsAndCreateAllNodes( const fs_path& dirname
             BOOST_THROW_EXCEPTION( FatalError( "No valid node dirs found" ) );
         }
 
-        CHECK_STATE( nodeCount == nodes.size() );
+        // the replay tool creates only the node of the trace
+        CHECK_STATE( nodeCount == nodes.size() || !nodeIDs.empty() );
 
         BinConsensusInstance::initHistory( nodes.begin()->second->getSchain()->getNodeCount() );
 
@@ -548,6 +622,15 @@ node_count ConsensusEngine::nodesCount() {
     return node_count( nodes.size() );
 }
 
+vector< ptr< Node > > ConsensusEngine::getNodes() {
+    vector< ptr< Node > > result;
+    for ( auto&& item : nodes ) {
+        CHECK_STATE( item.second );
+        result.push_back( item.second );
+    }
+    return result;
+}
+
 
 std::string ConsensusEngine::exec( const char* cmd ) {
     CHECK_ARGUMENT( cmd );
@@ -602,8 +685,20 @@ void ConsensusEngine::init() {
 
     threadRegistry = make_shared< GlobalThreadRegistry >();
 
+    GlobalThreadRegistry::installDumpSignalHandler();
+
+    executor = make_shared< WorkStealingExecutor >(
+        max< uint64_t >( thread::hardware_concurrency(), 1 ), threadRegistry,
+        EXECUTOR_MAX_BLOCKED_WORKERS );
+
+    timerWheel = make_shared< TimerWheel >( executor );
+
     logInit();
 
+#if CONSENSUS_MICROPROFILE
+    MicroProfileSetEnableAllGroups( true );
+#endif
+
     sigset_t sigpipe_mask;
     sigemptyset( &sigpipe_mask );
     sigaddset( &sigpipe_mask, SIGPIPE );
@@ -724,13 +819,18 @@ void ConsensusEngine::exitGracefullyAsync() {
 
         }
 
+        CHECK_STATE( timerWheel );
+
+        // cancels all timers and wakes up threads sleeping on the wheel
+        timerWheel->shutdown();
+
         CHECK_STATE( threadRegistry );
 
         threadRegistry->joinAll();
 
-        for ( auto&& it : nodes ) {
-            it.second->getSchain()->joinMonitorAndTimeoutThreads();
-        }
+        CHECK_STATE( executor );
+
+        executor->shutdown();
     } catch ( exception& e ) {
         SkaleException::logNested( e );
         status = CONSENSUS_EXITED;
@@ -742,6 +842,12 @@ ConsensusEngine::~ConsensusEngine() {
     exitGracefullyBlocking();
     std::cerr << "nodes.clear()!!" << std::endl;
     nodes.clear();
+
+    try {
+        logShutdown();
+    } catch ( exception& e ) {
+        SkaleException::logNested( e );
+    }
 }
 
 
@@ -761,6 +867,24 @@ block_id ConsensusEngine::getLargestCommittedBlockID() {
     return id;
 }
 
+block_id ConsensusEngine::getSmallestCommittedBlockID() {
+    CHECK_STATE( !nodes.empty() );
+
+    block_id id = UINT64_MAX;
+
+    for ( auto&& item : nodes ) {
+        CHECK_STATE( item.second );
+
+        auto id2 = item.second->getSchain()->getLastCommittedBlockID();
+
+        if ( id2 < id ) {
+            id = id2;
+        }
+    }
+
+    return id;
+}
+
 u256 ConsensusEngine::getPriceForBlockId( uint64_t _blockId ) const {
     CHECK_STATE( nodes.size() == 1 );
 
@@ -773,6 +897,44 @@ u256 ConsensusEngine::getPriceForBlockId( uint64_t _blockId ) const {
 }
 
 
+size_t ConsensusEngine::submitTransactions(
+    vector< vector< uint8_t > >&& _transactions, const u256& _stateRoot,
+    uint64_t _stateRootBlockId ) {
+    CHECK_STATE( nodes.size() > 0 );
+
+    lock_guard< std::mutex > lock( submitTransactionsLock );
+
+    vector< ptr< TransactionIntakeQueue > > queues;
+
+    uint64_t accepted = _transactions.size();
+
+    for ( auto&& item : nodes ) {
+        CHECK_STATE( item.second );
+        auto queue = item.second->getSchain()->getPendingTransactionsAgent()->getIntakeQueue();
+        accepted = min( accepted, queue->getFreeSpace() );
+        queues.push_back( queue );
+    }
+
+    vector< ptr< vector< uint8_t > > > transactions;
+    transactions.reserve( accepted );
+
+    for ( uint64_t i = 0; i < accepted; i++ ) {
+        CHECK_ARGUMENT2( !_transactions[i].empty(), "Empty transaction submitted" );
+    }
+
+    for ( uint64_t i = 0; i < accepted; i++ ) {
+        transactions.push_back( make_shared< vector< uint8_t > >( move( _transactions[i] ) ) );
+    }
+
+    // nodes of a test engine share the transaction buffers, they are never modified
+    for ( auto&& queue : queues ) {
+        queue->push( transactions, _stateRoot, _stateRootBlockId );
+    }
+
+    return accepted;
+}
+
+
 bool ConsensusEngine::onTravis = false;
 
 bool ConsensusEngine::noUlimitCheck = false;
@@ -807,6 +969,20 @@ ptr< GlobalThreadRegistry > ConsensusEngine::getThreadRegistry() const {
     return threadRegistry;
 }
 
+string ConsensusEngine::getThreadsAndQueuesJSON() const {
+    return getThreadRegistry()->toJSON().dump();
+}
+
+ptr< WorkStealingExecutor > ConsensusEngine::getExecutor() const {
+    CHECK_STATE( executor );
+    return executor;
+}
+
+ptr< TimerWheel > ConsensusEngine::getTimerWheel() const {
+    CHECK_STATE( timerWheel );
+    return timerWheel;
+}
+
 const string& ConsensusEngine::getHealthCheckDir() const {
     CHECK_STATE( healthCheckDir != "");
     return healthCheckDir;
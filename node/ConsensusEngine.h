@@ -45,6 +45,8 @@ using namespace spdlog::level;
 
 class GlobalThreadRegistry;
 class StorageLimits;
+class WorkStealingExecutor;
+class TimerWheel;
 
 
 class ConsensusEngine : public ConsensusInterface {
@@ -78,6 +80,10 @@ class ConsensusEngine : public ConsensusInterface {
 
     ptr< GlobalThreadRegistry > threadRegistry;
 
+    ptr< WorkStealingExecutor > executor;
+
+    ptr< TimerWheel > timerWheel;
+
     uint64_t engineID = 0;
 
     recursive_mutex mutex;
@@ -99,6 +105,19 @@ class ConsensusEngine : public ConsensusInterface {
     string logDir;
 
     static recursive_mutex logMutex;
+
+    // engines between logInit() and destruction, guarded by logMutex
+    static uint64_t loggingEngines;
+
+    // true if logInit() created the spdlog thread pool, so the last engine may shut it down
+    static bool ownsLogThreadPool;
+
+    static terminate_handler previousTerminateHandler;
+
+    // writes out queued log records before the process aborts
+    static void terminateHandler();
+
+    void logShutdown();
     
     string logFileNamePrefix;
 
@@ -106,6 +125,8 @@ class ConsensusEngine : public ConsensusInterface {
 
     ptr<StorageLimits> storageLimits = nullptr;
 
+    std::mutex submitTransactionsLock;
+
 public:
 
     // used for testing only
@@ -131,12 +152,22 @@ public:
 
     [[nodiscard]] const string& getHealthCheckDir() const;
 
-    static void log( level_enum _severity, const string& _message, const string& _className );
+    // _logger is returned by SkaleLog::enabledLogger, use the LOG macro
+    static void log( spdlog::logger* _logger, level_enum _severity, const string& _message );
+
+    static spdlog::logger* getConfigLogger();
+
+    // used for testing only, replaces the logger used by threads without a node
+    // and returns the previous one
+    static ptr< spdlog::logger > setConfigLogger( const ptr< spdlog::logger >& _logger );
 
     static void logConfig( level_enum _severity, const string& _message, const string& _className );
 
     ptr< spdlog::logger > createLogger( const string& loggerName );
 
+    // asks the async loggers to write out the records queued so far
+    static void flushLogs();
+
     const string getDataDir();
     
     const string getLogDir();
@@ -189,8 +220,12 @@ public:
 
     node_count nodesCount();
 
+    vector< ptr< Node > > getNodes();
+
     block_id getLargestCommittedBlockID();
 
+    block_id getSmallestCommittedBlockID();
+
     explicit ConsensusEngine( block_id _lastId = 0 );
 
     ~ConsensusEngine() override;
@@ -240,12 +275,24 @@ public:
 
     u256 getPriceForBlockId( uint64_t _blockId ) const override;
 
+    size_t submitTransactions(
+        vector< vector< uint8_t > >&& _transactions, const u256& _stateRoot,
+        uint64_t _stateRootBlockId ) override;
+
     void systemHealthCheck();
 
     static string getEngineVersion();
 
     [[nodiscard]] ptr< GlobalThreadRegistry > getThreadRegistry() const;
 
+    // threads with their CPU time and queues with their depth and waiting times, as JSON.
+    // Can be served by an admin call, SIGUSR1 writes it to the health check dir
+    [[nodiscard]] string getThreadsAndQueuesJSON() const;
+
+    [[nodiscard]] ptr< WorkStealingExecutor > getExecutor() const;
+
+    [[nodiscard]] ptr< TimerWheel > getTimerWheel() const;
+
     void setTestKeys(const string& _sgxServerURL, string _configFile, uint64_t _totalNodes,
         uint64_t _requiredNodes );
 
@@ -75,6 +75,26 @@ public:
     virtual void setEmptyBlockIntervalMs(uint64_t) {}
 
     virtual consensus_engine_status getStatus() const = 0;
+
+    /* Push model for pending transactions, an alternative to ConsensusExtFace::pendingTransactions.
+     Transactions are moved into a queue owned by consensus, a proposer that waits for transactions
+     is woken up immediately. Once the host submitted transactions, pendingTransactions is not
+     called anymore.
+
+     _stateRoot is the state root after the host processed block _stateRootBlockId. The proposal
+     of the next block waits for this state root, so the host has to submit after each block it
+     processes, with no transactions if it has none.
+
+     Returns the number of transactions taken from the front of _transactions, the rest do not fit
+     into the queue and are left intact, they can be submitted again later.
+
+     A transaction that was taken is proposed until a committed block includes it, it is then
+     passed to ConsensusExtFace::createBlock. Transactions of a proposal that lost are put back
+     into the queue, the host does not resubmit them.
+     */
+    virtual size_t submitTransactions(std::vector<std::vector<uint8_t> >&& /*_transactions*/,
+                                      const u256& /*_stateRoot*/,
+                                      uint64_t /*_stateRootBlockId*/) { return 0; }
 };
 
 /**
@@ -84,6 +104,14 @@ class ConsensusExtFace {
 public:
     typedef std::vector<std::vector<uint8_t> > transactions_vector;
 
+    // read-only view of a transaction of a committed block
+    struct transaction_view {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    typedef std::vector<transaction_view> transactions_view;
+
     // Returns hashes and bytes of new transactions as well as state root to put into block proposal
     virtual transactions_vector pendingTransactions(size_t _limit, u256& _stateRoot) = 0;
 
@@ -92,6 +120,23 @@ public:
                              uint32_t _timeStampMillis, uint64_t _blockID, u256 _gasPrice,
                              u256 _stateRoot, uint64_t _winningNodeIndex) = 0;
 
+    // Same as createBlock, but the transactions are not copied. The views point into the
+    // committed block and are valid only until the call returns.
+    // The default implementation copies the transactions and calls createBlock
+    virtual void createBlockFromView(const transactions_view &_approvedTransactions, uint64_t _timeStamp,
+                                     uint32_t _timeStampMillis, uint64_t _blockID, u256 _gasPrice,
+                                     u256 _stateRoot, uint64_t _winningNodeIndex) {
+        transactions_vector transactions;
+        transactions.reserve(_approvedTransactions.size());
+
+        for (auto &&transaction : _approvedTransactions) {
+            transactions.emplace_back(transaction.data, transaction.data + transaction.size);
+        }
+
+        createBlock(transactions, _timeStamp, _timeStampMillis, _blockID, _gasPrice, _stateRoot,
+                    _winningNodeIndex);
+    }
+
     virtual ~ConsensusExtFace() = default;
 
     virtual void terminateApplication() {};
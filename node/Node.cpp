@@ -60,9 +60,10 @@
 #include "db/SigDB.h"
 #include "messages/Message.h"
 #include "messages/NetworkMessageEnvelope.h"
+#include "monitoring/MessageTrace.h"
 #include "network/Sockets.h"
-#include "network/TCPServerSocket.h"
-#include "network/ZMQNetwork.h"
+#include "network/StreamServerSocket.h"
+#include "network/Transport.h"
 #include "network/ZMQSockets.h"
 #include "json/JSONFactory.h"
 #include "db/StorageLimits.h"
@@ -214,6 +215,9 @@ void Node::initParamsFromConfig() {
     maxTransactionsPerBlock = getParamUint64("maxTransactionsPerBlock", MAX_TRANSACTIONS_PER_BLOCK);
     minBlockIntervalMs = getParamUint64("minBlockIntervalMs", MIN_BLOCK_INTERVAL_MS);
 
+    string noTrace = "";
+    traceDir = getParamString("traceDir", noTrace);
+
 
     blockDBSize = getParamUint64("blockDBSize", storageLimits->getBlockDbSize());
     proposalHashDBSize = getParamUint64("proposalHashDBSize", storageLimits->getProposalHashDbSize() );
@@ -232,6 +236,11 @@ void Node::initParamsFromConfig() {
 
     simulateNetworkWriteDelayMs = getParamInt64("simulateNetworkWriteDelayMs", 0);
 
+    if (!TEST_HOOKS_ENABLED && simulateNetworkWriteDelayMs > 0) {
+        LOG(warn, "Built without test hooks, ignoring simulateNetworkWriteDelayMs");
+        simulateNetworkWriteDelayMs = 0;
+    }
+
     testConfig = make_shared<TestConfig>(cfg);
 }
 
@@ -270,9 +279,19 @@ void Node::startServers() {
 
     sChain->constructServers(sockets);
 
+    if (!traceDir.empty()) {
+        TraceHeader header;
+        header.nodeID = (uint64_t) nodeID;
+        header.schainIndex = (uint64_t) sChain->getSchainIndex();
+        header.nodeCount = (uint64_t) sChain->getNodeCount();
+        header.startBlockID = (uint64_t) getBlockDB()->readLastCommittedBlockID();
+        traceWriter = make_shared<TraceWriter>(
+            traceDir + "/consensus_trace_" + to_string(nodeID) + ".bin", header);
+    }
+
     LOG(trace, " Creating consensus network");
 
-    network = make_shared<ZMQNetwork>(*sChain);
+    network = Transport::get().createNetwork(*sChain);
 
     LOG(trace, " Starting consensus messaging");
 
@@ -296,6 +315,7 @@ void Node::startClients() {
     if( isExitRequested() )
         return;
     releaseGlobalClientBarrier();
+    network->startDeferredMessagesTimer();
 }
 
 void Node::testNodeInfos() {
@@ -483,13 +503,16 @@ void Node::exitOnFatalError(const string &_message) {
         return;
     exit();
 
+    // logged and flushed first, the application may exit as soon as it is asked to
+    LOG(critical, _message);
+    ConsensusEngine::flushLogs();
+
     //    consensusEngine->joinAll();
     auto extFace = consensusEngine->getExtFace();
 
     if (extFace) {
         extFace->terminateApplication();
     }
-    LOG(critical, _message);
 }
 
 bool Node::isSgxEnabled() {
@@ -51,6 +51,7 @@ class PriceDB;
 class ProposalHashDB;
 class ProposalVectorDB;
 class MsgDB;
+class TraceWriter;
 class ConsensusStateDB;
 class TestConfig;
 class BlockSigShareDB;
@@ -177,6 +178,11 @@ class Node {
 
     uint64_t minBlockIntervalMs = 0;
 
+    // capture of received messages and ExtFace calls, off when empty
+    string traceDir;
+
+    ptr< TraceWriter > traceWriter;
+
     uint64_t blockDBSize = 0;;
     uint64_t proposalHashDBSize = 0;
     uint64_t proposalVectorDBSize = 0;
@@ -332,6 +338,9 @@ public:
 
     uint64_t getMinBlockIntervalMs() const;
 
+    // nullptr unless traceDir is set
+    ptr< TraceWriter > getTraceWriter() const;
+
     uint64_t getWaitAfterNetworkErrorMs();
 
     uint64_t getParamUint64( const string& _paramName, uint64_t paramDefault );
@@ -277,6 +277,10 @@ uint64_t Node::getMinBlockIntervalMs() const {
     return minBlockIntervalMs;
 }
 
+ptr<TraceWriter> Node::getTraceWriter() const {
+    return traceWriter;
+}
+
 uint64_t Node::getBlockDBSize() const {
     return blockDBSize;
 }
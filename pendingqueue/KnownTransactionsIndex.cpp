@@ -0,0 +1,204 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file KnownTransactionsIndex.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include "datastructures/Transaction.h"
+
+#include "KnownTransactionsIndex.h"
+
+
+KnownTransactionsIndex::KnownTransactionsIndex( uint64_t _capacity, uint64_t _shardCount )
+    : shardCount( _shardCount ), shards( _shardCount ) {
+    CHECK_ARGUMENT( _capacity > 0 );
+    CHECK_ARGUMENT( _shardCount > 0 );
+    CHECK_ARGUMENT( ( _shardCount & ( _shardCount - 1 ) ) == 0 );
+
+    auto shardCapacity = ( _capacity + _shardCount - 1 ) / _shardCount;
+
+    // at most half of the slots are used, so that probe sequences stay short
+    slotBits = 1;
+    while ( ( 1ULL << slotBits ) < 2 * shardCapacity ) {
+        slotBits++;
+    }
+    slotMask = ( 1ULL << slotBits ) - 1;
+
+    for ( auto&& shard : shards ) {
+        shard.slots.resize( slotMask + 1 );
+        shard.fifo.resize( shardCapacity );
+    }
+}
+
+
+uint64_t KnownTransactionsIndex::keyOf( const uint8_t* _partialHash ) {
+    static_assert( PARTIAL_HASH_LEN == sizeof( uint64_t ) );
+    CHECK_ARGUMENT( _partialHash );
+    uint64_t key;
+    memcpy( &key, _partialHash, sizeof( key ) );
+    return key;
+}
+
+
+uint64_t KnownTransactionsIndex::keyOf( const partial_sha_hash& _partialHash ) {
+    return keyOf( _partialHash.data() );
+}
+
+
+uint64_t KnownTransactionsIndex::shardOf( uint64_t _key ) const {
+    return _key & ( shardCount - 1 );
+}
+
+
+uint64_t KnownTransactionsIndex::homeSlot( uint64_t _key ) const {
+    // the low bits pick the shard, the slot is taken from the high ones
+    return ( _key * 0x9E3779B97F4A7C15ULL ) >> ( 64 - slotBits );
+}
+
+
+uint64_t KnownTransactionsIndex::probe( const Shard& _shard, uint64_t _key ) const {
+    auto i = homeSlot( _key );
+    while ( _shard.slots[i].transaction && _shard.slots[i].key != _key ) {
+        i = ( i + 1 ) & slotMask;
+    }
+    return i;
+}
+
+
+void KnownTransactionsIndex::erase( Shard& _shard, uint64_t _slot ) {
+    // backward shift deletion, entries after the hole move into it unless that would put
+    // them before their home slot
+    auto hole = _slot;
+    auto i = _slot;
+
+    while ( true ) {
+        i = ( i + 1 ) & slotMask;
+
+        if ( !_shard.slots[i].transaction )
+            break;
+
+        auto home = homeSlot( _shard.slots[i].key );
+
+        // distances from the home slot, modulo the table size
+        if ( ( ( i - home ) & slotMask ) >= ( ( i - hole ) & slotMask ) ) {
+            _shard.slots[hole] = move( _shard.slots[i] );
+            hole = i;
+        }
+    }
+
+    _shard.slots[hole].transaction = nullptr;
+}
+
+
+bool KnownTransactionsIndex::insert( uint64_t _key, const ptr< Transaction >& _transaction ) {
+    CHECK_ARGUMENT( _transaction );
+
+    auto& shard = shards[shardOf( _key )];
+
+    lock_guard< mutex > lock( shard.lock );
+
+    auto i = probe( shard, _key );
+
+    if ( shard.slots[i].transaction )
+        return false;
+
+    auto capacity = shard.fifo.size();
+
+    if ( shard.count == capacity ) {
+        erase( shard, probe( shard, shard.fifo[shard.head] ) );
+        shard.head = ( shard.head + 1 ) % capacity;
+        shard.count--;
+        // the deletion may have moved the free slot of the key
+        i = probe( shard, _key );
+    }
+
+    shard.slots[i].key = _key;
+    shard.slots[i].transaction = _transaction;
+
+    shard.fifo[( shard.head + shard.count ) % capacity] = _key;
+    shard.count++;
+
+    return true;
+}
+
+
+ptr< Transaction > KnownTransactionsIndex::find( uint64_t _key ) {
+    auto& shard = shards[shardOf( _key )];
+
+    lock_guard< mutex > lock( shard.lock );
+
+    return shard.slots[probe( shard, _key )].transaction;
+}
+
+
+void KnownTransactionsIndex::findBatch(
+    const uint64_t* _keys, uint64_t _count, vector< ptr< Transaction > >& _result ) {
+    CHECK_ARGUMENT( _keys || _count == 0 );
+
+    _result.assign( _count, nullptr );
+
+    // counting sort of the key indices by shard
+    vector< uint64_t > shardBegin( shardCount + 1, 0 );
+
+    for ( uint64_t i = 0; i < _count; i++ ) {
+        shardBegin[shardOf( _keys[i] ) + 1]++;
+    }
+
+    for ( uint64_t s = 0; s < shardCount; s++ ) {
+        shardBegin[s + 1] += shardBegin[s];
+    }
+
+    vector< uint64_t > order( _count );
+    auto next = shardBegin;
+
+    for ( uint64_t i = 0; i < _count; i++ ) {
+        order[next[shardOf( _keys[i] )]++] = i;
+    }
+
+    for ( uint64_t s = 0; s < shardCount; s++ ) {
+        if ( shardBegin[s] == shardBegin[s + 1] )
+            continue;
+
+        auto& shard = shards[s];
+
+        lock_guard< mutex > lock( shard.lock );
+
+        for ( auto j = shardBegin[s]; j < shardBegin[s + 1]; j++ ) {
+            auto i = order[j];
+            _result[i] = shard.slots[probe( shard, _keys[i] )].transaction;
+        }
+    }
+}
+
+
+uint64_t KnownTransactionsIndex::size() {
+    uint64_t result = 0;
+
+    for ( auto&& shard : shards ) {
+        lock_guard< mutex > lock( shard.lock );
+        result += shard.count;
+    }
+
+    return result;
+}
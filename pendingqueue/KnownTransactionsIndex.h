@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file KnownTransactionsIndex.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_KNOWNTRANSACTIONSINDEX_H
+#define SKALED_KNOWNTRANSACTIONSINDEX_H
+
+
+class Transaction;
+
+// Transactions known to the node by their partial hash.
+//
+// The table is split into shards by the key, each shard is an open addressing table with
+// linear probing behind its own lock. When a shard is full, the transaction that was inserted
+// into it first is evicted. Partial hashes are taken from transaction hashes, so their bits are
+// used as is to pick the shard and the slot.
+
+class KnownTransactionsIndex {
+
+    struct Slot {
+        uint64_t key = 0;
+        ptr< Transaction > transaction;  // nullptr if the slot is empty
+    };
+
+    struct alignas( 64 ) Shard {
+        mutex lock;
+
+        vector< Slot > slots;  // guarded by lock
+
+        // keys in insertion order, the oldest at head
+        vector< uint64_t > fifo;  // guarded by lock
+
+        uint64_t head = 0;  // guarded by lock
+
+        uint64_t count = 0;  // guarded by lock
+    };
+
+    const uint64_t shardCount;
+
+    uint64_t slotMask = 0;
+
+    uint64_t slotBits = 0;
+
+    vector< Shard > shards;
+
+    uint64_t shardOf( uint64_t _key ) const;
+
+    uint64_t homeSlot( uint64_t _key ) const;
+
+    // returns the slot of the key, or of the empty slot that ends its probe sequence
+    uint64_t probe( const Shard& _shard, uint64_t _key ) const;
+
+    void erase( Shard& _shard, uint64_t _slot );
+
+public:
+
+    // _shardCount has to be a power of two
+    KnownTransactionsIndex( uint64_t _capacity, uint64_t _shardCount );
+
+    static uint64_t keyOf( const uint8_t* _partialHash );
+
+    static uint64_t keyOf( const partial_sha_hash& _partialHash );
+
+    // returns false if the key is already known
+    bool insert( uint64_t _key, const ptr< Transaction >& _transaction );
+
+    ptr< Transaction > find( uint64_t _key );
+
+    // _result[i] is the transaction of _keys[i] or nullptr, each shard is locked once
+    void findBatch( const uint64_t* _keys, uint64_t _count, vector< ptr< Transaction > >& _result );
+
+    uint64_t size();
+};
+
+
+#endif  // SKALED_KNOWNTRANSACTIONSINDEX_H
@@ -0,0 +1,206 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file KnownTransactionsIndexTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "datastructures/Transaction.h"
+
+#include "KnownTransactionsIndex.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t KNOWN_TEST_READERS = 8;
+static constexpr uint64_t KNOWN_TEST_BATCHES = 40;
+
+
+// partial hashes are hash bytes, so the test keys have to be random too
+static uint64_t testKey( uint64_t _i ) {
+    uint64_t z = _i + 0x9E3779B97F4A7C15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    return z ^ ( z >> 31 );
+}
+
+
+static ptr< Transaction > testTransaction( uint64_t _i ) {
+    return make_shared< Transaction >(
+        make_shared< vector< uint8_t > >( 1, ( uint8_t )( _i + 1 ) ), false );
+}
+
+
+TEST_CASE( "Known transactions are evicted oldest first", "[known-transactions]" ) {
+    KnownTransactionsIndex index( 64, 1 );
+
+    for ( uint64_t i = 0; i < 64; i++ ) {
+        REQUIRE( index.insert( testKey( i ), testTransaction( i ) ) );
+    }
+
+    REQUIRE( !index.insert( testKey( 5 ), testTransaction( 5 ) ) );
+    REQUIRE( index.size() == 64 );
+
+    for ( uint64_t i = 64; i < 96; i++ ) {
+        REQUIRE( index.insert( testKey( i ), testTransaction( i ) ) );
+    }
+
+    REQUIRE( index.size() == 64 );
+
+    for ( uint64_t i = 0; i < 96; i++ ) {
+        auto transaction = index.find( testKey( i ) );
+        if ( i < 32 ) {
+            REQUIRE( transaction == nullptr );
+        } else {
+            REQUIRE( transaction );
+            REQUIRE( transaction->getData()->at( 0 ) == ( uint8_t )( i + 1 ) );
+        }
+    }
+}
+
+
+TEST_CASE( "Known transactions are looked up in batches", "[known-transactions]" ) {
+    KnownTransactionsIndex index( KNOWN_TRANSACTIONS_HISTORY, KNOWN_TRANSACTIONS_SHARDS );
+
+    // a long history, so that every shard evicts many times
+    for ( uint64_t i = 0; i < 3 * KNOWN_TRANSACTIONS_HISTORY; i++ ) {
+        index.insert( testKey( i ), testTransaction( i ) );
+    }
+
+    REQUIRE( index.size() <= KNOWN_TRANSACTIONS_HISTORY );
+
+    vector< uint64_t > keys;
+    for ( uint64_t i = 0; i < MAX_TRANSACTIONS_PER_BLOCK; i++ ) {
+        // every other key has been evicted long ago
+        keys.push_back( testKey( i % 2 ? 3 * KNOWN_TRANSACTIONS_HISTORY - 1 - i : i ) );
+    }
+
+    vector< ptr< Transaction > > result;
+    index.findBatch( keys.data(), keys.size(), result );
+
+    REQUIRE( result.size() == keys.size() );
+
+    for ( uint64_t i = 0; i < keys.size(); i++ ) {
+        REQUIRE( result[i] == index.find( keys[i] ) );
+        REQUIRE( ( result[i] != nullptr ) == ( i % 2 == 1 ) );
+    }
+}
+
+
+TEST_CASE( "Known transactions lookup under contention", "[known-transactions]" ) {
+    vector< ptr< Transaction > > transactions;
+    vector< uint64_t > keys;
+
+    for ( uint64_t i = 0; i < 2 * KNOWN_TRANSACTIONS_HISTORY; i++ ) {
+        transactions.push_back( testTransaction( i ) );
+        keys.push_back( testKey( i ) );
+    }
+
+    // the proposal receivers look up the last block's worth of transactions while new
+    // transactions are pushed
+    auto run = [&]( const function< void( uint64_t ) >& _insert,
+                   const function< uint64_t( const uint64_t*, uint64_t ) >& _lookup ) {
+        for ( uint64_t i = 0; i < KNOWN_TRANSACTIONS_HISTORY; i++ ) {
+            _insert( i );
+        }
+
+        atomic< bool > done = false;
+        atomic< uint64_t > found = 0;
+
+        auto begin = chrono::steady_clock::now();
+
+        thread writer( [&]() {
+            // keeps evicting and pushing again the transactions the readers look up
+            for ( uint64_t i = KNOWN_TRANSACTIONS_HISTORY; !done; i++ ) {
+                _insert( i % transactions.size() );
+            }
+        } );
+
+        vector< thread > readers;
+        for ( uint64_t r = 0; r < KNOWN_TEST_READERS; r++ ) {
+            readers.emplace_back( [&]() {
+                for ( uint64_t b = 0; b < KNOWN_TEST_BATCHES; b++ ) {
+                    found += _lookup(
+                        keys.data() + KNOWN_TRANSACTIONS_HISTORY - MAX_TRANSACTIONS_PER_BLOCK,
+                        MAX_TRANSACTIONS_PER_BLOCK );
+                }
+            } );
+        }
+
+        for ( auto&& reader : readers ) {
+            reader.join();
+        }
+
+        auto elapsed = chrono::duration_cast< chrono::milliseconds >(
+            chrono::steady_clock::now() - begin )
+                           .count();
+
+        done = true;
+        writer.join();
+
+        return make_pair( elapsed, ( uint64_t ) found );
+    };
+
+    KnownTransactionsIndex index( KNOWN_TRANSACTIONS_HISTORY, KNOWN_TRANSACTIONS_SHARDS );
+
+    auto [shardedMs, shardedFound] = run(
+        [&]( uint64_t _i ) { index.insert( keys[_i], transactions[_i] ); },
+        [&]( const uint64_t* _keys, uint64_t _count ) {
+            vector< ptr< Transaction > > result;
+            index.findBatch( _keys, _count, result );
+            uint64_t count = 0;
+            for ( auto&& t : result ) {
+                count += ( t != nullptr );
+            }
+            return count;
+        } );
+
+    // a single locked map that is looked up one hash at a time
+    recursive_mutex mapLock;
+    unordered_map< uint64_t, ptr< Transaction > > knownMap;
+    deque< uint64_t > order;
+
+    auto [singleLockMs, singleLockFound] = run(
+        [&]( uint64_t _i ) {
+            LOCK( mapLock )
+            if ( !knownMap.emplace( keys[_i], transactions[_i] ).second )
+                return;
+            order.push_back( keys[_i] );
+            if ( order.size() > KNOWN_TRANSACTIONS_HISTORY ) {
+                knownMap.erase( order.front() );
+                order.pop_front();
+            }
+        },
+        [&]( const uint64_t* _keys, uint64_t _count ) {
+            uint64_t count = 0;
+            for ( uint64_t i = 0; i < _count; i++ ) {
+                LOCK( mapLock )
+                count += knownMap.count( _keys[i] );
+            }
+            return count;
+        } );
+
+    cerr << "Known transactions lookup:readers:" << KNOWN_TEST_READERS
+         << ":batches:" << KNOWN_TEST_BATCHES << ":sharded ms:" << shardedMs
+         << ":single lock ms:" << singleLockMs << ":found:" << shardedFound << ":"
+         << singleLockFound << endl;
+}
@@ -25,10 +25,13 @@
 #include "SkaleCommon.h"
 #include "db/BlockDB.h"
 #include "db/CacheLevelDB.h"
+#include "exceptions/ExitRequestedException.h"
 #include "exceptions/FatalError.h"
 #include "leveldb/db.h"
 #include "thirdparty/json.hpp"
 #include <monitoring/LivelinessMonitor.h>
+#include "monitoring/MessageTrace.h"
+#include "monitoring/StageMetrics.h"
 #include <unordered_set>
 
 #include "PendingTransactionsAgent.h"
@@ -36,6 +39,7 @@
 #include "crypto/CryptoManager.h"
 #include "crypto/BLAKE3Hash.h"
 #include "datastructures/BlockProposal.h"
+#include "datastructures/CommittedBlock.h"
 #include "datastructures/MyBlockProposal.h"
 #include "datastructures/PartialHashesList.h"
 #include "datastructures/Transaction.h"
@@ -43,7 +47,10 @@
 #include "db/CommittedTransactionDB.h"
 #include "node/ConsensusEngine.h"
 #include "node/Node.h"
+#include "pendingqueue/KnownTransactionsIndex.h"
 #include "pendingqueue/TestMessageGeneratorAgent.h"
+#include "pendingqueue/TransactionIntakeQueue.h"
+#include "threads/TimerWheel.h"
 #include "utils/Time.h"
 
 #include "microprofile.h"
@@ -52,39 +59,115 @@ using namespace std;
 
 
 PendingTransactionsAgent::PendingTransactionsAgent( Schain& ref_sChain )
-    : Agent(ref_sChain, false)  {}
+    : Agent(ref_sChain, false)  {
+    intakeQueue = make_shared<TransactionIntakeQueue>(PENDING_TRANSACTIONS_INTAKE_CAPACITY);
+    knownTransactions = make_shared<KnownTransactionsIndex>(KNOWN_TRANSACTIONS_HISTORY,
+                                                            KNOWN_TRANSACTIONS_SHARDS);
+}
+
+ptr<TransactionIntakeQueue> PendingTransactionsAgent::getIntakeQueue() const {
+    CHECK_STATE(intakeQueue);
+    return intakeQueue;
+}
+
+ptr<vector<ptr<vector<uint8_t>>>> PendingTransactionsAgent::popIntakeTransactions(size_t _limit) {
+
+    auto result = make_shared<vector<ptr<vector<uint8_t>>>>();
+
+    auto startTimeMs = Time::getSteadyTimeMs();
+
+    while (true) {
+
+        getSchain()->getNode()->exitCheck();
+
+        auto elapsedMs = Time::getSteadyTimeMs() - startTimeMs;
+        auto emptyBlockIntervalMs = getSchain()->getNode()->getEmptyBlockIntervalMs();
+
+        uint64_t waitMs = 0;
+
+        // a push wakes the wait up, the timeout only bounds the exit check interval
+        if (this->sChain->getLastCommittedBlockID() > 0 && elapsedMs < emptyBlockIntervalMs)
+            waitMs = min(PENDING_TRANSACTIONS_POLL_INTERVAL_MS, emptyBlockIntervalMs - elapsedMs);
+
+        if (intakeQueue->pop(_limit, waitMs, *result) || waitMs == 0)
+            return result;
+    }
+}
+
+u256 PendingTransactionsAgent::waitForIntakeStateRoot(block_id _blockId) {
+
+    auto startTimeMs = Time::getSteadyTimeMs();
+    auto lastWarningMs = startTimeMs;
+
+    u256 stateRoot = 0;
+
+    while (!intakeQueue->getStateRoot(_blockId, PENDING_TRANSACTIONS_POLL_INTERVAL_MS, stateRoot)) {
+
+        getSchain()->getNode()->exitCheck();
+
+        auto nowMs = Time::getSteadyTimeMs();
+
+        if (nowMs - lastWarningMs >= getSchain()->getNode()->getEmptyBlockIntervalMs()) {
+            LOG(warn, "Waiting for the host to submit the state root of block " +
+                      to_string((uint64_t) _blockId) + ":ms:" + to_string(nowMs - startTimeMs));
+            lastWarningMs = nowMs;
+        }
+    }
+
+    return stateRoot;
+}
 
 ptr<BlockProposal> PendingTransactionsAgent::buildBlockProposal(block_id _blockID,
     ptr<TimeStamp> _previousBlockTimeStamp) {
 
+    auto timerWheel = getNode()->getConsensusEngine()->getTimerWheel();
+
+    auto previousBlockTimeMs = _previousBlockTimeStamp->getS() * 1000 +
+                               _previousBlockTimeStamp->getMs();
+
+    // the interval is counted from the previous block, the time it spent in consensus is a part of it
     MICROPROFILE_ENTERI( "PendingTransactionsAgent", "sleep", MP_DIMGRAY );
-    usleep(getNode()->getMinBlockIntervalMs() * 1000);
+    timerWheel->sleepUntilTimeMs(previousBlockTimeMs + getNode()->getMinBlockIntervalMs());
     MICROPROFILE_LEAVE();
 
-    auto result  = createTransactionsListForProposal();
-    auto transactions = result.first;
-    CHECK_STATE(transactions);
-    auto stateRoot = result.second;
+    MEASURE_STAGE(STAGE_PROPOSAL_BUILD)
 
-/*
-    if (getSchain()->getSchainIndex() != 1) {
-        transactions->clear();
+    ptr<TransactionList> transactionList = nullptr;
+    u256 stateRoot = 0;
+
+    if (!takeSpeculativeTransactions(transactionList)) {
+        auto result = createTransactionsListForProposal();
+        auto transactions = result.first;
+        CHECK_STATE(transactions);
+        stateRoot = result.second;
+        transactionList = make_shared<TransactionList>(transactions);
+    } else if (!intakeQueue->isEnabled()) {
+        // test message generator
+        stateRoot = 7;
+    }
+
+    // the transactions may have been pulled before the previous block was committed,
+    // its state root is only known once the host has processed it
+    if (intakeQueue->isEnabled()) {
+        stateRoot = waitForIntakeStateRoot(_blockID - 1);
     }
-    */
 
-    while (Time::getCurrentTimeMs() <= _previousBlockTimeStamp->getS() * 1000 +
-                                            _previousBlockTimeStamp->getMs()) {
-        usleep(10);
+    if (intakeQueue->isEnabled()) {
+        lock_guard<mutex> lock(speculationLock);
+        proposedTransactions[_blockID] = transactionList;
     }
 
-    auto transactionList = make_shared<TransactionList>(transactions);
+    // the proposal time stamp has to be strictly larger than the previous one
+    while (Time::getCurrentTimeMs() <= previousBlockTimeMs) {
+        timerWheel->sleepUntilTimeMs(previousBlockTimeMs + 1);
+    }
 
     auto stamp = TimeStamp::getCurrentTimeStamp();
 
     auto myBlockProposal = make_shared<MyBlockProposal>(*sChain, _blockID, sChain->getSchainIndex(),
             transactionList, stateRoot, stamp->getS(), stamp->getMs(), getSchain()->getCryptoManager());
 
-    LOG(trace, "Created proposal, transactions:" + to_string(transactions->size()));
+    LOG(trace, "Created proposal, transactions:" + to_string(transactionList->size()));
 
     auto pHashesList = myBlockProposal->createPartialHashesList();
     CHECK_STATE(pHashesList);
@@ -97,6 +180,7 @@ ptr<BlockProposal> PendingTransactionsAgent::buildBlockProposal(block_id _blockI
 pair<ptr<vector<ptr<Transaction>>>, u256> PendingTransactionsAgent::createTransactionsListForProposal() {
 
     MONITOR2( __CLASS_NAME__, __FUNCTION__, getSchain()->getMaxExternalBlockProcessingTime() )
+    MEASURE_STAGE(STAGE_PENDING_PULL)
 
     auto result = make_shared<vector<ptr<Transaction>>>();
 
@@ -109,6 +193,16 @@ pair<ptr<vector<ptr<Transaction>>>, u256> PendingTransactionsAgent::createTransa
     u256 stateRoot = 0;
     static u256 stateRootSample = 1;
 
+    if (intakeQueue->isEnabled()) {
+        auto transactions = popIntakeTransactions(need_max);
+        for (auto&& data : *transactions) {
+            auto pt = make_shared<Transaction>(data, false);
+            result->push_back(pt);
+            pushKnownTransaction(pt);
+        }
+        return {result, stateRoot};
+    }
+
     while( txVector.empty() ){
 
         getSchain()->getNode()->exitCheck();
@@ -116,6 +210,11 @@ pair<ptr<vector<ptr<Transaction>>>, u256> PendingTransactionsAgent::createTransa
         if (sChain->getExtFace()) {
             txVector = sChain->getExtFace()->pendingTransactions(need_max, stateRoot);
 
+            if (auto traceWriter = getNode()->getTraceWriter()) {
+                traceWriter->recordPendingTransactions(
+                        (uint64_t) sChain->getLastCommittedBlockID() + 1, txVector, stateRoot);
+            }
+
             // exit immediately if exitGracefully has been requested
             getSchain()->getNode()->exitCheck();
         } else {
@@ -128,16 +227,21 @@ pair<ptr<vector<ptr<Transaction>>>, u256> PendingTransactionsAgent::createTransa
         boost::posix_time::ptime t2 = boost::posix_time::microsec_clock::local_time();
         boost::posix_time::time_duration diff = t2 - t1;
 
-        if( this->sChain->getLastCommittedBlockID() == 0 || (uint64_t ) diff.total_milliseconds() >= getSchain()->getNode()->getEmptyBlockIntervalMs())
+        auto elapsedMs = (uint64_t ) diff.total_milliseconds();
+        auto emptyBlockIntervalMs = getSchain()->getNode()->getEmptyBlockIntervalMs();
+
+        if( this->sChain->getLastCommittedBlockID() == 0 || elapsedMs >= emptyBlockIntervalMs)
             break;
 
-        usleep(100 * 1000);
+        // wake up exactly at the empty block deadline if it comes before the next poll
+        getNode()->getConsensusEngine()->getTimerWheel()->sleepFor(
+            min(PENDING_TRANSACTIONS_POLL_INTERVAL_MS, emptyBlockIntervalMs - elapsedMs));
 
     }// while
 
-    for(const auto& e: txVector ){
-        ptr<Transaction> pt = Transaction::deserialize( make_shared<std::vector<uint8_t>>(e),
-                0,e.size(), false );
+    for(auto& e: txVector ){
+        // the transaction takes over the bytes returned by the host
+        auto pt = make_shared<Transaction>(make_shared<std::vector<uint8_t>>(move(e)), false);
         result->push_back(pt);
         pushKnownTransaction(pt);
     }
@@ -146,41 +250,193 @@ pair<ptr<vector<ptr<Transaction>>>, u256> PendingTransactionsAgent::createTransa
 }
 
 
-ptr<Transaction> PendingTransactionsAgent::getKnownTransactionByPartialHash(const ptr<partial_sha_hash> hash) {
-    LOCK(transactionsMutex);
-    if (knownTransactions.count(hash))
-        return knownTransactions.at(hash);
-    return nullptr;
+void PendingTransactionsAgent::pullAvailableTransactions(size_t _limit,
+                                                         vector<ptr<Transaction>>& _result) {
+
+    auto start = _result.size();
+
+    if (intakeQueue->isEnabled()) {
+        vector<ptr<vector<uint8_t>>> intakeTransactions;
+        intakeQueue->pop(_limit, 0, intakeTransactions);
+        for (auto&& data : intakeTransactions) {
+            _result.push_back(make_shared<Transaction>(data, false));
+        }
+    } else {
+        for (auto& e : sChain->getTestMessageGeneratorAgent()->pendingTransactions(_limit)) {
+            _result.push_back(
+                    make_shared<Transaction>(make_shared<std::vector<uint8_t>>(move(e)), false));
+        }
+    }
+
+    for (auto i = start; i < _result.size(); i++) {
+        pushKnownTransaction(_result[i]);
+    }
 }
 
-void PendingTransactionsAgent::pushKnownTransaction(const ptr<Transaction>& _transaction) {
 
-    CHECK_ARGUMENT(_transaction);
+void PendingTransactionsAgent::prepareNextProposal() {
+
+    // the state root has to be read after the commit
+    if (sChain->getExtFace() && !intakeQueue->isEnabled())
+        return;
 
-    LOCK(transactionsMutex);
+    try {
+        lock_guard<mutex> lock(speculationLock);
 
-    if (knownTransactions.count(_transaction->getPartialHash())) {
-        LOG(trace, "Duplicate transaction pushed to known transactions");
+        if (speculativeTransactions)
+            return;
+
+        auto transactions = make_shared<vector<ptr<Transaction>>>();
+
+        pullAvailableTransactions(getNode()->getMaxTransactionsPerBlock(), *transactions);
+
+        if (transactions->empty())
+            return;
+
+        auto list = make_shared<TransactionList>(transactions);
+
+        // hashes the transactions and caches the root
+        CHECK_STATE(list->calculateTopMerkleRoot());
+
+        speculativeTransactions = list;
+
+    } catch (ExitRequestedException&) {
         return;
+    } catch (exception& e) {
+        SkaleException::logNested(e);
     }
+}
+
+
+void PendingTransactionsAgent::blockCommitted(const ptr<CommittedBlock>& _block) {
+
+    CHECK_ARGUMENT(_block);
+
+    lock_guard<mutex> lock(speculationLock);
+
+    // the intake queue does not have the transactions of proposals that lost anymore and the
+    // host does not know about them, so they are taken into the next proposal
+    vector<ptr<Transaction>> lost;
+
+    unordered_set<ptr<partial_sha_hash>, Hasher, Equal> committed;
+
+    for (auto&& transaction : *_block->getTransactionList()->getItems()) {
+        committed.insert(transaction->getPartialHash());
+    }
+
+    auto end = proposedTransactions.upper_bound(_block->getBlockID());
+
+    for (auto it = proposedTransactions.begin(); it != end; it++) {
+        for (auto&& transaction : *it->second->getItems()) {
+            if (committed.count(transaction->getPartialHash()) == 0)
+                lost.push_back(transaction);
+        }
+    }
+
+    proposedTransactions.erase(proposedTransactions.begin(), end);
+
+    if (lost.empty() && (!speculativeTransactions || committed.empty()))
+        return;
+
+    // the lost transactions were pulled first, they stay in front of the prepared ones
+    auto remaining = make_shared<vector<ptr<Transaction>>>(move(lost));
+
+    auto lostCount = remaining->size();
+
+    if (speculativeTransactions) {
+        for (auto&& transaction : *speculativeTransactions->getItems()) {
+            if (committed.count(transaction->getPartialHash()) == 0)
+                remaining->push_back(transaction);
+        }
+    }
+
+    if (lostCount == 0 && remaining->size() == speculativeTransactions->size())
+        return;
+
+    size_t need_max = getNode()->getMaxTransactionsPerBlock();
+
+    if (remaining->size() > need_max) {
+        vector<ptr<vector<uint8_t>>> overflow;
+        for (auto i = need_max; i < remaining->size(); i++) {
+            overflow.push_back((*remaining)[i]->getData());
+        }
+        remaining->resize(need_max);
+        intakeQueue->pushFront(overflow);
+    }
+
+    speculativeTransactions = remaining->empty() ? nullptr : make_shared<TransactionList>(remaining);
+}
+
+
+bool PendingTransactionsAgent::takeSpeculativeTransactions(ptr<TransactionList>& _transactions) {
+
+    lock_guard<mutex> lock(speculationLock);
+
+    if (!speculativeTransactions)
+        return false;
+
+    _transactions = speculativeTransactions;
+    speculativeTransactions = nullptr;
+
+    // the list was prepared while the previous block was in consensus, transactions that
+    // arrived since then are added so that the proposal is not under-filled
+    size_t need_max = getNode()->getMaxTransactionsPerBlock();
+
+    if (_transactions->size() < need_max) {
+        auto transactions = make_shared<vector<ptr<Transaction>>>(*_transactions->getItems());
+
+        pullAvailableTransactions(need_max - transactions->size(), *transactions);
+
+        if (transactions->size() > _transactions->size())
+            _transactions = make_shared<TransactionList>(transactions);
+    }
+
+    return true;
+}
+
+
+ptr<Transaction> PendingTransactionsAgent::getKnownTransactionByPartialHash(const ptr<partial_sha_hash> hash) {
+    CHECK_ARGUMENT(hash);
+    return knownTransactions->find(KnownTransactionsIndex::keyOf(*hash));
+}
+
+
+void PendingTransactionsAgent::getKnownTransactionsByPartialHashes(
+        const ptr<PartialHashesList>& _hashes, vector<ptr<Transaction>>& _result) {
+
+    CHECK_ARGUMENT(_hashes);
+
+    auto count = (uint64_t) _hashes->getTransactionCount();
+    auto hashes = _hashes->getPartialHashes();
+
+    CHECK_STATE(hashes->size() >= count * PARTIAL_HASH_LEN);
+
+    vector<uint64_t> keys(count);
+
+    for (uint64_t i = 0; i < count; i++) {
+        keys[i] = KnownTransactionsIndex::keyOf(hashes->data() + i * PARTIAL_HASH_LEN);
+    }
+
+    knownTransactions->findBatch(keys.data(), count, _result);
+}
+
+
+void PendingTransactionsAgent::pushKnownTransaction(const ptr<Transaction>& _transaction) {
+
+    CHECK_ARGUMENT(_transaction);
 
     auto partialHash =  _transaction->getPartialHash();
 
     CHECK_STATE(partialHash);
 
-    knownTransactions[partialHash] = _transaction;
-
-    while (knownTransactions.size() > KNOWN_TRANSACTIONS_HISTORY) {
-        auto tx = knownTransactions.begin()->first;
-        CHECK_STATE(tx);
-        knownTransactions.erase(tx);
+    if (!knownTransactions->insert(KnownTransactionsIndex::keyOf(*partialHash), _transaction)) {
+        LOG(trace, "Duplicate transaction pushed to known transactions");
     }
 }
 
 
 uint64_t PendingTransactionsAgent::getKnownTransactionsSize() {
-    LOCK(transactionsMutex);
-    return knownTransactions.size();
+    return knownTransactions->size();
 }
 
 
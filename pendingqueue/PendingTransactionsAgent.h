@@ -31,6 +31,10 @@ class Schain;
 class BlockProposal;
 class PartialHashesList;
 class Transaction;
+class TransactionIntakeQueue;
+class TransactionList;
+class CommittedBlock;
+class KnownTransactionsIndex;
 
 #include "db/CacheLevelDB.h"
 
@@ -80,14 +84,36 @@ private:
         }
     };
 
-    unordered_map<ptr<partial_sha_hash>, ptr<Transaction> , Hasher, Equal> knownTransactions;
-
-    recursive_mutex transactionsMutex;
+    ptr<KnownTransactionsIndex> knownTransactions;
 
     transaction_count transactionCounter = 0;
 
+    ptr<TransactionIntakeQueue> intakeQueue;
+
+    // transactions of the next proposal, prepared while the previous block is in consensus
+    mutex speculationLock;
+
+    ptr<TransactionList> speculativeTransactions = nullptr; // guarded by speculationLock
+
+    // transactions taken from the intake queue for the proposals of blocks that are not
+    // committed yet, the ones a committed block does not include go back to the queue
+    map<block_id, ptr<TransactionList>> proposedTransactions; // guarded by speculationLock
+
+    // returns false if there are no prepared transactions, otherwise tops them up with the
+    // transactions available now
+    bool takeSpeculativeTransactions(ptr<TransactionList>& _transactions);
+
+    // takes up to _limit transactions without waiting and appends them to _result
+    void pullAvailableTransactions(size_t _limit, vector<ptr<Transaction>>& _result);
+
     pair<ptr<vector<ptr<Transaction>>>, u256> createTransactionsListForProposal();
 
+    // used once the host submitted transactions through ConsensusEngine::submitTransactions
+    ptr<vector<ptr<vector<uint8_t>>>> popIntakeTransactions(size_t _limit);
+
+    // waits until the host submitted the state root it has after processing _blockId
+    u256 waitForIntakeStateRoot(block_id _blockId);
+
 public:
 
     explicit PendingTransactionsAgent(Schain& _sChain);
@@ -98,8 +124,24 @@ public:
 
     ptr<Transaction> getKnownTransactionByPartialHash(ptr<partial_sha_hash> hash);
 
+    // _result[i] is the known transaction for the i-th hash of the list or nullptr
+    void getKnownTransactionsByPartialHashes(const ptr<PartialHashesList>& _hashes,
+                                             vector<ptr<Transaction>>& _result);
+
     ptr<BlockProposal> buildBlockProposal(block_id _blockID, ptr<TimeStamp> _timeStamp);
 
+    ptr<TransactionIntakeQueue> getIntakeQueue() const;
+
+    // Pulls the transactions available now and builds the transaction list and its merkle root,
+    // so that only the time stamp and the signature are left when the proposal is built.
+    // Not used when transactions are polled from ConsensusExtFace, since the state root returned
+    // together with them is only valid after the previous block has been committed
+    void prepareNextProposal();
+
+    // drops the committed transactions from the prepared ones. Transactions that this node
+    // proposed and the block does not include are proposed again before the prepared ones
+    void blockCommitted(const ptr<CommittedBlock>& _block);
+
     ~PendingTransactionsAgent() override = default;
 
 
@@ -31,6 +31,11 @@
 #include "exceptions/FatalError.h"
 #include "node/ConsensusEngine.h"
 #include "thirdparty/json.hpp"
+#include "utils/Time.h"
+
+
+atomic<uint64_t> TestMessageGeneratorAgent::transactionsPerSecond = 0;
+atomic<uint64_t> TestMessageGeneratorAgent::transactionSize = 200;
 
 
 TestMessageGeneratorAgent::TestMessageGeneratorAgent(Schain& _sChain_) : Agent(_sChain_, false) {
@@ -38,10 +43,17 @@ TestMessageGeneratorAgent::TestMessageGeneratorAgent(Schain& _sChain_) : Agent(_
 }
 
 
+void TestMessageGeneratorAgent::setLoad(uint64_t _transactionsPerSecond, uint64_t _transactionSize) {
+    CHECK_ARGUMENT(_transactionSize >= 8);
+    transactionsPerSecond = _transactionsPerSecond;
+    transactionSize = _transactionSize;
+}
+
+
 
 ConsensusExtFace::transactions_vector TestMessageGeneratorAgent::pendingTransactions( size_t _limit ) {
 
-    uint64_t  messageSize = 200;
+    uint64_t  messageSize = transactionSize;
 
     ConsensusExtFace::transactions_vector result;
 
@@ -53,6 +65,17 @@ ConsensusExtFace::transactions_vector TestMessageGeneratorAgent::pendingTransact
     if (test == SchainTest::NONE)
         return result;
 
+    uint64_t rate = transactionsPerSecond;
+
+    if (rate > 0) {
+        // offer the transactions that arrived at the rate since the first call
+        auto now = Time::getSteadyTimeUs();
+        if (startTimeUs == 0)
+            startTimeUs = now;
+        auto arrived = (uint64_t) ((__uint128_t) rate * (now - startTimeUs) / 1000000);
+        _limit = min((uint64_t) _limit, arrived > counter ? arrived - counter : 0);
+    }
+
     for (uint64_t i = 0; i < _limit; i++) {
 
         vector<uint8_t> transaction(messageSize);
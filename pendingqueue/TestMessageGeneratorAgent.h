@@ -31,10 +31,19 @@ class Schain;
 
 class TestMessageGeneratorAgent : Agent {
     uint64_t counter = 0;
+
+    uint64_t startTimeUs = 0;
+
+    // transactions per second each node offers, 0 fills every block
+    static atomic<uint64_t> transactionsPerSecond;
+    static atomic<uint64_t> transactionSize;
+
 public:
 
     explicit TestMessageGeneratorAgent(Schain& _sChain);
 
+    static void setLoad(uint64_t _transactionsPerSecond, uint64_t _transactionSize);
+
     ConsensusExtFace::transactions_vector pendingTransactions( size_t _limit);
 
 };
@@ -0,0 +1,150 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TransactionIntakeQueue.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+
+#include "TransactionIntakeQueue.h"
+
+
+TransactionIntakeQueue::TransactionIntakeQueue( uint64_t _capacity )
+    : capacity( _capacity ), ring( _capacity ) {
+    CHECK_ARGUMENT( _capacity > 0 );
+}
+
+
+bool TransactionIntakeQueue::isEnabled() const {
+    return enabled;
+}
+
+
+uint64_t TransactionIntakeQueue::getFreeSpace() {
+    lock_guard< mutex > lock( queueLock );
+    return count < capacity ? capacity - count : 0;
+}
+
+
+uint64_t TransactionIntakeQueue::getSize() {
+    lock_guard< mutex > lock( queueLock );
+    return count;
+}
+
+
+bool TransactionIntakeQueue::getStateRoot(
+    block_id _blockId, uint64_t _timeoutMs, u256& _stateRoot ) {
+    unique_lock< mutex > lock( queueLock );
+
+    if ( stateRootBlockId < _blockId && _timeoutMs > 0 ) {
+        queueCond.wait_for( lock, chrono::milliseconds( _timeoutMs ),
+            [this, _blockId]() { return stateRootBlockId >= _blockId; } );
+    }
+
+    if ( stateRootBlockId != _blockId )
+        return false;
+
+    _stateRoot = stateRoot;
+
+    return true;
+}
+
+
+void TransactionIntakeQueue::push( const vector< ptr< vector< uint8_t > > >& _transactions,
+    const u256& _stateRoot, block_id _stateRootBlockId ) {
+    {
+        lock_guard< mutex > lock( queueLock );
+
+        CHECK_ARGUMENT( count <= capacity && _transactions.size() <= capacity - count );
+
+        for ( auto&& transaction : _transactions ) {
+            CHECK_ARGUMENT( transaction && !transaction->empty() );
+            ring[( head + count ) % ring.size()] = transaction;
+            count++;
+        }
+
+        // pushes of different host threads may arrive out of order
+        if ( _stateRootBlockId >= stateRootBlockId ) {
+            stateRoot = _stateRoot;
+            stateRootBlockId = _stateRootBlockId;
+        }
+
+        enabled = true;
+    }
+
+    queueCond.notify_all();
+}
+
+
+void TransactionIntakeQueue::pushFront( const vector< ptr< vector< uint8_t > > >& _transactions ) {
+    if ( _transactions.empty() )
+        return;
+
+    for ( auto&& transaction : _transactions ) {
+        CHECK_ARGUMENT( transaction && !transaction->empty() );
+    }
+
+    {
+        lock_guard< mutex > lock( queueLock );
+
+        if ( count + _transactions.size() > ring.size() ) {
+            vector< ptr< vector< uint8_t > > > grown( count + _transactions.size() );
+            for ( uint64_t i = 0; i < count; i++ ) {
+                grown[_transactions.size() + i] = move( ring[( head + i ) % ring.size()] );
+            }
+            ring = move( grown );
+            head = _transactions.size();
+        }
+
+        head = ( head + ring.size() - _transactions.size() ) % ring.size();
+
+        for ( uint64_t i = 0; i < _transactions.size(); i++ ) {
+            ring[( head + i ) % ring.size()] = _transactions[i];
+        }
+
+        count += _transactions.size();
+    }
+
+    queueCond.notify_all();
+}
+
+
+bool TransactionIntakeQueue::pop(
+    uint64_t _limit, uint64_t _timeoutMs, vector< ptr< vector< uint8_t > > >& _result ) {
+    unique_lock< mutex > lock( queueLock );
+
+    if ( count == 0 && _timeoutMs > 0 ) {
+        queueCond.wait_for(
+            lock, chrono::milliseconds( _timeoutMs ), [this]() { return count > 0; } );
+    }
+
+    auto popped = min( _limit, count );
+
+    for ( uint64_t i = 0; i < popped; i++ ) {
+        _result.push_back( move( ring[head] ) );
+        head = ( head + 1 ) % ring.size();
+    }
+
+    count -= popped;
+
+    return popped > 0;
+}
@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TransactionIntakeQueue.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_TRANSACTIONINTAKEQUEUE_H
+#define SKALED_TRANSACTIONINTAKEQUEUE_H
+
+
+// Bounded ring buffer of pending transactions pushed by the host through
+// ConsensusEngine::submitTransactions.
+//
+// Transactions are moved in and handed to the proposal as is, the proposer that waits for
+// transactions is woken up by the push instead of polling ConsensusExtFace::pendingTransactions.
+//
+// Each push carries the state root the host has after processing a block and the id of that
+// block. A proposal for block N + 1 only takes the state root pushed for block N.
+//
+// Transactions of a proposal that lost are put back in front of the queue, they are not
+// counted against the capacity the host may fill.
+
+class TransactionIntakeQueue {
+
+    mutex queueLock;
+
+    condition_variable queueCond;
+
+    // the free space the host sees
+    const uint64_t capacity;
+
+    // grows beyond the capacity if transactions are put back into a full queue
+    vector< ptr< vector< uint8_t > > > ring;  // guarded by queueLock
+
+    uint64_t head = 0;  // guarded by queueLock
+
+    uint64_t count = 0;  // guarded by queueLock
+
+    u256 stateRoot = 0;  // guarded by queueLock
+
+    block_id stateRootBlockId = 0;  // guarded by queueLock
+
+    // set by the first push, after that the host is not polled anymore
+    atomic< bool > enabled = false;
+
+public:
+
+    explicit TransactionIntakeQueue( uint64_t _capacity );
+
+    bool isEnabled() const;
+
+    uint64_t getFreeSpace();
+
+    uint64_t getSize();
+
+    // waits up to _timeoutMs for the state root pushed for _blockId, returns false if the
+    // latest state root belongs to an earlier block
+    bool getStateRoot( block_id _blockId, uint64_t _timeoutMs, u256& _stateRoot );
+
+    // _transactions have to fit into the free space and may be empty. _stateRoot is the state
+    // root after block _stateRootBlockId, a state root of an earlier block than the current
+    // one is ignored
+    void push( const vector< ptr< vector< uint8_t > > >& _transactions, const u256& _stateRoot,
+        block_id _stateRootBlockId );
+
+    // puts _transactions back in front of the queue in the given order, so that they are
+    // proposed before the ones pushed after them
+    void pushFront( const vector< ptr< vector< uint8_t > > >& _transactions );
+
+    // waits up to _timeoutMs for transactions, returns false if there are none
+    bool pop( uint64_t _limit, uint64_t _timeoutMs, vector< ptr< vector< uint8_t > > >& _result );
+};
+
+
+#endif  // SKALED_TRANSACTIONINTAKEQUEUE_H
@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TransactionIntakeTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "TransactionIntakeQueue.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t INTAKE_TEST_ROUNDS = 200;
+
+
+static vector< ptr< vector< uint8_t > > > makeTransactions( uint8_t _first, uint64_t _count ) {
+    vector< ptr< vector< uint8_t > > > result;
+    for ( uint64_t i = 0; i < _count; i++ ) {
+        result.push_back( make_shared< vector< uint8_t > >( 1, _first + i ) );
+    }
+    return result;
+}
+
+
+TEST_CASE( "Intake queue keeps order and capacity", "[transaction-intake]" ) {
+    TransactionIntakeQueue queue( 4 );
+
+    REQUIRE( !queue.isEnabled() );
+
+    queue.push( makeTransactions( 1, 3 ), 7, 1 );
+
+    REQUIRE( queue.isEnabled() );
+    REQUIRE( queue.getFreeSpace() == 1 );
+    REQUIRE_THROWS( queue.push( makeTransactions( 10, 2 ), 8, 2 ) );
+
+    vector< ptr< vector< uint8_t > > > popped;
+
+    REQUIRE( queue.pop( 2, 0, popped ) );
+
+    // wraps around the end of the ring
+    queue.push( makeTransactions( 4, 3 ), 8, 2 );
+
+    REQUIRE( queue.pop( 10, 0, popped ) );
+    REQUIRE( popped.size() == 6 );
+
+    for ( uint64_t i = 0; i < popped.size(); i++ ) {
+        REQUIRE( popped[i]->at( 0 ) == i + 1 );
+    }
+
+    REQUIRE( !queue.pop( 10, 0, popped ) );
+    REQUIRE( queue.getSize() == 0 );
+}
+
+
+TEST_CASE( "Transactions put back go in front of the queue", "[transaction-intake]" ) {
+    TransactionIntakeQueue queue( 4 );
+
+    queue.push( makeTransactions( 1, 4 ), 7, 1 );
+
+    vector< ptr< vector< uint8_t > > > popped;
+
+    REQUIRE( queue.pop( 2, 0, popped ) );
+
+    queue.push( makeTransactions( 5, 2 ), 8, 2 );
+
+    // a full queue grows, the host still sees no free space
+    queue.pushFront( popped );
+
+    REQUIRE( queue.getSize() == 6 );
+    REQUIRE( queue.getFreeSpace() == 0 );
+
+    popped.clear();
+
+    REQUIRE( queue.pop( 10, 0, popped ) );
+    REQUIRE( popped.size() == 6 );
+
+    for ( uint64_t i = 0; i < popped.size(); i++ ) {
+        REQUIRE( popped[i]->at( 0 ) == i + 1 );
+    }
+
+    REQUIRE( queue.getFreeSpace() == 4 );
+
+    queue.push( makeTransactions( 7, 4 ), 9, 3 );
+
+    REQUIRE( queue.getSize() == 4 );
+}
+
+
+TEST_CASE( "Intake queue refuses a stale state root", "[transaction-intake]" ) {
+    TransactionIntakeQueue queue( 4 );
+
+    u256 stateRoot = 0;
+
+    queue.push( makeTransactions( 1, 1 ), 7, 1 );
+
+    REQUIRE( queue.getStateRoot( 1, 0, stateRoot ) );
+    REQUIRE( stateRoot == 7 );
+
+    // the host has not processed block 2 yet
+    REQUIRE( !queue.getStateRoot( 2, 10, stateRoot ) );
+
+    // a late push for an earlier block does not replace the state root
+    queue.push( {}, 8, 2 );
+    queue.push( {}, 9, 1 );
+
+    REQUIRE( queue.getStateRoot( 2, 0, stateRoot ) );
+    REQUIRE( stateRoot == 8 );
+
+    // a proposer waiting for the state root is woken up by the push
+    thread host( [&queue]() {
+        usleep( 2000 );
+        queue.push( {}, 10, 3 );
+    } );
+
+    REQUIRE( queue.getStateRoot( 3, 10000, stateRoot ) );
+    REQUIRE( stateRoot == 10 );
+
+    host.join();
+
+    REQUIRE( queue.getSize() == 1 );
+}
+
+
+TEST_CASE( "Proposer waiting for transactions is woken up by a push", "[transaction-intake]" ) {
+    TransactionIntakeQueue queue( PENDING_TRANSACTIONS_INTAKE_CAPACITY );
+
+    uint64_t totalLatencyUs = 0;
+
+    for ( uint64_t i = 0; i < INTAKE_TEST_ROUNDS; i++ ) {
+        atomic< uint64_t > wokenUpUs = 0;
+        atomic< bool > gotTransactions = false;
+
+        thread proposer( [&]() {
+            vector< ptr< vector< uint8_t > > > popped;
+            gotTransactions = queue.pop( MAX_TRANSACTIONS_PER_BLOCK, 10000, popped );
+            wokenUpUs = chrono::duration_cast< chrono::microseconds >(
+                chrono::steady_clock::now().time_since_epoch() )
+                            .count();
+        } );
+
+        // let the proposer start waiting on an empty queue
+        usleep( 2000 );
+
+        auto pushedUs = chrono::duration_cast< chrono::microseconds >(
+            chrono::steady_clock::now().time_since_epoch() )
+                            .count();
+
+        queue.push( makeTransactions( 1, 1 ), 0, i );
+
+        proposer.join();
+
+        REQUIRE( gotTransactions );
+
+        totalLatencyUs += wokenUpUs - pushedUs;
+    }
+
+    auto averageUs = totalLatencyUs / INTAKE_TEST_ROUNDS;
+
+    cerr << "Empty queue to first transaction latency:average us:" << averageUs << endl;
+
+    REQUIRE( averageUs < 1000 );
+}
@@ -28,7 +28,7 @@
 
 
 u256 DynamicPricingStrategy::calculatePrice(u256 _previousPrice,
-                                         const ConsensusExtFace::transactions_vector & _block,
+                                         const ConsensusExtFace::transactions_view & _block,
                                          uint64_t, uint32_t, block_id) {
 
 
@@ -63,7 +63,7 @@ PricingAgent::PricingAgent(Schain &_sChain) : Agent(_sChain, false) {
 }
 
 u256
-PricingAgent::calculatePrice(const ConsensusExtFace::transactions_vector &_approvedTransactions, uint64_t _timeStamp,
+PricingAgent::calculatePrice(const ConsensusExtFace::transactions_view &_approvedTransactions, uint64_t _timeStamp,
                              uint32_t _timeStampMs,
                              block_id _blockID) {
 
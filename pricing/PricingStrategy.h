@@ -27,7 +27,7 @@
 
 class PricingStrategy {
 public:
-  virtual u256 calculatePrice(u256 previousPrice, const ConsensusExtFace::transactions_vector &_approvedTransactions,
+  virtual u256 calculatePrice(u256 previousPrice, const ConsensusExtFace::transactions_view &_approvedTransactions,
           uint64_t _timeStamp, uint32_t _timeStampMs,  block_id _blockID) = 0;
     virtual ~PricingStrategy() {}
 };
@@ -26,7 +26,7 @@
 #include "ZeroPricingStrategy.h"
 
 u256 ZeroPricingStrategy::calculatePrice(u256,
-                                         const ConsensusExtFace::transactions_vector &,
+                                         const ConsensusExtFace::transactions_view &,
                                          uint64_t, uint32_t,  block_id) {
     return 0;
 }
@@ -30,7 +30,7 @@ class ZeroPricingStrategy : public PricingStrategy{
 
 public:
 
-    u256 calculatePrice(u256 previousPrice, const ConsensusExtFace::transactions_vector &_approvedTransactions,
+    u256 calculatePrice(u256 previousPrice, const ConsensusExtFace::transactions_view &_approvedTransactions,
                         uint64_t _timeStamp, uint32_t _timeStampMs, block_id _blockID) override;
 
 };
@@ -39,6 +39,7 @@
 #include "messages/MessageEnvelope.h"
 #include "messages/NetworkMessageEnvelope.h"
 #include "messages/ParentMessage.h"
+#include "monitoring/StageMetrics.h"
 #include "network/Network.h"
 #include "node/Node.h"
 #include "node/NodeInfo.h"
@@ -53,11 +54,14 @@
 #include "BVBroadcastMessage.h"
 #include "BinConsensusInstance.h"
 
+#include "microprofile.h"
+
 
 using namespace std;
 
 
 void BinConsensusInstance::processMessage(const ptr<MessageEnvelope>& _me ) {
+    MICROPROFILE_SCOPEI( "BinConsensusInstance", "processMessage", MP_BLUE );
 
     CHECK_ARGUMENT( _me );
     auto msg = _me->getMessage();
@@ -154,6 +158,8 @@ void BinConsensusInstance::processParentProposal(const ptr<InternalMessageEnvelo
 
     setProposal(m->getRound(), m->getValue());
 
+    roundStartUs = Time::getSteadyTimeUs();
+
     networkBroadcastValue(m);
 
     addBVSelfVoteToHistory(m->getRound(), m->getValue());
@@ -467,6 +473,8 @@ void BinConsensusInstance::proceedWithNewRound(bin_consensus_value _value) {
     CHECK_STATE(getCurrentRound() < 100);
     CHECK_STATE(isTwoThird(totalAUXVotes(getCurrentRound())));
 
+    recordRoundLatency();
+
     setCurrentRound(getCurrentRound() + 1);
 
     setProposal(getCurrentRound(), _value);
@@ -488,6 +496,15 @@ void BinConsensusInstance::proceedWithNewRound(bin_consensus_value _value) {
 
 }
 
+void BinConsensusInstance::recordRoundLatency() {
+    if (roundStartUs == 0)
+        return;
+
+    auto now = Time::getSteadyTimeUs();
+    getSchain()->getStageMetrics()->recordStage(STAGE_BIN_CONSENSUS_ROUND, now - roundStartUs);
+    roundStartUs = now;
+}
+
 void BinConsensusInstance::printHistory() {
 
 #ifdef CONSENSUS_DEBUG
@@ -541,6 +558,8 @@ void BinConsensusInstance::decide(bin_consensus_value _b) {
 
     CHECK_STATE(!isDecided);
 
+    recordRoundLatency();
+
     setDecidedRoundAndValue(getCurrentRound(), bin_consensus_value(_b));
 
     addDecideToGlobalHistory(decidedValue);
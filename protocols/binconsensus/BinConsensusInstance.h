@@ -51,6 +51,9 @@ class BinConsensusInstance : public ProtocolInstance{
     uint64_t maxProcessingTimeMs = 0;
     uint64_t maxLatencyTimeMs = 0;
 
+    // steady clock time the current round started, 0 if this instance did not propose yet
+    uint64_t roundStartUs = 0;
+
 
     class Comparator {
     public:
@@ -144,6 +147,8 @@ class BinConsensusInstance : public ProtocolInstance{
 
     void proceedWithCommonCoin(bool _hasTrue, bool _hasFalse, uint64_t _random);
 
+    void recordRoundLatency();
+
     void proceedWithNewRound(bin_consensus_value _value);
 
     void printHistory();
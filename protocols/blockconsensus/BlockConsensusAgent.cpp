@@ -27,7 +27,6 @@
 #include "thirdparty/json.hpp"
 
 #include "blockfinalize/client/BlockFinalizeDownloader.h"
-#include "blockfinalize/client/BlockFinalizeDownloaderThreadPool.h"
 #include "blockproposal/pusher/BlockProposalClientAgent.h"
 #include "chains/Schain.h"
 #include "crypto/BLAKE3Hash.h"
@@ -45,6 +44,7 @@
 #include "messages/NetworkMessage.h"
 #include "messages/NetworkMessageEnvelope.h"
 #include "messages/ParentMessage.h"
+#include "monitoring/StageMetrics.h"
 #include "network/Network.h"
 #include "node/Node.h"
 #include "node/NodeInfo.h"
@@ -158,6 +158,9 @@ void BlockConsensusAgent::decideBlock(block_id _blockId, schain_index _sChainInd
 
                   ":BID:" + to_string(_blockId) + ":STATS:|" + _stats + "| Now signing block ...");
 
+        signWaitStartUs = Time::getSteadyTimeUs();
+        signWaitBlockID = (uint64_t) _blockId;
+
         auto msg = make_shared<BlockSignBroadcastMessage>(_blockId, _sChainIndex,
                 Time::getCurrentTimeMs(), *this);
 
@@ -169,6 +172,7 @@ void BlockConsensusAgent::decideBlock(block_id _blockId, schain_index _sChainInd
         decidedIndices->put((uint64_t) _blockId, _sChainIndex);
 
         if (signature != nullptr) {
+            blockSigned(_blockId);
             getSchain()->finalizeDecidedAndSignedBlock( _blockId, _sChainIndex, signature );
         }
 
@@ -285,6 +289,15 @@ void BlockConsensusAgent::reportConsensusAndDecideIfNeeded(const ptr<ChildBVDeci
 }
 
 
+void BlockConsensusAgent::blockSigned(block_id _blockId) {
+    uint64_t expected = (uint64_t) _blockId;
+    if (signWaitBlockID.compare_exchange_strong(expected, 0)) {
+        getSchain()->getStageMetrics()->recordStage(
+            STAGE_BLOCK_SIGN, Time::getSteadyTimeUs() - signWaitStartUs);
+    }
+}
+
+
 void BlockConsensusAgent::processBlockSignMessage(const ptr<BlockSignBroadcastMessage>& _message) {
     try {
         auto signature =
@@ -297,6 +310,8 @@ void BlockConsensusAgent::processBlockSignMessage(const ptr<BlockSignBroadcastMe
         auto proposer = _message->getBlockProposerIndex();
         auto blockId = _message->getBlockId();
 
+        blockSigned(blockId);
+
         LOG(info, string("BLOCK_DECIDE (GOT SIG): PRPSR:") + to_string(proposer) +
                   ":BID:" + to_string(blockId) + "| Now signing block ...");
 
@@ -49,6 +49,12 @@ class BlockConsensusAgent : public ProtocolInstance {
     ptr<cache::lru_cache<uint64_t , ptr<map<schain_index, ptr<ChildBVDecidedMessage>>>>> falseDecisions;
     ptr<cache::lru_cache<uint64_t , schain_index>> decidedIndices;
 
+    // decided block that waits for the threshold signature, used to measure block signing
+    atomic<uint64_t> signWaitBlockID = 0;
+    atomic<uint64_t> signWaitStartUs = 0;
+
+    void blockSigned(block_id _blockId);
+
 
     void processChildMessageImpl(const ptr<InternalMessageEnvelope>& _me);
 
@@ -56,18 +56,8 @@ BlockSignBroadcastMessage::BlockSignBroadcastMessage(block_id _blockID, schain_i
 
     auto schain = _sourceProtocolInstance.getSchain();
 
-    HASH_INIT(hashObj)
-
-    auto bpi = getBlockProposerIndex();
-    HASH_UPDATE(hashObj, bpi)
-
-    HASH_UPDATE(hashObj,this->blockID)
-    HASH_UPDATE(hashObj, this->schainID)
-    HASH_UPDATE(hashObj, this->msgType)
-
-    auto hash = make_shared<BLAKE3Hash>();
-
-    HASH_FINAL(hashObj, hash->data());
+    // the same hash is used to verify the threshold signature of blocks received through catchup
+    auto hash = CryptoManager::calculateBlockSigHash(getBlockProposerIndex(), this->blockID, this->schainID);
 
     this->sigShare = schain->getCryptoManager()->signBlockSigShare(hash, _blockID);
     this->sigShareString = sigShare->toString();
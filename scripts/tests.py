@@ -69,9 +69,25 @@ consensustExecutive = getConsensustExecutive()
 #unitTest(consensustExecutive, "[sgx]")
 unitTest(consensustExecutive, "[tx-serialize]")
 unitTest(consensustExecutive, "[tx-list-serialize]")   
+unitTest(consensustExecutive, "[executor]")
+unitTest(consensustExecutive, "[timer-wheel]")
+unitTest(consensustExecutive, "[epoll-server]")
+unitTest(consensustExecutive, "[io-latency]")
+unitTest(consensustExecutive, "[catchup-ranges]")
+unitTest(consensustExecutive, "[erasure-coding]")
+unitTest(consensustExecutive, "[transaction-intake]")
+unitTest(consensustExecutive, "[known-transactions]")
+unitTest(consensustExecutive, "[log]")
+unitTest(consensustExecutive, "[stage-metrics]")
+unitTest(consensustExecutive, "[transport]")
+unitTest(consensustExecutive, "[message-trace]")
+unitTest(consensustExecutive, "[thread-registry]")
+unitTest(consensustExecutive, "[liveliness]")
 
 
 # fullConsensusTest("sixteennodes", consensustExecutive, "[consensus-finalization-download]")
+# finalization time when five of the sixteen proposers are down
+# fullConsensusTest("11_out_of_16", consensustExecutive, "[consensus-finalization-download]")
 
 # try:
 #    fullConsensusTest("two_out_of_four", consensustExecutive, "[consensus-stuck]")
@@ -82,8 +98,11 @@ unitTest(consensustExecutive, "[tx-list-serialize]")
 fullConsensusTest("onenode", consensustExecutive, "[consensus-basic]")
 fullConsensusTest("twonodes", consensustExecutive, "[consensus-basic]")
 fullConsensusTest("fournodes", consensustExecutive, "[consensus-basic]")
+fullConsensusTest("fournodes", consensustExecutive, "[consensus-submit-transactions]")
+fullConsensusTest("fournodes_slow_peer", consensustExecutive, "[consensus-finalization-slow-peer]")
 fullConsensusTest("sixteennodes", consensustExecutive, "[consensus-basic]")
 #fullConsensusTest("fournodes_catchup", consensustExecutive, "[consensus-basic]")
+#fullConsensusTest("fournodes_catchup_throughput", consensustExecutive, "[consensus-catchup-throughput]")
 #fullConsensusTest("three_out_of_four", consensustExecutive, "[consensus-basic]")
 
 unitTest(consensustExecutive, "[tx-serialize]")
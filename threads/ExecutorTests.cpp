@@ -0,0 +1,283 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file ExecutorTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include <sys/resource.h>
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/InvalidStateException.h"
+
+#include "WorkStealingExecutor.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t EXECUTOR_BENCHMARK_ROUNDS = 200;
+static constexpr uint64_t EXECUTOR_BENCHMARK_PEERS = 15;
+static constexpr uint64_t EXECUTOR_BENCHMARK_TASK_US = 200;
+static constexpr uint64_t PIPELINE_BENCHMARK_BATCHES = 64;
+static constexpr uint64_t PIPELINE_BENCHMARK_VERIFY_US = 4000;
+static constexpr uint64_t PIPELINE_BENCHMARK_COMMIT_US = 1000;
+
+
+uint64_t contextSwitches() {
+    struct rusage usage;
+    CHECK_STATE( getrusage( RUSAGE_SELF, &usage ) == 0 );
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+uint64_t osThreadCount() {
+    ifstream status( "/proc/self/status" );
+    string line;
+    while ( getline( status, line ) ) {
+        if ( line.rfind( "Threads:", 0 ) == 0 )
+            return stoull( line.substr( 8 ) );
+    }
+    return 0;
+}
+
+
+TEST_CASE( "Executor runs tasks in priority order", "[executor]" ) {
+    WorkStealingExecutor executor( 1 );
+
+    mutex startLock;
+    startLock.lock();
+
+    // keep the only worker busy while the tasks are queued
+    executor.submit( PRIORITY_CONSENSUS, [&startLock]() { lock_guard< mutex > l( startLock ); } );
+
+    mutex orderLock;
+    vector< task_priority > order;
+
+    for ( auto priority :
+        { PRIORITY_MONITORING, PRIORITY_CATCHUP, PRIORITY_PROPOSAL, PRIORITY_CONSENSUS } ) {
+        executor.submit( priority, [&orderLock, &order, priority]() {
+            lock_guard< mutex > l( orderLock );
+            order.push_back( priority );
+        } );
+    }
+
+    startLock.unlock();
+    executor.shutdown();
+
+    REQUIRE( order == vector< task_priority >{ PRIORITY_CONSENSUS, PRIORITY_PROPOSAL,
+                          PRIORITY_CATCHUP, PRIORITY_MONITORING } );
+}
+
+
+TEST_CASE( "Executor workers steal nested tasks", "[executor]" ) {
+    WorkStealingExecutor executor( 4 );
+
+    atomic< uint64_t > counter = 0;
+
+    vector< WorkStealingExecutor::task > outer;
+
+    for ( int i = 0; i < 4; i++ ) {
+        outer.push_back( [&executor, &counter]() {
+            vector< WorkStealingExecutor::task > inner;
+            for ( int j = 0; j < 16; j++ ) {
+                inner.push_back( [&counter]() { counter++; } );
+            }
+            executor.submitAndWait( PRIORITY_PROPOSAL, inner );
+        } );
+    }
+
+    executor.submitAndWait( PRIORITY_PROPOSAL, outer );
+
+    REQUIRE( counter == 64 );
+    REQUIRE( executor.getWorkerCount() <= 4 );
+
+    executor.shutdown();
+
+    REQUIRE_THROWS( executor.submit( PRIORITY_PROPOSAL, []() {} ) );
+}
+
+
+TEST_CASE( "Executor caps running workers and replaces blocked ones", "[executor]" ) {
+    SECTION( "Tasks that do not block run on at most the active workers" ) {
+        WorkStealingExecutor executor( 2, nullptr, 8 );
+
+        atomic< uint64_t > running = 0;
+        atomic< uint64_t > peak = 0;
+
+        vector< WorkStealingExecutor::task > tasks( 16, [&running, &peak]() {
+            auto now = ++running;
+            auto previous = peak.load();
+            while ( now > previous && !peak.compare_exchange_weak( previous, now ) ) {
+            }
+            auto end = chrono::steady_clock::now() + chrono::milliseconds( 5 );
+            while ( chrono::steady_clock::now() < end ) {
+            }
+            running--;
+        } );
+
+        executor.submitAndWait( PRIORITY_PROPOSAL, tasks );
+
+        REQUIRE( peak <= 2 );
+        REQUIRE( executor.getWorkerCount() <= 2 );
+
+        executor.shutdown();
+    }
+
+    SECTION( "Tasks that wait for each other do not deadlock when they mark the wait" ) {
+        WorkStealingExecutor executor( 1, nullptr, 4 );
+
+        mutex lock;
+        condition_variable cond;
+        uint64_t arrived = 0;
+
+        vector< WorkStealingExecutor::task > tasks( 4, [&lock, &cond, &arrived]() {
+            WorkStealingExecutor::BlockingScope blocking;
+            unique_lock< mutex > l( lock );
+            arrived++;
+            cond.notify_all();
+            CHECK_STATE( cond.wait_for(
+                l, chrono::seconds( 10 ), [&arrived]() { return arrived == 4; } ) );
+        } );
+
+        executor.submitAndWait( PRIORITY_PROPOSAL, tasks );
+
+        REQUIRE( arrived == 4 );
+        REQUIRE( executor.getWorkerCount() <= 5 );
+        REQUIRE( executor.getBlockedWorkerCount() == 0 );
+
+        executor.shutdown();
+    }
+}
+
+
+TEST_CASE( "Executor consumes ordered results while tasks run", "[executor]" ) {
+    WorkStealingExecutor executor( 8 );
+
+    // the pattern of catchup: batches are verified on workers and committed in order
+    auto verify = []() { usleep( PIPELINE_BENCHMARK_VERIFY_US ); };
+    auto commit = []() { usleep( PIPELINE_BENCHMARK_COMMIT_US ); };
+
+    auto begin = chrono::steady_clock::now();
+
+    for ( uint64_t i = 0; i < PIPELINE_BENCHMARK_BATCHES; i++ ) {
+        verify();
+        commit();
+    }
+
+    auto serialElapsed = chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - begin ).count();
+
+    vector< WorkStealingExecutor::task > tasks( PIPELINE_BENCHMARK_BATCHES, verify );
+    vector< uint64_t > order;
+
+    begin = chrono::steady_clock::now();
+
+    executor.submitOrdered( PRIORITY_CATCHUP, tasks, [&order, &commit]( uint64_t _index ) {
+        order.push_back( _index );
+        commit();
+    } );
+
+    auto pipelinedElapsed = chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - begin ).count();
+
+    cerr << "Verify and commit of " << PIPELINE_BENCHMARK_BATCHES << " batches:serial ms:"
+         << serialElapsed << ":pipelined ms:" << pipelinedElapsed << endl;
+
+    REQUIRE( order.size() == PIPELINE_BENCHMARK_BATCHES );
+    for ( uint64_t i = 0; i < order.size(); i++ ) {
+        REQUIRE( order[i] == i );
+    }
+
+    // a failed task stops the consumption, the error is passed to the caller
+    tasks[3] = []() { BOOST_THROW_EXCEPTION( InvalidStateException( "Test", "ExecutorTests" ) ); };
+    order.clear();
+
+    REQUIRE_THROWS( executor.submitOrdered(
+        PRIORITY_CATCHUP, tasks, [&order]( uint64_t _index ) { order.push_back( _index ); } ) );
+    REQUIRE( order == vector< uint64_t >{ 0, 1, 2 } );
+
+    executor.shutdown();
+}
+
+
+TEST_CASE( "Executor vs thread per task", "[executor-bench]" ) {
+    // the pattern of BlockFinalizeDownloader: one task per peer for each block, that waits
+    // for the peer
+
+    auto task = []() {
+        WorkStealingExecutor::BlockingScope blocking;
+        usleep( EXECUTOR_BENCHMARK_TASK_US );
+    };
+
+    auto switchesBefore = contextSwitches();
+    uint64_t peakThreads = 0;
+    auto begin = chrono::steady_clock::now();
+
+    for ( uint64_t i = 0; i < EXECUTOR_BENCHMARK_ROUNDS; i++ ) {
+        vector< ptr< thread > > threads;
+        for ( uint64_t j = 0; j < EXECUTOR_BENCHMARK_PEERS; j++ ) {
+            threads.push_back( make_shared< thread >( task ) );
+        }
+        peakThreads = max( peakThreads, osThreadCount() );
+        for ( auto&& t : threads ) {
+            t->join();
+        }
+    }
+
+    auto threadsElapsed = chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - begin ).count();
+    auto threadsSwitches = contextSwitches() - switchesBefore;
+
+    cerr << "Thread per task: created threads:"
+         << EXECUTOR_BENCHMARK_ROUNDS * EXECUTOR_BENCHMARK_PEERS << ":peak threads:" << peakThreads
+         << ":context switches:" << threadsSwitches << ":ms:" << threadsElapsed << endl;
+
+    // sized as in ConsensusEngine
+    auto activeWorkers = max< uint64_t >( thread::hardware_concurrency(), 1 );
+    auto executor = make_shared< WorkStealingExecutor >(
+        activeWorkers, nullptr, EXECUTOR_MAX_BLOCKED_WORKERS );
+
+    vector< WorkStealingExecutor::task > tasks( EXECUTOR_BENCHMARK_PEERS, task );
+
+    switchesBefore = contextSwitches();
+    peakThreads = 0;
+    begin = chrono::steady_clock::now();
+
+    for ( uint64_t i = 0; i < EXECUTOR_BENCHMARK_ROUNDS; i++ ) {
+        executor->submitAndWait( PRIORITY_PROPOSAL, tasks );
+        peakThreads = max( peakThreads, osThreadCount() );
+    }
+
+    auto executorElapsed = chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - begin ).count();
+    auto executorSwitches = contextSwitches() - switchesBefore;
+
+    cerr << "Executor: created threads:" << executor->getWorkerCount()
+         << ":peak threads:" << peakThreads << ":context switches:" << executorSwitches
+         << ":stolen tasks:" << executor->getStolenTaskCount() << ":ms:" << executorElapsed
+         << endl;
+
+    // a worker that has just finished a task may not be counted as free yet
+    REQUIRE( executor->getWorkerCount() <= activeWorkers + 2 * EXECUTOR_BENCHMARK_PEERS );
+
+    executor->shutdown();
+
+    REQUIRE( executor->getExecutedTaskCount() ==
+             EXECUTOR_BENCHMARK_ROUNDS * EXECUTOR_BENCHMARK_PEERS );
+}
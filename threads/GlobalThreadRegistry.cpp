@@ -25,10 +25,19 @@
 #include "SkaleCommon.h"
 #include "Log.h"
 #include "exceptions/FatalError.h"
+#include "monitoring/LivelinessMonitor.h"
+#include "utils/Time.h"
 
+#include <csignal>
+#include <sys/syscall.h>
+
+#include "QueueMetrics.h"
 #include "GlobalThreadRegistry.h"
 
 
+atomic< uint64_t > GlobalThreadRegistry::dumpRequests = 0;
+
+
 void GlobalThreadRegistry::joinAll() {
 
 
@@ -53,3 +62,149 @@ void GlobalThreadRegistry::add(const ptr<thread>& _t) {
     LOCK(allThreadsLock)
     allThreads.push_back(_t);
 }
+
+void GlobalThreadRegistry::registerThread( const string& _name, const string& _role,
+    const string& _agent, uint64_t _nodeID ) {
+
+    ThreadInfo info;
+    info.name = _name;
+    info.role = _role;
+    info.agent = _agent;
+    info.nodeID = _nodeID;
+    info.tid = ( uint64_t ) syscall( SYS_gettid );
+
+    LOCK(allThreadsLock)
+    // a tid of an exited thread can be reused
+    threadInfos[info.tid] = info;
+}
+
+void GlobalThreadRegistry::registerQueue( const ptr< QueueMetrics >& _queue ) {
+
+    CHECK_ARGUMENT( _queue );
+
+    LOCK(allThreadsLock)
+    queues.push_back( _queue );
+}
+
+int64_t GlobalThreadRegistry::getThreadCpuUs( uint64_t _tid ) {
+
+    ifstream f( "/proc/self/task/" + to_string( _tid ) + "/stat" );
+
+    string stat;
+
+    if ( !getline( f, stat ) )
+        return -1;
+
+    // the thread name in parentheses can contain spaces, fields are counted after it
+    auto nameEnd = stat.rfind( ')' );
+
+    if ( nameEnd == string::npos )
+        return -1;
+
+    istringstream fields( stat.substr( nameEnd + 1 ) );
+
+    string field;
+    uint64_t utime = 0;
+    uint64_t stime = 0;
+
+    // state is field 3 of the file, utime and stime are fields 14 and 15
+    for ( int i = 3; i <= 15 && fields >> field; i++ ) {
+        if ( i == 14 )
+            utime = stoull( field );
+        if ( i == 15 )
+            stime = stoull( field );
+    }
+
+    static const uint64_t ticksPerSec = sysconf( _SC_CLK_TCK );
+
+    return ( int64_t ) ( ( utime + stime ) * 1000000 / ticksPerSec );
+}
+
+nlohmann::json GlobalThreadRegistry::toJSON() {
+
+    map< uint64_t, ThreadInfo > threadsCopy;
+    vector< ptr< QueueMetrics > > queuesCopy;
+
+    {
+        LOCK(allThreadsLock)
+        threadsCopy = threadInfos;
+        queuesCopy = queues;
+    }
+
+    auto result = nlohmann::json::object();
+    result["timeMs"] = Time::getCurrentTimeMs();
+    result["threads"] = nlohmann::json::array();
+    result["queues"] = nlohmann::json::array();
+
+    for ( auto&& item : threadsCopy ) {
+        auto& info = item.second;
+        auto cpuUs = getThreadCpuUs( info.tid );
+
+        auto threadJSON = nlohmann::json::object();
+        threadJSON["name"] = info.name;
+        threadJSON["role"] = info.role;
+        threadJSON["agent"] = info.agent;
+        threadJSON["nodeID"] = info.nodeID;
+        threadJSON["tid"] = info.tid;
+        threadJSON["alive"] = cpuUs >= 0;
+        threadJSON["cpuUs"] = max< int64_t >( cpuUs, 0 );
+        result["threads"].push_back( threadJSON );
+    }
+
+    for ( auto&& queue : queuesCopy ) {
+        result["queues"].push_back( queue->toJSON() );
+    }
+
+    // durations of monitored scopes, of all engines of the process
+    result["scopes"] = MonitorSite::allToJSON();
+
+    return result;
+}
+
+void GlobalThreadRegistry::writeJSON( const string& _fileName ) {
+
+    auto tmpFileName = _fileName + ".tmp";
+
+    ofstream f;
+    f.open( tmpFileName, ios::trunc );
+    f << toJSON().dump();
+    f.close();
+
+    if ( !f || rename( tmpFileName.c_str(), _fileName.c_str() ) != 0 ) {
+        BOOST_THROW_EXCEPTION(
+            InvalidStateException( "Could not write " + _fileName, __CLASS_NAME__ ) );
+    }
+}
+
+void GlobalThreadRegistry::requestDump() {
+    dumpRequests++;
+}
+
+void GlobalThreadRegistry::dumpSignalHandler( int ) {
+    requestDump();
+}
+
+void GlobalThreadRegistry::installDumpSignalHandler() {
+
+    struct sigaction current;
+
+    if ( sigaction( SIGUSR1, nullptr, &current ) != 0 || current.sa_handler != SIG_DFL )
+        return;
+
+    struct sigaction action;
+    memset( &action, 0, sizeof( action ) );
+    action.sa_handler = &GlobalThreadRegistry::dumpSignalHandler;
+    sigemptyset( &action.sa_mask );
+    action.sa_flags = SA_RESTART;
+
+    sigaction( SIGUSR1, &action, nullptr );
+}
+
+bool GlobalThreadRegistry::takeDumpRequest() {
+
+    auto requested = dumpRequests.load();
+    auto served = dumpRequestsServed.load();
+
+    // the monitoring agents of several nodes share the registry, one of them writes the dump
+    return served < requested && dumpRequestsServed.compare_exchange_strong( served, requested );
+}
@@ -25,20 +25,74 @@
 #define SKALED_GLOBALTHREADREGISTRY_H
 
 
+#include "thirdparty/json.hpp"
+
+class QueueMetrics;
+
+
+// Joins the threads of the engine on exit, and knows the threads and queues of all agents.
+//
+// A thread registers itself on start with its name, role and agent, so that its CPU time can be
+// read from /proc/self/task. The dump of threads and queues is requested by SIGUSR1 or by
+// requestDump(), and is written by the monitoring agent.
+
 class GlobalThreadRegistry {
 
+    class ThreadInfo {
+    public:
+        string name;
+        string role;
+        string agent;
+        uint64_t nodeID = 0;
+        uint64_t tid = 0;
+    };
+
     vector< ptr<thread>> allThreads;
 
     recursive_mutex allThreadsLock;
 
     bool joined = false;
 
+    map< uint64_t, ThreadInfo > threadInfos; // by tid, guarded by allThreadsLock
+
+    vector< ptr< QueueMetrics > > queues; // guarded by allThreadsLock
+
+    // dump requests are counted, so that each registry of the process serves each request
+    static atomic< uint64_t > dumpRequests;
+
+    atomic< uint64_t > dumpRequestsServed = 0;
+
+    static void dumpSignalHandler( int );
+
 public:
 
     void joinAll();
 
     void add(const ptr<thread>& _t);
 
+    // called on the thread that is registered
+    void registerThread( const string& _name, const string& _role, const string& _agent,
+        uint64_t _nodeID );
+
+    void registerQueue( const ptr< QueueMetrics >& _queue );
+
+    // CPU time of a thread of this process, or -1 if the thread exited
+    static int64_t getThreadCpuUs( uint64_t _tid );
+
+    nlohmann::json toJSON();
+
+    // replaces the file atomically
+    void writeJSON( const string& _fileName );
+
+    // async signal safe
+    static void requestDump();
+
+    // installs the SIGUSR1 handler, unless the application handles SIGUSR1 itself
+    static void installDumpSignalHandler();
+
+    // true once for each dump request
+    bool takeDumpRequest();
+
 };
 
 
@@ -0,0 +1,148 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file GlobalThreadRegistryTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include <sys/syscall.h>
+
+#include "thirdparty/catch.hpp"
+
+#include "GlobalThreadRegistry.h"
+#include "QueueMetrics.h"
+
+
+static constexpr uint64_t QUEUE_TEST_WAIT_MS = 20;
+
+
+TEST_CASE( "Queue metrics track depth and waiting times", "[thread-registry]" ) {
+    QueueMetrics fifo( "items", "TestAgent", 3 );
+
+    fifo.pushed();
+    fifo.pushed();
+    fifo.pushed();
+
+    usleep( QUEUE_TEST_WAIT_MS * 1000 );
+
+    fifo.popped( 2 );
+    fifo.droppedOldest();
+
+    REQUIRE( fifo.getDepth() == 0 );
+    REQUIRE_THROWS( fifo.popped() );
+
+    fifo.pushed();
+
+    auto json = fifo.toJSON();
+
+    REQUIRE( json["name"] == "items" );
+    REQUIRE( json["agent"] == "TestAgent" );
+    REQUIRE( json["nodeID"] == 3 );
+    REQUIRE( json["depth"] == 1 );
+    REQUIRE( json["enqueued"] == 4 );
+    REQUIRE( json["dequeued"] == 2 );
+    REQUIRE( json["dropped"] == 1 );
+    REQUIRE( json["maxWaitUs"] >= QUEUE_TEST_WAIT_MS * 1000 );
+    REQUIRE( json["oldestWaitUs"] < QUEUE_TEST_WAIT_MS * 1000 );
+    REQUIRE( json["enqueuePerSec"] > 0 );
+
+    QueueMetrics byBlock( "deferred", "TestAgent", 3, false );
+
+    byBlock.pushed();
+    byBlock.pushed();
+    byBlock.poppedAfter( 5000 );
+
+    REQUIRE_THROWS( fifo.poppedAfter( 1 ) );
+
+    json = byBlock.toJSON();
+
+    REQUIRE( json["depth"] == 1 );
+    REQUIRE( json["maxWaitUs"] == 5000 );
+    REQUIRE( json.count( "oldestWaitUs" ) == 0 );
+}
+
+
+TEST_CASE( "Thread registry reports threads and queues", "[thread-registry]" ) {
+    GlobalThreadRegistry registry;
+
+    auto queue = make_shared< QueueMetrics >( "items", "TestAgent", 1 );
+    registry.registerQueue( queue );
+    queue->pushed();
+
+    atomic< uint64_t > tid = 0;
+
+    auto worker = make_shared< thread >( [&registry, &tid]() {
+        registry.registerThread( "TestWorker", "test", "TestAgent", 1 );
+        tid = ( uint64_t ) syscall( SYS_gettid );
+
+        // burn some CPU
+        auto start = chrono::steady_clock::now();
+        volatile uint64_t sum = 0;
+        while ( chrono::steady_clock::now() - start < chrono::milliseconds( 50 ) ) {
+            sum = sum + 1;
+        }
+    } );
+
+    while ( tid == 0 ) {
+        usleep( 1000 );
+    }
+
+    auto json = registry.toJSON();
+
+    REQUIRE( json["threads"].size() == 1 );
+    REQUIRE( json["threads"][0]["name"] == "TestWorker" );
+    REQUIRE( json["threads"][0]["role"] == "test" );
+    REQUIRE( json["threads"][0]["agent"] == "TestAgent" );
+    REQUIRE( json["threads"][0]["tid"] == tid.load() );
+    REQUIRE( json["threads"][0]["alive"] == true );
+    REQUIRE( json["queues"].size() == 1 );
+    REQUIRE( json["queues"][0]["depth"] == 1 );
+
+    worker->join();
+
+    REQUIRE( GlobalThreadRegistry::getThreadCpuUs( tid ) == -1 );
+    REQUIRE( GlobalThreadRegistry::getThreadCpuUs( ( uint64_t ) syscall( SYS_gettid ) ) >= 0 );
+
+    json = registry.toJSON();
+
+    REQUIRE( json["threads"][0]["alive"] == false );
+}
+
+
+TEST_CASE( "Thread registry serves each dump request once", "[thread-registry]" ) {
+    GlobalThreadRegistry first;
+    GlobalThreadRegistry second;
+
+    // requests made before the registries were created
+    first.takeDumpRequest();
+    second.takeDumpRequest();
+
+    REQUIRE_FALSE( first.takeDumpRequest() );
+
+    GlobalThreadRegistry::requestDump();
+
+    REQUIRE( first.takeDumpRequest() );
+    REQUIRE_FALSE( first.takeDumpRequest() );
+    REQUIRE( second.takeDumpRequest() );
+    REQUIRE_FALSE( second.takeDumpRequest() );
+}
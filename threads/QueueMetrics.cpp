@@ -0,0 +1,159 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file QueueMetrics.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/FatalError.h"
+#include "utils/Time.h"
+
+#include "QueueMetrics.h"
+
+
+QueueMetrics::QueueMetrics(
+    const string& _name, const string& _agent, uint64_t _nodeID, bool _fifo )
+    : name( _name ),
+      agent( _agent ),
+      nodeID( _nodeID ),
+      fifo( _fifo ),
+      windowStartUs( Time::getSteadyTimeUs() ) {
+    CHECK_ARGUMENT( !_name.empty() );
+}
+
+
+void QueueMetrics::updateRate( uint64_t _nowUs ) {
+    // called with m held
+    auto elapsedUs = _nowUs - windowStartUs;
+
+    if ( elapsedUs < RATE_WINDOW_US )
+        return;
+
+    enqueueRate = windowEnqueued * 1000000.0 / elapsedUs;
+    rateKnown = true;
+    windowEnqueued = 0;
+    windowStartUs = _nowUs;
+}
+
+
+void QueueMetrics::removeOldest( uint64_t _count, uint64_t _nowUs ) {
+    // called with m held
+    CHECK_STATE( _count <= depth );
+
+    depth -= _count;
+
+    if ( !fifo )
+        return;
+
+    for ( uint64_t i = 0; i < _count; i++ ) {
+        CHECK_STATE( !enqueueTimesUs.empty() );
+        maxWaitUs = max( maxWaitUs, _nowUs - enqueueTimesUs.front() );
+        enqueueTimesUs.pop_front();
+    }
+}
+
+
+void QueueMetrics::pushed() {
+    auto now = Time::getSteadyTimeUs();
+
+    lock_guard< mutex > lock( m );
+
+    depth++;
+    enqueued++;
+    windowEnqueued++;
+
+    if ( fifo )
+        enqueueTimesUs.push_back( now );
+
+    updateRate( now );
+}
+
+
+void QueueMetrics::popped( uint64_t _count ) {
+    auto now = Time::getSteadyTimeUs();
+
+    lock_guard< mutex > lock( m );
+
+    removeOldest( _count, now );
+    dequeued += _count;
+}
+
+
+void QueueMetrics::droppedOldest() {
+    auto now = Time::getSteadyTimeUs();
+
+    lock_guard< mutex > lock( m );
+
+    removeOldest( 1, now );
+    dropped++;
+}
+
+
+void QueueMetrics::poppedAfter( uint64_t _waitUs ) {
+    CHECK_STATE( !fifo );
+
+    lock_guard< mutex > lock( m );
+
+    removeOldest( 1, 0 );
+    dequeued++;
+    maxWaitUs = max( maxWaitUs, _waitUs );
+}
+
+
+const string& QueueMetrics::getName() const {
+    return name;
+}
+
+
+uint64_t QueueMetrics::getDepth() {
+    lock_guard< mutex > lock( m );
+    return depth;
+}
+
+
+nlohmann::json QueueMetrics::toJSON() {
+    auto now = Time::getSteadyTimeUs();
+
+    lock_guard< mutex > lock( m );
+
+    updateRate( now );
+
+    auto result = nlohmann::json::object();
+    result["name"] = name;
+    result["agent"] = agent;
+    result["nodeID"] = nodeID;
+    result["depth"] = depth;
+    result["enqueued"] = enqueued;
+    result["dequeued"] = dequeued;
+    result["dropped"] = dropped;
+    // until the first window completes, the rate of the current one
+    result["enqueuePerSec"] = rateKnown ? enqueueRate :
+                                          windowEnqueued * 1000000.0 /
+                                              max< uint64_t >( 1, now - windowStartUs );
+    result["maxWaitUs"] = maxWaitUs;
+
+    // a stuck queue shows up here before anything is popped from it
+    if ( fifo )
+        result["oldestWaitUs"] = enqueueTimesUs.empty() ? 0 : now - enqueueTimesUs.front();
+
+    return result;
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file QueueMetrics.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+
+#ifndef SKALED_QUEUEMETRICS_H
+#define SKALED_QUEUEMETRICS_H
+
+#include <deque>
+
+#include "thirdparty/json.hpp"
+
+
+// Depth, enqueue rate and waiting times of one queue of an agent.
+//
+// The owner of the queue reports pushes and pops, usually under the lock of the queue.
+// For a FIFO queue the enqueue times are kept, so that a pop knows how long the item waited.
+// Queues that are not FIFO pass the waiting time of the removed item instead.
+
+class QueueMetrics {
+
+    // the enqueue rate is computed over windows of this length
+    static constexpr uint64_t RATE_WINDOW_US = 10000000;
+
+    const string name;
+
+    const string agent;
+
+    const uint64_t nodeID;
+
+    const bool fifo;
+
+    mutex m;
+
+    deque< uint64_t > enqueueTimesUs;  // FIFO only
+
+    uint64_t depth = 0;
+
+    uint64_t enqueued = 0;
+
+    uint64_t dequeued = 0;
+
+    uint64_t dropped = 0;
+
+    uint64_t maxWaitUs = 0;
+
+    uint64_t windowStartUs;
+
+    uint64_t windowEnqueued = 0;
+
+    double enqueueRate = 0;  // of the last complete window
+
+    bool rateKnown = false;
+
+    void removeOldest( uint64_t _count, uint64_t _nowUs );
+
+    void updateRate( uint64_t _nowUs );
+
+public:
+
+    QueueMetrics( const string& _name, const string& _agent, uint64_t _nodeID, bool _fifo = true );
+
+    void pushed();
+
+    // the oldest items left the queue
+    void popped( uint64_t _count = 1 );
+
+    // the oldest item was removed because the queue is full
+    void droppedOldest();
+
+    // an item of a queue that is not FIFO left the queue after waiting _waitUs
+    void poppedAfter( uint64_t _waitUs );
+
+    [[nodiscard]] const string& getName() const;
+
+    [[nodiscard]] uint64_t getDepth();
+
+    nlohmann::json toJSON();
+};
+
+
+#endif  // SKALED_QUEUEMETRICS_H
@@ -0,0 +1,352 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TimerWheel.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+#include "utils/Time.h"
+
+#include "GlobalThreadRegistry.h"
+#include "TimerWheel.h"
+
+
+TimerWheel::TimerWheel( const ptr< WorkStealingExecutor >& _executor )
+    : executor( _executor ), startTime( chrono::steady_clock::now() ) {
+    CHECK_ARGUMENT( _executor );
+    wheelThread = make_shared< thread >( &TimerWheel::wheelLoop, this );
+}
+
+
+TimerWheel::~TimerWheel() {
+    shutdown();
+}
+
+
+uint64_t TimerWheel::nowTick() const {
+    return chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now() - startTime )
+        .count();
+}
+
+
+uint64_t TimerWheel::levelSpan( uint64_t _level ) {
+    return ( uint64_t ) 1 << ( SLOT_BITS * _level );
+}
+
+
+void TimerWheel::insert( const ptr< Timer >& _timer ) {
+    CHECK_STATE( _timer->expiryTick >= currentTick );
+
+    auto delta = _timer->expiryTick - currentTick;
+
+    uint64_t level = 0;
+
+    while ( level < LEVELS - 1 && delta >= levelSpan( level + 1 ) ) {
+        level++;
+    }
+
+    auto slotTick = _timer->expiryTick;
+
+    // too far in the future, the timer will be re-inserted when the top level cascades
+    if ( delta >= levelSpan( LEVELS ) ) {
+        slotTick = currentTick + levelSpan( LEVELS ) - 1;
+    }
+
+    auto index = ( slotTick >> ( SLOT_BITS * level ) ) & ( SLOTS - 1 );
+
+    slots[level][index].push_back( _timer );
+    levelSizes[level]++;
+}
+
+
+void TimerWheel::cascade( uint64_t _level ) {
+    auto index = ( currentTick >> ( SLOT_BITS * _level ) ) & ( SLOTS - 1 );
+
+    list< ptr< Timer > > timers;
+    timers.swap( slots[_level][index] );
+    levelSizes[_level] -= timers.size();
+
+    for ( auto&& timer : timers ) {
+        if ( !timer->cancelled )
+            insert( timer );
+    }
+}
+
+
+uint64_t TimerWheel::nextEventTick() {
+    for ( uint64_t d = 1; d <= SLOTS; d++ ) {
+        auto tick = currentTick + d;
+
+        if ( !slots[0][tick & ( SLOTS - 1 )].empty() )
+            return tick;
+
+        for ( uint64_t level = 1; level < LEVELS; level++ ) {
+            if ( levelSizes[level] > 0 && ( tick & ( levelSpan( level ) - 1 ) ) == 0 )
+                return tick;
+        }
+    }
+
+    // level 1 boundaries are always within SLOTS ticks, so only upper levels are left
+    uint64_t result = UINT64_MAX;
+
+    for ( uint64_t level = 2; level < LEVELS; level++ ) {
+        if ( levelSizes[level] > 0 ) {
+            auto boundary = ( ( currentTick >> ( SLOT_BITS * level ) ) + 1 )
+                            << ( SLOT_BITS * level );
+            result = min( result, boundary );
+        }
+    }
+
+    return result;
+}
+
+
+void TimerWheel::advanceTo( uint64_t _tick ) {
+    while ( currentTick < _tick ) {
+        auto next = nextEventTick();
+
+        if ( next > _tick ) {
+            currentTick = _tick;
+            return;
+        }
+
+        currentTick = next;
+
+        for ( uint64_t level = LEVELS - 1; level > 0; level-- ) {
+            if ( ( currentTick & ( levelSpan( level ) - 1 ) ) == 0 )
+                cascade( level );
+        }
+
+        list< ptr< Timer > > expired;
+        expired.swap( slots[0][currentTick & ( SLOTS - 1 )] );
+        levelSizes[0] -= expired.size();
+
+        for ( auto&& timer : expired ) {
+            if ( !timer->cancelled )
+                fire( timer );
+        }
+    }
+}
+
+
+void TimerWheel::fire( const ptr< Timer >& _timer ) {
+    // called with wheelLock held
+    firedTimers++;
+
+    if ( _timer->periodMs == 0 )
+        activeTimers.erase( _timer->id );
+
+    if ( _timer->runInline ) {
+        _timer->callback();
+        return;
+    }
+
+    try {
+        executor->submit( _timer->priority, [this, _timer]() {
+            logThreadLocal_ = _timer->log;
+
+            try {
+                _timer->callback();
+            } catch ( ExitRequestedException& ) {
+                return;
+            } catch ( exception& e ) {
+                // a periodic timer keeps running after a failed run
+                SkaleException::logNested( e );
+            }
+
+            if ( _timer->periodMs == 0 )
+                return;
+
+            lock_guard< mutex > lock( wheelLock );
+
+            if ( _timer->cancelled || shutdownRequested )
+                return;
+
+            _timer->expiryTick = max( nowTick(), currentTick ) + _timer->periodMs;
+            insert( _timer );
+            wheelCond.notify_all();
+        } );
+    } catch ( ExitRequestedException& ) {
+        // the engine is exiting
+    }
+}
+
+
+uint64_t TimerWheel::addTimer( uint64_t _delayMs, uint64_t _periodMs, task_priority _priority,
+    const WorkStealingExecutor::task& _callback, bool _runInline ) {
+    CHECK_ARGUMENT( _callback );
+
+    auto timer = make_shared< Timer >();
+    timer->periodMs = _periodMs;
+    timer->priority = _priority;
+    timer->callback = _callback;
+    timer->log = logThreadLocal_;
+    timer->runInline = _runInline;
+
+    lock_guard< mutex > lock( wheelLock );
+
+    if ( shutdownRequested ) {
+        BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+    }
+
+    // catch up first so that the timer is placed relative to the current time
+    advanceTo( nowTick() );
+
+    timer->id = ++timerCounter;
+    timer->expiryTick = currentTick + _delayMs;
+
+    activeTimers[timer->id] = timer;
+
+    if ( _delayMs == 0 ) {
+        fire( timer );
+    } else {
+        insert( timer );
+        wheelCond.notify_all();
+    }
+
+    return timer->id;
+}
+
+
+uint64_t TimerWheel::schedule(
+    uint64_t _delayMs, task_priority _priority, const WorkStealingExecutor::task& _callback ) {
+    return addTimer( _delayMs, 0, _priority, _callback, false );
+}
+
+
+uint64_t TimerWheel::schedulePeriodic(
+    uint64_t _periodMs, task_priority _priority, const WorkStealingExecutor::task& _callback ) {
+    CHECK_ARGUMENT( _periodMs > 0 );
+    return addTimer( _periodMs, _periodMs, _priority, _callback, false );
+}
+
+
+bool TimerWheel::cancel( uint64_t _timerId ) {
+    lock_guard< mutex > lock( wheelLock );
+
+    auto it = activeTimers.find( _timerId );
+
+    if ( it == activeTimers.end() )
+        return false;
+
+    // removed from its slot lazily
+    it->second->cancelled = true;
+    activeTimers.erase( it );
+
+    return true;
+}
+
+
+void TimerWheel::sleepFor( uint64_t _delayMs ) {
+    auto fired = make_shared< bool >( false );
+
+    // runs on the wheel thread with wheelLock held
+    auto timerId = addTimer(
+        _delayMs, 0, PRIORITY_CONSENSUS,
+        [this, fired]() {
+            *fired = true;
+            wheelCond.notify_all();
+        },
+        true );
+
+    WorkStealingExecutor::BlockingScope blocking;
+
+    unique_lock< mutex > lock( wheelLock );
+
+    wheelCond.wait( lock, [this, fired]() { return *fired || shutdownRequested; } );
+
+    if ( !*fired ) {
+        lock.unlock();
+        cancel( timerId );
+        BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+    }
+}
+
+
+void TimerWheel::sleepUntilTimeMs( uint64_t _systemTimeMs ) {
+    auto now = Time::getCurrentTimeMs();
+
+    if ( _systemTimeMs <= now )
+        return;
+
+    sleepFor( _systemTimeMs - now );
+}
+
+
+void TimerWheel::wheelLoop() {
+#ifdef __linux__
+    pthread_setname_np( pthread_self(), "TimerWheel" );
+#endif
+
+    if ( executor->getThreadRegistry() )
+        executor->getThreadRegistry()->registerThread( "TimerWheel", "timer", "TimerWheel", 0 );
+
+    unique_lock< mutex > lock( wheelLock );
+
+    while ( !shutdownRequested ) {
+        advanceTo( nowTick() );
+
+        auto next = nextEventTick();
+
+        if ( next == UINT64_MAX ) {
+            wheelCond.wait( lock );
+        } else {
+            wheelCond.wait_until( lock, startTime + chrono::milliseconds( next ) );
+        }
+    }
+}
+
+
+void TimerWheel::shutdown() {
+    {
+        lock_guard< mutex > lock( wheelLock );
+
+        if ( shutdownRequested )
+            return;
+
+        shutdownRequested = true;
+
+        for ( auto&& item : activeTimers ) {
+            item.second->cancelled = true;
+        }
+
+        activeTimers.clear();
+
+        wheelCond.notify_all();
+    }
+
+    if ( wheelThread && wheelThread->joinable() ) {
+        wheelThread->join();
+    }
+}
+
+
+uint64_t TimerWheel::getActiveTimerCount() {
+    lock_guard< mutex > lock( wheelLock );
+    return activeTimers.size();
+}
+
+uint64_t TimerWheel::getFiredTimerCount() const {
+    return firedTimers;
+}
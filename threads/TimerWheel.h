@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TimerWheel.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_TIMERWHEEL_H
+#define SKALED_TIMERWHEEL_H
+
+#include <list>
+
+#include "WorkStealingExecutor.h"
+
+class SkaleLog;
+
+// Hierarchical timer wheel shared by all agents of a ConsensusEngine.
+//
+// Four levels of 64 slots with 1 ms resolution. The wheel thread sleeps until the next
+// non-empty slot or cascade boundary instead of ticking every ms. Expired callbacks are
+// submitted to the executor, so a slow callback never delays other timers.
+
+class TimerWheel {
+
+public:
+
+    static constexpr uint64_t SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t LEVELS = 4;
+
+private:
+
+    class Timer {
+    public:
+        uint64_t id = 0;
+        uint64_t expiryTick = 0;
+        uint64_t periodMs = 0;  // 0 for one shot timers
+        task_priority priority = PRIORITY_CONSENSUS;
+        WorkStealingExecutor::task callback;
+        ptr< SkaleLog > log;
+        bool runInline = false;  // run on the wheel thread, used by sleepers
+        bool cancelled = false;
+    };
+
+    ptr< WorkStealingExecutor > executor;
+
+    const chrono::steady_clock::time_point startTime;
+
+    mutex wheelLock;
+    condition_variable wheelCond;
+
+    array< array< list< ptr< Timer > >, SLOTS >, LEVELS > slots;  // guarded by wheelLock
+
+    array< uint64_t, LEVELS > levelSizes = {};  // guarded by wheelLock
+
+    map< uint64_t, ptr< Timer > > activeTimers;  // guarded by wheelLock
+
+    uint64_t currentTick = 0;  // guarded by wheelLock
+
+    uint64_t timerCounter = 0;  // guarded by wheelLock
+
+    atomic< uint64_t > firedTimers = 0;
+
+    bool shutdownRequested = false;  // guarded by wheelLock
+
+    ptr< thread > wheelThread;
+
+    uint64_t nowTick() const;
+
+    static uint64_t levelSpan( uint64_t _level );
+
+    void insert( const ptr< Timer >& _timer );
+
+    void cascade( uint64_t _level );
+
+    uint64_t nextEventTick();
+
+    void advanceTo( uint64_t _tick );
+
+    void fire( const ptr< Timer >& _timer );
+
+    uint64_t addTimer( uint64_t _delayMs, uint64_t _periodMs, task_priority _priority,
+        const WorkStealingExecutor::task& _callback, bool _runInline );
+
+    void wheelLoop();
+
+public:
+
+    explicit TimerWheel( const ptr< WorkStealingExecutor >& _executor );
+
+    ~TimerWheel();
+
+    // returns timer id that can be passed to cancel()
+    uint64_t schedule(
+        uint64_t _delayMs, task_priority _priority, const WorkStealingExecutor::task& _callback );
+
+    // the next run is scheduled when the previous one finishes, so runs never overlap
+    uint64_t schedulePeriodic(
+        uint64_t _periodMs, task_priority _priority, const WorkStealingExecutor::task& _callback );
+
+    bool cancel( uint64_t _timerId );
+
+    // blocks the calling thread, throws ExitRequestedException if the wheel is shut down
+    void sleepFor( uint64_t _delayMs );
+
+    void sleepUntilTimeMs( uint64_t _systemTimeMs );
+
+    void shutdown();
+
+    uint64_t getActiveTimerCount();
+
+    uint64_t getFiredTimerCount() const;
+};
+
+
+#endif  // SKALED_TIMERWHEEL_H
@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file TimerWheelTests.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+
+#include "TimerWheel.h"
+#include "WorkStealingExecutor.h"
+
+#include "thirdparty/catch.hpp"
+
+
+static constexpr uint64_t TIMER_WHEEL_TOLERANCE_MS = 50;
+
+
+uint64_t steadyTimeMs() {
+    return chrono::duration_cast< chrono::milliseconds >(
+        chrono::steady_clock::now().time_since_epoch() )
+        .count();
+}
+
+
+TEST_CASE( "Timer wheel fires one shot timers", "[timer-wheel]" ) {
+    auto executor = make_shared< WorkStealingExecutor >( 2 );
+    TimerWheel wheel( executor );
+
+    atomic< uint64_t > firedAt = 0;
+    atomic< uint64_t > cancelledRuns = 0;
+
+    auto begin = steadyTimeMs();
+
+    wheel.schedule( 30, PRIORITY_CONSENSUS, [&firedAt]() { firedAt = steadyTimeMs(); } );
+
+    auto cancelledId =
+        wheel.schedule( 30, PRIORITY_CONSENSUS, [&cancelledRuns]() { cancelledRuns++; } );
+
+    REQUIRE( wheel.cancel( cancelledId ) );
+    REQUIRE_FALSE( wheel.cancel( cancelledId ) );
+
+    wheel.sleepFor( 100 );
+
+    REQUIRE( firedAt >= begin + 30 );
+    REQUIRE( firedAt <= begin + 30 + TIMER_WHEEL_TOLERANCE_MS );
+    REQUIRE( cancelledRuns == 0 );
+    REQUIRE( wheel.getActiveTimerCount() == 0 );
+
+    wheel.shutdown();
+    executor->shutdown();
+}
+
+
+TEST_CASE( "Timer wheel cascades long timers", "[timer-wheel]" ) {
+    auto executor = make_shared< WorkStealingExecutor >( 2 );
+    TimerWheel wheel( executor );
+
+    // 70 ms and 300 ms are on level 1, 4500 ms on level 2
+    for ( uint64_t delay : { 70, 300, 4500 } ) {
+        auto begin = steadyTimeMs();
+        wheel.sleepFor( delay );
+        auto elapsed = steadyTimeMs() - begin;
+        REQUIRE( elapsed >= delay );
+        REQUIRE( elapsed <= delay + TIMER_WHEEL_TOLERANCE_MS );
+    }
+
+    wheel.shutdown();
+
+    REQUIRE_THROWS( wheel.sleepFor( 10 ) );
+
+    executor->shutdown();
+}
+
+
+TEST_CASE( "Timer wheel runs periodic timers", "[timer-wheel]" ) {
+    auto executor = make_shared< WorkStealingExecutor >( 2 );
+    TimerWheel wheel( executor );
+
+    atomic< uint64_t > runs = 0;
+
+    auto id = wheel.schedulePeriodic( 20, PRIORITY_MONITORING, [&runs]() { runs++; } );
+
+    wheel.sleepFor( 210 );
+
+    REQUIRE( wheel.cancel( id ) );
+
+    auto runsAfterCancel = ( uint64_t ) runs;
+
+    // runs start when the previous one finishes, so some drift is expected
+    REQUIRE( runsAfterCancel >= 7 );
+    REQUIRE( runsAfterCancel <= 10 );
+
+    wheel.sleepFor( 100 );
+
+    REQUIRE( runs <= runsAfterCancel + 1 );
+
+    wheel.shutdown();
+    executor->shutdown();
+}
@@ -0,0 +1,472 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file WorkStealingExecutor.cpp
+    @author Stan Kladko
+    @date 2021
+*/
+
+#include "SkaleCommon.h"
+#include "Log.h"
+#include "exceptions/ExitRequestedException.h"
+#include "exceptions/FatalError.h"
+
+#include "GlobalThreadRegistry.h"
+#include "WorkStealingExecutor.h"
+
+
+thread_local WorkStealingExecutor* WorkStealingExecutor::currentExecutor = nullptr;
+thread_local uint64_t WorkStealingExecutor::currentWorkerIndex = 0;
+
+
+WorkStealingExecutor::WorkStealingExecutor( uint64_t _maxActiveWorkers,
+    const ptr< GlobalThreadRegistry >& _threadRegistry, uint64_t _maxBlockedWorkers )
+    : maxActiveWorkers( _maxActiveWorkers ),
+      maxWorkers( _maxActiveWorkers + _maxBlockedWorkers ),
+      threadRegistry( _threadRegistry ) {
+    CHECK_ARGUMENT( _maxActiveWorkers > 0 );
+
+    workerQueues.reserve( maxWorkers );
+
+    for ( uint64_t i = 0; i < maxWorkers; i++ ) {
+        workerQueues.push_back( make_shared< TaskQueues >() );
+    }
+
+    workers.reserve( maxWorkers );
+}
+
+
+WorkStealingExecutor::BlockingScope::BlockingScope() : executor( currentExecutor ) {
+    if ( executor )
+        executor->enterBlocking();
+}
+
+
+WorkStealingExecutor::BlockingScope::~BlockingScope() {
+    if ( executor )
+        executor->leaveBlocking();
+}
+
+
+void WorkStealingExecutor::enterBlocking() {
+    lock_guard< mutex > lock( sleepLock );
+
+    blockedWorkers++;
+
+    // the tasks this worker would have picked up next need another worker now
+    if ( pendingTasks > searchingWorkers && !shutdownRequested )
+        startWorker();
+}
+
+
+void WorkStealingExecutor::leaveBlocking() {
+    lock_guard< mutex > lock( sleepLock );
+    CHECK_STATE( blockedWorkers > 0 );
+    blockedWorkers--;
+}
+
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    shutdown();
+}
+
+
+void WorkStealingExecutor::submit( task_priority _priority, const task& _task ) {
+    CHECK_ARGUMENT( _priority < PRIORITY_COUNT );
+    CHECK_ARGUMENT( _task );
+
+    // tasks of different nodes share the workers, so the log of the submitting node
+    // is passed to the task
+    auto log = logThreadLocal_;
+
+    task wrappedTask = [log, _task]() {
+        logThreadLocal_ = log;
+        runTask( _task );
+        logThreadLocal_ = nullptr;
+    };
+
+    auto& queues = ( currentExecutor == this ) ? *workerQueues.at( currentWorkerIndex ) :
+                                                 sharedQueues;
+
+    // workers exit only when nothing is pending, so the check and the push are done
+    // under sleepLock
+    lock_guard< mutex > lock( sleepLock );
+
+    if ( shutdownRequested ) {
+        BOOST_THROW_EXCEPTION( ExitRequestedException( __CLASS_NAME__ ) );
+    }
+
+    {
+        lock_guard< mutex > queuesLock( queues.queuesLock );
+        pendingTasks++;
+        queues.tasks[_priority].push_back( move( wrappedTask ) );
+    }
+
+    if ( pendingTasks <= searchingWorkers ) {
+        return;  // a searching worker will pick it up
+    }
+
+    startWorker();
+}
+
+
+void WorkStealingExecutor::startWorker() {
+    // workers that have finished blocking may still run, so the number of running workers
+    // can exceed maxActiveWorkers for a moment
+    if ( workerCount - blockedWorkers - idleWorkers >= maxActiveWorkers )
+        return;
+
+    if ( idleWorkers > 0 ) {
+        idleWorkers--;
+        wakeTokens++;
+        searchingWorkers++;
+        sleepCond.notify_one();
+    } else if ( workerCount < maxWorkers ) {
+        spawnWorker();
+    }
+}
+
+
+void WorkStealingExecutor::submitAndWait( task_priority _priority, const vector< task >& _tasks ) {
+    struct Completion {
+        mutex lock;
+        condition_variable cond;
+        uint64_t remaining;
+    };
+
+    auto completion = make_shared< Completion >();
+    completion->remaining = _tasks.size();
+
+    auto finish = [completion]( uint64_t _count ) {
+        lock_guard< mutex > lock( completion->lock );
+        completion->remaining -= _count;
+        if ( completion->remaining == 0 )
+            completion->cond.notify_all();
+    };
+
+    for ( uint64_t i = 0; i < _tasks.size(); i++ ) {
+        auto t = _tasks[i];
+        try {
+            submit( _priority, [t, finish]() {
+                try {
+                    t();
+                } catch ( ... ) {
+                    finish( 1 );
+                    throw;
+                }
+                finish( 1 );
+            } );
+        } catch ( ... ) {
+            // the tasks that have not been submitted will never run
+            finish( _tasks.size() - i );
+            unique_lock< mutex > lock( completion->lock );
+            completion->cond.wait( lock, [completion]() { return completion->remaining == 0; } );
+            throw;
+        }
+    }
+
+    // a worker that waits for its own subtasks keeps executing tasks, otherwise
+    // all workers could end up waiting
+    while ( currentExecutor == this ) {
+        {
+            lock_guard< mutex > lock( completion->lock );
+            if ( completion->remaining == 0 )
+                return;
+        }
+
+        task nextTask;
+
+        if ( tryPop( nextTask ) ) {
+            // this worker is busy, not searching
+            searchingWorkers++;
+            nextTask();
+            executedTasks++;
+        } else {
+            unique_lock< mutex > lock( completion->lock );
+            completion->cond.wait_for( lock, chrono::milliseconds( 1 ),
+                [completion]() { return completion->remaining == 0; } );
+        }
+    }
+
+    unique_lock< mutex > lock( completion->lock );
+    completion->cond.wait( lock, [completion]() { return completion->remaining == 0; } );
+}
+
+
+void WorkStealingExecutor::submitOrdered( task_priority _priority, const vector< task >& _tasks,
+    const function< void( uint64_t ) >& _consume ) {
+    CHECK_ARGUMENT( _consume );
+
+    struct Progress {
+        mutex lock;
+        condition_variable cond;
+        vector< bool > finished;
+        vector< exception_ptr > errors;
+    };
+
+    auto progress = make_shared< Progress >();
+    progress->finished.resize( _tasks.size(), false );
+    progress->errors.resize( _tasks.size() );
+
+    auto waitFor = [this, progress]( uint64_t _index ) {
+        auto isFinished = [progress, _index]() { return ( bool ) progress->finished[_index]; };
+
+        // same as in submitAndWait, a worker keeps executing tasks while it waits
+        while ( currentExecutor == this ) {
+            {
+                lock_guard< mutex > lock( progress->lock );
+                if ( isFinished() )
+                    return;
+            }
+
+            task nextTask;
+
+            if ( tryPop( nextTask ) ) {
+                searchingWorkers++;
+                nextTask();
+                executedTasks++;
+            } else {
+                unique_lock< mutex > lock( progress->lock );
+                progress->cond.wait_for( lock, chrono::milliseconds( 1 ), isFinished );
+            }
+        }
+
+        unique_lock< mutex > lock( progress->lock );
+        progress->cond.wait( lock, isFinished );
+    };
+
+    uint64_t submitted = 0;
+
+    try {
+        for ( ; submitted < _tasks.size(); submitted++ ) {
+            auto t = _tasks[submitted];
+            auto index = submitted;
+            submit( _priority, [t, index, progress]() {
+                exception_ptr error = nullptr;
+                try {
+                    t();
+                } catch ( ... ) {
+                    error = current_exception();
+                }
+                lock_guard< mutex > lock( progress->lock );
+                progress->errors[index] = error;
+                progress->finished[index] = true;
+                progress->cond.notify_all();
+            } );
+        }
+    } catch ( ... ) {
+        for ( uint64_t i = 0; i < submitted; i++ ) {
+            waitFor( i );
+        }
+        throw;
+    }
+
+    exception_ptr error = nullptr;
+
+    // after an error the remaining tasks are waited for, since they may use the caller's data
+    for ( uint64_t i = 0; i < _tasks.size(); i++ ) {
+        waitFor( i );
+
+        if ( error )
+            continue;
+
+        {
+            lock_guard< mutex > lock( progress->lock );
+            error = progress->errors[i];
+        }
+
+        if ( error )
+            continue;
+
+        try {
+            _consume( i );
+        } catch ( ... ) {
+            error = current_exception();
+        }
+    }
+
+    if ( error ) {
+        rethrow_exception( error );
+    }
+}
+
+
+void WorkStealingExecutor::spawnWorker() {
+    // called with sleepLock held
+    auto index = ( uint64_t ) workerCount;
+    CHECK_STATE( index < maxWorkers );
+    searchingWorkers++;
+    workers.push_back( make_shared< thread >( &WorkStealingExecutor::workerLoop, this, index ) );
+    workerCount++;
+}
+
+
+void WorkStealingExecutor::workerLoop( uint64_t _workerIndex ) {
+    currentExecutor = this;
+    currentWorkerIndex = _workerIndex;
+
+#ifdef __linux__
+    pthread_setname_np( pthread_self(), ( "Executor" + to_string( _workerIndex ) ).c_str() );
+#endif
+
+    if ( threadRegistry )
+        threadRegistry->registerThread(
+            "Executor" + to_string( _workerIndex ), "executor", "WorkStealingExecutor", 0 );
+
+    while ( true ) {
+        task nextTask;
+
+        if ( tryPop( nextTask ) ) {
+            nextTask();
+            executedTasks++;
+            searchingWorkers++;
+            continue;
+        }
+
+        unique_lock< mutex > lock( sleepLock );
+
+        // a task was queued after the scan above
+        if ( pendingTasks > 0 )
+            continue;
+
+        searchingWorkers--;
+
+        if ( shutdownRequested )
+            return;
+
+        idleWorkers++;
+
+        sleepCond.wait_for( lock, chrono::milliseconds( EXECUTOR_IDLE_WAIT_MS ),
+            [this]() { return wakeTokens > 0 || shutdownRequested; } );
+
+        if ( wakeTokens > 0 ) {
+            // a submitter has already moved this worker from idle to searching
+            wakeTokens--;
+        } else {
+            idleWorkers--;
+            searchingWorkers++;
+        }
+    }
+}
+
+
+bool WorkStealingExecutor::popFrom(
+    TaskQueues& _queues, task_priority _priority, bool _back, task& _task ) {
+    lock_guard< mutex > lock( _queues.queuesLock );
+
+    auto& q = _queues.tasks[_priority];
+
+    if ( q.empty() )
+        return false;
+
+    if ( _back ) {
+        _task = move( q.back() );
+        q.pop_back();
+    } else {
+        _task = move( q.front() );
+        q.pop_front();
+    }
+
+    // decremented first so that a concurrent submit never sees the task
+    // as taken by a worker that is about to become busy
+    searchingWorkers--;
+    pendingTasks--;
+
+    return true;
+}
+
+
+bool WorkStealingExecutor::tryPop( task& _task ) {
+    auto count = ( uint64_t ) workerCount;
+
+    for ( int p = 0; p < PRIORITY_COUNT; p++ ) {
+        auto priority = ( task_priority ) p;
+
+        if ( popFrom( *workerQueues.at( currentWorkerIndex ), priority, true, _task ) )
+            return true;
+
+        if ( popFrom( sharedQueues, priority, false, _task ) )
+            return true;
+
+        for ( uint64_t i = 1; i < count; i++ ) {
+            auto victim = ( currentWorkerIndex + i ) % count;
+            if ( popFrom( *workerQueues.at( victim ), priority, false, _task ) ) {
+                stolenTasks++;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+void WorkStealingExecutor::runTask( const task& _task ) {
+    try {
+        _task();
+    } catch ( ExitRequestedException& ) {
+    } catch ( exception& e ) {
+        SkaleException::logNested( e );
+    } catch ( ... ) {
+        LOG( err, "Unknown exception in executor task" );
+    }
+}
+
+
+void WorkStealingExecutor::shutdown() {
+    vector< ptr< thread > > toJoin;
+
+    {
+        lock_guard< mutex > lock( sleepLock );
+        if ( shutdownRequested.exchange( true ) )
+            return;
+        sleepCond.notify_all();
+        toJoin = workers;
+    }
+
+    // workers drain the queued tasks before exiting
+    for ( auto&& worker : toJoin ) {
+        if ( worker->get_id() == this_thread::get_id() ) {
+            worker->detach();
+        } else if ( worker->joinable() ) {
+            worker->join();
+        }
+    }
+}
+
+
+uint64_t WorkStealingExecutor::getWorkerCount() const {
+    return workerCount;
+}
+
+uint64_t WorkStealingExecutor::getBlockedWorkerCount() {
+    lock_guard< mutex > lock( sleepLock );
+    return blockedWorkers;
+}
+
+uint64_t WorkStealingExecutor::getExecutedTaskCount() const {
+    return executedTasks;
+}
+
+uint64_t WorkStealingExecutor::getStolenTaskCount() const {
+    return stolenTasks;
+}
+
+ptr< GlobalThreadRegistry > WorkStealingExecutor::getThreadRegistry() const {
+    return threadRegistry;
+}
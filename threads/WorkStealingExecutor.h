@@ -0,0 +1,161 @@
+/*
+    Copyright (C) 2021 SKALE Labs
+
+    This file is part of skale-consensus.
+
+    skale-consensus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    skale-consensus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with skale-consensus.  If not, see <https://www.gnu.org/licenses/>.
+
+    @file WorkStealingExecutor.h
+    @author Stan Kladko
+    @date 2021
+*/
+
+#ifndef SKALED_WORKSTEALINGEXECUTOR_H
+#define SKALED_WORKSTEALINGEXECUTOR_H
+
+#include <deque>
+#include <functional>
+
+class GlobalThreadRegistry;
+
+// lower value means higher priority
+enum task_priority {
+    PRIORITY_CONSENSUS = 0, PRIORITY_PROPOSAL = 1, PRIORITY_CATCHUP = 2, PRIORITY_MONITORING = 3,
+    PRIORITY_COUNT = 4
+};
+
+
+// Executor shared by all agents of a ConsensusEngine.
+//
+// Each worker owns a deque per priority. Tasks submitted from a worker go to its own deque
+// and are taken LIFO, tasks submitted from other threads go to the shared deques. An idle
+// worker takes the highest priority task available, stealing FIFO from other workers if needed.
+// A worker is spawned when a task can not be picked up by a searching or sleeping worker.
+// Workers that are not blocked are capped at maxActiveWorkers, usually the number of cores.
+// A task that waits for a peer marks the wait with BlockingScope, then another worker may
+// run meanwhile, up to maxBlockedWorkers more. Workers are reused until shutdown.
+
+class WorkStealingExecutor {
+
+public:
+
+    using task = function< void() >;
+
+    // marks a wait for network IO or a timer on a worker, does nothing on other threads
+    class BlockingScope {
+        WorkStealingExecutor* executor;
+
+    public:
+        BlockingScope();
+
+        ~BlockingScope();
+    };
+
+private:
+
+    class TaskQueues {
+    public:
+        mutex queuesLock;
+        array< deque< task >, PRIORITY_COUNT > tasks;  // tsafe
+    };
+
+    const uint64_t maxActiveWorkers;
+
+    const uint64_t maxWorkers;
+
+    // workers register with it if set
+    const ptr< GlobalThreadRegistry > threadRegistry;
+
+    TaskQueues sharedQueues;
+
+    // allocated in the constructor so that thieves never see the vector reallocate
+    vector< ptr< TaskQueues > > workerQueues;
+
+    vector< ptr< thread > > workers;  // guarded by sleepLock
+
+    atomic< uint64_t > workerCount = 0;
+
+    uint64_t blockedWorkers = 0;  // guarded by sleepLock
+
+    atomic< int64_t > pendingTasks = 0;
+
+    // workers that are not running a task and will look at the queues before sleeping
+    atomic< int64_t > searchingWorkers = 0;
+
+    atomic< uint64_t > executedTasks = 0;
+
+    atomic< uint64_t > stolenTasks = 0;
+
+    atomic< bool > shutdownRequested = false;
+
+    mutex sleepLock;
+    condition_variable sleepCond;
+
+    uint64_t idleWorkers = 0;  // guarded by sleepLock, not yet claimed by a submitter
+    uint64_t wakeTokens = 0;   // guarded by sleepLock
+
+    static thread_local WorkStealingExecutor* currentExecutor;
+    static thread_local uint64_t currentWorkerIndex;
+
+    void spawnWorker();
+
+    // called with sleepLock held when a task may be waiting for a worker
+    void startWorker();
+
+    void enterBlocking();
+
+    void leaveBlocking();
+
+    void workerLoop( uint64_t _workerIndex );
+
+    bool popFrom( TaskQueues& _queues, task_priority _priority, bool _back, task& _task );
+
+    bool tryPop( task& _task );
+
+    static void runTask( const task& _task );
+
+public:
+
+    explicit WorkStealingExecutor( uint64_t _maxActiveWorkers,
+        const ptr< GlobalThreadRegistry >& _threadRegistry = nullptr,
+        uint64_t _maxBlockedWorkers = 0 );
+
+    ~WorkStealingExecutor();
+
+    void submit( task_priority _priority, const task& _task );
+
+    // submits all tasks and blocks until each of them has finished
+    void submitAndWait( task_priority _priority, const vector< task >& _tasks );
+
+    // submits all tasks and calls _consume( i ) on the calling thread in task order, as soon as
+    // task i has finished, while the later tasks are still running. Returns after all tasks
+    // have finished, rethrows the first exception of a task or of _consume
+    void submitOrdered( task_priority _priority, const vector< task >& _tasks,
+        const function< void( uint64_t ) >& _consume );
+
+    void shutdown();
+
+    uint64_t getWorkerCount() const;
+
+    uint64_t getBlockedWorkerCount();
+
+    uint64_t getExecutedTaskCount() const;
+
+    uint64_t getStolenTaskCount() const;
+
+    ptr< GlobalThreadRegistry > getThreadRegistry() const;
+};
+
+
+#endif  // SKALED_WORKSTEALINGEXECUTOR_H
@@ -33,6 +33,12 @@ usleep(1000 * Consensust::getRunningTimeMS()); /* Flawfinder: ignore */
 
 REQUIRE(engine->nodesCount() > 0);
 REQUIRE(engine->getLargestCommittedBlockID() > 0);
+
+auto downloads = BlockFinalizeDownloader::getTotalDownloads();
+
+cerr << "Finalization downloads:" << downloads << ":average ms:"
+     << BlockFinalizeDownloader::getTotalDownloadTimeMs() / max<uint64_t>(downloads, 1) << endl;
+
 engine->exitGracefullyBlocking();
 delete engine;
 SUCCEED();
@@ -60,6 +66,72 @@ delete engine;
 SUCCEED();
 }
 
+TEST_CASE_METHOD(StartFromScratch, "Submitted transactions are not lost when other nodes win", "[consensus-submit-transactions]") {
+
+// the test acts as the host of all nodes: it submits the transactions to every node and the state
+// root of each block once all nodes committed it. Only one proposal of a block wins, the
+// transactions of the other ones have to be proposed again
+
+engine = new ConsensusEngine();
+engine->parseTestConfigsAndCreateAllNodes( Consensust::getConfigDirPath() );
+engine->submitTransactions({}, 0, 0);
+engine->slowStartBootStrapTest();
+
+uint64_t nextTransaction = 0;
+block_id scannedBlockID = 0;
+set<uint64_t> committed;
+
+auto startTime = time(NULL);
+
+while (committed.size() < SUBMIT_TEST_TRANSACTIONS) {
+
+    REQUIRE(time(NULL) - startTime < SUBMIT_TEST_TIMEOUT_S);
+
+    auto blockID = engine->getSmallestCommittedBlockID();
+
+    vector<vector<uint8_t>> transactions;
+
+    while (nextTransaction < SUBMIT_TEST_TRANSACTIONS && transactions.size() < SUBMIT_TEST_BATCH) {
+        vector<uint8_t> transaction(sizeof(uint64_t));
+        memcpy(transaction.data(), &nextTransaction, sizeof(uint64_t));
+        transactions.push_back(move(transaction));
+        nextTransaction++;
+    }
+
+    auto submitted = transactions.size();
+
+    nextTransaction -= submitted - engine->submitTransactions(
+        move(transactions), (uint64_t) blockID, (uint64_t) blockID);
+
+    for (uint64_t id = (uint64_t) scannedBlockID + 1; id <= (uint64_t) blockID; id++) {
+        auto blockTransactions = get<0>(engine->getBlock(id));
+        REQUIRE(blockTransactions);
+        for (auto&& transaction : *blockTransactions) {
+            REQUIRE(transaction.size() == sizeof(uint64_t));
+            uint64_t value;
+            memcpy(&value, transaction.data(), sizeof(uint64_t));
+            REQUIRE(value < nextTransaction);
+            committed.insert(value);
+        }
+    }
+
+    scannedBlockID = blockID;
+
+    usleep(10000);
+}
+
+cerr << "Committed " << SUBMIT_TEST_TRANSACTIONS << " submitted transactions in "
+     << scannedBlockID << " blocks:s:" << time(NULL) - startTime << endl;
+
+engine->exitGracefullyBlocking();
+delete engine;
+SUCCEED();
+}
+
+
+// these tests need the test hooks, see CONSENSUS_TEST_HOOKS
+#if CONSENSUS_TEST_HOOKS
+
 TEST_CASE_METHOD(StartFromScratch, "Issue different proposals to different nodes", "[corrupt-proposal]") {
 setenv("CORRUPT_PROPOSAL_TEST", "1", 1);
 
@@ -82,3 +154,71 @@ unsetenv("CORRUPT_PROPOSAL_TEST");
 SUCCEED();
 }
 
+
+TEST_CASE_METHOD(StartFromScratch, "Finalization download does not wait for a slow node", "[consensus-finalization-slow-peer]") {
+
+// run in test/fournodes_slow_peer, node4 delays everything it sends by SLOW_PEER_DELAY_MS. Two of
+// the three fragments are enough, so a download completes without waiting for node4
+
+setenv("TEST_FINALIZATION_DOWNLOAD_ONLY", "1", 1);
+
+engine = new ConsensusEngine();
+engine->parseTestConfigsAndCreateAllNodes( Consensust::getConfigDirPath() );
+engine->slowStartBootStrapTest();
+usleep(1000 * Consensust::getRunningTimeMS()); /* Flawfinder: ignore */
+
+REQUIRE(engine->getLargestCommittedBlockID() > 0);
+
+auto downloads = BlockFinalizeDownloader::getTotalDownloads();
+
+REQUIRE(downloads > 0);
+
+auto averageMs = BlockFinalizeDownloader::getTotalDownloadTimeMs() / downloads;
+
+cerr << "Finalization downloads with a slow node:" << downloads << ":average ms:" << averageMs
+     << endl;
+
+REQUIRE(averageMs < SLOW_PEER_DELAY_MS / 2);
+
+engine->exitGracefullyBlocking();
+delete engine;
+
+unsetenv("TEST_FINALIZATION_DOWNLOAD_ONLY");
+SUCCEED();
+}
+
+
+TEST_CASE_METHOD(StartFromScratch, "Catchup throughput", "[consensus-catchup-throughput]") {
+
+// the last node drops consensus messages for the first CATCHUP_TEST_BLOCKS blocks, so it gets
+// them from the other nodes through catchup
+
+engine = new ConsensusEngine();
+engine->parseTestConfigsAndCreateAllNodes( Consensust::getConfigDirPath() );
+engine->slowStartBootStrapTest();
+
+auto startTime = time(NULL);
+time_t producedTime = 0;
+
+while (engine->getSmallestCommittedBlockID() < CATCHUP_TEST_BLOCKS) {
+    if (producedTime == 0 && engine->getLargestCommittedBlockID() >= CATCHUP_TEST_BLOCKS)
+        producedTime = time(NULL);
+    REQUIRE(time(NULL) - startTime < CATCHUP_TEST_TIMEOUT_S);
+    usleep(100000);
+}
+
+auto finishTime = time(NULL);
+
+if (producedTime == 0)
+    producedTime = finishTime;
+
+cerr << "Catchup of " << CATCHUP_TEST_BLOCKS << " blocks:total s:" << finishTime - startTime
+     << ":lag behind the other nodes s:" << finishTime - producedTime << ":blocks/s:"
+     << CATCHUP_TEST_BLOCKS / max<uint64_t>(finishTime - startTime, 1) << endl;
+
+engine->exitGracefullyBlocking();
+delete engine;
+SUCCEED();
+}
+
+#endif
@@ -41,3 +41,15 @@ uint64_t Time::getCurrentTimeMs() {
 }
 
 
+uint64_t Time::getSteadyTimeMs() {
+    uint64_t result = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    return result;
+}
+
+
+uint64_t Time::getSteadyTimeUs() {
+    uint64_t result = chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    return result;
+}
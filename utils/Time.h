@@ -30,6 +30,11 @@ public:
     static uint64_t getCurrentTimeSec();
 
     static uint64_t getCurrentTimeMs();
+
+    // monotonic, use for timeouts
+    static uint64_t getSteadyTimeMs();
+
+    static uint64_t getSteadyTimeUs();
 };
 
 